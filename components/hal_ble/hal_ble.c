@@ -57,6 +57,10 @@ const esp_ble_gap_conn_params_t phy_coded_conn_params = {
 };
 
 static uint16_t g_gattc_if = ESP_GATT_IF_NONE;
+static ezos_work_t g_check_work;
+
+// 连接状态检查周期，单位ms
+#define HAL_BLE_CHECK_PERIOD_MS 100
 
 #define HAL_MASTER_CONNECT_MAX 2
 
@@ -312,7 +316,7 @@ static int hal_ble_set_status(char *dev_name, uint8_t status)
             {
 
                 g_remote_tabs[i].con_status = status;
-                ESP_LOGW(GATTC_TAG, "set status %d", status);
+                EZOS_LOGI(GATTC_TAG, "set status %d", status);
 
                 return 0;
             }
@@ -334,7 +338,7 @@ static int hal_ble_get_status(char *dev_name, uint8_t *status)
             if (strcmp(dev_name, g_remote_tabs[i].adv_name) == 0)
             {
                 *status = g_remote_tabs[i].con_status;
-                ESP_LOGW(GATTC_TAG, "get status %d", *status);
+                EZOS_LOGD(GATTC_TAG, "get status %d", *status);
 
                 return 0;
             }
@@ -356,7 +360,7 @@ static int hal_ble_set_status_by_addr(esp_bd_addr_t addr, uint8_t status)
             {
 
                 g_remote_tabs[i].con_status = status;
-                ESP_LOGW(GATTC_TAG, "set status %d", status);
+                EZOS_LOGI(GATTC_TAG, "set status %d", status);
                 return 0;
             }
         }
@@ -388,7 +392,8 @@ static void ble_scan_start_switch(uint8_t OnOff)
     ESP_LOGI(GATTC_TAG, "scan_start_flag %d", scan_start_flag);
 }
 
-void hal_ble_func_check_timer_cb(void *arg)
+// 在系统工作队列中执行，执行完再延时提交自己
+static void hal_ble_func_check_work(void *arg)
 {
     uint8_t scan_flag = 0;
     for (int i = 0; i < HAL_MASTER_CONNECT_MAX; i++)
@@ -408,6 +413,7 @@ void hal_ble_func_check_timer_cb(void *arg)
     }
 
     ble_scan_start_switch(scan_flag);
+    ezos_work_submit_delayed(NULL, &g_check_work, HAL_BLE_CHECK_PERIOD_MS);
 }
 
 int hal_ble_init(void)
@@ -475,9 +481,13 @@ int hal_ble_init(void)
         ESP_LOGE(GATTC_TAG, "Set extend scan params error, error code = %x", ret);
     }
 
-    ;
-
-    ezos_timer_start(ezos_timer_create(hal_ble_func_check_timer_cb, 0, 1), 100);
+    if (ezos_sysworkq_init() != EZOS_SUCCESS)
+    {
+        ESP_LOGE(GATTC_TAG, "sysworkq init failed");
+        return -1;
+    }
+    ezos_work_init(&g_check_work, hal_ble_func_check_work, NULL, EZOS_WORK_PRIO_NORMAL);
+    ezos_work_submit_delayed(NULL, &g_check_work, HAL_BLE_CHECK_PERIOD_MS);
 
     return 0;
 }
@@ -4,6 +4,10 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
 
 #define EZOS_VERSION_INFO "EasyOSAL Version 0.0.4(beta)"
 
@@ -21,6 +25,11 @@ typedef void *ezos_mutex_id_t;
 typedef void *ezos_sem_id_t;
 typedef void *ezos_queue_id_t;
 typedef void *ezos_timer_id_t;
+typedef void *ezos_mempool_id_t;
+typedef void *ezos_event_id_t;
+typedef void *ezos_streambuf_id_t;
+typedef void *ezos_msgbuf_id_t;
+typedef void *ezos_workqueue_id_t;
 
 #define EZOS_DELAY_FOREVER 0xffffffff
 
@@ -60,6 +69,98 @@ typedef struct
     uint32_t stack_size; // 任务栈大小
 } ezos_thread_params_t;
 
+// 静态对象的存储大小，不小于各后端内部结构，后端编译时校验
+#if defined(__linux__) || defined(__APPLE__)
+#define EZOS_THREAD_STATIC_SIZE 320
+#define EZOS_MUTEX_STATIC_SIZE 96
+#define EZOS_SEM_STATIC_SIZE 96
+#define EZOS_QUEUE_STATIC_SIZE 192
+#define EZOS_TIMER_STATIC_SIZE 64
+#define EZOS_MEMPOOL_STATIC_SIZE 64
+#define EZOS_EVENT_STATIC_SIZE 96
+#define EZOS_STREAMBUF_STATIC_SIZE 272
+#define EZOS_MSGBUF_STATIC_SIZE 272
+#else
+#define EZOS_THREAD_STATIC_SIZE 448
+#define EZOS_MUTEX_STATIC_SIZE 112
+#define EZOS_SEM_STATIC_SIZE 112
+#define EZOS_QUEUE_STATIC_SIZE 112
+#define EZOS_TIMER_STATIC_SIZE 80
+#define EZOS_MEMPOOL_STATIC_SIZE 48
+#define EZOS_EVENT_STATIC_SIZE 48
+#define EZOS_STREAMBUF_STATIC_SIZE 288
+#define EZOS_MSGBUF_STATIC_SIZE 288
+#endif
+
+// 静态对象的存储，内容由后端解释，调用者只负责提供内存
+typedef struct
+{
+    uint64_t opaque[(EZOS_THREAD_STATIC_SIZE + 7) / 8];
+} ezos_thread_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_MUTEX_STATIC_SIZE + 7) / 8];
+} ezos_mutex_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_SEM_STATIC_SIZE + 7) / 8];
+} ezos_sem_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_QUEUE_STATIC_SIZE + 7) / 8];
+} ezos_queue_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_TIMER_STATIC_SIZE + 7) / 8];
+} ezos_timer_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_MEMPOOL_STATIC_SIZE + 7) / 8];
+} ezos_mempool_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_EVENT_STATIC_SIZE + 7) / 8];
+} ezos_event_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_STREAMBUF_STATIC_SIZE + 7) / 8];
+} ezos_streambuf_static_t;
+
+typedef struct
+{
+    uint64_t opaque[(EZOS_MSGBUF_STATIC_SIZE + 7) / 8];
+} ezos_msgbuf_static_t;
+
+// 在文件作用域定义静态对象的存储，配合下面的EZOS_xxx_CREATE_STATIC使用
+#define EZOS_THREAD_STATIC_DEFINE(name, stack_size)  \
+    static ezos_thread_static_t name##_tcb;          \
+    static uint8_t name##_stack[stack_size] __attribute__((aligned(16)))
+#define EZOS_MUTEX_STATIC_DEFINE(name) static ezos_mutex_static_t name##_mcb
+#define EZOS_SEM_STATIC_DEFINE(name) static ezos_sem_static_t name##_scb
+#define EZOS_QUEUE_STATIC_DEFINE(name, msg_count, msg_size) \
+    static ezos_queue_static_t name##_qcb;                  \
+    static uint8_t name##_buf[(msg_count) * (msg_size)] __attribute__((aligned(4)))
+#define EZOS_TIMER_STATIC_DEFINE(name) static ezos_timer_static_t name##_tmcb
+#define EZOS_EVENT_STATIC_DEFINE(name) static ezos_event_static_t name##_ecb
+
+#define EZOS_THREAD_CREATE_STATIC(name, func, param) \
+    ezos_thread_create_static(func, param, &name##_tcb, name##_stack, sizeof(name##_stack))
+#define EZOS_MUTEX_CREATE_STATIC(name) ezos_mutex_create_static(&name##_mcb)
+#define EZOS_SEM_CREATE_STATIC(name, max_count, initial_count) \
+    ezos_sem_create_static(max_count, initial_count, &name##_scb)
+#define EZOS_QUEUE_CREATE_STATIC(name, msg_count, msg_size) \
+    ezos_queue_create_static(msg_count, msg_size, &name##_qcb, name##_buf)
+#define EZOS_TIMER_CREATE_STATIC(name, cb, arg, repeat) \
+    ezos_timer_create_static(cb, arg, repeat, &name##_tmcb)
+#define EZOS_EVENT_CREATE_STATIC(name) ezos_event_create_static(&name##_ecb)
+
 //  ==== Thread Functions ====
 /// @brief 创建任务,
 /// @param func   任务函数
@@ -85,7 +186,84 @@ ezos_status_t ezos_thread_resume(ezos_thread_id_t id);
 /// @return  0：success
 ezos_status_t ezos_thread_yield(void);
 
+/// @brief 使用调用者提供的存储创建任务，不从堆上分配
+/// @param func   任务函数
+/// @param param   任务参数，stack_size不使用，为NULL时使用默认值
+/// @param storage 任务控制块存储，任务存在期间必须有效
+/// @param stack   任务栈
+/// @param stack_size 任务栈大小，单位字节
+/// @return    返回值，如果为NULL，则失败，否则成功
+ezos_thread_id_t ezos_thread_create_static(ezos_thread_func_cb func, ezos_thread_params_t *param,
+                                           ezos_thread_static_t *storage, void *stack, uint32_t stack_size);
+
+/// @brief 获取当前任务
+/// @return 当前任务id
+ezos_thread_id_t ezos_thread_self(void);
+
+//  ==== Notification Functions ====
+// 任务通知：每个任务自带一个32位通知值，不需要额外的内核对象，比信号量和队列更轻。
+// give/take把通知值当计数器用，set_bits/wait_bits把它当事件位用，同一个任务只用其中一种。
+// 超时语义与ezos_sem_take一致，单位ms，EZOS_DELAY_FOREVER表示永久等待
+
+/// @brief 通知值加1，唤醒在ezos_notify_take中等待的任务，中断中可调用
+/// @param id 目标任务
+ezos_status_t ezos_notify_give(ezos_thread_id_t id);
+
+/// @brief 等待通知值不为0
+/// @param clear 1：返回前清零(二值信号量) 0：返回前减1(计数信号量)
+/// @param count 返回前的通知值，可为NULL
+/// @param timeout 超时时间，单位ms
+/// @return 0：成功，EZOS_TIMEOUT：超时，EZOS_ERRISR：在中断中调用
+ezos_status_t ezos_notify_take(uint8_t clear, uint32_t *count, uint32_t timeout);
+
+/// @brief 通知值按位或上bits并唤醒目标任务，中断中可调用
+/// @param id 目标任务
+/// @param bits 要置的位
+ezos_status_t ezos_notify_set_bits(ezos_thread_id_t id, uint32_t bits);
+
+/// @brief 等待通知
+/// @param clear_on_entry 进入时若没有未处理的通知，先清掉这些位
+/// @param clear_on_exit 收到通知后清掉这些位
+/// @param bits 清除前的通知值，可为NULL
+/// @param timeout 超时时间，单位ms
+/// @return 0：成功，EZOS_TIMEOUT：超时，EZOS_ERRISR：在中断中调用
+ezos_status_t ezos_notify_wait_bits(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *bits, uint32_t timeout);
+
 //  ==== Memory Functions ====
+// 堆实现：0(默认)使用系统堆(libc的malloc族，ESP-IDF上与pvPortMalloc是同一个堆)；
+// 1使用ezos自带的TLSF堆，管理EZOS_HEAP_SIZE字节的静态内存，malloc/free为O(1)。
+// TLSF堆的内存不论是否用到都常驻.bss，所有ezos_malloc的使用者共用，需要按实测峰值配置大小。
+// ESP-IDF下在menuconfig的EasyOSAL中配置
+#ifndef EZOS_HEAP_TLSF
+#ifdef CONFIG_EZOS_HEAP_TLSF
+#define EZOS_HEAP_TLSF 1
+#else
+#define EZOS_HEAP_TLSF 0
+#endif
+#endif
+
+#ifndef EZOS_HEAP_SIZE
+#if defined(CONFIG_EZOS_HEAP_SIZE)
+#define EZOS_HEAP_SIZE CONFIG_EZOS_HEAP_SIZE
+#elif defined(__linux__) || defined(__APPLE__)
+#define EZOS_HEAP_SIZE (1024 * 1024)
+#else
+#define EZOS_HEAP_SIZE (32 * 1024)
+#endif
+#endif
+
+typedef struct
+{
+    size_t total;        // 可分配的总字节数
+    size_t used;         // 已分配(按块大小计)
+    size_t used_max;     // 已分配的历史最大值
+    size_t free;         // 空闲字节数
+    size_t largest_free; // 最大空闲块
+    uint32_t free_blocks; // 空闲块个数
+    uint32_t fails;       // 分配失败次数
+    uint8_t frag_pct;     // 碎片率：100 - 最大空闲块 * 100 / 空闲总量
+} ezos_heap_stat_t;
+
 /// @brief 内存分配
 /// @param size 分配大小
 /// @return 返回分配空间的地址，不为NULL，则成功
@@ -107,6 +285,282 @@ void *ezos_calloc(uint32_t nitems, size_t size);
 /// @param ptr 指针指向一个要释放内存的内存块
 void ezos_free(void *ptr);
 
+/// @brief 获取堆统计，遍历空闲链，只用于诊断
+/// @param stat 统计结果
+/// @return 0：成功，EZOS_EPERM：主机上使用系统堆时不支持(ESP-IDF上取自heap_caps_get_info)
+ezos_status_t ezos_heap_stat_get(ezos_heap_stat_t *stat);
+
+// 调用点统计：开启后ezos_malloc/realloc/calloc按文件和行号记录存活字节、次数和峰值，
+// 每次分配多占8BYTE。需要作为全局编译选项打开，保证所有组件一致
+#ifndef EZOS_HEAP_TRACE
+#define EZOS_HEAP_TRACE 0
+#endif
+
+// 调用点表的大小，表满后新的调用点都计入最后一项
+#ifndef EZOS_HEAP_TRACE_SITES
+#define EZOS_HEAP_TRACE_SITES 32
+#endif
+
+typedef struct
+{
+    const char *file;    // 分配所在文件，未知时为"?"
+    uint16_t line;       // 分配所在行号，表满后合并的项为"?"、行号0
+    uint16_t live_count; // 存活块数
+    uint32_t live_bytes; // 存活字节数
+    uint32_t peak_bytes; // 存活字节数的峰值
+    uint32_t allocs;     // 累计分配次数
+} ezos_heap_site_t;
+
+void *ezos_malloc_trace(uint32_t size, const char *file, uint16_t line);
+void *ezos_realloc_trace(void *ptr, uint32_t size, const char *file, uint16_t line);
+void *ezos_calloc_trace(uint32_t nitems, size_t size, const char *file, uint16_t line);
+
+#if EZOS_HEAP_TRACE
+#define ezos_malloc(size) ezos_malloc_trace(size, __FILE__, __LINE__)
+#define ezos_realloc(ptr, size) ezos_realloc_trace(ptr, size, __FILE__, __LINE__)
+#define ezos_calloc(nitems, size) ezos_calloc_trace(nitems, size, __FILE__, __LINE__)
+#endif
+
+/// @brief 读取调用点统计
+/// @param sites 结果数组
+/// @param max 数组长度
+/// @return 有记录的调用点个数，未开启EZOS_HEAP_TRACE时为0
+uint16_t ezos_heap_trace_get(ezos_heap_site_t *sites, uint16_t max);
+
+/// @brief 通过ezos_printf打印堆统计和调用点统计快照
+void ezos_heap_dump(void);
+
+//  ==== Critical Section Functions ====
+/// @brief 进入临界区，关闭调度和中断，任务和中断中都可调用，可嵌套
+/// 临界区内不能调用会阻塞的接口
+void ezos_critical_enter(void);
+
+/// @brief 退出临界区，与ezos_critical_enter()成对调用
+void ezos_critical_exit(void);
+
+//  ==== Memory Pool Functions ====
+// 统计开关，关闭后ezos_mempool_stat_get()只返回块大小和总数
+#ifndef EZOS_MEMPOOL_STATS
+#define EZOS_MEMPOOL_STATS 1
+#endif
+
+// 调试模式：块前后加保护字，释放时检查越界写和重复释放，检查到的错误计入统计，不打印(释放可能在中断中)
+#ifndef EZOS_MEMPOOL_DEBUG
+#define EZOS_MEMPOOL_DEBUG 0
+#endif
+
+#define EZOS_MEMPOOL_ALIGN 8
+#define EZOS_MEMPOOL_ALIGN_UP(x) (((x) + EZOS_MEMPOOL_ALIGN - 1) & ~(uint32_t)(EZOS_MEMPOOL_ALIGN - 1))
+#if EZOS_MEMPOOL_DEBUG
+#define EZOS_MEMPOOL_GUARD_SIZE EZOS_MEMPOOL_ALIGN
+#else
+#define EZOS_MEMPOOL_GUARD_SIZE 0
+#endif
+
+// 每块实际占用的字节数，至少能放下一个指针
+#define EZOS_MEMPOOL_BLOCK_SIZE(size) \
+    (EZOS_MEMPOOL_ALIGN_UP((size) < sizeof(void *) ? sizeof(void *) : (size)) + 2 * EZOS_MEMPOOL_GUARD_SIZE)
+// 内存池缓冲区大小
+#define EZOS_MEMPOOL_BUF_SIZE(size, count) (EZOS_MEMPOOL_BLOCK_SIZE(size) * (count))
+
+// 在文件作用域定义静态内存池的存储，配合EZOS_MEMPOOL_CREATE_STATIC使用
+#define EZOS_MEMPOOL_STATIC_DEFINE(name, size, count) \
+    static ezos_mempool_static_t name##_pcb;          \
+    static uint8_t name##_pool[EZOS_MEMPOOL_BUF_SIZE(size, count)] __attribute__((aligned(EZOS_MEMPOOL_ALIGN)))
+#define EZOS_MEMPOOL_CREATE_STATIC(name, size, count) \
+    ezos_mempool_create_static(size, count, &name##_pcb, name##_pool)
+
+typedef struct
+{
+    uint32_t block_size;   // 用户可用的块大小
+    uint32_t total;        // 块总数
+    uint32_t used;         // 当前已分配
+    uint32_t used_max;     // 已分配的历史最大值
+    uint32_t fails;        // 池空导致的分配失败次数
+    uint32_t double_frees; // 调试模式下检查到的重复释放次数
+    uint32_t corrupts;     // 调试模式下检查到的保护字被改写次数
+    int32_t bad_block;     // 最近一次出错的块序号，没有出错时为-1
+} ezos_mempool_stat_t;
+
+/// @brief 创建定长块内存池，控制块和缓冲区从堆上分配
+/// @param block_size 块大小
+/// @param block_count 块数量
+/// @return 成功返回内存池，失败返回NULL
+ezos_mempool_id_t ezos_mempool_create(uint32_t block_size, uint32_t block_count);
+
+/// @brief 使用调用者提供的存储创建内存池
+/// @param block_size 块大小
+/// @param block_count 块数量
+/// @param storage 控制块存储
+/// @param buf 缓冲区，大小为EZOS_MEMPOOL_BUF_SIZE(block_size, block_count)，按EZOS_MEMPOOL_ALIGN对齐
+/// @return 成功返回内存池，失败返回NULL
+ezos_mempool_id_t ezos_mempool_create_static(uint32_t block_size, uint32_t block_count,
+                                             ezos_mempool_static_t *storage, void *buf);
+
+/// @brief 删除内存池，已分配的块随之失效
+/// @param pool 内存池
+void ezos_mempool_destroy(ezos_mempool_id_t pool);
+
+/// @brief 分配一块，O(1)，任务和中断中都可调用
+/// @param pool 内存池
+/// @return 块地址，池空时返回NULL
+void *ezos_mempool_alloc(ezos_mempool_id_t pool);
+
+/// @brief 释放一块，O(1)，任务和中断中都可调用
+/// @param pool 内存池
+/// @param ptr 块地址
+/// @return 0:成功 EZOS_EINVAL:不是本池的块 EZOS_FAILURE:调试模式下检查到越界写或重复释放
+ezos_status_t ezos_mempool_free(ezos_mempool_id_t pool, void *ptr);
+
+/// @brief 获取内存池统计，调试模式下的错误在任务中用它取出并打印
+/// @param pool 内存池
+/// @param stat 统计结果
+ezos_status_t ezos_mempool_stat_get(ezos_mempool_id_t pool, ezos_mempool_stat_t *stat);
+
+//  ==== Stream/Message Buffer Functions ====
+// 流缓冲区传字节流，消息缓冲区传变长消息，都是单读单写的环形缓冲区。
+// 写端可以先借出缓冲区内的空间(reserve)，原地填好后提交(commit)；
+// 读端可以原地查看数据(peek)，用完后归还(release)，数据全程不经过中间拷贝。
+// 同一时刻写端最多借出一块，读端最多查看一块。
+// 写端在中断中只能以timeout为0调用；超时单位ms，与ezos_sem_take一致
+
+#define EZOS_MSGBUF_ALIGN 4
+// 一条消息在缓冲区中占用的字节数：长度头 + 按4字节对齐的数据
+#define EZOS_MSGBUF_ITEM_SIZE(len) (4 + (((len) + EZOS_MSGBUF_ALIGN - 1) & ~(uint32_t)(EZOS_MSGBUF_ALIGN - 1)))
+// 能放下count条len字节消息的缓冲区大小，多出的一条用于回绕时尾部空间放不下的情况
+#define EZOS_MSGBUF_BUF_SIZE(len, count) (EZOS_MSGBUF_ITEM_SIZE(len) * ((count) + 1))
+
+// 在文件作用域定义静态缓冲区的存储，配合EZOS_xxx_CREATE_STATIC使用
+#define EZOS_STREAMBUF_STATIC_DEFINE(name, size) \
+    static ezos_streambuf_static_t name##_sbcb;  \
+    static uint8_t name##_sbbuf[size]
+#define EZOS_STREAMBUF_CREATE_STATIC(name, size, trigger) \
+    ezos_streambuf_create_static(size, trigger, &name##_sbcb, name##_sbbuf)
+#define EZOS_MSGBUF_STATIC_DEFINE(name, size) \
+    static ezos_msgbuf_static_t name##_mbcb;  \
+    static uint8_t name##_mbbuf[size] __attribute__((aligned(EZOS_MSGBUF_ALIGN)))
+#define EZOS_MSGBUF_CREATE_STATIC(name, size) ezos_msgbuf_create_static(size, &name##_mbcb, name##_mbbuf)
+
+/// @brief 创建流缓冲区，控制块和缓冲区从堆上分配
+/// @param size 缓冲区大小
+/// @param trigger 读端等到至少这么多字节才返回，超时则返回已有的数据，0按1处理
+/// @return 成功返回流缓冲区，失败返回NULL
+ezos_streambuf_id_t ezos_streambuf_create(uint32_t size, uint32_t trigger);
+
+/// @brief 使用调用者提供的存储创建流缓冲区，删除时不释放存储
+/// @param size 缓冲区大小
+/// @param trigger 同ezos_streambuf_create
+/// @param storage 控制块存储
+/// @param buf 缓冲区
+/// @return 成功返回流缓冲区，失败返回NULL
+ezos_streambuf_id_t ezos_streambuf_create_static(uint32_t size, uint32_t trigger,
+                                                 ezos_streambuf_static_t *storage, void *buf);
+
+/// @brief 删除流缓冲区
+/// @param sb 流缓冲区
+void ezos_streambuf_destroy(ezos_streambuf_id_t sb);
+
+/// @brief 写入数据，空间不足时等待，超时返回已写入的部分
+/// @param sb 流缓冲区
+/// @param data 数据
+/// @param len 数据长度
+/// @param timeout 超时时间，单位ms
+/// @return 写入的字节数
+uint32_t ezos_streambuf_send(ezos_streambuf_id_t sb, const void *data, uint32_t len, uint32_t timeout);
+
+/// @brief 读取数据，等到trigger个字节或超时
+/// @param sb 流缓冲区
+/// @param buf 数据缓冲区
+/// @param len 缓冲区长度
+/// @param timeout 超时时间，单位ms
+/// @return 读取的字节数
+uint32_t ezos_streambuf_recv(ezos_streambuf_id_t sb, void *buf, uint32_t len, uint32_t timeout);
+
+/// @brief 借出一段连续的空闲空间，至少有1个字节空闲时返回
+/// @param sb 流缓冲区
+/// @param len 输入期望的长度，输出实际借出的长度，回绕时可能比期望的短
+/// @param timeout 超时时间，单位ms
+/// @return 空间地址，超时返回NULL
+void *ezos_streambuf_reserve(ezos_streambuf_id_t sb, uint32_t *len, uint32_t timeout);
+
+/// @brief 提交借出空间的前len个字节，剩余部分归还
+/// @param sb 流缓冲区
+/// @param len 实际写入的长度，不超过借出的长度
+ezos_status_t ezos_streambuf_commit(ezos_streambuf_id_t sb, uint32_t len);
+
+/// @brief 原地查看一段连续的数据，等到trigger个字节或超时
+/// @param sb 流缓冲区
+/// @param len 输出可读的长度，回绕时只返回到缓冲区末尾
+/// @param timeout 超时时间，单位ms
+/// @return 数据地址，没有数据时返回NULL
+const void *ezos_streambuf_peek(ezos_streambuf_id_t sb, uint32_t *len, uint32_t timeout);
+
+/// @brief 归还查看过的数据的前len个字节
+/// @param sb 流缓冲区
+/// @param len 已处理的长度，不超过查看到的长度
+ezos_status_t ezos_streambuf_release(ezos_streambuf_id_t sb, uint32_t len);
+
+/// @brief 获取可读的字节数
+uint32_t ezos_streambuf_bytes_get(ezos_streambuf_id_t sb);
+
+/// @brief 创建消息缓冲区，控制块和缓冲区从堆上分配
+/// @param size 缓冲区大小，可用EZOS_MSGBUF_BUF_SIZE计算
+/// @return 成功返回消息缓冲区，失败返回NULL
+ezos_msgbuf_id_t ezos_msgbuf_create(uint32_t size);
+
+/// @brief 使用调用者提供的存储创建消息缓冲区，删除时不释放存储
+/// @param size 缓冲区大小
+/// @param storage 控制块存储
+/// @param buf 缓冲区，按EZOS_MSGBUF_ALIGN对齐
+/// @return 成功返回消息缓冲区，失败返回NULL
+ezos_msgbuf_id_t ezos_msgbuf_create_static(uint32_t size, ezos_msgbuf_static_t *storage, void *buf);
+
+/// @brief 删除消息缓冲区
+/// @param mb 消息缓冲区
+void ezos_msgbuf_destroy(ezos_msgbuf_id_t mb);
+
+/// @brief 写入一条消息，空间不足时等待
+/// @param mb 消息缓冲区
+/// @param data 消息
+/// @param len 消息长度
+/// @param timeout 超时时间，单位ms
+/// @return 0：成功，EZOS_TIMEOUT：超时，EZOS_EINVAL：消息比缓冲区还大
+ezos_status_t ezos_msgbuf_send(ezos_msgbuf_id_t mb, const void *data, uint32_t len, uint32_t timeout);
+
+/// @brief 读取一条消息，消息比buf长时截断，多出的部分丢弃
+/// @param mb 消息缓冲区
+/// @param buf 数据缓冲区
+/// @param len 缓冲区长度
+/// @param timeout 超时时间，单位ms
+/// @return 读取的字节数，超时返回0
+uint32_t ezos_msgbuf_recv(ezos_msgbuf_id_t mb, void *buf, uint32_t len, uint32_t timeout);
+
+/// @brief 借出能放下len字节消息的连续空间
+/// @param mb 消息缓冲区
+/// @param len 消息的最大长度
+/// @param timeout 超时时间，单位ms
+/// @return 空间地址，按EZOS_MSGBUF_ALIGN对齐，超时或len过大返回NULL
+void *ezos_msgbuf_reserve(ezos_msgbuf_id_t mb, uint32_t len, uint32_t timeout);
+
+/// @brief 提交借出的空间作为一条消息
+/// @param mb 消息缓冲区
+/// @param len 消息的实际长度，不超过借出时的长度
+ezos_status_t ezos_msgbuf_commit(ezos_msgbuf_id_t mb, uint32_t len);
+
+/// @brief 原地查看最早的一条消息
+/// @param mb 消息缓冲区
+/// @param len 输出消息长度
+/// @param timeout 超时时间，单位ms
+/// @return 消息地址，超时返回NULL
+const void *ezos_msgbuf_peek(ezos_msgbuf_id_t mb, uint32_t *len, uint32_t timeout);
+
+/// @brief 归还查看过的消息
+/// @param mb 消息缓冲区
+ezos_status_t ezos_msgbuf_release(ezos_msgbuf_id_t mb);
+
+/// @brief 获取缓冲区中的消息数
+uint32_t ezos_msgbuf_count_get(ezos_msgbuf_id_t mb);
+
 //  ==== mutex Functions ====
 /// @brief 创建锁
 /// @return 返回NULL，则失败
@@ -124,6 +578,11 @@ ezos_status_t ezos_mutex_lock(ezos_mutex_id_t mutex);
 /// @param mutex 锁句柄
 ezos_status_t ezos_mutex_unlock(ezos_mutex_id_t mutex);
 
+/// @brief 使用调用者提供的存储创建锁，删除时不释放存储
+/// @param storage 锁存储
+/// @return 返回NULL，则失败
+ezos_mutex_id_t ezos_mutex_create_static(ezos_mutex_static_t *storage);
+
 //  ==== Semaphore Management Function ====
 /// @brief 创建信号量
 /// @param max_count   信号量最大计数器
@@ -145,6 +604,60 @@ ezos_status_t ezos_sem_take(ezos_sem_id_t sem, uint32_t timeout);
 /// @param sem 信号量
 ezos_status_t ezos_sem_give(ezos_sem_id_t sem);
 
+/// @brief 使用调用者提供的存储创建信号量，删除时不释放存储
+/// @param max_count   信号量最大计数器
+/// @param initial_count    信号量计数器初始值
+/// @param storage 信号量存储
+/// @return 成功，返回一个信号量，失败返回NULL
+ezos_sem_id_t ezos_sem_create_static(uint32_t max_count, uint32_t initial_count, ezos_sem_static_t *storage);
+
+//  ==== Event Flags Functions ====
+// 事件标志组只有低24位可用，与FreeRTOS事件组一致
+#define EZOS_EVENT_BITS_MASK 0x00FFFFFFu
+
+// ezos_event_wait的选项
+#define EZOS_EVENT_WAIT_ANY 0x00 // 任一位置位即返回
+#define EZOS_EVENT_WAIT_ALL 0x01 // 所有位都置位才返回
+#define EZOS_EVENT_CLEAR 0x02    // 返回前清掉等待的位
+
+/// @brief 创建事件标志组
+/// @return 成功返回事件标志组，失败返回NULL
+ezos_event_id_t ezos_event_create(void);
+
+/// @brief 使用调用者提供的存储创建事件标志组，删除时不释放存储
+/// @param storage 事件标志组存储
+/// @return 成功返回事件标志组，失败返回NULL
+ezos_event_id_t ezos_event_create_static(ezos_event_static_t *storage);
+
+/// @brief 删除事件标志组
+/// @param event 事件标志组
+ezos_status_t ezos_event_destroy(ezos_event_id_t event);
+
+/// @brief 置位并唤醒满足条件的等待者，中断中可调用(由定时器任务代为置位)
+/// @param event 事件标志组
+/// @param bits 要置的位
+/// @return 0：成功，EZOS_EINVAL：超出EZOS_EVENT_BITS_MASK，EZOS_FAILURE：中断中投递失败
+ezos_status_t ezos_event_set(ezos_event_id_t event, uint32_t bits);
+
+/// @brief 清除位
+/// @param event 事件标志组
+/// @param bits 要清的位
+ezos_status_t ezos_event_clear(ezos_event_id_t event, uint32_t bits);
+
+/// @brief 读取当前的位，中断中可调用
+/// @param event 事件标志组
+/// @return 当前的位
+uint32_t ezos_event_get(ezos_event_id_t event);
+
+/// @brief 等待位
+/// @param event 事件标志组
+/// @param bits 等待的位
+/// @param options EZOS_EVENT_WAIT_ANY/EZOS_EVENT_WAIT_ALL，可或上EZOS_EVENT_CLEAR
+/// @param out 返回时(清除前)的位，可为NULL
+/// @param timeout 超时时间，单位ms，与ezos_sem_take一致
+/// @return 0：成功，EZOS_TIMEOUT：超时，EZOS_ERRISR：在中断中调用
+ezos_status_t ezos_event_wait(ezos_event_id_t event, uint32_t bits, uint8_t options, uint32_t *out, uint32_t timeout);
+
 //  ==== Message Queue Management Functions====
 /// @brief 创建一个消息队列
 /// @param queue_count 队列消息数量
@@ -159,14 +672,14 @@ void ezos_queue_destroy(ezos_queue_id_t queue);
 /// @brief 将消息写入队列中
 /// @param queue 队列
 /// @param msg 消息
-/// @param timeout 队列满超时时间。传入0表示不超时，立即返回；0xFFFFFFFFFF表示永久等待;其他时间表示超时时间
+/// @param timeout 队列满超时时间，单位ms。传入0表示不超时，立即返回；EZOS_DELAY_FOREVER表示永久等待;其他时间表示超时时间
 /// @return  0: 成功，-1：失败，其他：返回超时
 ezos_status_t ezos_queue_write(ezos_queue_id_t queue, void *msg_ptr,uint32_t msg_size, uint32_t timeout);
 
 /// @brief 从队列中读取消息
 /// @param queue 队列
 /// @param msg_ptr 消息
-/// @param timeout 读队列空超时时间。传入0表示不超时，立即返回；0xFFFFFFFFFF表示永久等待;其他时间表示超时时间
+/// @param timeout 读队列空超时时间，单位ms。传入0表示不超时，立即返回；EZOS_DELAY_FOREVER表示永久等待;其他时间表示超时时间
 /// @return  0: 成功，-1：失败，其他：返回超时
 ezos_status_t ezos_queue_read(ezos_queue_id_t queue, void *msg_ptr,uint32_t msg_size,uint32_t timeout);
 
@@ -179,6 +692,14 @@ uint32_t ezos_queue_count_get(ezos_queue_id_t queue);
 /// @param queue 队列
 void ezos_queue_reset(ezos_queue_id_t queue);
 
+/// @brief 使用调用者提供的存储创建队列，删除时不释放存储
+/// @param queue_count 队列消息数量
+/// @param queue_size   队列中最大消息大小
+/// @param storage 队列控制块存储
+/// @param buf 消息存储，大小为msg_count * msg_size
+/// @return 成功返回一个队列，失败返回NULL
+ezos_queue_id_t ezos_queue_create_static(uint32_t msg_count, uint32_t msg_size, ezos_queue_static_t *storage, void *buf);
+
 //  ==== timer Management Functions====
 /// @brief 创建一个定时器
 /// @param cb 定时器回调函数
@@ -191,13 +712,13 @@ ezos_timer_id_t ezos_timer_create(ezos_thread_timer_cb cb, void *arg, int repeat
 /// @param timer 定时器
 ezos_status_t ezos_timer_destroy(ezos_timer_id_t timer);
 
-/// @brief 启动定时器
+/// @brief 启动定时器，任务和中断中都可调用
 /// @param timer 定时器
 /// @param ms 定时器定时时间
 /// @return  0：成功，非0 失败
 ezos_status_t ezos_timer_start(ezos_timer_id_t timer, uint32_t ms);
 
-/// @brief 停止定时器
+/// @brief 停止定时器，任务和中断中都可调用
 /// @param timer 定时器
 /// @return 0：成功，非0 失败
 ezos_status_t ezos_timer_stop(ezos_timer_id_t timer);
@@ -213,6 +734,535 @@ ezos_status_t ezos_timer_update(ezos_timer_id_t timer, uint32_t ms);
 /// @return 0：不在运行，1：正在运行
 ezos_timer_stat_t ezos_timer_is_active(ezos_timer_id_t timer);
 
+/// @brief 使用调用者提供的存储创建定时器，删除时不释放存储
+/// @param cb 定时器回调函数
+/// @param arg  定时器回调函数参数
+/// @param repeat 周期或单次（1：周期，0：单次）。
+/// @param storage 定时器存储
+/// @return 返回一个定时器，失败返回NULL
+ezos_timer_id_t ezos_timer_create_static(ezos_thread_timer_cb cb, void *arg, int repeat, ezos_timer_static_t *storage);
+
+//  ==== Timer Wheel Functions ====
+// 分层时间轮：定时器结构由调用者嵌入自己的上下文中，启动和停止都是O(1)，不分配内存，
+// 到期的回调在同一个任务中批量执行。适合大量短生命周期的超时，如请求超时、重组超时、重连退避。
+// 时间轮不单独占任务，由一个ezos定时器驱动，回调在定时器服务任务中执行(开启EZOS_TWHEEL_HRTIMER时为esp_timer任务)，
+// 轮上没有定时器时驱动定时器停止。
+// 启动和停止在任务和中断中都可调用；回调中可以重新启动或停止任意定时器，但不能阻塞，
+// 也不要做打印之类用栈多的事，耗时的处理提交到工作队列
+
+// 时间轮的精度，单位ms，定时时间向上取整到它的整数倍
+#ifndef EZOS_TWHEEL_TICK_MS
+#define EZOS_TWHEEL_TICK_MS 10
+#endif
+
+// 用esp_timer驱动时间轮，EZOS_TWHEEL_TICK_MS可以小于系统tick；主机上忽略。
+// 不开启时EZOS_TWHEEL_TICK_MS不能小于系统tick
+#ifndef EZOS_TWHEEL_HRTIMER
+#define EZOS_TWHEEL_HRTIMER 0
+#endif
+
+typedef struct ezos_wtimer_node
+{
+    struct ezos_wtimer_node *next;
+    struct ezos_wtimer_node **pprev; // 指向自己的那个指针
+} ezos_wtimer_node_t;
+
+// 成员仅供时间轮内部使用，通过ezos_wtimer_xxx接口访问
+typedef struct
+{
+    ezos_wtimer_node_t node; // 不在轮上时pprev为NULL
+    uint32_t expire;         // 到期时刻，单位为时间轮tick
+    uint32_t period;         // 周期，0为单次
+    ezos_thread_timer_cb cb;
+    void *arg;
+} ezos_wtimer_t;
+
+/// @brief 初始化时间轮并创建驱动定时器，只需调用一次
+/// @return 0：成功，EZOS_FAILURE：创建定时器失败
+ezos_status_t ezos_twheel_init(void);
+
+/// @brief 初始化定时器
+/// @param timer 定时器
+/// @param cb 到期回调，在定时器服务任务中执行
+/// @param arg 回调参数
+void ezos_wtimer_init(ezos_wtimer_t *timer, ezos_thread_timer_cb cb, void *arg);
+
+/// @brief 启动定时器，已在运行时按新的时间重新开始
+/// @param timer 定时器
+/// @param ms 首次到期时间，单位ms，不会早于ms到期，最多晚一个EZOS_TWHEEL_TICK_MS
+/// @param period_ms 之后的周期，单位ms，0为单次
+/// @return 0：成功，EZOS_EINVAL：参数错误，EZOS_EPERM：时间轮未初始化，EZOS_FAILURE：驱动定时器启动失败，下次启动定时器时重试
+ezos_status_t ezos_wtimer_start(ezos_wtimer_t *timer, uint32_t ms, uint32_t period_ms);
+
+/// @brief 停止定时器，不在运行时什么也不做
+/// 在其他任务中调用时，回调可能正在定时器服务任务中执行，返回后不会再被调用
+/// @param timer 定时器
+ezos_status_t ezos_wtimer_stop(ezos_wtimer_t *timer);
+
+/// @brief 检查定时器是否在运行
+/// @param timer 定时器
+/// @return 0：不在运行，1：正在运行
+uint8_t ezos_wtimer_is_active(ezos_wtimer_t *timer);
+
+//  ==== Work Queue Functions ====
+// 工作队列：少量工作任务执行各模块提交的短作业，模块不必各自创建任务。
+// 作业按优先级分道，先执行高优先级道中的作业，同一道内先进先出。
+// 已在排队的作业再次提交不会重复排队；正在执行时再次提交，执行完后再执行一次，同一作业不会并发执行。
+// 延时提交使用时间轮，创建工作队列时自动初始化时间轮
+
+// 系统工作队列，各模块共用
+#ifndef EZOS_SYSWORKQ_WORKERS
+#define EZOS_SYSWORKQ_WORKERS 1
+#endif
+
+#ifndef EZOS_SYSWORKQ_PRIORITY
+#define EZOS_SYSWORKQ_PRIORITY 18
+#endif
+
+#ifndef EZOS_SYSWORKQ_STACK_SIZE
+#define EZOS_SYSWORKQ_STACK_SIZE 2048
+#endif
+
+typedef enum
+{
+    EZOS_WORK_PRIO_HIGH = 0,
+    EZOS_WORK_PRIO_NORMAL,
+    EZOS_WORK_PRIO_LOW,
+    EZOS_WORK_PRIO_NUM,
+} ezos_work_prio_t;
+
+// 成员仅供工作队列内部使用，通过ezos_work_xxx接口访问
+typedef struct ezos_work
+{
+    struct ezos_work *next;
+    ezos_thread_func_cb func;
+    void *arg;
+    ezos_workqueue_id_t wq;
+    uint8_t prio;
+    uint8_t state;
+    ezos_wtimer_t timer; // 延时提交
+} ezos_work_t;
+
+/// @brief 创建工作队列
+/// @param name 工作任务名称
+/// @param workers 工作任务数
+/// @param priority 工作任务优先级
+/// @param stack_size 每个工作任务的栈大小
+/// @return 成功返回工作队列，失败返回NULL
+ezos_workqueue_id_t ezos_workqueue_create(const char *name, uint32_t workers, uint16_t priority, uint32_t stack_size);
+
+/// @brief 创建系统工作队列，重复调用直接返回，需在任务中调用
+/// @return 0：成功，EZOS_FAILURE：创建失败
+ezos_status_t ezos_sysworkq_init(void);
+
+/// @brief 初始化作业
+/// @param work 作业
+/// @param func 作业函数，在工作任务中执行
+/// @param arg 作业函数参数
+/// @param prio 优先级
+void ezos_work_init(ezos_work_t *work, ezos_thread_func_cb func, void *arg, ezos_work_prio_t prio);
+
+/// @brief 提交作业，已在排队时什么也不做，任务和中断中都可调用
+/// @param wq 工作队列，NULL为系统工作队列
+/// @param work 作业
+/// @return 0：成功，EZOS_EINVAL：参数错误，EZOS_EPERM：系统工作队列未初始化
+ezos_status_t ezos_work_submit(ezos_workqueue_id_t wq, ezos_work_t *work);
+
+/// @brief 延时ms后提交作业，已在排队或已在延时中时什么也不做，任务和中断中都可调用
+/// @param wq 工作队列，NULL为系统工作队列
+/// @param work 作业
+/// @param ms 延时，单位ms
+/// @return 0：成功，EZOS_EINVAL：参数错误，EZOS_EPERM：系统工作队列未初始化
+ezos_status_t ezos_work_submit_delayed(ezos_workqueue_id_t wq, ezos_work_t *work, uint32_t ms);
+
+/// @brief 重新设置延时提交，已在延时中的按新的延时重新计时，任务和中断中都可调用
+/// @param wq 工作队列，NULL为系统工作队列
+/// @param work 作业
+/// @param ms 延时，单位ms，0为立即提交，EZOS_DELAY_FOREVER为只取消延时
+/// @return 0：成功，EZOS_EINVAL：参数错误，EZOS_EPERM：系统工作队列未初始化
+ezos_status_t ezos_work_reschedule(ezos_workqueue_id_t wq, ezos_work_t *work, uint32_t ms);
+
+/// @brief 取消尚未执行的作业，包括延时中的
+/// @param work 作业
+/// @return 0：成功，EZOS_EBUZY：作业正在执行，本次执行不受影响
+ezos_status_t ezos_work_cancel(ezos_work_t *work);
+
+/// @brief 检查作业是否在排队或延时中
+/// @param work 作业
+/// @return 0：否，1：是
+uint8_t ezos_work_is_pending(ezos_work_t *work);
+
+//  ==== Coroutine Functions ====
+// 无栈协程：协程函数每次被调用时从上次挂起的位置继续执行，挂起时直接返回，不占用任务栈。
+// 协程作为作业在工作队列中运行，一个工作任务可以跑很多协程，每个协程只占一个ezos_coro_t(32位平台上76字节)。
+// 限制：
+//   局部变量在挂起后不保留，需要跨挂起点的状态放在arg指向的结构中
+//   挂起宏不能出现在协程函数内的switch语句中，同一行只能写一个挂起宏
+//   协程函数内不要调用阻塞接口，等待一律用EZOS_CORO_xxx宏
+// 等待信号量、队列、事件标志组时以0超时尝试，不成功就挂在对象上，对象的give/write/read/set直接唤醒协程，
+// 定时器只负责超时，永久等待不占定时器。
+// EZOS_CORO_WAIT_UNTIL和EZOS_CORO_AWAIT等待的是任意条件，只能每EZOS_CORO_POLL_MS或被ezos_coro_wake唤醒时再试一次
+
+// 等待任意条件时的轮询周期，单位ms
+#ifndef EZOS_CORO_POLL_MS
+#define EZOS_CORO_POLL_MS 10
+#endif
+
+// 协程函数的返回值，由EZOS_CORO_xxx宏返回，协程函数不要直接返回
+typedef enum
+{
+    EZOS_CORO_WAITING = 0, // 等待中
+    EZOS_CORO_YIELDED,     // 让出，排到队尾后继续
+    EZOS_CORO_EXITED,      // 已结束
+} ezos_coro_ret_t;
+
+// 挂起宏中返回后落到恢复点的case，告诉编译器是有意的
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define EZOS_CORO_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define EZOS_CORO_FALLTHROUGH ((void)0)
+#endif
+
+typedef struct ezos_coro ezos_coro_t;
+typedef ezos_coro_ret_t (*ezos_coro_func_t)(ezos_coro_t *co, void *arg);
+
+// 成员仅供协程宏和内部使用
+struct ezos_coro
+{
+    uint16_t lc;       // 继续执行的位置，即挂起处的行号
+    uint8_t state;
+    uint8_t forever;   // 本次等待没有超时
+    uint32_t deadline; // 等待的截止时刻，单位ms
+    uint32_t sleep;    // 本次挂起后多久再运行，单位ms
+    uint32_t wait_gen; // 挂上时的唤醒代数
+    const void *wait_obj; // 正在等待的对象，NULL表示不在等待链表上
+    ezos_coro_t *wait_next;
+    ezos_coro_func_t func;
+    void *arg;
+    ezos_work_t work;
+};
+
+#define EZOS_CORO_BEGIN(co) \
+    switch ((co)->lc)       \
+    {                       \
+    case 0:
+
+#define EZOS_CORO_END(co)   \
+    }                       \
+    (co)->lc = 0;           \
+    return EZOS_CORO_EXITED
+
+/// @brief 结束协程
+#define EZOS_CORO_EXIT(co)       \
+    do                           \
+    {                            \
+        (co)->lc = 0;            \
+        return EZOS_CORO_EXITED; \
+    } while (0)
+
+/// @brief 让出工作任务，排到队尾后继续
+#define EZOS_CORO_YIELD(co)       \
+    do                            \
+    {                             \
+        (co)->lc = __LINE__;      \
+        return EZOS_CORO_YIELDED; \
+    case __LINE__:;               \
+    } while (0)
+
+/// @brief 挂起ms毫秒
+#define EZOS_CORO_DELAY(co, ms)          \
+    do                                   \
+    {                                    \
+        ezos_coro_wait_begin(co, ms);    \
+        (co)->lc = __LINE__;             \
+        EZOS_CORO_FALLTHROUGH;           \
+    case __LINE__:                       \
+        if (ezos_coro_wait_again(co, 0)) \
+            return EZOS_CORO_WAITING;    \
+    } while (0)
+
+/// @brief 挂起直到cond成立
+#define EZOS_CORO_WAIT_UNTIL(co, cond)                \
+    do                                                \
+    {                                                 \
+        ezos_coro_wait_begin(co, EZOS_DELAY_FOREVER); \
+        (co)->lc = __LINE__;                          \
+        EZOS_CORO_FALLTHROUGH;                        \
+    case __LINE__:                                    \
+        if (!(cond) && ezos_coro_wait_again(co, 1))   \
+            return EZOS_CORO_WAITING;                 \
+    } while (0)
+
+/// @brief 等待try_expr返回EZOS_SUCCESS，try_expr须为不阻塞的尝试。先挂到对象上再尝试，尝试之后的唤醒不会丢
+/// @param obj 条件由哪个ezos对象改变，对象的唤醒路径会唤醒协程；NULL为按EZOS_CORO_POLL_MS轮询
+/// @param ret 结果，EZOS_SUCCESS或超时后为EZOS_TIMEOUT
+/// @param timeout 超时时间，单位ms，EZOS_DELAY_FOREVER表示永久等待
+#define EZOS_CORO_AWAIT_OBJ(co, obj, try_expr, ret, timeout) \
+    do                                                       \
+    {                                                        \
+        ezos_coro_wait_begin(co, timeout);                   \
+        (co)->lc = __LINE__;                                 \
+        EZOS_CORO_FALLTHROUGH;                               \
+    case __LINE__:                                           \
+        ezos_coro_wait_on(co, obj);                          \
+        (ret) = (try_expr);                                  \
+        if ((ret) == EZOS_SUCCESS)                           \
+            ezos_coro_wait_off(co);                          \
+        else if (ezos_coro_wait_again(co, (obj) == NULL))    \
+            return EZOS_CORO_WAITING;                        \
+        else                                                 \
+            (ret) = EZOS_TIMEOUT;                            \
+    } while (0)
+
+/// @brief 等待try_expr返回EZOS_SUCCESS，按EZOS_CORO_POLL_MS轮询
+#define EZOS_CORO_AWAIT(co, try_expr, ret, timeout) \
+    EZOS_CORO_AWAIT_OBJ(co, NULL, try_expr, ret, timeout)
+
+#define EZOS_CORO_SEM_TAKE(co, sem, ret, timeout) \
+    EZOS_CORO_AWAIT_OBJ(co, sem, ezos_sem_take(sem, 0), ret, timeout)
+
+#define EZOS_CORO_QUEUE_READ(co, queue, msg_ptr, msg_size, ret, timeout) \
+    EZOS_CORO_AWAIT_OBJ(co, queue, ezos_queue_read(queue, msg_ptr, msg_size, 0), ret, timeout)
+
+#define EZOS_CORO_QUEUE_WRITE(co, queue, msg_ptr, msg_size, ret, timeout) \
+    EZOS_CORO_AWAIT_OBJ(co, queue, ezos_queue_write(queue, msg_ptr, msg_size, 0), ret, timeout)
+
+#define EZOS_CORO_EVENT_WAIT(co, event, bits, options, out, ret, timeout) \
+    EZOS_CORO_AWAIT_OBJ(co, event, ezos_event_wait(event, bits, options, out, 0), ret, timeout)
+
+/// @brief 初始化协程
+/// @param co 协程
+/// @param func 协程函数
+/// @param arg 协程函数参数，一般指向保存协程状态的结构
+/// @param prio 在工作队列中的优先级
+void ezos_coro_init(ezos_coro_t *co, ezos_coro_func_t func, void *arg, ezos_work_prio_t prio);
+
+/// @brief 从头开始运行协程，已结束的协程可以再次启动
+/// @param wq 工作队列，NULL为系统工作队列
+/// @param co 协程
+/// @return 0：成功，EZOS_EINVAL：参数错误，EZOS_EPERM：系统工作队列未初始化，EZOS_EBUZY：协程未结束或最后一步仍在执行
+ezos_status_t ezos_coro_start(ezos_workqueue_id_t wq, ezos_coro_t *co);
+
+/// @brief 停止协程，正在执行的一步执行完后不再继续
+/// @param co 协程
+/// @return 0：成功，EZOS_EINVAL：参数错误
+ezos_status_t ezos_coro_stop(ezos_coro_t *co);
+
+/// @brief 唤醒等待中的协程，让它马上检查等待条件，任务和中断中都可调用
+/// @param co 协程
+void ezos_coro_wake(ezos_coro_t *co);
+
+/// @brief 检查协程是否已结束或已停止
+/// @param co 协程
+/// @return 0：否，1：是
+uint8_t ezos_coro_is_done(ezos_coro_t *co);
+
+// 供协程宏使用
+void ezos_coro_wait_begin(ezos_coro_t *co, uint32_t timeout);
+uint8_t ezos_coro_wait_again(ezos_coro_t *co, uint8_t poll);
+void ezos_coro_wait_on(ezos_coro_t *co, const void *obj);
+void ezos_coro_wait_off(ezos_coro_t *co);
+
+/// @brief 唤醒挂在对象上的协程，由后端在信号量、队列、事件标志组的唤醒路径中调用，中断中可调用
+/// @param obj 对象
+void ezos_coro_obj_wake(const void *obj);
+
+//  ==== Profiler Functions ====
+// 任务剖析：每个任务的运行时间、CPU占用、栈高水位，以及在ezos对象上阻塞后从被唤醒到恢复运行的延迟。
+// 唤醒延迟：释放者在sem_give/queue_write/event_set/notify_give等接口中给对象打时间戳，
+// 等待者阻塞返回后用当前时间减去该时间戳；没有真正阻塞的调用不计入。
+// 需要作为全局编译选项打开，关闭时后端中的埋点为空。
+// FreeRTOS后端需要打开CONFIG_FREERTOS_USE_TRACE_FACILITY，
+// 运行时间还需要CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS，否则为0
+#ifndef EZOS_PROF
+#define EZOS_PROF 0
+#endif
+
+// 统计表的任务数，超出的任务不统计CPU占用和唤醒延迟
+#ifndef EZOS_PROF_TASKS
+#define EZOS_PROF_TASKS 24
+#endif
+
+// 唤醒时间戳的槽数，按对象地址散列，冲突时后来的覆盖
+#ifndef EZOS_PROF_WAKE_SLOTS
+#define EZOS_PROF_WAKE_SLOTS 32
+#endif
+
+typedef struct
+{
+    ezos_thread_id_t id;
+    char name[16];
+    uint8_t priority;        // 后端的优先级数值
+    uint16_t cpu_permille;   // 统计窗口内的CPU占用，千分比，相对单核
+    uint32_t stack_free_min; // 栈剩余的最小值，单位BYTE，未知时为0
+    uint32_t runtime_us;     // 累计运行时间，32位回绕，不支持时为0
+    uint32_t wakeups;        // 在ezos对象上阻塞后被唤醒的次数
+    uint32_t wake_lat_avg_us;
+    uint32_t wake_lat_max_us;
+} ezos_prof_task_t;
+
+typedef struct
+{
+    uint32_t window_us;  // 统计窗口，即距上次ezos_prof_get的时间
+    uint32_t switches;   // 窗口内的上下文切换次数，不支持时为0
+    uint32_t wakeups;    // 窗口内所有任务被唤醒的次数
+    uint16_t tasks;      // 任务总数，可能比返回的多
+} ezos_prof_stat_t;
+
+/// @brief 读取任务剖析数据，CPU占用和stat按两次调用之间的窗口计算
+/// @param tasks 结果数组
+/// @param max 数组长度
+/// @param stat 汇总，可以为NULL
+/// @return 返回的任务数，未开启EZOS_PROF时为0
+uint16_t ezos_prof_get(ezos_prof_task_t *tasks, uint16_t max, ezos_prof_stat_t *stat);
+
+/// @brief 清零唤醒延迟统计
+void ezos_prof_reset(void);
+
+/// @brief 通过ezos_printf打印任务剖析快照
+void ezos_prof_dump(void);
+
+// 供后端使用
+#if EZOS_PROF
+void ezos_prof_wake_mark(const void *obj);
+void ezos_prof_wake_done(const void *obj, uint64_t wait_start);
+// 后端实现：填写id、name、priority、stack_free_min、runtime_us，返回任务总数
+uint16_t ezos_prof_tasks_snapshot(ezos_prof_task_t *tasks, uint16_t max, uint32_t *switches);
+#define EZOS_PROF_WAKE(obj) ezos_prof_wake_mark(obj)
+#define EZOS_PROF_WAIT_START() ezos_time_us()
+#define EZOS_PROF_WAIT_DONE(obj, start) ezos_prof_wake_done(obj, start)
+#else
+#define EZOS_PROF_WAKE(obj) ((void)0)
+#define EZOS_PROF_WAIT_START() 0
+#define EZOS_PROF_WAIT_DONE(obj, start) ((void)(start))
+#endif
+
+//  ==== Log Functions ====
+// 异步二进制日志：调用处只把tag、格式串指针、时间戳和参数原值写进无锁环形缓冲区，不格式化也不输出。
+// 由低优先级的日志任务(ezos_log_init创建)格式化后通过weak_ezos_puts输出；
+// 或者不创建日志任务，用ezos_log_read取出原始记录发给主机，由主机工具按固件中的格式串还原。
+// 参数按uintptr_t原值保存，格式串只能用整数、字符和指针(%d %u %x %c %p)，最多EZOS_LOG_MAX_ARGS个，
+// 不支持浮点和64位整数；%s的字符串在输出前必须一直有效，只用于字面量之类的常量。
+// 级别在编译时过滤，高于EZOS_LOG_LEVEL的日志展开为空，参数不会求值；可以在包含ezos.h前按文件定义。
+// 缓冲区满时丢弃新的记录并计数，不阻塞，任务和中断中都可调用
+#define EZOS_LOG_LEVEL_NONE 0
+#define EZOS_LOG_LEVEL_ERROR 1
+#define EZOS_LOG_LEVEL_WARN 2
+#define EZOS_LOG_LEVEL_INFO 3
+#define EZOS_LOG_LEVEL_DEBUG 4
+
+#ifndef EZOS_LOG_LEVEL
+#define EZOS_LOG_LEVEL EZOS_LOG_LEVEL_INFO
+#endif
+
+// 记录数，必须是2的幂
+#ifndef EZOS_LOG_SLOTS
+#define EZOS_LOG_SLOTS 32
+#endif
+
+#ifndef EZOS_LOG_MAX_ARGS
+#define EZOS_LOG_MAX_ARGS 6
+#endif
+
+// 日志任务，没有新记录时每EZOS_LOG_FLUSH_MS检查一次，缓冲区用掉一半时被提前叫醒
+#ifndef EZOS_LOG_PRIORITY
+#define EZOS_LOG_PRIORITY 2
+#endif
+
+#ifndef EZOS_LOG_STACK_SIZE
+#define EZOS_LOG_STACK_SIZE 2048
+#endif
+
+#ifndef EZOS_LOG_FLUSH_MS
+#define EZOS_LOG_FLUSH_MS 20
+#endif
+
+typedef struct
+{
+    const char *tag;
+    const char *fmt;
+    uint32_t time_ms; // 开机以来的毫秒数，49天回绕
+    uint8_t level;
+    uint8_t nargs;
+    uintptr_t args[EZOS_LOG_MAX_ARGS];
+} ezos_log_rec_t;
+
+typedef struct
+{
+    uint32_t written; // 写入的记录数
+    uint32_t dropped; // 缓冲区满丢弃的记录数
+} ezos_log_stat_t;
+
+// 参数个数和逐个转换为uintptr_t
+#define EZOS_LOG_NARGS(...) EZOS_LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define EZOS_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define EZOS_LOG_A0()
+#define EZOS_LOG_A1(a) , (uintptr_t)(a)
+#define EZOS_LOG_A2(a, ...) , (uintptr_t)(a) EZOS_LOG_A1(__VA_ARGS__)
+#define EZOS_LOG_A3(a, ...) , (uintptr_t)(a) EZOS_LOG_A2(__VA_ARGS__)
+#define EZOS_LOG_A4(a, ...) , (uintptr_t)(a) EZOS_LOG_A3(__VA_ARGS__)
+#define EZOS_LOG_A5(a, ...) , (uintptr_t)(a) EZOS_LOG_A4(__VA_ARGS__)
+#define EZOS_LOG_A6(a, ...) , (uintptr_t)(a) EZOS_LOG_A5(__VA_ARGS__)
+#define EZOS_LOG_CAT(a, b) EZOS_LOG_CAT_(a, b)
+#define EZOS_LOG_CAT_(a, b) a##b
+#define EZOS_LOG_EMIT(level, tag, fmt, ...)                                                  \
+    ezos_log_write(level, tag, fmt, EZOS_LOG_NARGS(__VA_ARGS__)                              \
+                   EZOS_LOG_CAT(EZOS_LOG_A, EZOS_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__))
+
+#if EZOS_LOG_LEVEL >= EZOS_LOG_LEVEL_ERROR
+#define EZOS_LOGE(tag, fmt, ...) EZOS_LOG_EMIT(EZOS_LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+#define EZOS_LOGE(tag, fmt, ...) ((void)0)
+#endif
+
+#if EZOS_LOG_LEVEL >= EZOS_LOG_LEVEL_WARN
+#define EZOS_LOGW(tag, fmt, ...) EZOS_LOG_EMIT(EZOS_LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+#define EZOS_LOGW(tag, fmt, ...) ((void)0)
+#endif
+
+#if EZOS_LOG_LEVEL >= EZOS_LOG_LEVEL_INFO
+#define EZOS_LOGI(tag, fmt, ...) EZOS_LOG_EMIT(EZOS_LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+#define EZOS_LOGI(tag, fmt, ...) ((void)0)
+#endif
+
+#if EZOS_LOG_LEVEL >= EZOS_LOG_LEVEL_DEBUG
+#define EZOS_LOGD(tag, fmt, ...) EZOS_LOG_EMIT(EZOS_LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+#define EZOS_LOGD(tag, fmt, ...) ((void)0)
+#endif
+
+/// @brief 写一条日志记录，一般通过EZOS_LOGx宏调用，可变参数必须是nargs个uintptr_t
+/// @param level 级别
+/// @param tag 模块名，须一直有效
+/// @param fmt 格式串，须一直有效，不需要带换行
+/// @param nargs 参数个数，超过EZOS_LOG_MAX_ARGS的丢弃
+void ezos_log_write(uint8_t level, const char *tag, const char *fmt, uint8_t nargs, ...);
+
+/// @brief 取出一条原始记录，只能有一个读者，已创建日志任务时不要调用
+/// @param rec 记录
+/// @return 0：成功，EZOS_FAILURE：没有记录
+ezos_status_t ezos_log_read(ezos_log_rec_t *rec);
+
+/// @brief 把一条记录格式化为一行文本，以\r\n结尾
+/// @param rec 记录
+/// @param buf 缓冲区
+/// @param len 缓冲区长度
+/// @return 文本长度，超过len时截断
+uint32_t ezos_log_format(const ezos_log_rec_t *rec, char *buf, uint32_t len);
+
+/// @brief 创建日志任务，重复调用直接返回
+/// @return 0：成功，EZOS_FAILURE：创建任务失败
+ezos_status_t ezos_log_init(void);
+
+/// @brief 让日志任务马上输出缓冲区中的记录，不等待输出完成，任务和中断中都可调用
+void ezos_log_flush(void);
+
+/// @brief 获取日志统计
+/// @param stat 统计结果
+void ezos_log_stat_get(ezos_log_stat_t *stat);
+
 //  ==== system Management Functions====
 /// @brief os系统初始化
 ezos_status_t ezos_init(void);
@@ -248,6 +1298,29 @@ uint32_t ezos_tick_conut_get(void);
 /// @return 返回周期tick数
 uint32_t ezos_tick_freq_get(void);
 
+// ezos_delay_us短于这个时间时全程忙等，单位us
+#ifndef EZOS_DELAY_US_SPIN_MAX
+#define EZOS_DELAY_US_SPIN_MAX 1000
+#endif
+
+/// @brief 获取开机以来的微秒数，不受系统tick精度限制，中断中可调用
+/// @return 微秒数
+uint64_t ezos_time_us(void);
+
+/// @brief 获取CPU周期计数，32位回绕，用于测量很短的代码段，中断中可调用
+/// @return 周期计数
+uint32_t ezos_cycles(void);
+
+/// @brief 获取ezos_cycles()的计数频率
+/// @return 每秒的周期数
+uint32_t ezos_cycles_freq_get(void);
+
+/// @brief 微秒延时，不短于us
+/// 短于EZOS_DELAY_US_SPIN_MAX时忙等；更长时先按tick睡眠，最后不足一个tick的部分忙等，
+/// 忙等期间不让出CPU，长时间等待应使用ezos_delayms()
+/// @param us 单位微秒
+void ezos_delay_us(uint32_t us);
+
 /// @brief 打印
 /// @param fmt 
 /// @param  
@@ -0,0 +1,214 @@
+#include "ezos.h"
+
+#include <string.h>
+
+/*
+ * 无栈协程：每个协程是一个作业，作业函数调用一次协程函数，按返回值决定下一次什么时候运行：
+ *   WAITING  按co->sleep延时重新提交，EZOS_DELAY_FOREVER时只等唤醒
+ *   YIELDED  立即重新提交，排到同优先级队尾
+ *   EXITED   结束
+ * 等待对象的协程挂在g_waiters上，对象的唤醒路径调用ezos_coro_obj_wake把挂在该对象上的协程摘下并提交。
+ * 链表通常很短，没有协程在等时唤醒路径只读一次链表头。
+ * 被唤醒或轮询到时条件不一定成立，协程宏会重新检查，多跑一次没有副作用。
+ */
+
+#define CORO_RUNNING 0x01
+
+static ezos_coro_t *g_waiters = NULL;
+// 每次ezos_coro_obj_wake加1，只唤醒在此之前挂上的协程，被唤醒后马上又挂回来的不会被同一次唤醒反复摘下
+static uint32_t g_wake_gen = 0;
+
+static uint32_t coro_clock_ms(void)
+{
+    return (uint32_t)((uint64_t)ezos_tick_conut_get() * 1000 / ezos_tick_freq_get());
+}
+
+static void coro_run(void *arg)
+{
+    ezos_coro_t *co = arg;
+    ezos_coro_ret_t ret;
+
+    if (!(co->state & CORO_RUNNING))
+        return;
+
+    co->sleep = EZOS_DELAY_FOREVER;
+    ret = co->func(co, co->arg);
+
+    // 执行期间被停止
+    if (!(co->state & CORO_RUNNING))
+        return;
+
+    switch (ret)
+    {
+    case EZOS_CORO_EXITED:
+        co->state &= ~CORO_RUNNING;
+        break;
+    case EZOS_CORO_YIELDED:
+        ezos_work_reschedule(co->work.wq, &co->work, 0);
+        break;
+    default:
+        ezos_work_reschedule(co->work.wq, &co->work, co->sleep);
+        break;
+    }
+}
+
+void ezos_coro_init(ezos_coro_t *co, ezos_coro_func_t func, void *arg, ezos_work_prio_t prio)
+{
+    if (co == NULL)
+        return;
+
+    memset(co, 0, sizeof(ezos_coro_t));
+    co->func = func;
+    co->arg = arg;
+    ezos_work_init(&co->work, coro_run, co, prio);
+}
+
+ezos_status_t ezos_coro_start(ezos_workqueue_id_t wq, ezos_coro_t *co)
+{
+    ezos_status_t ret;
+
+    if (co == NULL || co->func == NULL)
+        return EZOS_EINVAL;
+    // 上一次的最后一步还在执行时不能重新开始，否则会改写lc
+    if ((co->state & CORO_RUNNING) || ezos_work_cancel(&co->work) == EZOS_EBUZY)
+        return EZOS_EBUZY;
+
+    co->lc = 0;
+    co->state = CORO_RUNNING;
+    ret = ezos_work_submit(wq, &co->work);
+    if (ret != EZOS_SUCCESS)
+        co->state = 0;
+    return ret;
+}
+
+ezos_status_t ezos_coro_stop(ezos_coro_t *co)
+{
+    if (co == NULL)
+        return EZOS_EINVAL;
+
+    co->state &= ~CORO_RUNNING;
+    ezos_coro_wait_off(co);
+    // 正在执行时coro_run返回前会检查状态，不再重新提交
+    ezos_work_cancel(&co->work);
+    return EZOS_SUCCESS;
+}
+
+void ezos_coro_wake(ezos_coro_t *co)
+{
+    if (co == NULL || !(co->state & CORO_RUNNING))
+        return;
+
+    ezos_work_submit(co->work.wq, &co->work);
+}
+
+uint8_t ezos_coro_is_done(ezos_coro_t *co)
+{
+    if (co == NULL)
+        return 1;
+
+    return !(co->state & CORO_RUNNING);
+}
+
+void ezos_coro_wait_begin(ezos_coro_t *co, uint32_t timeout)
+{
+    co->forever = timeout == EZOS_DELAY_FOREVER;
+    co->deadline = coro_clock_ms() + timeout;
+}
+
+uint8_t ezos_coro_wait_again(ezos_coro_t *co, uint8_t poll)
+{
+    int32_t remain;
+
+    if (co->forever)
+    {
+        co->sleep = poll ? EZOS_CORO_POLL_MS : EZOS_DELAY_FOREVER;
+        return 1;
+    }
+
+    remain = (int32_t)(co->deadline - coro_clock_ms());
+    if (remain <= 0)
+    {
+        ezos_coro_wait_off(co);
+        return 0;
+    }
+
+    co->sleep = (poll && (uint32_t)remain > EZOS_CORO_POLL_MS) ? EZOS_CORO_POLL_MS : (uint32_t)remain;
+    return 1;
+}
+
+void ezos_coro_wait_on(ezos_coro_t *co, const void *obj)
+{
+    if (obj == NULL)
+        return;
+
+    ezos_critical_enter();
+    if (co->wait_obj == NULL)
+    {
+        co->wait_next = g_waiters;
+        g_waiters = co;
+    }
+    co->wait_obj = obj;
+    co->wait_gen = g_wake_gen;
+    ezos_critical_exit();
+    // 与ezos_coro_obj_wake中的屏障配对：要么唤醒方看到协程已挂上，要么协程随后的尝试看到对象已就绪
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void ezos_coro_wait_off(ezos_coro_t *co)
+{
+    ezos_coro_t **pp;
+
+    ezos_critical_enter();
+    if (co->wait_obj != NULL)
+    {
+        for (pp = &g_waiters; *pp != NULL; pp = &(*pp)->wait_next)
+        {
+            if (*pp == co)
+            {
+                *pp = co->wait_next;
+                break;
+            }
+        }
+        co->wait_obj = NULL;
+        co->wait_next = NULL;
+    }
+    ezos_critical_exit();
+}
+
+void ezos_coro_obj_wake(const void *obj)
+{
+    ezos_coro_t **pp;
+    ezos_coro_t *co;
+    uint32_t gen;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&g_waiters, __ATOMIC_RELAXED) == NULL)
+        return;
+
+    ezos_critical_enter();
+    gen = ++g_wake_gen;
+    ezos_critical_exit();
+
+    // 每次摘一个，提交放在临界区外，工作队列的提交会释放信号量
+    for (;;)
+    {
+        ezos_critical_enter();
+        for (pp = &g_waiters; *pp != NULL; pp = &(*pp)->wait_next)
+        {
+            if ((*pp)->wait_obj == obj && (int32_t)((*pp)->wait_gen - gen) < 0)
+                break;
+        }
+        co = *pp;
+        if (co != NULL)
+        {
+            *pp = co->wait_next;
+            co->wait_obj = NULL;
+            co->wait_next = NULL;
+        }
+        ezos_critical_exit();
+
+        if (co == NULL)
+            break;
+        ezos_coro_wake(co);
+    }
+}
@@ -1,6 +1,7 @@
 #include "ezos.h"
 
 #if 1
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
@@ -19,6 +20,10 @@
 #include "freertos/list.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
 
 
 
@@ -27,6 +32,14 @@
 #define DONT_BLOCK 0
 #define VALUE_BEFORE_TIMER_START 1
 
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+_Static_assert(sizeof(StaticTask_t) <= sizeof(ezos_thread_static_t), "EZOS_THREAD_STATIC_SIZE too small");
+_Static_assert(sizeof(StaticSemaphore_t) <= sizeof(ezos_mutex_static_t), "EZOS_MUTEX_STATIC_SIZE too small");
+_Static_assert(sizeof(StaticSemaphore_t) <= sizeof(ezos_sem_static_t), "EZOS_SEM_STATIC_SIZE too small");
+_Static_assert(sizeof(StaticQueue_t) <= sizeof(ezos_queue_static_t), "EZOS_QUEUE_STATIC_SIZE too small");
+_Static_assert(sizeof(StaticEventGroup_t) <= sizeof(ezos_event_static_t), "EZOS_EVENT_STATIC_SIZE too small");
+#endif
+
 extern BaseType_t xPortCheckIfInISR(void);
 
 static inline uint32_t ezos_irq_context(void)
@@ -51,7 +64,26 @@ static inline uint32_t ezos_irq_context(void)
     return (irq);
 }
 
+// 超时ms转tick，不足一个tick的按一个tick等待
+static TickType_t ezos_ms_to_ticks(uint32_t ms)
+{
+    TickType_t ticks;
+
+    if (ms == EZOS_DELAY_FOREVER)
+        return portMAX_DELAY;
+
+    ticks = pdMS_TO_TICKS(ms);
+    if (ticks == 0 && ms != 0)
+        ticks = 1;
+    return ticks;
+}
+
 //  ==== Thread Functions ====
+static uint32_t ezos_prio_map(uint16_t priority)
+{
+    return ((float)configMAX_PRIORITIES / EZ_MAX_PRIORITY) * priority;
+}
+
 ezos_thread_id_t ezos_thread_create(ezos_thread_func_cb func, ezos_thread_params_t *param)
 {
     TaskHandle_t task_handle = NULL;
@@ -72,7 +104,7 @@ ezos_thread_id_t ezos_thread_create(ezos_thread_func_cb func, ezos_thread_params
     if (param->priority > EZ_MAX_PRIORITY)
         return NULL;
 
-    prio = ((float)configMAX_PRIORITIES / EZ_MAX_PRIORITY) * param->priority;
+    prio = ezos_prio_map(param->priority);
 
     int ret = xTaskCreate((TaskFunction_t)func, param->thread_name, param->stack_size, param->user_arg, prio, &task_handle);
     if (ret != pdPASS)
@@ -82,6 +114,28 @@ ezos_thread_id_t ezos_thread_create(ezos_thread_func_cb func, ezos_thread_params
     return task_handle;
 }
 
+ezos_thread_id_t ezos_thread_create_static(ezos_thread_func_cb func, ezos_thread_params_t *param,
+                                           ezos_thread_static_t *storage, void *stack, uint32_t stack_size)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    uint16_t priority = EZ_DEFAULT_PRIORITY;
+
+    if (func == NULL || storage == NULL || stack == NULL)
+        return NULL;
+
+    if (param != NULL)
+        priority = param->priority;
+    if (priority > EZ_MAX_PRIORITY)
+        return NULL;
+
+    return xTaskCreateStatic((TaskFunction_t)func, param != NULL ? param->thread_name : NULL,
+                             stack_size / sizeof(StackType_t), param != NULL ? param->user_arg : NULL,
+                             ezos_prio_map(priority), (StackType_t *)stack, (StaticTask_t *)storage);
+#else
+    return NULL;
+#endif
+}
+
 void ezos_thread_destroy(ezos_thread_id_t id)
 {
     vTaskDelete((TaskHandle_t)id);
@@ -125,26 +179,112 @@ ezos_status_t ezos_thread_yield(void)
     return EZOS_SUCCESS;
 }
 
-//  ==== Memory Functions ====
-void *ezos_malloc(uint32_t size)
+ezos_thread_id_t ezos_thread_self(void)
+{
+    return xTaskGetCurrentTaskHandle();
+}
+
+//  ==== Notification Functions ====
+ezos_status_t ezos_notify_give(ezos_thread_id_t id)
+{
+    if (id == NULL)
+        return EZOS_EINVAL;
+
+    EZOS_PROF_WAKE(id);
+    if (ezos_irq_context() != 0)
+    {
+        BaseType_t yield = pdFALSE;
+        vTaskNotifyGiveFromISR((TaskHandle_t)id, &yield);
+        portYIELD_FROM_ISR(yield);
+    }
+    else
+    {
+        xTaskNotifyGive((TaskHandle_t)id);
+    }
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_notify_take(uint8_t clear, uint32_t *count, uint32_t timeout)
+{
+    uint32_t value;
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    if (ezos_irq_context() != 0)
+        return EZOS_ERRISR;
+
+    value = ulTaskNotifyTake(clear ? pdTRUE : pdFALSE, ezos_ms_to_ticks(timeout));
+    if (count != NULL)
+        *count = value;
+    if (value == 0)
+        return EZOS_TIMEOUT;
+    EZOS_PROF_WAIT_DONE(xTaskGetCurrentTaskHandle(), start);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_notify_set_bits(ezos_thread_id_t id, uint32_t bits)
 {
+    if (id == NULL)
+        return EZOS_EINVAL;
 
-    return pvPortMalloc(size);
+    EZOS_PROF_WAKE(id);
+    if (ezos_irq_context() != 0)
+    {
+        BaseType_t yield = pdFALSE;
+        xTaskNotifyFromISR((TaskHandle_t)id, bits, eSetBits, &yield);
+        portYIELD_FROM_ISR(yield);
+    }
+    else
+    {
+        xTaskNotify((TaskHandle_t)id, bits, eSetBits);
+    }
+    return EZOS_SUCCESS;
 }
 
-void *ezos_realloc(void *ptr, uint32_t size)
+ezos_status_t ezos_notify_wait_bits(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *bits, uint32_t timeout)
 {
-    return realloc(ptr, size);
+    uint32_t value = 0;
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    if (ezos_irq_context() != 0)
+        return EZOS_ERRISR;
+
+    if (xTaskNotifyWait(clear_on_entry, clear_on_exit, &value, ezos_ms_to_ticks(timeout)) != pdTRUE)
+    {
+        if (bits != NULL)
+            *bits = value;
+        return EZOS_TIMEOUT;
+    }
+    if (bits != NULL)
+        *bits = value;
+    EZOS_PROF_WAIT_DONE(xTaskGetCurrentTaskHandle(), start);
+    return EZOS_SUCCESS;
 }
 
-void *ezos_calloc(uint32_t nitems, size_t size)
+//  ==== Critical Section Functions ====
+static portMUX_TYPE g_critical_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void ezos_critical_enter(void)
 {
-    return calloc(nitems, size);
+    if (ezos_irq_context() != 0)
+    {
+        portENTER_CRITICAL_ISR(&g_critical_mux);
+    }
+    else
+    {
+        portENTER_CRITICAL(&g_critical_mux);
+    }
 }
 
-void ezos_free(void *ptr)
+void ezos_critical_exit(void)
 {
-    vPortFree(ptr);
+    if (ezos_irq_context() != 0)
+    {
+        portEXIT_CRITICAL_ISR(&g_critical_mux);
+    }
+    else
+    {
+        portEXIT_CRITICAL(&g_critical_mux);
+    }
 }
 
 //  ==== mutex Functions ====
@@ -157,6 +297,19 @@ ezos_mutex_id_t ezos_mutex_create(void)
 #endif
 }
 
+/// @brief 使用调用者提供的存储创建锁
+/// @return 返回NULL，则失败
+ezos_mutex_id_t ezos_mutex_create_static(ezos_mutex_static_t *storage)
+{
+#if (configUSE_MUTEXES == 1) && (configSUPPORT_STATIC_ALLOCATION == 1)
+    if (storage == NULL)
+        return NULL;
+    return xSemaphoreCreateMutexStatic((StaticSemaphore_t *)storage);
+#else
+    return NULL;
+#endif
+}
+
 /// @brief 删除锁
 /// @param mutex 锁句柄
 ezos_status_t ezos_mutex_destroy(ezos_mutex_id_t mutex)
@@ -211,6 +364,22 @@ ezos_sem_id_t ezos_sem_create(uint32_t max_count, uint32_t initial_count)
     return xSemaphoreCreateCounting(max_count, initial_count);
 }
 
+/// @brief 使用调用者提供的存储创建信号量
+/// @return 成功，返回一个信号量，失败返回NULL
+ezos_sem_id_t ezos_sem_create_static(uint32_t max_count, uint32_t initial_count, ezos_sem_static_t *storage)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    if (storage == NULL || max_count == 0 || max_count < initial_count)
+    {
+        return NULL;
+    }
+
+    return xSemaphoreCreateCountingStatic(max_count, initial_count, (StaticSemaphore_t *)storage);
+#else
+    return NULL;
+#endif
+}
+
 /// @brief 删除信号量
 /// @param sem 信号量
 ezos_status_t ezos_sem_destroy(ezos_sem_id_t sem)
@@ -242,7 +411,11 @@ ezos_status_t ezos_sem_take(ezos_sem_id_t sem, uint32_t timeout)
     }
     else
     {
-        ret = xSemaphoreTake(sem, timeout);
+        uint64_t start = EZOS_PROF_WAIT_START();
+
+        ret = xSemaphoreTake(sem, ezos_ms_to_ticks(timeout));
+        if (ret && timeout != 0)
+            EZOS_PROF_WAIT_DONE(sem, start);
     }
     return ret ? EZOS_SUCCESS : EZOS_EBUZY;
 }
@@ -257,6 +430,8 @@ ezos_status_t ezos_sem_give(ezos_sem_id_t sem)
         return EZOS_EINVAL;
     }
 
+    // 先打时间戳，释放时等待者可能立即抢占
+    EZOS_PROF_WAKE(sem);
     if (ezos_irq_context())
     { // 判断是否处于中断
         ret = xSemaphoreGiveFromISR(sem, NULL);
@@ -265,7 +440,123 @@ ezos_status_t ezos_sem_give(ezos_sem_id_t sem)
     {
         ret = xSemaphoreGive(sem);
     }
-    return ret ? EZOS_SUCCESS : EZOS_EBUZY;
+    if (!ret)
+        return EZOS_EBUZY;
+    ezos_coro_obj_wake(sem);
+    return EZOS_SUCCESS;
+}
+
+//  ==== Event Flags Functions ====
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+// 中断中置位的后半段，在定时器任务中执行
+static void event_set_deferred(void *event, uint32_t bits)
+{
+    xEventGroupSetBits((EventGroupHandle_t)event, bits);
+    ezos_coro_obj_wake(event);
+}
+#endif
+
+ezos_event_id_t ezos_event_create(void)
+{
+    return xEventGroupCreate();
+}
+
+ezos_event_id_t ezos_event_create_static(ezos_event_static_t *storage)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    if (storage == NULL)
+        return NULL;
+    return xEventGroupCreateStatic((StaticEventGroup_t *)storage);
+#else
+    return NULL;
+#endif
+}
+
+ezos_status_t ezos_event_destroy(ezos_event_id_t event)
+{
+    if (event == NULL)
+        return EZOS_EINVAL;
+
+    vEventGroupDelete((EventGroupHandle_t)event);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_event_set(ezos_event_id_t event, uint32_t bits)
+{
+    if (event == NULL || (bits & ~EZOS_EVENT_BITS_MASK) != 0)
+        return EZOS_EINVAL;
+
+    EZOS_PROF_WAKE(event);
+    if (ezos_irq_context() != 0)
+    {
+#if (INCLUDE_xTimerPendFunctionCall == 1)
+        // 中断中置位由定时器任务代为完成，定时器命令队列满时失败。
+        // 不用xEventGroupSetBitsFromISR，它要求打开configUSE_TRACE_FACILITY，每个TCB和内核对象都会变大
+        BaseType_t yield = pdFALSE;
+        if (xTimerPendFunctionCallFromISR(event_set_deferred, event, bits, &yield) != pdPASS)
+            return EZOS_FAILURE;
+        portYIELD_FROM_ISR(yield);
+#else
+        return EZOS_ERRISR;
+#endif
+    }
+    else
+    {
+        xEventGroupSetBits((EventGroupHandle_t)event, bits);
+        ezos_coro_obj_wake(event);
+    }
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_event_clear(ezos_event_id_t event, uint32_t bits)
+{
+    if (event == NULL)
+        return EZOS_EINVAL;
+
+    if (ezos_irq_context() != 0)
+        return EZOS_ERRISR;
+
+    xEventGroupClearBits((EventGroupHandle_t)event, bits & EZOS_EVENT_BITS_MASK);
+    return EZOS_SUCCESS;
+}
+
+uint32_t ezos_event_get(ezos_event_id_t event)
+{
+    if (event == NULL)
+        return 0;
+
+    if (ezos_irq_context() != 0)
+        return xEventGroupGetBitsFromISR((EventGroupHandle_t)event);
+    return xEventGroupGetBits((EventGroupHandle_t)event);
+}
+
+ezos_status_t ezos_event_wait(ezos_event_id_t event, uint32_t bits, uint8_t options, uint32_t *out, uint32_t timeout)
+{
+    EventBits_t cur;
+    int match;
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    if (event == NULL || bits == 0 || (bits & ~EZOS_EVENT_BITS_MASK) != 0)
+        return EZOS_EINVAL;
+
+    if (ezos_irq_context() != 0)
+        return EZOS_ERRISR;
+
+    cur = xEventGroupWaitBits((EventGroupHandle_t)event, bits,
+                              (options & EZOS_EVENT_CLEAR) ? pdTRUE : pdFALSE,
+                              (options & EZOS_EVENT_WAIT_ALL) ? pdTRUE : pdFALSE,
+                              ezos_ms_to_ticks(timeout));
+    if (out != NULL)
+        *out = cur;
+
+    if (options & EZOS_EVENT_WAIT_ALL)
+        match = (cur & bits) == bits;
+    else
+        match = (cur & bits) != 0;
+    if (!match)
+        return EZOS_TIMEOUT;
+    EZOS_PROF_WAIT_DONE(event, start);
+    return EZOS_SUCCESS;
 }
 
 //  ==== Message Queue Management Functions====
@@ -278,6 +569,17 @@ ezos_queue_id_t ezos_queue_create(uint32_t msg_count, uint32_t msg_size)
     return queue_id;
 }
 
+ezos_queue_id_t ezos_queue_create_static(uint32_t msg_count, uint32_t msg_size, ezos_queue_static_t *storage, void *buf)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    if (msg_count == 0 || msg_size == 0 || storage == NULL || buf == NULL)
+        return NULL;
+    return xQueueCreateStatic(msg_count, msg_size, (uint8_t *)buf, (StaticQueue_t *)storage);
+#else
+    return NULL;
+#endif
+}
+
 void ezos_queue_destroy(ezos_queue_id_t queue)
 {
     vQueueDelete((QueueHandle_t)queue);
@@ -291,6 +593,7 @@ ezos_status_t ezos_queue_write(ezos_queue_id_t queue, void *msg_ptr, uint32_t ms
     if (queue_id == NULL || msg_ptr == NULL)
         return EZOS_EINVAL;
 
+    EZOS_PROF_WAKE(queue);
     if (ezos_irq_context() != 0)
     {
         BaseType_t yield = pdFALSE;
@@ -305,7 +608,7 @@ ezos_status_t ezos_queue_write(ezos_queue_id_t queue, void *msg_ptr, uint32_t ms
     }
     else
     {
-        if (xQueueSend(queue_id, msg_ptr, (TickType_t)timeout) != pdTRUE)
+        if (xQueueSend(queue_id, msg_ptr, ezos_ms_to_ticks(timeout)) != pdTRUE)
         {
             ret = EZOS_FAILURE;
             if (timeout != 0)
@@ -314,6 +617,8 @@ ezos_status_t ezos_queue_write(ezos_queue_id_t queue, void *msg_ptr, uint32_t ms
             }
         }
     }
+    if (ret == EZOS_SUCCESS)
+        ezos_coro_obj_wake(queue);
     return ret;
 }
 
@@ -339,7 +644,9 @@ ezos_status_t ezos_queue_read(ezos_queue_id_t queue, void *msg_ptr, uint32_t msg
     }
     else
     {
-        if (xQueueReceive(queue_id, msg_ptr, (TickType_t)timeout) != pdTRUE)
+        uint64_t start = EZOS_PROF_WAIT_START();
+
+        if (xQueueReceive(queue_id, msg_ptr, ezos_ms_to_ticks(timeout)) != pdTRUE)
         {
             ret = EZOS_FAILURE;
             if (timeout != 0)
@@ -347,7 +654,13 @@ ezos_status_t ezos_queue_read(ezos_queue_id_t queue, void *msg_ptr, uint32_t msg
                 ret = EZOS_TIMEOUT;
             }
         }
+        else if (timeout != 0)
+        {
+            EZOS_PROF_WAIT_DONE(queue, start);
+        }
     }
+    if (ret == EZOS_SUCCESS)
+        ezos_coro_obj_wake(queue);
     return ret;
 }
 
@@ -385,8 +698,19 @@ typedef struct tmr_adapter
     void *func_arg;
     ezos_timer_type_t type;
     ezos_timer_stat_t stat;
+    uint8_t is_static; // 存储由调用者提供，删除时不释放
 } timer_adapter_t;
 
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+typedef struct
+{
+    timer_adapter_t adapter;
+    StaticTimer_t timer;
+} timer_static_t;
+
+_Static_assert(sizeof(timer_static_t) <= sizeof(ezos_timer_static_t), "EZOS_TIMER_STATIC_SIZE too small");
+#endif
+
 static void tmr_adapt_cb(TimerHandle_t xTimer)
 {
     timer_adapter_t *timer = pvTimerGetTimerID(xTimer);
@@ -426,6 +750,7 @@ ezos_timer_id_t ezos_timer_create(ezos_thread_timer_cb cb, void *arg, int repeat
     tmr_adapter->func_arg = arg;
     tmr_adapter->type = type;
     tmr_adapter->stat = EZOS_TIMER_ST_INACTIVE;
+    tmr_adapter->is_static = 0;
 
     TimerHandle_t handle = xTimerCreate("Timer", 1, type, tmr_adapter, tmr_adapt_cb);
     if (handle != NULL)
@@ -440,6 +765,36 @@ ezos_timer_id_t ezos_timer_create(ezos_thread_timer_cb cb, void *arg, int repeat
     }
 }
 
+/// @brief 使用调用者提供的存储创建定时器
+/// @return 返回一个定时器，失败返回NULL
+ezos_timer_id_t ezos_timer_create_static(ezos_thread_timer_cb cb, void *arg, int repeat, ezos_timer_static_t *storage)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    timer_static_t *tmr = (timer_static_t *)storage;
+    ezos_timer_type_t type = repeat ? EZOS_TIMER_TYPE_PERIODIC : EZOS_TIMER_TYPE_ONCE;
+
+    if (storage == NULL)
+    {
+        return NULL;
+    }
+
+    tmr->adapter.func = cb;
+    tmr->adapter.func_arg = arg;
+    tmr->adapter.type = type;
+    tmr->adapter.stat = EZOS_TIMER_ST_INACTIVE;
+    tmr->adapter.is_static = 1;
+
+    tmr->adapter.timer = xTimerCreateStatic("Timer", 1, type, &tmr->adapter, tmr_adapt_cb, &tmr->timer);
+    if (tmr->adapter.timer == NULL)
+    {
+        return NULL;
+    }
+    return &tmr->adapter;
+#else
+    return NULL;
+#endif
+}
+
 /// @brief 删除定时器
 /// @param timer 定时器
 ezos_status_t ezos_timer_destroy(ezos_timer_id_t timer)
@@ -458,7 +813,10 @@ ezos_status_t ezos_timer_destroy(ezos_timer_id_t timer)
         return EZOS_EPERM;
     }
 
-    vPortFree(tmr_adapter);
+    if (!tmr_adapter->is_static)
+    {
+        vPortFree(tmr_adapter);
+    }
 
     return EZOS_SUCCESS;
 }
@@ -474,7 +832,17 @@ ezos_status_t ezos_timer_start(ezos_timer_id_t timer, uint32_t ms)
         return EZOS_EINVAL;
     }
     timer_adapter_t *tmr_adapter = timer;
-    int tmp = xTimerChangePeriod(tmr_adapter->timer, pdMS_TO_TICKS(ms), DONT_BLOCK);
+    int tmp;
+    if (ezos_irq_context() != 0)
+    {
+        BaseType_t yield = pdFALSE;
+        tmp = xTimerChangePeriodFromISR(tmr_adapter->timer, pdMS_TO_TICKS(ms), &yield);
+        portYIELD_FROM_ISR(yield);
+    }
+    else
+    {
+        tmp = xTimerChangePeriod(tmr_adapter->timer, pdMS_TO_TICKS(ms), DONT_BLOCK);
+    }
     if (tmp == pdTRUE)
     {
         tmr_adapter->stat = EZOS_TIMER_ST_ACTIVE;
@@ -497,7 +865,16 @@ ezos_status_t ezos_timer_stop(ezos_timer_id_t timer)
     }
     timer_adapter_t *tmr_adapter = timer;
     int tmp;
-    tmp = xTimerStop(tmr_adapter->timer, DONT_BLOCK);
+    if (ezos_irq_context() != 0)
+    {
+        BaseType_t yield = pdFALSE;
+        tmp = xTimerStopFromISR(tmr_adapter->timer, &yield);
+        portYIELD_FROM_ISR(yield);
+    }
+    else
+    {
+        tmp = xTimerStop(tmr_adapter->timer, DONT_BLOCK);
+    }
     if (tmp == 0)
     {
         return EZOS_ETIMEDOUT;
@@ -555,6 +932,46 @@ ezos_timer_stat_t ezos_timer_is_active(ezos_timer_id_t timer)
     return tmr_adapter->stat;
 }
 
+//  ==== Profiler Functions ====
+#if EZOS_PROF
+#if (configUSE_TRACE_FACILITY != 1)
+#error "EZOS_PROF需要打开CONFIG_FREERTOS_USE_TRACE_FACILITY"
+#endif
+
+uint16_t ezos_prof_tasks_snapshot(ezos_prof_task_t *tasks, uint16_t max, uint32_t *switches)
+{
+    UBaseType_t total = uxTaskGetNumberOfTasks();
+    TaskStatus_t *status;
+    UBaseType_t n;
+
+    // FreeRTOS没有对外的切换计数
+    *switches = 0;
+    if (max == 0)
+        return total;
+
+    // 多留两项，取数期间可能有新任务
+    status = ezos_malloc(sizeof(TaskStatus_t) * (total + 2));
+    if (status == NULL)
+        return 0;
+    n = uxTaskGetSystemState(status, total + 2, NULL);
+
+    for (UBaseType_t i = 0; i < n && i < max; i++)
+    {
+        memset(&tasks[i], 0, sizeof(ezos_prof_task_t));
+        tasks[i].id = status[i].xHandle;
+        strncpy(tasks[i].name, status[i].pcTaskName, sizeof(tasks[i].name) - 1);
+        tasks[i].priority = status[i].uxCurrentPriority;
+        tasks[i].stack_free_min = status[i].usStackHighWaterMark * sizeof(StackType_t);
+#if (configGENERATE_RUN_TIME_STATS == 1)
+        // 运行时间计数默认由esp_timer驱动，单位us
+        tasks[i].runtime_us = (uint32_t)status[i].ulRunTimeCounter;
+#endif
+    }
+    ezos_free(status);
+    return n;
+}
+#endif
+
 //  ==== system Management Functions====
 ezos_status_t ezos_init(void)
 {
@@ -607,20 +1024,63 @@ uint32_t ezos_tick_freq_get(void)
     return configTICK_RATE_HZ;
 }
 
+uint64_t ezos_time_us(void)
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+uint32_t ezos_cycles(void)
+{
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+uint32_t ezos_cycles_freq_get(void)
+{
+    return esp_rom_get_cpu_ticks_per_us() * 1000000;
+}
+
+void ezos_delay_us(uint32_t us)
+{
+    const uint32_t tick_us = 1000000 / configTICK_RATE_HZ;
+    uint64_t deadline;
+    uint8_t aligned = 0;
+
+    if (us < EZOS_DELAY_US_SPIN_MAX || us < tick_us || ezos_irq_context() != 0 ||
+        xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+    {
+        esp_rom_delay_us(us);
+        return;
+    }
+
+    // vTaskDelay(n)醒在之后第n个tick中断上。调用时不知道离下一个tick还有多远，先睡1个tick对齐到tick边界，
+    // 之后按剩余的整tick数睡，醒来时不超过截止时间；只要还剩一个tick就睡眠，最后不足一个tick的部分忙等
+    deadline = ezos_time_us() + us;
+    for (uint64_t now = ezos_time_us(); now + tick_us <= deadline; now = ezos_time_us())
+    {
+        vTaskDelay(aligned ? (TickType_t)((deadline - now) / tick_us) : 1);
+        aligned = 1;
+    }
+    while (ezos_time_us() < deadline)
+    {
+    }
+}
+
 void __attribute__((weak)) weak_ezos_puts(char *data)
 {
-    printf(data);
+    // data是格式化后的结果，可能含有%，不能再当格式串
+    fputs(data, stdout);
 }
 
+// 缓冲区在调用者栈上，多个任务同时打印互不覆盖
 void ezos_printf(const char *fmt, ...)
 {
-    static char _log_buf[DEBUG_PRINTF_MAX_SIZE];
-    memset(_log_buf, 0, DEBUG_PRINTF_MAX_SIZE);
+    char log_buf[DEBUG_PRINTF_MAX_SIZE];
     va_list args;
+
     va_start(args, fmt);
-    vsnprintf(_log_buf, DEBUG_PRINTF_MAX_SIZE, fmt, args);
+    vsnprintf(log_buf, DEBUG_PRINTF_MAX_SIZE, fmt, args);
     va_end(args);
-    weak_ezos_puts(_log_buf);
+    weak_ezos_puts(log_buf);
 }
 
 #endif // OSAL_USE_FREERTOS
\ No newline at end of file
@@ -0,0 +1,842 @@
+#include "ezos.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 本文件实现真正的函数，不使用ezos.h中的调用点宏
+#undef ezos_malloc
+#undef ezos_realloc
+#undef ezos_calloc
+
+/*
+ * ezos的内存接口统一走这里，malloc/realloc/calloc/free始终属于同一个堆。
+ *
+ * EZOS_HEAP_TLSF为1时使用两级分离适配(TLSF)堆，管理一块独立的静态内存：
+ *   一级按大小的最高位分桶，二级把每个一级区间再等分为TLSF_SL_COUNT份，
+ *   两级各有一个位图，查找空闲块只需要两次找最低置位，malloc/free都是O(1)；
+ *   释放时与物理相邻的空闲块立即合并；realloc能原地扩展时不拷贝。
+ * 块头只有一个size字(低两位为标志)，前一块的地址存放在前一块空闲时的最后一个字中。
+ *
+ * EZOS_HEAP_TLSF为0时直接使用libc的malloc族，ESP-IDF上统计取自heap_caps_get_info()。
+ */
+
+#if EZOS_HEAP_TLSF
+
+#define TLSF_ALIGN_LOG2 3
+#define TLSF_ALIGN (1u << TLSF_ALIGN_LOG2)
+#define TLSF_SL_LOG2 4
+#define TLSF_SL_COUNT (1u << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_FL_MAX 24 // 单块最大16MB
+#define TLSF_FL_COUNT (TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_SIZE (1u << TLSF_FL_SHIFT) // 小于该值的块线性映射到一级桶0
+
+#define BLOCK_FREE 0x1u
+#define BLOCK_PREV_FREE 0x2u
+#define BLOCK_FLAGS (BLOCK_FREE | BLOCK_PREV_FREE)
+
+typedef struct tlsf_block
+{
+    struct tlsf_block *prev_phys; // 物理上的前一块，只在前一块空闲时有效
+    size_t size;                  // 用户区大小 | 标志
+    struct tlsf_block *next_free; // 以下两项只在本块空闲时有效
+    struct tlsf_block *prev_free;
+} tlsf_block_t;
+
+#define BLOCK_OVERHEAD sizeof(size_t)
+#define BLOCK_START (offsetof(tlsf_block_t, size) + sizeof(size_t))
+#define BLOCK_SIZE_MIN (sizeof(tlsf_block_t) - sizeof(tlsf_block_t *))
+#define BLOCK_SIZE_MAX ((size_t)1 << TLSF_FL_MAX)
+
+_Static_assert(sizeof(size_t) * 8 >= TLSF_FL_MAX, "size_t too small for TLSF_FL_MAX");
+
+typedef struct
+{
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[TLSF_FL_COUNT];
+    tlsf_block_t *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    uint8_t ready;
+    size_t total;
+    size_t used;
+    size_t used_max;
+    uint32_t fails;
+} tlsf_t;
+
+static uint64_t g_heap_mem[EZOS_HEAP_SIZE / sizeof(uint64_t)];
+static tlsf_t g_tlsf;
+
+static int tlsf_fls(size_t size)
+{
+#if SIZE_MAX > 0xFFFFFFFFu
+    return 63 - __builtin_clzll((unsigned long long)size);
+#else
+    return 31 - __builtin_clz((unsigned int)size);
+#endif
+}
+
+static int tlsf_ffs(uint32_t word)
+{
+    return __builtin_ctz(word);
+}
+
+static size_t block_size(const tlsf_block_t *block)
+{
+    return block->size & ~(size_t)BLOCK_FLAGS;
+}
+
+static void block_set_size(tlsf_block_t *block, size_t size)
+{
+    block->size = size | (block->size & BLOCK_FLAGS);
+}
+
+static void *block_to_ptr(tlsf_block_t *block)
+{
+    return (uint8_t *)block + BLOCK_START;
+}
+
+static tlsf_block_t *block_from_ptr(void *ptr)
+{
+    return (tlsf_block_t *)((uint8_t *)ptr - BLOCK_START);
+}
+
+static tlsf_block_t *block_next(tlsf_block_t *block)
+{
+    return (tlsf_block_t *)((uint8_t *)block_to_ptr(block) + block_size(block) - BLOCK_OVERHEAD);
+}
+
+static tlsf_block_t *block_link_next(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_next(block);
+
+    next->prev_phys = block;
+    return next;
+}
+
+static void block_mark_as_free(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_link_next(block);
+
+    next->size |= BLOCK_PREV_FREE;
+    block->size |= BLOCK_FREE;
+}
+
+static void block_mark_as_used(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_next(block);
+
+    next->size &= ~(size_t)BLOCK_PREV_FREE;
+    block->size &= ~(size_t)BLOCK_FREE;
+}
+
+static void mapping_insert(size_t size, int *fl, int *sl)
+{
+    if (size < TLSF_SMALL_SIZE)
+    {
+        *fl = 0;
+        *sl = (int)(size / (TLSF_SMALL_SIZE / TLSF_SL_COUNT));
+    }
+    else
+    {
+        int f = tlsf_fls(size);
+
+        *sl = (int)((size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT);
+        *fl = f - (TLSF_FL_SHIFT - 1);
+    }
+}
+
+// 向上取整到下一个二级区间，保证取到的桶中任何一块都够用
+static void mapping_search(size_t size, int *fl, int *sl)
+{
+    if (size >= TLSF_SMALL_SIZE)
+        size += ((size_t)1 << (tlsf_fls(size) - TLSF_SL_LOG2)) - 1;
+    mapping_insert(size, fl, sl);
+}
+
+static tlsf_block_t *search_suitable_block(int *fl, int *sl)
+{
+    uint32_t sl_map = g_tlsf.sl_bitmap[*fl] & (~0u << *sl);
+
+    if (sl_map == 0)
+    {
+        uint32_t fl_map = (*fl + 1 >= TLSF_FL_COUNT) ? 0 : (g_tlsf.fl_bitmap & (~0u << (*fl + 1)));
+
+        if (fl_map == 0)
+            return NULL;
+        *fl = tlsf_ffs(fl_map);
+        sl_map = g_tlsf.sl_bitmap[*fl];
+    }
+    *sl = tlsf_ffs(sl_map);
+    return g_tlsf.blocks[*fl][*sl];
+}
+
+static void remove_free_block(tlsf_block_t *block, int fl, int sl)
+{
+    tlsf_block_t *prev = block->prev_free;
+    tlsf_block_t *next = block->next_free;
+
+    if (next != NULL)
+        next->prev_free = prev;
+    if (prev != NULL)
+        prev->next_free = next;
+
+    if (g_tlsf.blocks[fl][sl] == block)
+    {
+        g_tlsf.blocks[fl][sl] = next;
+        if (next == NULL)
+        {
+            g_tlsf.sl_bitmap[fl] &= ~(1u << sl);
+            if (g_tlsf.sl_bitmap[fl] == 0)
+                g_tlsf.fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+static void insert_free_block(tlsf_block_t *block, int fl, int sl)
+{
+    tlsf_block_t *cur = g_tlsf.blocks[fl][sl];
+
+    block->next_free = cur;
+    block->prev_free = NULL;
+    if (cur != NULL)
+        cur->prev_free = block;
+    g_tlsf.blocks[fl][sl] = block;
+    g_tlsf.fl_bitmap |= 1u << fl;
+    g_tlsf.sl_bitmap[fl] |= 1u << sl;
+}
+
+static void block_remove(tlsf_block_t *block)
+{
+    int fl, sl;
+
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(block, fl, sl);
+}
+
+static void block_insert(tlsf_block_t *block)
+{
+    int fl, sl;
+
+    mapping_insert(block_size(block), &fl, &sl);
+    insert_free_block(block, fl, sl);
+}
+
+static int block_can_split(tlsf_block_t *block, size_t size)
+{
+    return block_size(block) >= sizeof(tlsf_block_t) + size;
+}
+
+// 从block尾部切出剩余部分，返回剩余部分(已标记为空闲，未入链)
+static tlsf_block_t *block_split(tlsf_block_t *block, size_t size)
+{
+    tlsf_block_t *remaining = (tlsf_block_t *)((uint8_t *)block_to_ptr(block) + size - BLOCK_OVERHEAD);
+    size_t remain_size = block_size(block) - (size + BLOCK_OVERHEAD);
+
+    remaining->size = remain_size;
+    block_set_size(block, size);
+    block_mark_as_free(remaining);
+    return remaining;
+}
+
+static tlsf_block_t *block_absorb(tlsf_block_t *prev, tlsf_block_t *block)
+{
+    prev->size += block_size(block) + BLOCK_OVERHEAD;
+    block_link_next(prev);
+    return prev;
+}
+
+static tlsf_block_t *block_merge_prev(tlsf_block_t *block)
+{
+    if (block->size & BLOCK_PREV_FREE)
+    {
+        tlsf_block_t *prev = block->prev_phys;
+
+        block_remove(prev);
+        block = block_absorb(prev, block);
+    }
+    return block;
+}
+
+static tlsf_block_t *block_merge_next(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_next(block);
+
+    if (next->size & BLOCK_FREE)
+    {
+        block_remove(next);
+        block = block_absorb(block, next);
+    }
+    return block;
+}
+
+static void block_trim_free(tlsf_block_t *block, size_t size)
+{
+    if (block_can_split(block, size))
+    {
+        tlsf_block_t *remaining = block_split(block, size);
+
+        block_link_next(block);
+        remaining->size |= BLOCK_PREV_FREE;
+        block_insert(remaining);
+    }
+}
+
+static void block_trim_used(tlsf_block_t *block, size_t size)
+{
+    if (block_can_split(block, size))
+    {
+        tlsf_block_t *remaining = block_split(block, size);
+
+        remaining->size &= ~(size_t)BLOCK_PREV_FREE;
+        remaining = block_merge_next(remaining);
+        block_insert(remaining);
+    }
+}
+
+static size_t adjust_request(size_t size)
+{
+    size_t adjust;
+
+    if (size == 0 || size > BLOCK_SIZE_MAX)
+        return 0;
+
+    adjust = (size + TLSF_ALIGN - 1) & ~(size_t)(TLSF_ALIGN - 1);
+    return adjust < BLOCK_SIZE_MIN ? BLOCK_SIZE_MIN : adjust;
+}
+
+// 整块内存作为一个空闲块，末尾放一个大小为0的已用哨兵块
+static void tlsf_init(void)
+{
+    uint8_t *mem = (uint8_t *)g_heap_mem;
+    // 末尾留出一个完整块头给哨兵
+    size_t bytes = (sizeof(g_heap_mem) - BLOCK_START - (sizeof(tlsf_block_t) - BLOCK_OVERHEAD)) & ~(size_t)(TLSF_ALIGN - 1);
+    tlsf_block_t *block;
+    tlsf_block_t *next;
+
+    if (bytes > BLOCK_SIZE_MAX)
+        bytes = BLOCK_SIZE_MAX;
+
+    memset(&g_tlsf, 0, sizeof(g_tlsf));
+    block = (tlsf_block_t *)mem;
+    block->size = bytes | BLOCK_FREE;
+    block_insert(block);
+
+    next = block_link_next(block);
+    next->size = 0 | BLOCK_PREV_FREE;
+
+    g_tlsf.total = bytes;
+    g_tlsf.ready = 1;
+}
+
+static int tlsf_owns(void *ptr)
+{
+    return (uint8_t *)ptr >= (uint8_t *)g_heap_mem + BLOCK_START &&
+           (uint8_t *)ptr < (uint8_t *)g_heap_mem + sizeof(g_heap_mem);
+}
+
+// 以下三个函数在临界区内调用
+static void *tlsf_malloc_locked(size_t size)
+{
+    size_t adjust = adjust_request(size);
+    tlsf_block_t *block;
+    int fl, sl;
+
+    if (!g_tlsf.ready)
+        tlsf_init();
+    if (adjust == 0)
+        return NULL;
+
+    mapping_search(adjust, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT)
+    {
+        g_tlsf.fails++;
+        return NULL;
+    }
+    block = search_suitable_block(&fl, &sl);
+    if (block == NULL)
+    {
+        g_tlsf.fails++;
+        return NULL;
+    }
+
+    remove_free_block(block, fl, sl);
+    block_trim_free(block, adjust);
+    block_mark_as_used(block);
+
+    g_tlsf.used += block_size(block);
+    if (g_tlsf.used > g_tlsf.used_max)
+        g_tlsf.used_max = g_tlsf.used;
+    return block_to_ptr(block);
+}
+
+static void tlsf_free_locked(void *ptr)
+{
+    tlsf_block_t *block = block_from_ptr(ptr);
+
+    g_tlsf.used -= block_size(block);
+    block_mark_as_free(block);
+    block = block_merge_prev(block);
+    block = block_merge_next(block);
+    block_insert(block);
+}
+
+// 原地调整，成功返回ptr，需要搬移时返回NULL
+static void *tlsf_resize_locked(void *ptr, size_t size)
+{
+    tlsf_block_t *block = block_from_ptr(ptr);
+    tlsf_block_t *next = block_next(block);
+    size_t cur = block_size(block);
+    size_t adjust = adjust_request(size);
+
+    if (adjust == 0)
+        return NULL;
+    if (adjust > cur && (!(next->size & BLOCK_FREE) || adjust > cur + block_size(next) + BLOCK_OVERHEAD))
+        return NULL;
+
+    g_tlsf.used -= cur;
+    if (adjust > cur)
+    {
+        block_merge_next(block);
+        block_mark_as_used(block);
+    }
+    block_trim_used(block, adjust);
+
+    g_tlsf.used += block_size(block);
+    if (g_tlsf.used > g_tlsf.used_max)
+        g_tlsf.used_max = g_tlsf.used;
+    return ptr;
+}
+
+static void *heap_malloc(size_t size)
+{
+    void *ptr;
+
+    ezos_critical_enter();
+    ptr = tlsf_malloc_locked(size);
+    ezos_critical_exit();
+    return ptr;
+}
+
+static void heap_free(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    if (!tlsf_owns(ptr))
+    {
+        ezos_printf("ezos_free: %p is not from the ezos heap\r\n", ptr);
+        return;
+    }
+
+    ezos_critical_enter();
+    tlsf_free_locked(ptr);
+    ezos_critical_exit();
+}
+
+static void *heap_realloc(void *ptr, size_t size)
+{
+    void *new_ptr;
+    size_t cur;
+
+    if (ptr == NULL)
+        return heap_malloc(size);
+    if (size == 0)
+    {
+        heap_free(ptr);
+        return NULL;
+    }
+    if (!tlsf_owns(ptr))
+        return NULL;
+
+    ezos_critical_enter();
+    new_ptr = tlsf_resize_locked(ptr, size);
+    cur = block_size(block_from_ptr(ptr));
+    ezos_critical_exit();
+    if (new_ptr != NULL)
+        return new_ptr;
+
+    // 拷贝在临界区外进行
+    new_ptr = heap_malloc(size);
+    if (new_ptr == NULL)
+        return NULL;
+    memcpy(new_ptr, ptr, cur < size ? cur : size);
+    heap_free(ptr);
+    return new_ptr;
+}
+
+ezos_status_t ezos_heap_stat_get(ezos_heap_stat_t *stat)
+{
+    size_t free_total = 0;
+
+    if (stat == NULL)
+        return EZOS_EINVAL;
+
+    memset(stat, 0, sizeof(ezos_heap_stat_t));
+
+    // 遍历所有空闲链，只用于诊断，不是O(1)
+    ezos_critical_enter();
+    if (!g_tlsf.ready)
+        tlsf_init();
+    for (int fl = 0; fl < TLSF_FL_COUNT; fl++)
+    {
+        for (int sl = 0; sl < (int)TLSF_SL_COUNT; sl++)
+        {
+            for (tlsf_block_t *b = g_tlsf.blocks[fl][sl]; b != NULL; b = b->next_free)
+            {
+                size_t size = block_size(b);
+
+                free_total += size;
+                stat->free_blocks++;
+                if (size > stat->largest_free)
+                    stat->largest_free = size;
+            }
+        }
+    }
+    stat->total = g_tlsf.total;
+    stat->used = g_tlsf.used;
+    stat->used_max = g_tlsf.used_max;
+    stat->fails = g_tlsf.fails;
+    ezos_critical_exit();
+
+    stat->free = free_total;
+    if (free_total != 0)
+        stat->frag_pct = (uint8_t)(100 - (uint64_t)stat->largest_free * 100 / free_total);
+    return EZOS_SUCCESS;
+}
+
+#else
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+static uint32_t g_heap_fails = 0;
+
+static void *heap_malloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL && size != 0)
+        __atomic_fetch_add(&g_heap_fails, 1, __ATOMIC_RELAXED);
+    return p;
+}
+
+static void *heap_realloc(void *ptr, size_t size)
+{
+    void *p = realloc(ptr, size);
+
+    if (p == NULL && size != 0)
+        __atomic_fetch_add(&g_heap_fails, 1, __ATOMIC_RELAXED);
+    return p;
+}
+
+static void heap_free(void *ptr)
+{
+    free(ptr);
+}
+
+ezos_status_t ezos_heap_stat_get(ezos_heap_stat_t *stat)
+{
+#ifdef ESP_PLATFORM
+    multi_heap_info_t info;
+#endif
+
+    if (stat == NULL)
+        return EZOS_EINVAL;
+
+    memset(stat, 0, sizeof(ezos_heap_stat_t));
+    stat->fails = __atomic_load_n(&g_heap_fails, __ATOMIC_RELAXED);
+#ifdef ESP_PLATFORM
+    // malloc从MALLOC_CAP_DEFAULT的各个区域中分配，按这些区域汇总
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    stat->free = info.total_free_bytes;
+    stat->used = info.total_allocated_bytes;
+    stat->total = stat->free + stat->used;
+    stat->used_max = stat->total - info.minimum_free_bytes;
+    stat->largest_free = info.largest_free_block;
+    stat->free_blocks = info.free_blocks;
+    if (stat->free != 0)
+        stat->frag_pct = (uint8_t)(100 - (uint64_t)stat->largest_free * 100 / stat->free);
+    return EZOS_SUCCESS;
+#else
+    // 主机的libc堆不提供统计
+    return EZOS_EPERM;
+#endif
+}
+
+#endif // EZOS_HEAP_TLSF
+
+#if EZOS_HEAP_TRACE
+/*
+ * 调用点统计：每次分配前加一个8BYTE的头，记录大小和调用点编号，
+ * 调用点按(文件, 行号)哈希到EZOS_HEAP_TRACE_SITES个槽中，表满后计入最后一个槽。
+ * 统计在堆操作之外的短临界区中更新，只是几次加减。
+ */
+#define TRACE_MAGIC 0xE2A1u
+#define TRACE_SITE_OTHER (EZOS_HEAP_TRACE_SITES - 1)
+
+typedef struct
+{
+    uint32_t size;
+    uint16_t site;
+    uint16_t magic;
+} trace_hdr_t;
+
+_Static_assert(sizeof(trace_hdr_t) == 8, "trace header must keep 8-byte alignment");
+
+static ezos_heap_site_t g_sites[EZOS_HEAP_TRACE_SITES];
+
+static uint16_t trace_site_lookup(const char *file, uint16_t line)
+{
+    uint32_t h = ((uint32_t)(uintptr_t)file ^ ((uint32_t)line * 2654435761u)) % TRACE_SITE_OTHER;
+
+    for (uint16_t i = 0; i < TRACE_SITE_OTHER; i++)
+    {
+        ezos_heap_site_t *site = &g_sites[h];
+
+        if (site->file == file && site->line == line)
+            return h;
+        if (site->file == NULL)
+        {
+            site->file = file;
+            site->line = line;
+            return h;
+        }
+        h = (h + 1) % TRACE_SITE_OTHER;
+    }
+    // 表满后的调用点合并到最后一项，没有单一的文件和行号
+    if (g_sites[TRACE_SITE_OTHER].file == NULL)
+    {
+        g_sites[TRACE_SITE_OTHER].file = "?";
+        g_sites[TRACE_SITE_OTHER].line = 0;
+    }
+    return TRACE_SITE_OTHER;
+}
+
+static void trace_account(uint16_t idx, int32_t bytes, int16_t count)
+{
+    ezos_heap_site_t *site = &g_sites[idx];
+
+    site->live_bytes += bytes;
+    site->live_count += count;
+    if (site->live_bytes > site->peak_bytes)
+        site->peak_bytes = site->live_bytes;
+}
+
+static void *trace_attach(trace_hdr_t *hdr, uint32_t size, const char *file, uint16_t line)
+{
+    if (hdr == NULL)
+        return NULL;
+
+    ezos_critical_enter();
+    hdr->size = size;
+    hdr->site = trace_site_lookup(file, line);
+    hdr->magic = TRACE_MAGIC;
+    trace_account(hdr->site, (int32_t)size, 1);
+    g_sites[hdr->site].allocs++;
+    ezos_critical_exit();
+    return hdr + 1;
+}
+
+static trace_hdr_t *trace_detach(void *ptr)
+{
+    trace_hdr_t *hdr = (trace_hdr_t *)ptr - 1;
+
+    if (hdr->magic != TRACE_MAGIC)
+    {
+        ezos_printf("ezos_free: %p has no trace header\r\n", ptr);
+        return NULL;
+    }
+
+    ezos_critical_enter();
+    trace_account(hdr->site, -(int32_t)hdr->size, -1);
+    hdr->magic = 0;
+    ezos_critical_exit();
+    return hdr;
+}
+
+void *ezos_malloc_trace(uint32_t size, const char *file, uint16_t line)
+{
+    if (size > UINT32_MAX - sizeof(trace_hdr_t))
+        return NULL;
+    return trace_attach(heap_malloc(sizeof(trace_hdr_t) + size), size, file, line);
+}
+
+void *ezos_calloc_trace(uint32_t nitems, size_t size, const char *file, uint16_t line)
+{
+    void *ptr;
+
+    if (size != 0 && nitems > (UINT32_MAX - sizeof(trace_hdr_t)) / size)
+        return NULL;
+
+    ptr = ezos_malloc_trace(nitems * size, file, line);
+    if (ptr != NULL)
+        memset(ptr, 0, nitems * size);
+    return ptr;
+}
+
+void *ezos_realloc_trace(void *ptr, uint32_t size, const char *file, uint16_t line)
+{
+    trace_hdr_t *hdr;
+    trace_hdr_t *new_hdr;
+
+    if (ptr == NULL)
+        return ezos_malloc_trace(size, file, line);
+    if (size == 0)
+    {
+        ezos_free(ptr);
+        return NULL;
+    }
+    if (size > UINT32_MAX - sizeof(trace_hdr_t))
+        return NULL;
+
+    hdr = trace_detach(ptr);
+    if (hdr == NULL)
+        return NULL;
+
+    new_hdr = heap_realloc(hdr, sizeof(trace_hdr_t) + size);
+    if (new_hdr == NULL)
+    {
+        // 原块仍然有效，恢复原来的记账
+        ezos_critical_enter();
+        hdr->magic = TRACE_MAGIC;
+        trace_account(hdr->site, (int32_t)hdr->size, 1);
+        ezos_critical_exit();
+        return NULL;
+    }
+    return trace_attach(new_hdr, size, file, line);
+}
+
+void *ezos_malloc(uint32_t size)
+{
+    return ezos_malloc_trace(size, "?", 0);
+}
+
+void *ezos_realloc(void *ptr, uint32_t size)
+{
+    return ezos_realloc_trace(ptr, size, "?", 0);
+}
+
+void *ezos_calloc(uint32_t nitems, size_t size)
+{
+    return ezos_calloc_trace(nitems, size, "?", 0);
+}
+
+void ezos_free(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+    heap_free(trace_detach(ptr));
+}
+
+uint16_t ezos_heap_trace_get(ezos_heap_site_t *sites, uint16_t max)
+{
+    uint16_t n = 0;
+
+    ezos_critical_enter();
+    for (uint16_t i = 0; i < EZOS_HEAP_TRACE_SITES && n < max; i++)
+    {
+        if (g_sites[i].allocs != 0)
+            sites[n++] = g_sites[i];
+    }
+    ezos_critical_exit();
+    return n;
+}
+
+#else
+
+void *ezos_malloc(uint32_t size)
+{
+    return heap_malloc(size);
+}
+
+void *ezos_realloc(void *ptr, uint32_t size)
+{
+    return heap_realloc(ptr, size);
+}
+
+void *ezos_calloc(uint32_t nitems, size_t size)
+{
+    void *ptr;
+
+    if (size != 0 && nitems > SIZE_MAX / size)
+        return NULL;
+
+    ptr = heap_malloc(nitems * size);
+    if (ptr != NULL)
+        memset(ptr, 0, nitems * size);
+    return ptr;
+}
+
+void ezos_free(void *ptr)
+{
+    heap_free(ptr);
+}
+
+void *ezos_malloc_trace(uint32_t size, const char *file, uint16_t line)
+{
+    (void)file;
+    (void)line;
+    return ezos_malloc(size);
+}
+
+void *ezos_realloc_trace(void *ptr, uint32_t size, const char *file, uint16_t line)
+{
+    (void)file;
+    (void)line;
+    return ezos_realloc(ptr, size);
+}
+
+void *ezos_calloc_trace(uint32_t nitems, size_t size, const char *file, uint16_t line)
+{
+    (void)file;
+    (void)line;
+    return ezos_calloc(nitems, size);
+}
+
+uint16_t ezos_heap_trace_get(ezos_heap_site_t *sites, uint16_t max)
+{
+    (void)sites;
+    (void)max;
+    return 0;
+}
+
+#endif // EZOS_HEAP_TRACE
+
+#if EZOS_HEAP_TRACE
+static const char *heap_basename(const char *file)
+{
+    const char *p;
+
+    if (file == NULL)
+        return "?";
+    p = strrchr(file, '/');
+
+    return p != NULL ? p + 1 : file;
+}
+#endif
+
+void ezos_heap_dump(void)
+{
+    ezos_heap_stat_t stat;
+#if EZOS_HEAP_TRACE
+    // 调用点表有EZOS_HEAP_TRACE_SITES * 20BYTE，不放在调用者的栈上
+    static ezos_heap_site_t sites[EZOS_HEAP_TRACE_SITES];
+    uint16_t n;
+#endif
+
+    if (ezos_heap_stat_get(&stat) == EZOS_SUCCESS)
+    {
+        ezos_printf("heap total=%u used=%u peak=%u free=%u largest=%u blocks=%u frag=%u%% fails=%u\r\n",
+                    (unsigned)stat.total, (unsigned)stat.used, (unsigned)stat.used_max, (unsigned)stat.free,
+                    (unsigned)stat.largest_free, (unsigned)stat.free_blocks, stat.frag_pct, (unsigned)stat.fails);
+    }
+
+#if EZOS_HEAP_TRACE
+    n = ezos_heap_trace_get(sites, EZOS_HEAP_TRACE_SITES);
+    for (uint16_t i = 0; i < n; i++)
+    {
+        ezos_printf("  %s:%u live=%u/%u peak=%u allocs=%u\r\n", heap_basename(sites[i].file), sites[i].line,
+                    (unsigned)sites[i].live_bytes, sites[i].live_count, (unsigned)sites[i].peak_bytes,
+                    (unsigned)sites[i].allocs);
+    }
+#endif
+}
@@ -0,0 +1,188 @@
+#include "ezos.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * 多写者单读者的无锁环形缓冲区，每个槽带一个序号：
+ *   写者读到写位置pos，槽的序号等于pos所在圈的起点时表示空闲，用CAS把写位置推进到pos+1占住这个槽，
+ *   填好记录后把序号置为起点+1表示可读；序号小于起点说明上一圈的记录还没被取走，缓冲区已满。
+ *   读者看到序号为起点+1时取走记录，再把序号置为下一圈的起点。
+ * 写者之间、写者与读者之间都不加锁，中断打断正在写的任务时抢到的是另一个槽；
+ * 读者遇到还没写完的槽就停下，下一轮再取。
+ */
+
+#define LOG_MASK (EZOS_LOG_SLOTS - 1)
+
+_Static_assert((EZOS_LOG_SLOTS & LOG_MASK) == 0, "EZOS_LOG_SLOTS must be a power of 2");
+_Static_assert(EZOS_LOG_MAX_ARGS <= 6, "EZOS_LOG_A* macros handle at most 6 args");
+
+typedef struct
+{
+    uint32_t seq;
+    ezos_log_rec_t rec;
+} log_slot_t;
+
+static log_slot_t g_log_slots[EZOS_LOG_SLOTS];
+static uint32_t g_log_wr = 0;
+static uint32_t g_log_rd = 0;
+static uint32_t g_log_written = 0;
+static uint32_t g_log_dropped = 0;
+static ezos_thread_id_t g_log_task = NULL;
+EZOS_THREAD_STATIC_DEFINE(g_log_thread, EZOS_LOG_STACK_SIZE);
+
+void weak_ezos_puts(char *data);
+
+void ezos_log_write(uint8_t level, const char *tag, const char *fmt, uint8_t nargs, ...)
+{
+    uint32_t pos = __atomic_load_n(&g_log_wr, __ATOMIC_RELAXED);
+    log_slot_t *slot;
+    va_list args;
+
+    for (;;)
+    {
+        int32_t diff;
+
+        slot = &g_log_slots[pos & LOG_MASK];
+        diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos & ~LOG_MASK));
+        if (diff == 0)
+        {
+            // 失败时pos被更新为最新的写位置
+            if (__atomic_compare_exchange_n(&g_log_wr, &pos, pos + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+        {
+            __atomic_fetch_add(&g_log_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else
+        {
+            pos = __atomic_load_n(&g_log_wr, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->rec.tag = tag;
+    slot->rec.fmt = fmt;
+    slot->rec.time_ms = (uint32_t)(ezos_time_us() / 1000);
+    slot->rec.level = level;
+    slot->rec.nargs = nargs < EZOS_LOG_MAX_ARGS ? nargs : EZOS_LOG_MAX_ARGS;
+    va_start(args, nargs);
+    for (uint8_t i = 0; i < slot->rec.nargs; i++)
+    {
+        slot->rec.args[i] = va_arg(args, uintptr_t);
+    }
+    va_end(args);
+    __atomic_store_n(&slot->seq, (pos & ~LOG_MASK) + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&g_log_written, 1, __ATOMIC_RELAXED);
+
+    // 用掉半个缓冲区时叫醒日志任务，平时由它定时来取，写日志不用每次都通知
+    if (((pos + 1) & (LOG_MASK >> 1)) == 0 && g_log_task != NULL)
+        ezos_notify_give(g_log_task);
+}
+
+ezos_status_t ezos_log_read(ezos_log_rec_t *rec)
+{
+    uint32_t pos = g_log_rd;
+    log_slot_t *slot = &g_log_slots[pos & LOG_MASK];
+
+    if (rec == NULL)
+        return EZOS_EINVAL;
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != (pos & ~LOG_MASK) + 1)
+        return EZOS_FAILURE;
+
+    memcpy(rec, &slot->rec, sizeof(ezos_log_rec_t));
+    __atomic_store_n(&slot->seq, (pos & ~LOG_MASK) + EZOS_LOG_SLOTS, __ATOMIC_RELEASE);
+    g_log_rd = pos + 1;
+    return EZOS_SUCCESS;
+}
+
+uint32_t ezos_log_format(const ezos_log_rec_t *rec, char *buf, uint32_t len)
+{
+    static const char levels[] = "NEWID";
+    uintptr_t a[6] = {0};
+    uint32_t n;
+    int ret;
+
+    if (rec == NULL || buf == NULL || len < 3)
+        return 0;
+
+    // 格式串用不到的参数传0，多传的参数printf不会读
+    memcpy(a, rec->args, sizeof(uintptr_t) * (rec->nargs < EZOS_LOG_MAX_ARGS ? rec->nargs : EZOS_LOG_MAX_ARGS));
+
+    // 留出\r\n的位置
+    len -= 2;
+    ret = snprintf(buf, len, "%c (%u) %s: ", levels[rec->level < sizeof(levels) - 1 ? rec->level : 0],
+                   (unsigned)rec->time_ms, rec->tag != NULL ? rec->tag : "");
+    n = ret < 0 ? 0 : ((uint32_t)ret < len ? (uint32_t)ret : len - 1);
+    if (rec->fmt != NULL)
+    {
+        ret = snprintf(&buf[n], len - n, rec->fmt, a[0], a[1], a[2], a[3], a[4], a[5]);
+        n += ret < 0 ? 0 : ((uint32_t)ret < len - n ? (uint32_t)ret : len - n - 1);
+    }
+    buf[n++] = '\r';
+    buf[n++] = '\n';
+    buf[n] = '\0';
+    return n;
+}
+
+static void log_task(void *arg)
+{
+    char line[DEBUG_PRINTF_MAX_SIZE + 2];
+    ezos_log_rec_t rec;
+    uint32_t dropped = 0;
+
+    (void)arg;
+    for (;;)
+    {
+        uint32_t now_dropped;
+
+        while (ezos_log_read(&rec) == EZOS_SUCCESS)
+        {
+            ezos_log_format(&rec, line, sizeof(line));
+            weak_ezos_puts(line);
+        }
+
+        now_dropped = __atomic_load_n(&g_log_dropped, __ATOMIC_RELAXED);
+        if (now_dropped != dropped)
+        {
+            snprintf(line, sizeof(line), "W (%u) ezos_log: dropped %u\r\n", (unsigned)(ezos_time_us() / 1000),
+                     (unsigned)(now_dropped - dropped));
+            weak_ezos_puts(line);
+            dropped = now_dropped;
+        }
+
+        ezos_notify_take(1, NULL, EZOS_LOG_FLUSH_MS);
+    }
+}
+
+ezos_status_t ezos_log_init(void)
+{
+    ezos_thread_params_t param = {
+        .thread_name = "ezos_log",
+        .priority = EZOS_LOG_PRIORITY,
+        .stack_size = EZOS_LOG_STACK_SIZE,
+    };
+
+    if (g_log_task != NULL)
+        return EZOS_SUCCESS;
+
+    g_log_task = EZOS_THREAD_CREATE_STATIC(g_log_thread, log_task, &param);
+    return g_log_task != NULL ? EZOS_SUCCESS : EZOS_FAILURE;
+}
+
+void ezos_log_flush(void)
+{
+    if (g_log_task != NULL)
+        ezos_notify_give(g_log_task);
+}
+
+void ezos_log_stat_get(ezos_log_stat_t *stat)
+{
+    if (stat == NULL)
+        return;
+
+    stat->written = __atomic_load_n(&g_log_written, __ATOMIC_RELAXED);
+    stat->dropped = __atomic_load_n(&g_log_dropped, __ATOMIC_RELAXED);
+}
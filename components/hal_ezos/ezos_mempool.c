@@ -0,0 +1,226 @@
+#include "ezos.h"
+
+#include <string.h>
+
+/*
+ * 定长块内存池：空闲块串成单链表，next指针存放在空闲块自身，分配和释放都是O(1)。
+ * 链表操作在ezos_critical_enter/exit内完成，中断中也可以调用。
+ *
+ * 调试模式下每块的布局：
+ *   头保护(8BYTE：状态字 + 保护字) | 用户数据 | 尾保护(8BYTE)
+ * 状态字区分已分配/空闲，用于识别重复释放；保护字被改写说明相邻块越界写。
+ * 释放可能在中断中，检查到的错误只计数并记下块序号，由ezos_mempool_stat_get()在任务中取出。
+ */
+
+#define MEMPOOL_MAGIC_USED 0xA5A5C0DEu
+#define MEMPOOL_MAGIC_FREE 0x5A5AF4EEu
+#define MEMPOOL_GUARD 0xDEADBEEFu
+
+typedef struct
+{
+    void *free_list;
+    uint8_t *base;
+    uint32_t block_size; // 含保护字
+    uint32_t user_size;
+    uint32_t total;
+#if EZOS_MEMPOOL_STATS
+    uint32_t used;
+    uint32_t used_max;
+    uint32_t fails;
+#endif
+#if EZOS_MEMPOOL_DEBUG
+    uint32_t double_frees;
+    uint32_t corrupts;
+    int32_t bad_block;
+#endif
+    uint8_t is_static;
+} mempool_t;
+
+_Static_assert(sizeof(mempool_t) <= sizeof(ezos_mempool_static_t), "EZOS_MEMPOOL_STATIC_SIZE too small");
+
+#if EZOS_MEMPOOL_DEBUG
+static uint32_t *mempool_head(mempool_t *pool, uint8_t *user)
+{
+    (void)pool;
+    return (uint32_t *)(user - EZOS_MEMPOOL_GUARD_SIZE);
+}
+
+static uint32_t *mempool_tail(mempool_t *pool, uint8_t *user)
+{
+    return (uint32_t *)(user + pool->user_size);
+}
+#endif
+
+static void mempool_init(mempool_t *pool, uint32_t block_size, uint32_t block_count, uint8_t *buf)
+{
+    memset(pool, 0, sizeof(mempool_t));
+    pool->base = buf;
+    pool->block_size = EZOS_MEMPOOL_BLOCK_SIZE(block_size);
+    pool->user_size = pool->block_size - 2 * EZOS_MEMPOOL_GUARD_SIZE;
+    pool->total = block_count;
+#if EZOS_MEMPOOL_DEBUG
+    pool->bad_block = -1;
+#endif
+
+    // 倒序入链，分配从低地址开始
+    for (uint32_t i = block_count; i > 0; i--)
+    {
+        uint8_t *user = buf + (i - 1) * pool->block_size + EZOS_MEMPOOL_GUARD_SIZE;
+
+#if EZOS_MEMPOOL_DEBUG
+        mempool_head(pool, user)[0] = MEMPOOL_MAGIC_FREE;
+        mempool_head(pool, user)[1] = MEMPOOL_GUARD;
+        mempool_tail(pool, user)[0] = MEMPOOL_GUARD;
+#endif
+        *(void **)user = pool->free_list;
+        pool->free_list = user;
+    }
+}
+
+ezos_mempool_id_t ezos_mempool_create(uint32_t block_size, uint32_t block_count)
+{
+    mempool_t *pool;
+    uint8_t *buf;
+
+    if (block_size == 0 || block_count == 0)
+        return NULL;
+
+    pool = ezos_malloc(sizeof(mempool_t));
+    if (pool == NULL)
+        return NULL;
+
+    buf = ezos_malloc(EZOS_MEMPOOL_BUF_SIZE(block_size, block_count));
+    if (buf == NULL)
+    {
+        ezos_free(pool);
+        return NULL;
+    }
+
+    mempool_init(pool, block_size, block_count, buf);
+    return pool;
+}
+
+ezos_mempool_id_t ezos_mempool_create_static(uint32_t block_size, uint32_t block_count,
+                                             ezos_mempool_static_t *storage, void *buf)
+{
+    mempool_t *pool = (mempool_t *)storage;
+
+    if (block_size == 0 || block_count == 0 || storage == NULL || buf == NULL)
+        return NULL;
+    if (((uintptr_t)buf & (EZOS_MEMPOOL_ALIGN - 1)) != 0)
+        return NULL;
+
+    mempool_init(pool, block_size, block_count, buf);
+    pool->is_static = 1;
+    return pool;
+}
+
+void ezos_mempool_destroy(ezos_mempool_id_t pool)
+{
+    mempool_t *p = pool;
+
+    if (p == NULL || p->is_static)
+        return;
+
+    ezos_free(p->base);
+    ezos_free(p);
+}
+
+void *ezos_mempool_alloc(ezos_mempool_id_t pool)
+{
+    mempool_t *p = pool;
+    uint8_t *user;
+
+    if (p == NULL)
+        return NULL;
+
+    ezos_critical_enter();
+    user = p->free_list;
+    if (user == NULL)
+    {
+#if EZOS_MEMPOOL_STATS
+        p->fails++;
+#endif
+        ezos_critical_exit();
+        return NULL;
+    }
+    p->free_list = *(void **)user;
+#if EZOS_MEMPOOL_STATS
+    p->used++;
+    if (p->used > p->used_max)
+        p->used_max = p->used;
+#endif
+#if EZOS_MEMPOOL_DEBUG
+    mempool_head(p, user)[0] = MEMPOOL_MAGIC_USED;
+#endif
+    ezos_critical_exit();
+    return user;
+}
+
+ezos_status_t ezos_mempool_free(ezos_mempool_id_t pool, void *ptr)
+{
+    mempool_t *p = pool;
+    uint8_t *user = ptr;
+    uintptr_t offset;
+
+    if (p == NULL || user == NULL)
+        return EZOS_EINVAL;
+
+    offset = (uintptr_t)(user - EZOS_MEMPOOL_GUARD_SIZE) - (uintptr_t)p->base;
+    if ((uintptr_t)user < (uintptr_t)p->base + EZOS_MEMPOOL_GUARD_SIZE ||
+        offset >= (uintptr_t)p->block_size * p->total || offset % p->block_size != 0)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+#if EZOS_MEMPOOL_DEBUG
+    {
+        uint32_t *head = mempool_head(p, user);
+        uint32_t magic = head[0];
+
+        if (magic != MEMPOOL_MAGIC_USED || head[1] != MEMPOOL_GUARD || mempool_tail(p, user)[0] != MEMPOOL_GUARD)
+        {
+            if (magic == MEMPOOL_MAGIC_FREE)
+                p->double_frees++;
+            else
+                p->corrupts++;
+            p->bad_block = (int32_t)(offset / p->block_size);
+            ezos_critical_exit();
+            return EZOS_FAILURE;
+        }
+        head[0] = MEMPOOL_MAGIC_FREE;
+    }
+#endif
+    *(void **)user = p->free_list;
+    p->free_list = user;
+#if EZOS_MEMPOOL_STATS
+    p->used--;
+#endif
+    ezos_critical_exit();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_mempool_stat_get(ezos_mempool_id_t pool, ezos_mempool_stat_t *stat)
+{
+    mempool_t *p = pool;
+
+    if (p == NULL || stat == NULL)
+        return EZOS_EINVAL;
+
+    memset(stat, 0, sizeof(ezos_mempool_stat_t));
+    stat->block_size = p->user_size;
+    stat->total = p->total;
+    stat->bad_block = -1;
+    ezos_critical_enter();
+#if EZOS_MEMPOOL_STATS
+    stat->used = p->used;
+    stat->used_max = p->used_max;
+    stat->fails = p->fails;
+#endif
+#if EZOS_MEMPOOL_DEBUG
+    stat->double_frees = p->double_frees;
+    stat->corrupts = p->corrupts;
+    stat->bad_block = p->bad_block;
+#endif
+    ezos_critical_exit();
+    return EZOS_SUCCESS;
+}
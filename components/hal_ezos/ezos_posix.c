@@ -0,0 +1,1702 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "ezos.h"
+#include "ezos_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+/*
+ * 主机(Linux/POSIX)后端
+ *
+ * 所有ezos对象的状态由一把内核锁保护，相当于单核FreeRTOS的临界区；
+ * 任务阻塞统一经过posix_wait()，由等待队列唤醒或到达截止时间返回。
+ * tick为1ms，超时参数按毫秒处理。
+ * 栈大小在主机上不生效，任务使用pthread默认属性。
+ *
+ * 仿真模式(ezos_sim_enable)：同一时刻只有一个任务在运行，任务在阻塞点切换，
+ * 唤醒更高优先级的任务时当前任务在离开ezos调用前让出；所有任务都阻塞时虚拟
+ * 时钟直接跳到最近的截止时间。调度顺序只取决于程序本身，结果可重复。
+ * 非仿真模式下优先级不生效。
+ */
+
+#define POSIX_FOREVER UINT64_MAX
+
+// 定时器任务优先级，与ESP-IDF默认的定时器服务任务一致取低优先级
+#define POSIX_TIMER_TASK_PRIORITY 1
+
+enum
+{
+    SIM_READY,
+    SIM_RUNNING,
+    SIM_BLOCKED,
+};
+
+struct posix_thread;
+
+typedef struct
+{
+    pthread_cond_t cond;
+    struct posix_thread *head; // 仿真模式下的等待者，先进先出
+    struct posix_thread *tail;
+} posix_waitq_t;
+
+typedef struct posix_thread
+{
+    pthread_t tid;
+    ezos_thread_func_cb func;
+    void *arg;
+    char name[16];
+    uint8_t suspended;
+    uint8_t is_static; // 存储由调用者提供，退出时不释放
+    posix_waitq_t resume;
+
+    // 任务通知
+    uint32_t notify;
+    uint8_t notify_pending;
+    posix_waitq_t notify_wq;
+
+    // 仿真调度状态
+    pthread_cond_t run;
+    uint8_t state;
+    uint8_t prio;
+    uint8_t timed_out;
+    uint8_t killed;
+    uint32_t seq;
+    uint64_t deadline;
+    posix_waitq_t *waitq;
+    struct posix_thread *wq_next;
+    struct posix_thread *ready_next;
+    struct posix_thread *all_next;
+} posix_thread_t;
+
+typedef struct
+{
+    uint8_t locked;
+    uint8_t is_static;
+    posix_waitq_t wq;
+} posix_mutex_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t max;
+    uint8_t is_static;
+    posix_waitq_t wq;
+} posix_sem_t;
+
+typedef struct
+{
+    uint32_t bits;
+    uint8_t is_static;
+    posix_waitq_t wq;
+} posix_event_t;
+
+typedef struct
+{
+    uint8_t *buf;
+    uint8_t is_static;
+    uint32_t msg_size;
+    uint32_t cap;
+    uint32_t head;
+    uint32_t count;
+    posix_waitq_t wq_data;  // 等待消息的读者
+    posix_waitq_t wq_space; // 等待空间的写者
+} posix_queue_t;
+
+typedef struct posix_timer
+{
+    ezos_thread_timer_cb func;
+    void *arg;
+    ezos_timer_type_t type;
+    ezos_timer_stat_t stat;
+    uint8_t dead; // 回调中被删除，回调返回后释放
+    uint8_t is_static;
+    uint32_t period;
+    uint64_t expire;
+    struct posix_timer *next;
+} posix_timer_t;
+
+_Static_assert(sizeof(posix_thread_t) <= sizeof(ezos_thread_static_t), "EZOS_THREAD_STATIC_SIZE too small");
+_Static_assert(sizeof(posix_mutex_t) <= sizeof(ezos_mutex_static_t), "EZOS_MUTEX_STATIC_SIZE too small");
+_Static_assert(sizeof(posix_sem_t) <= sizeof(ezos_sem_static_t), "EZOS_SEM_STATIC_SIZE too small");
+_Static_assert(sizeof(posix_queue_t) <= sizeof(ezos_queue_static_t), "EZOS_QUEUE_STATIC_SIZE too small");
+_Static_assert(sizeof(posix_timer_t) <= sizeof(ezos_timer_static_t), "EZOS_TIMER_STATIC_SIZE too small");
+_Static_assert(sizeof(posix_event_t) <= sizeof(ezos_event_static_t), "EZOS_EVENT_STATIC_SIZE too small");
+
+static pthread_mutex_t g_kernel = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+static pthread_condattr_t g_condattr;
+static struct timespec g_boot;
+
+static __thread posix_thread_t *t_self = NULL;
+
+// 不是由ezos创建的线程(如main)第一次用到任务通知时，在这里登记
+static __thread posix_thread_t t_adopted;
+
+// 延时专用的等待队列，没有人唤醒，只等截止时间
+static posix_waitq_t g_sleep_wq;
+
+// 按到期时间排序的激活定时器
+static posix_timer_t *g_timers = NULL;
+static posix_timer_t *g_timer_running = NULL;
+static posix_waitq_t g_timer_wq;
+static posix_waitq_t g_timer_done_wq;
+static posix_thread_t *g_timer_thread = NULL;
+static uint8_t g_timer_started = 0;
+
+// 所有ezos任务，仿真模式下还有主线程
+static posix_thread_t *g_threads = NULL;
+
+static uint8_t g_sim = 0;
+static uint8_t g_sim_preempt = 0;
+static uint64_t g_sim_now = 0;
+static uint32_t g_sim_seq = 0;
+static posix_thread_t *g_sim_current = NULL;
+static posix_thread_t *g_sim_ready = NULL; // 按优先级从高到低，同优先级先进先出
+
+static void sim_yield_locked(posix_thread_t *self);
+
+//  ==== 内核锁与等待 ====
+static void posix_waitq_init(posix_waitq_t *wq)
+{
+    pthread_cond_init(&wq->cond, &g_condattr);
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+static void posix_waitq_destroy(posix_waitq_t *wq)
+{
+    pthread_cond_destroy(&wq->cond);
+}
+
+static void posix_init_once(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &g_boot);
+    pthread_condattr_init(&g_condattr);
+    pthread_condattr_setclock(&g_condattr, CLOCK_MONOTONIC);
+    posix_waitq_init(&g_sleep_wq);
+    posix_waitq_init(&g_timer_wq);
+    posix_waitq_init(&g_timer_done_wq);
+}
+
+static void posix_lock(void)
+{
+    pthread_once(&g_once, posix_init_once);
+    pthread_mutex_lock(&g_kernel);
+}
+
+// 仿真模式下本次调用唤醒了更高优先级的任务，离开前让出
+static void posix_unlock(void)
+{
+    if (g_sim_preempt && t_self != NULL && t_self == g_sim_current)
+    {
+        g_sim_preempt = 0;
+        sim_yield_locked(t_self);
+    }
+    pthread_mutex_unlock(&g_kernel);
+}
+
+static void posix_unlock_cleanup(void *arg)
+{
+    (void)arg;
+    pthread_mutex_unlock(&g_kernel);
+}
+
+static uint64_t posix_now_ms(void)
+{
+    struct timespec now;
+
+    if (g_sim)
+        return g_sim_now;
+
+    pthread_once(&g_once, posix_init_once);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - g_boot.tv_sec) * 1000 + (now.tv_nsec - g_boot.tv_nsec) / 1000000;
+}
+
+static uint64_t posix_deadline(uint32_t timeout)
+{
+    if (timeout == EZOS_DELAY_FOREVER)
+        return POSIX_FOREVER;
+    return posix_now_ms() + timeout;
+}
+
+//  ==== 仿真调度，均在内核锁内调用 ====
+static void sim_ready_push(posix_thread_t *thread)
+{
+    posix_thread_t **pp = &g_sim_ready;
+
+    while (*pp != NULL && (*pp)->prio >= thread->prio)
+    {
+        pp = &(*pp)->ready_next;
+    }
+    thread->ready_next = *pp;
+    *pp = thread;
+    thread->state = SIM_READY;
+}
+
+static void sim_waitq_remove(posix_thread_t *thread)
+{
+    posix_waitq_t *wq = thread->waitq;
+    posix_thread_t **pp;
+
+    if (wq == NULL)
+        return;
+
+    for (pp = &wq->head; *pp != NULL; pp = &(*pp)->wq_next)
+    {
+        if (*pp == thread)
+        {
+            *pp = thread->wq_next;
+            break;
+        }
+    }
+    wq->tail = NULL;
+    for (posix_thread_t *t = wq->head; t != NULL; t = t->wq_next)
+    {
+        wq->tail = t;
+    }
+    thread->wq_next = NULL;
+    thread->waitq = NULL;
+}
+
+static void sim_wake(posix_thread_t *thread, uint8_t timed_out)
+{
+    sim_waitq_remove(thread);
+    thread->timed_out = timed_out;
+    sim_ready_push(thread);
+    if (g_sim_current != NULL && thread->prio > g_sim_current->prio)
+        g_sim_preempt = 1;
+}
+
+// 没有就绪任务时，虚拟时钟跳到最近的截止时间，按截止时间和创建顺序唤醒到期任务
+static void sim_advance(void)
+{
+    while (1)
+    {
+        posix_thread_t *next = NULL;
+
+        for (posix_thread_t *t = g_threads; t != NULL; t = t->all_next)
+        {
+            if (t->state != SIM_BLOCKED || t->deadline == POSIX_FOREVER)
+                continue;
+            if (next == NULL || t->deadline < next->deadline || (t->deadline == next->deadline && t->seq < next->seq))
+                next = t;
+        }
+        if (next == NULL || (g_sim_ready != NULL && next->deadline > g_sim_now))
+            return;
+
+        if (next->deadline > g_sim_now)
+            g_sim_now = next->deadline;
+        sim_wake(next, 1);
+    }
+}
+
+// 把运行权交给下一个就绪任务
+static void sim_dispatch(void)
+{
+    posix_thread_t *next;
+
+    if (g_sim_ready == NULL)
+        sim_advance();
+
+    next = g_sim_ready;
+    if (next == NULL)
+    {
+        fprintf(stderr, "ezos sim: all tasks blocked forever at %llu ms\n", (unsigned long long)g_sim_now);
+        abort();
+    }
+
+    g_sim_ready = next->ready_next;
+    next->ready_next = NULL;
+    next->state = SIM_RUNNING;
+    g_sim_current = next;
+    g_sim_preempt = 0;
+    pthread_cond_signal(&next->run);
+}
+
+// 当前任务已离开运行态，调度后等待再次轮到自己
+static void sim_switch(posix_thread_t *self)
+{
+    sim_dispatch();
+    while (self->state != SIM_RUNNING)
+    {
+        pthread_cond_wait(&self->run, &g_kernel);
+    }
+    if (self->killed)
+    {
+        pthread_mutex_unlock(&g_kernel);
+        pthread_exit(NULL);
+    }
+}
+
+static void sim_yield_locked(posix_thread_t *self)
+{
+    sim_ready_push(self);
+    sim_switch(self);
+}
+
+static ezos_status_t sim_wait(posix_waitq_t *wq, uint64_t deadline)
+{
+    posix_thread_t *self = t_self;
+
+    if (self == NULL)
+    {
+        fprintf(stderr, "ezos sim: blocking call from a thread not created by ezos\n");
+        abort();
+    }
+    if (deadline != POSIX_FOREVER && g_sim_now >= deadline)
+        return EZOS_TIMEOUT;
+
+    self->deadline = deadline;
+    self->timed_out = 0;
+    self->waitq = wq;
+    self->wq_next = NULL;
+    if (wq->tail != NULL)
+        wq->tail->wq_next = self;
+    else
+        wq->head = self;
+    wq->tail = self;
+    self->state = SIM_BLOCKED;
+
+    sim_switch(self);
+    return self->timed_out ? EZOS_TIMEOUT : EZOS_SUCCESS;
+}
+
+static void posix_wake_one(posix_waitq_t *wq)
+{
+    if (g_sim)
+    {
+        if (wq->head != NULL)
+            sim_wake(wq->head, 0);
+        return;
+    }
+    pthread_cond_signal(&wq->cond);
+}
+
+static void posix_wake_all(posix_waitq_t *wq)
+{
+    if (g_sim)
+    {
+        while (wq->head != NULL)
+        {
+            sim_wake(wq->head, 0);
+        }
+        return;
+    }
+    pthread_cond_broadcast(&wq->cond);
+}
+
+// 内核锁内调用，等待被唤醒或到达截止时间，返回EZOS_TIMEOUT表示已超时。
+// 被唤醒不代表条件成立，调用者需要循环检查
+static ezos_status_t posix_wait(posix_waitq_t *wq, uint64_t deadline)
+{
+    // pthread_cleanup_push可能用setjmp实现，在清理区域内赋值的局部变量要声明为volatile
+    volatile int ret = 0;
+
+    if (g_sim)
+        return sim_wait(wq, deadline);
+
+    if (deadline != POSIX_FOREVER && posix_now_ms() >= deadline)
+        return EZOS_TIMEOUT;
+
+    pthread_cleanup_push(posix_unlock_cleanup, NULL);
+    if (deadline == POSIX_FOREVER)
+    {
+        pthread_cond_wait(&wq->cond, &g_kernel);
+    }
+    else
+    {
+        struct timespec ts = g_boot;
+        ts.tv_sec += deadline / 1000;
+        ts.tv_nsec += (deadline % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        ret = pthread_cond_timedwait(&wq->cond, &g_kernel, &ts);
+    }
+    pthread_cleanup_pop(0);
+
+    return ret == ETIMEDOUT ? EZOS_TIMEOUT : EZOS_SUCCESS;
+}
+
+// pthread不能挂起其他线程，被挂起的任务在下一次进入ezos调用时停下
+static void posix_suspend_point(void)
+{
+    while (t_self != NULL && t_self->suspended)
+    {
+        posix_wait(&t_self->resume, POSIX_FOREVER);
+    }
+}
+
+//  ==== Thread Functions ====
+static void posix_thread_free(posix_thread_t *thread)
+{
+    posix_waitq_destroy(&thread->resume);
+    posix_waitq_destroy(&thread->notify_wq);
+    pthread_cond_destroy(&thread->run);
+    if (!thread->is_static)
+        free(thread);
+}
+
+static void posix_thread_cleanup(void *arg)
+{
+    posix_thread_t *thread = arg;
+    posix_thread_t **pp;
+
+    pthread_mutex_lock(&g_kernel);
+    for (pp = &g_threads; *pp != NULL; pp = &(*pp)->all_next)
+    {
+        if (*pp == thread)
+        {
+            *pp = thread->all_next;
+            break;
+        }
+    }
+    if (g_sim && g_sim_current == thread)
+    {
+        g_sim_current = NULL;
+        sim_dispatch();
+    }
+    pthread_mutex_unlock(&g_kernel);
+    posix_thread_free(thread);
+}
+
+static void *posix_thread_entry(void *arg)
+{
+    posix_thread_t *thread = arg;
+
+    t_self = thread;
+#if defined(__GLIBC__)
+    if (thread->name[0] != '\0')
+        pthread_setname_np(pthread_self(), thread->name);
+#endif
+    pthread_cleanup_push(posix_thread_cleanup, thread);
+    if (g_sim)
+    {
+        // 等到第一次被调度
+        pthread_mutex_lock(&g_kernel);
+        while (thread->state != SIM_RUNNING)
+        {
+            pthread_cond_wait(&thread->run, &g_kernel);
+        }
+        pthread_mutex_unlock(&g_kernel);
+        if (thread->killed)
+            pthread_exit(NULL);
+    }
+    thread->func(thread->arg);
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+static void posix_thread_init(posix_thread_t *thread, ezos_thread_func_cb func, void *arg, const char *name, uint8_t prio)
+{
+    pthread_once(&g_once, posix_init_once);
+    thread->func = func;
+    thread->arg = arg;
+    thread->prio = prio;
+    if (name != NULL)
+        strncpy(thread->name, name, sizeof(thread->name) - 1);
+    posix_waitq_init(&thread->resume);
+    posix_waitq_init(&thread->notify_wq);
+    pthread_cond_init(&thread->run, NULL);
+}
+
+static posix_thread_t *posix_thread_alloc(ezos_thread_func_cb func, void *arg, const char *name, uint8_t prio)
+{
+    posix_thread_t *thread = calloc(1, sizeof(posix_thread_t));
+
+    if (thread == NULL)
+        return NULL;
+
+    posix_thread_init(thread, func, arg, name, prio);
+    return thread;
+}
+
+// 主机上任务栈由pthread分配，调用者提供的栈不使用
+static posix_thread_t *posix_thread_start(posix_thread_t *thread)
+{
+    pthread_attr_t attr;
+    int ret;
+
+    // 仿真模式下先登记为就绪，创建出来的线程等待调度
+    pthread_mutex_lock(&g_kernel);
+    thread->all_next = g_threads;
+    g_threads = thread;
+    if (g_sim)
+    {
+        thread->seq = ++g_sim_seq;
+        sim_ready_push(thread);
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create(&thread->tid, &attr, posix_thread_entry, thread);
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0)
+    {
+        g_threads = thread->all_next;
+        if (g_sim)
+        {
+            for (posix_thread_t **pp = &g_sim_ready; *pp != NULL; pp = &(*pp)->ready_next)
+            {
+                if (*pp == thread)
+                {
+                    *pp = thread->ready_next;
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&g_kernel);
+        posix_thread_free(thread);
+        return NULL;
+    }
+
+    if (g_sim && g_sim_current != NULL && thread->prio > g_sim_current->prio)
+        g_sim_preempt = 1;
+    posix_unlock();
+    return thread;
+}
+
+static posix_thread_t *posix_thread_spawn(ezos_thread_func_cb func, void *arg, const char *name, uint8_t prio)
+{
+    posix_thread_t *thread = posix_thread_alloc(func, arg, name, prio);
+
+    if (thread == NULL)
+        return NULL;
+    return posix_thread_start(thread);
+}
+
+ezos_thread_id_t ezos_thread_create(ezos_thread_func_cb func, ezos_thread_params_t *param)
+{
+    if (func == NULL)
+        return NULL;
+    if (param != NULL && param->priority > EZ_MAX_PRIORITY)
+        return NULL;
+
+    if (param == NULL)
+        return posix_thread_spawn(func, NULL, NULL, EZ_DEFAULT_PRIORITY);
+    return posix_thread_spawn(func, param->user_arg, param->thread_name, (uint8_t)param->priority);
+}
+
+ezos_thread_id_t ezos_thread_create_static(ezos_thread_func_cb func, ezos_thread_params_t *param,
+                                           ezos_thread_static_t *storage, void *stack, uint32_t stack_size)
+{
+    posix_thread_t *thread = (posix_thread_t *)storage;
+
+    (void)stack_size;
+    if (func == NULL || storage == NULL || stack == NULL)
+        return NULL;
+    if (param != NULL && param->priority > EZ_MAX_PRIORITY)
+        return NULL;
+
+    memset(thread, 0, sizeof(posix_thread_t));
+    if (param == NULL)
+        posix_thread_init(thread, func, NULL, NULL, EZ_DEFAULT_PRIORITY);
+    else
+        posix_thread_init(thread, func, param->user_arg, param->thread_name, (uint8_t)param->priority);
+    thread->is_static = 1;
+    return posix_thread_start(thread);
+}
+
+void ezos_thread_destroy(ezos_thread_id_t id)
+{
+    posix_thread_t *thread = id;
+
+    if (thread == NULL || thread == t_self)
+    {
+        pthread_exit(NULL);
+    }
+
+    if (g_sim)
+    {
+        // 仿真模式下让目标在下一次被调度时自行退出
+        posix_lock();
+        thread->killed = 1;
+        if (thread->state == SIM_BLOCKED)
+            sim_wake(thread, 0);
+        posix_unlock();
+        return;
+    }
+    pthread_cancel(thread->tid);
+}
+
+ezos_status_t ezos_thread_suspend(ezos_thread_id_t id)
+{
+    posix_thread_t *thread = id;
+
+    if (thread == NULL)
+        return EZOS_EINVAL;
+
+    posix_lock();
+    thread->suspended = 1;
+    posix_suspend_point();
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_thread_resume(ezos_thread_id_t id)
+{
+    posix_thread_t *thread = id;
+
+    if (thread == NULL)
+        return EZOS_EINVAL;
+
+    posix_lock();
+    thread->suspended = 0;
+    posix_wake_all(&thread->resume);
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_thread_yield(void)
+{
+    posix_lock();
+    posix_suspend_point();
+    if (g_sim && t_self != NULL)
+    {
+        sim_yield_locked(t_self);
+        posix_unlock();
+        return EZOS_SUCCESS;
+    }
+    posix_unlock();
+    sched_yield();
+    return EZOS_SUCCESS;
+}
+
+// 仿真模式下只有ezos任务能阻塞，不做登记，返回NULL
+static posix_thread_t *posix_self(void)
+{
+    if (t_self != NULL || g_sim)
+        return t_self;
+
+    posix_thread_init(&t_adopted, NULL, NULL, NULL, EZ_DEFAULT_PRIORITY);
+    t_adopted.tid = pthread_self();
+    t_adopted.is_static = 1;
+    t_self = &t_adopted;
+    return t_self;
+}
+
+ezos_thread_id_t ezos_thread_self(void)
+{
+    return posix_self();
+}
+
+//  ==== Notification Functions ====
+ezos_status_t ezos_notify_give(ezos_thread_id_t id)
+{
+    posix_thread_t *thread = id;
+
+    if (thread == NULL)
+        return EZOS_EINVAL;
+
+    EZOS_PROF_WAKE(thread);
+    posix_lock();
+    thread->notify++;
+    thread->notify_pending = 1;
+    posix_wake_one(&thread->notify_wq);
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_notify_take(uint8_t clear, uint32_t *count, uint32_t timeout)
+{
+    posix_thread_t *self = posix_self();
+    uint64_t deadline = posix_deadline(timeout);
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    if (self == NULL)
+        return EZOS_EPERM;
+
+    posix_lock();
+    posix_suspend_point();
+    while (self->notify == 0)
+    {
+        if (posix_wait(&self->notify_wq, deadline) == EZOS_TIMEOUT && self->notify == 0)
+        {
+            posix_unlock();
+            if (count != NULL)
+                *count = 0;
+            return EZOS_TIMEOUT;
+        }
+    }
+    if (count != NULL)
+        *count = self->notify;
+    self->notify = clear ? 0 : self->notify - 1;
+    self->notify_pending = 0;
+    posix_unlock();
+    EZOS_PROF_WAIT_DONE(self, start);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_notify_set_bits(ezos_thread_id_t id, uint32_t bits)
+{
+    posix_thread_t *thread = id;
+
+    if (thread == NULL)
+        return EZOS_EINVAL;
+
+    EZOS_PROF_WAKE(thread);
+    posix_lock();
+    thread->notify |= bits;
+    thread->notify_pending = 1;
+    posix_wake_one(&thread->notify_wq);
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_notify_wait_bits(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *bits, uint32_t timeout)
+{
+    posix_thread_t *self = posix_self();
+    uint64_t deadline = posix_deadline(timeout);
+    uint64_t start = EZOS_PROF_WAIT_START();
+    ezos_status_t ret = EZOS_SUCCESS;
+
+    if (self == NULL)
+        return EZOS_EPERM;
+
+    posix_lock();
+    posix_suspend_point();
+    if (!self->notify_pending)
+        self->notify &= ~clear_on_entry;
+    while (!self->notify_pending)
+    {
+        if (posix_wait(&self->notify_wq, deadline) == EZOS_TIMEOUT && !self->notify_pending)
+        {
+            ret = EZOS_TIMEOUT;
+            break;
+        }
+    }
+    if (bits != NULL)
+        *bits = self->notify;
+    if (ret == EZOS_SUCCESS)
+    {
+        self->notify &= ~clear_on_exit;
+        self->notify_pending = 0;
+    }
+    posix_unlock();
+    if (ret == EZOS_SUCCESS)
+        EZOS_PROF_WAIT_DONE(self, start);
+    return ret;
+}
+
+//  ==== Critical Section Functions ====
+// 主机上没有中断，用一把可重入锁实现，与内核锁相互独立
+static pthread_mutex_t g_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void ezos_critical_enter(void)
+{
+    pthread_mutex_lock(&g_critical);
+}
+
+void ezos_critical_exit(void)
+{
+    pthread_mutex_unlock(&g_critical);
+}
+
+//  ==== mutex Functions ====
+ezos_mutex_id_t ezos_mutex_create(void)
+{
+    posix_mutex_t *mutex = calloc(1, sizeof(posix_mutex_t));
+
+    if (mutex == NULL)
+        return NULL;
+
+    pthread_once(&g_once, posix_init_once);
+    posix_waitq_init(&mutex->wq);
+    return mutex;
+}
+
+ezos_mutex_id_t ezos_mutex_create_static(ezos_mutex_static_t *storage)
+{
+    posix_mutex_t *mutex = (posix_mutex_t *)storage;
+
+    if (mutex == NULL)
+        return NULL;
+
+    memset(mutex, 0, sizeof(posix_mutex_t));
+    pthread_once(&g_once, posix_init_once);
+    posix_waitq_init(&mutex->wq);
+    mutex->is_static = 1;
+    return mutex;
+}
+
+ezos_status_t ezos_mutex_destroy(ezos_mutex_id_t mutex)
+{
+    posix_mutex_t *m = mutex;
+
+    if (m == NULL)
+        return EZOS_EINVAL;
+
+    posix_waitq_destroy(&m->wq);
+    if (!m->is_static)
+        free(m);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_mutex_lock(ezos_mutex_id_t mutex)
+{
+    posix_mutex_t *m = mutex;
+
+    if (m == NULL)
+        return EZOS_FAILURE;
+
+    posix_lock();
+    posix_suspend_point();
+    while (m->locked)
+    {
+        posix_wait(&m->wq, POSIX_FOREVER);
+    }
+    m->locked = 1;
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_mutex_unlock(ezos_mutex_id_t mutex)
+{
+    posix_mutex_t *m = mutex;
+
+    if (m == NULL)
+        return EZOS_FAILURE;
+
+    posix_lock();
+    if (!m->locked)
+    {
+        posix_unlock();
+        return EZOS_FAILURE;
+    }
+    m->locked = 0;
+    posix_wake_one(&m->wq);
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+//  ==== Semaphore Management Function ====
+ezos_sem_id_t ezos_sem_create(uint32_t max_count, uint32_t initial_count)
+{
+    posix_sem_t *sem;
+
+    if (max_count == 0 || max_count < initial_count)
+        return NULL;
+
+    sem = calloc(1, sizeof(posix_sem_t));
+    if (sem == NULL)
+        return NULL;
+
+    pthread_once(&g_once, posix_init_once);
+    sem->count = initial_count;
+    sem->max = max_count;
+    posix_waitq_init(&sem->wq);
+    return sem;
+}
+
+ezos_sem_id_t ezos_sem_create_static(uint32_t max_count, uint32_t initial_count, ezos_sem_static_t *storage)
+{
+    posix_sem_t *sem = (posix_sem_t *)storage;
+
+    if (sem == NULL || max_count == 0 || max_count < initial_count)
+        return NULL;
+
+    memset(sem, 0, sizeof(posix_sem_t));
+    pthread_once(&g_once, posix_init_once);
+    sem->count = initial_count;
+    sem->max = max_count;
+    sem->is_static = 1;
+    posix_waitq_init(&sem->wq);
+    return sem;
+}
+
+ezos_status_t ezos_sem_destroy(ezos_sem_id_t sem)
+{
+    posix_sem_t *s = sem;
+
+    if (s == NULL)
+        return EZOS_EINVAL;
+
+    posix_waitq_destroy(&s->wq);
+    if (!s->is_static)
+        free(s);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_sem_take(ezos_sem_id_t sem, uint32_t timeout)
+{
+    posix_sem_t *s = sem;
+    uint64_t deadline;
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    if (s == NULL)
+        return EZOS_EINVAL;
+
+    deadline = posix_deadline(timeout);
+    posix_lock();
+    posix_suspend_point();
+    while (s->count == 0)
+    {
+        if (posix_wait(&s->wq, deadline) == EZOS_TIMEOUT && s->count == 0)
+        {
+            posix_unlock();
+            return EZOS_EBUZY;
+        }
+    }
+    s->count--;
+    posix_unlock();
+    EZOS_PROF_WAIT_DONE(s, start);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_sem_give(ezos_sem_id_t sem)
+{
+    posix_sem_t *s = sem;
+    ezos_status_t ret = EZOS_SUCCESS;
+
+    if (s == NULL)
+        return EZOS_EINVAL;
+
+    // 埋点在内核锁外，避免与临界区锁形成环
+    EZOS_PROF_WAKE(s);
+    posix_lock();
+    if (s->count < s->max)
+    {
+        s->count++;
+        posix_wake_one(&s->wq);
+    }
+    else
+    {
+        ret = EZOS_EBUZY;
+    }
+    posix_unlock();
+    // 协程的唤醒会提交作业、释放工作队列的信号量，放在内核锁外
+    if (ret == EZOS_SUCCESS)
+        ezos_coro_obj_wake(s);
+    return ret;
+}
+
+//  ==== Event Flags Functions ====
+static void posix_event_init(posix_event_t *ev)
+{
+    pthread_once(&g_once, posix_init_once);
+    ev->bits = 0;
+    posix_waitq_init(&ev->wq);
+}
+
+ezos_event_id_t ezos_event_create(void)
+{
+    posix_event_t *ev = calloc(1, sizeof(posix_event_t));
+
+    if (ev == NULL)
+        return NULL;
+
+    posix_event_init(ev);
+    return ev;
+}
+
+ezos_event_id_t ezos_event_create_static(ezos_event_static_t *storage)
+{
+    posix_event_t *ev = (posix_event_t *)storage;
+
+    if (ev == NULL)
+        return NULL;
+
+    memset(ev, 0, sizeof(posix_event_t));
+    posix_event_init(ev);
+    ev->is_static = 1;
+    return ev;
+}
+
+ezos_status_t ezos_event_destroy(ezos_event_id_t event)
+{
+    posix_event_t *ev = event;
+
+    if (ev == NULL)
+        return EZOS_EINVAL;
+
+    posix_waitq_destroy(&ev->wq);
+    if (!ev->is_static)
+        free(ev);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_event_set(ezos_event_id_t event, uint32_t bits)
+{
+    posix_event_t *ev = event;
+
+    if (ev == NULL || (bits & ~EZOS_EVENT_BITS_MASK) != 0)
+        return EZOS_EINVAL;
+
+    EZOS_PROF_WAKE(ev);
+    posix_lock();
+    ev->bits |= bits;
+    // 等待条件各不相同，全部唤醒各自检查
+    posix_wake_all(&ev->wq);
+    posix_unlock();
+    ezos_coro_obj_wake(ev);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_event_clear(ezos_event_id_t event, uint32_t bits)
+{
+    posix_event_t *ev = event;
+
+    if (ev == NULL)
+        return EZOS_EINVAL;
+
+    posix_lock();
+    ev->bits &= ~bits;
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+uint32_t ezos_event_get(ezos_event_id_t event)
+{
+    posix_event_t *ev = event;
+    uint32_t bits;
+
+    if (ev == NULL)
+        return 0;
+
+    posix_lock();
+    bits = ev->bits;
+    posix_unlock();
+    return bits;
+}
+
+static int posix_event_match(uint32_t cur, uint32_t bits, uint8_t options)
+{
+    if (options & EZOS_EVENT_WAIT_ALL)
+        return (cur & bits) == bits;
+    return (cur & bits) != 0;
+}
+
+ezos_status_t ezos_event_wait(ezos_event_id_t event, uint32_t bits, uint8_t options, uint32_t *out, uint32_t timeout)
+{
+    posix_event_t *ev = event;
+    uint64_t deadline;
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    if (ev == NULL || bits == 0 || (bits & ~EZOS_EVENT_BITS_MASK) != 0)
+        return EZOS_EINVAL;
+
+    deadline = posix_deadline(timeout);
+    posix_lock();
+    posix_suspend_point();
+    while (!posix_event_match(ev->bits, bits, options))
+    {
+        if (posix_wait(&ev->wq, deadline) == EZOS_TIMEOUT && !posix_event_match(ev->bits, bits, options))
+        {
+            if (out != NULL)
+                *out = ev->bits;
+            posix_unlock();
+            return EZOS_TIMEOUT;
+        }
+    }
+    if (out != NULL)
+        *out = ev->bits;
+    if (options & EZOS_EVENT_CLEAR)
+        ev->bits &= ~bits;
+    posix_unlock();
+    EZOS_PROF_WAIT_DONE(ev, start);
+    return EZOS_SUCCESS;
+}
+
+//  ==== Message Queue Management Functions====
+ezos_queue_id_t ezos_queue_create(uint32_t msg_count, uint32_t msg_size)
+{
+    posix_queue_t *q;
+
+    if (msg_count == 0 || msg_size == 0)
+        return NULL;
+
+    q = calloc(1, sizeof(posix_queue_t));
+    if (q == NULL)
+        return NULL;
+
+    q->buf = malloc((size_t)msg_count * msg_size);
+    if (q->buf == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+
+    pthread_once(&g_once, posix_init_once);
+    q->msg_size = msg_size;
+    q->cap = msg_count;
+    posix_waitq_init(&q->wq_data);
+    posix_waitq_init(&q->wq_space);
+    return q;
+}
+
+ezos_queue_id_t ezos_queue_create_static(uint32_t msg_count, uint32_t msg_size, ezos_queue_static_t *storage, void *buf)
+{
+    posix_queue_t *q = (posix_queue_t *)storage;
+
+    if (msg_count == 0 || msg_size == 0 || q == NULL || buf == NULL)
+        return NULL;
+
+    memset(q, 0, sizeof(posix_queue_t));
+    pthread_once(&g_once, posix_init_once);
+    q->buf = buf;
+    q->is_static = 1;
+    q->msg_size = msg_size;
+    q->cap = msg_count;
+    posix_waitq_init(&q->wq_data);
+    posix_waitq_init(&q->wq_space);
+    return q;
+}
+
+void ezos_queue_destroy(ezos_queue_id_t queue)
+{
+    posix_queue_t *q = queue;
+
+    if (q == NULL)
+        return;
+
+    posix_waitq_destroy(&q->wq_data);
+    posix_waitq_destroy(&q->wq_space);
+    if (!q->is_static)
+    {
+        free(q->buf);
+        free(q);
+    }
+}
+
+// 与FreeRTOS一致，按创建时的消息大小拷贝，msg_size参数不使用
+ezos_status_t ezos_queue_write(ezos_queue_id_t queue, void *msg_ptr, uint32_t msg_size, uint32_t timeout)
+{
+    posix_queue_t *q = queue;
+    uint64_t deadline;
+
+    (void)msg_size;
+    if (q == NULL || msg_ptr == NULL)
+        return EZOS_EINVAL;
+
+    EZOS_PROF_WAKE(q);
+    deadline = posix_deadline(timeout);
+    posix_lock();
+    posix_suspend_point();
+    while (q->count == q->cap)
+    {
+        if (posix_wait(&q->wq_space, deadline) == EZOS_TIMEOUT && q->count == q->cap)
+        {
+            posix_unlock();
+            return timeout != 0 ? EZOS_TIMEOUT : EZOS_FAILURE;
+        }
+    }
+
+    memcpy(&q->buf[((q->head + q->count) % q->cap) * q->msg_size], msg_ptr, q->msg_size);
+    q->count++;
+    posix_wake_one(&q->wq_data);
+    posix_unlock();
+    ezos_coro_obj_wake(q);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_queue_read(ezos_queue_id_t queue, void *msg_ptr, uint32_t msg_size, uint32_t timeout)
+{
+    posix_queue_t *q = queue;
+    uint64_t deadline;
+    uint64_t start = EZOS_PROF_WAIT_START();
+
+    (void)msg_size;
+    if (q == NULL || msg_ptr == NULL)
+        return EZOS_EINVAL;
+
+    deadline = posix_deadline(timeout);
+    posix_lock();
+    posix_suspend_point();
+    while (q->count == 0)
+    {
+        if (posix_wait(&q->wq_data, deadline) == EZOS_TIMEOUT && q->count == 0)
+        {
+            posix_unlock();
+            return timeout != 0 ? EZOS_TIMEOUT : EZOS_FAILURE;
+        }
+    }
+
+    memcpy(msg_ptr, &q->buf[q->head * q->msg_size], q->msg_size);
+    q->head = (q->head + 1) % q->cap;
+    q->count--;
+    posix_wake_one(&q->wq_space);
+    posix_unlock();
+    ezos_coro_obj_wake(q);
+    EZOS_PROF_WAIT_DONE(q, start);
+    return EZOS_SUCCESS;
+}
+
+uint32_t ezos_queue_count_get(ezos_queue_id_t queue)
+{
+    posix_queue_t *q = queue;
+    uint32_t count;
+
+    if (q == NULL)
+        return 0;
+
+    posix_lock();
+    count = q->count;
+    posix_unlock();
+    return count;
+}
+
+void ezos_queue_reset(ezos_queue_id_t queue)
+{
+    posix_queue_t *q = queue;
+
+    if (q == NULL)
+        return;
+
+    posix_lock();
+    q->head = 0;
+    q->count = 0;
+    posix_wake_all(&q->wq_space);
+    posix_unlock();
+}
+
+//  ==== timer Management Functions====
+static void posix_timer_unlink(posix_timer_t *timer)
+{
+    posix_timer_t **pp = &g_timers;
+
+    while (*pp != NULL)
+    {
+        if (*pp == timer)
+        {
+            *pp = timer->next;
+            timer->next = NULL;
+            return;
+        }
+        pp = &(*pp)->next;
+    }
+}
+
+static void posix_timer_link(posix_timer_t *timer)
+{
+    posix_timer_t **pp = &g_timers;
+
+    while (*pp != NULL && (*pp)->expire <= timer->expire)
+    {
+        pp = &(*pp)->next;
+    }
+    timer->next = *pp;
+    *pp = timer;
+}
+
+// 定时器任务，回调在该任务中执行，与FreeRTOS的定时器服务任务一致
+static void posix_timer_task(void *arg)
+{
+    (void)arg;
+
+    posix_lock();
+    while (1)
+    {
+        posix_timer_t *timer = g_timers;
+
+        if (timer == NULL)
+        {
+            posix_wait(&g_timer_wq, POSIX_FOREVER);
+            continue;
+        }
+        if (posix_now_ms() < timer->expire)
+        {
+            posix_wait(&g_timer_wq, timer->expire);
+            continue;
+        }
+
+        g_timers = timer->next;
+        timer->next = NULL;
+        if (timer->type == EZOS_TIMER_TYPE_PERIODIC)
+        {
+            timer->expire += timer->period;
+            posix_timer_link(timer);
+        }
+        else
+        {
+            timer->stat = EZOS_TIMER_ST_INACTIVE;
+        }
+
+        g_timer_running = timer;
+        posix_unlock();
+        timer->func(timer->arg);
+        posix_lock();
+        g_timer_running = NULL;
+        posix_wake_all(&g_timer_done_wq);
+
+        if (timer->dead && !timer->is_static)
+        {
+            free(timer);
+        }
+    }
+}
+
+// 第一次创建定时器时启动定时器任务
+static int posix_timer_task_start(void)
+{
+    posix_lock();
+    if (g_timer_started)
+    {
+        posix_unlock();
+        return 0;
+    }
+    g_timer_started = 1;
+    posix_unlock();
+
+    g_timer_thread = posix_thread_spawn(posix_timer_task, NULL, "ezos_timer", POSIX_TIMER_TASK_PRIORITY);
+    if (g_timer_thread == NULL)
+    {
+        g_timer_started = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static void posix_timer_init(posix_timer_t *timer, ezos_thread_timer_cb cb, void *arg, int repeat)
+{
+    timer->func = cb;
+    timer->arg = arg;
+    timer->type = repeat ? EZOS_TIMER_TYPE_PERIODIC : EZOS_TIMER_TYPE_ONCE;
+    timer->stat = EZOS_TIMER_ST_INACTIVE;
+}
+
+ezos_timer_id_t ezos_timer_create(ezos_thread_timer_cb cb, void *arg, int repeat)
+{
+    posix_timer_t *timer;
+
+    if (cb == NULL)
+        return NULL;
+
+    timer = calloc(1, sizeof(posix_timer_t));
+    if (timer == NULL)
+        return NULL;
+
+    posix_timer_init(timer, cb, arg, repeat);
+    if (posix_timer_task_start() != 0)
+    {
+        free(timer);
+        return NULL;
+    }
+    return timer;
+}
+
+ezos_timer_id_t ezos_timer_create_static(ezos_thread_timer_cb cb, void *arg, int repeat, ezos_timer_static_t *storage)
+{
+    posix_timer_t *timer = (posix_timer_t *)storage;
+
+    if (cb == NULL || timer == NULL)
+        return NULL;
+
+    memset(timer, 0, sizeof(posix_timer_t));
+    posix_timer_init(timer, cb, arg, repeat);
+    timer->is_static = 1;
+    if (posix_timer_task_start() != 0)
+        return NULL;
+    return timer;
+}
+
+ezos_status_t ezos_timer_destroy(ezos_timer_id_t timer)
+{
+    posix_timer_t *t = timer;
+
+    if (t == NULL)
+        return EZOS_EINVAL;
+
+    posix_lock();
+    posix_timer_unlink(t);
+    t->stat = EZOS_TIMER_ST_INACTIVE;
+    if (g_timer_running == t)
+    {
+        if (t_self != NULL && t_self == g_timer_thread)
+        {
+            // 回调中删除自己，返回后由定时器任务释放
+            t->dead = 1;
+            posix_unlock();
+            return EZOS_SUCCESS;
+        }
+        while (g_timer_running == t)
+        {
+            posix_wait(&g_timer_done_wq, POSIX_FOREVER);
+        }
+    }
+    posix_unlock();
+    if (!t->is_static)
+        free(t);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_timer_start(ezos_timer_id_t timer, uint32_t ms)
+{
+    posix_timer_t *t = timer;
+
+    if (t == NULL || ms == 0)
+        return EZOS_EINVAL;
+
+    posix_lock();
+    posix_timer_unlink(t);
+    t->period = ms;
+    t->expire = posix_now_ms() + ms;
+    t->stat = EZOS_TIMER_ST_ACTIVE;
+    posix_timer_link(t);
+    posix_wake_all(&g_timer_wq);
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_timer_stop(ezos_timer_id_t timer)
+{
+    posix_timer_t *t = timer;
+
+    if (t == NULL)
+        return EZOS_EINVAL;
+
+    posix_lock();
+    posix_timer_unlink(t);
+    t->stat = EZOS_TIMER_ST_INACTIVE;
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+// 与FreeRTOS后端一致：运行中的定时器需要先停止
+ezos_status_t ezos_timer_update(ezos_timer_id_t timer, uint32_t ms)
+{
+    posix_timer_t *t = timer;
+
+    if (t == NULL || t->stat == EZOS_TIMER_ST_ACTIVE)
+        return EZOS_EINVAL;
+
+    return ezos_timer_start(timer, ms);
+}
+
+ezos_timer_stat_t ezos_timer_is_active(ezos_timer_id_t timer)
+{
+    posix_timer_t *t = timer;
+
+    if (t == NULL)
+        return EZOS_TIMER_ST_INACTIVE;
+    return t->stat;
+}
+
+//  ==== Profiler Functions ====
+#if EZOS_PROF
+uint16_t ezos_prof_tasks_snapshot(ezos_prof_task_t *tasks, uint16_t max, uint32_t *switches)
+{
+    struct rusage ru;
+    uint16_t n = 0;
+
+    // 主机上只能取到整个进程的切换次数
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        *switches = (uint32_t)(ru.ru_nvcsw + ru.ru_nivcsw);
+
+    posix_lock();
+    for (posix_thread_t *t = g_threads; t != NULL; t = t->all_next, n++)
+    {
+        ezos_prof_task_t *task;
+
+        if (n >= max)
+            continue;
+
+        // 主机上任务栈由pthread分配，不统计高水位
+        task = &tasks[n];
+        memset(task, 0, sizeof(ezos_prof_task_t));
+        task->id = t;
+        memcpy(task->name, t->name, sizeof(task->name));
+        task->priority = t->prio;
+#if defined(__linux__)
+        {
+            clockid_t cid;
+            struct timespec ts;
+
+            if (pthread_getcpuclockid(t->tid, &cid) == 0 && clock_gettime(cid, &ts) == 0)
+                task->runtime_us = (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+        }
+#endif
+    }
+    posix_unlock();
+    return n;
+}
+#endif
+
+//  ==== system Management Functions====
+ezos_status_t ezos_init(void)
+{
+    pthread_once(&g_once, posix_init_once);
+    return EZOS_SUCCESS;
+}
+
+// 主机上任务创建即运行，这里只阻塞调用者
+ezos_status_t ezos_start(void)
+{
+    posix_lock();
+    while (1)
+    {
+        posix_wait(&g_sleep_wq, POSIX_FOREVER);
+    }
+    posix_unlock();
+    return EZOS_SUCCESS;
+}
+
+void ezos_delayms(uint32_t ms)
+{
+    uint64_t deadline = posix_deadline(ms);
+
+    posix_lock();
+    posix_suspend_point();
+    while (posix_wait(&g_sleep_wq, deadline) != EZOS_TIMEOUT)
+    {
+    }
+    posix_unlock();
+}
+
+void ezos_delays(uint32_t s)
+{
+    while (s--)
+    {
+        ezos_delayms(1000);
+    }
+}
+
+const char *ezos_info_get(void)
+{
+    return EZOS_VERSION_INFO;
+}
+
+// 主机上没有tickless
+uint32_t ezos_suspend(void)
+{
+    return 0;
+}
+
+void ezos_resume(int32_t sleep_ticks)
+{
+    (void)sleep_ticks;
+}
+
+uint32_t ezos_tick_conut_get(void)
+{
+    return (uint32_t)posix_now_ms();
+}
+
+uint32_t ezos_tick_freq_get(void)
+{
+    return 1000;
+}
+
+// ezos_delay_us最后忙等的时长
+#define POSIX_SPIN_NS 200000
+
+// 真实时间，不受仿真模式影响
+static uint64_t posix_real_ns(void)
+{
+    struct timespec now;
+
+    pthread_once(&g_once, posix_init_once);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - g_boot.tv_sec) * 1000000000 + now.tv_nsec - g_boot.tv_nsec;
+}
+
+uint64_t ezos_time_us(void)
+{
+    if (g_sim)
+        return g_sim_now * 1000;
+    return posix_real_ns() / 1000;
+}
+
+// 主机上用单调时钟的纳秒数代替CPU周期
+uint32_t ezos_cycles(void)
+{
+    return (uint32_t)posix_real_ns();
+}
+
+uint32_t ezos_cycles_freq_get(void)
+{
+    return 1000000000;
+}
+
+void ezos_delay_us(uint32_t us)
+{
+    uint64_t deadline;
+
+    // 仿真时钟精度为ms
+    if (g_sim)
+    {
+        ezos_delayms((us + 999) / 1000);
+        return;
+    }
+
+    // 与目标板一致：先睡眠，最后一段忙等，避开nanosleep约100us的唤醒延迟
+    deadline = posix_real_ns() + (uint64_t)us * 1000;
+    if (us >= EZOS_DELAY_US_SPIN_MAX)
+    {
+        uint64_t wake = deadline - POSIX_SPIN_NS;
+        struct timespec ts = g_boot;
+
+        ts.tv_sec += wake / 1000000000;
+        ts.tv_nsec += wake % 1000000000;
+        if (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        {
+        }
+    }
+    while (posix_real_ns() < deadline)
+    {
+    }
+}
+
+//  ==== simulation ====
+void ezos_sim_enable(void)
+{
+    posix_thread_t *self;
+
+    if (g_sim)
+        return;
+
+    self = posix_thread_alloc(NULL, NULL, "main", EZ_DEFAULT_PRIORITY);
+    if (self == NULL)
+        abort();
+
+    pthread_mutex_lock(&g_kernel);
+    self->tid = pthread_self();
+    self->seq = ++g_sim_seq;
+    self->state = SIM_RUNNING;
+    self->all_next = g_threads;
+    g_threads = self;
+    g_sim_current = self;
+    g_sim_now = 0;
+    g_sim = 1;
+    t_self = self;
+    pthread_mutex_unlock(&g_kernel);
+}
+
+uint64_t ezos_sim_now_ms(void)
+{
+    return posix_now_ms();
+}
+
+void __attribute__((weak)) weak_ezos_puts(char *data)
+{
+    fputs(data, stdout);
+}
+
+void ezos_printf(const char *fmt, ...)
+{
+    char log_buf[DEBUG_PRINTF_MAX_SIZE];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(log_buf, DEBUG_PRINTF_MAX_SIZE, fmt, args);
+    va_end(args);
+    weak_ezos_puts(log_buf);
+}
@@ -0,0 +1,237 @@
+#include "ezos.h"
+
+#include <string.h>
+
+/*
+ * 任务剖析的通用部分：唤醒时间戳、每个任务的唤醒延迟和上一次的运行时间。
+ * 任务列表、栈高水位和运行时间由后端的ezos_prof_tasks_snapshot提供。
+ * 表项只比较任务id，不通过id访问任务，任务删除后留下的表项不会出错，只是占着位置。
+ */
+
+#if EZOS_PROF
+
+typedef struct
+{
+    const void *obj;
+    uint64_t stamp;
+} prof_wake_t;
+
+typedef struct
+{
+    ezos_thread_id_t id;
+    uint32_t wakeups;
+    uint32_t lat_max;
+    uint64_t lat_sum;
+    uint32_t last_runtime;
+    uint8_t seen; // last_runtime有效
+} prof_task_t;
+
+static prof_wake_t g_prof_wake[EZOS_PROF_WAKE_SLOTS];
+static prof_task_t g_prof_tasks[EZOS_PROF_TASKS];
+static uint32_t g_prof_wakeups = 0;
+static uint32_t g_prof_last_wakeups = 0;
+static uint32_t g_prof_last_switches = 0;
+static uint64_t g_prof_last_us = 0;
+
+// 每个对象可以放在相邻的两个槽之一，减少冲突覆盖
+static uint16_t prof_wake_hash(const void *obj)
+{
+    uint32_t h = (uint32_t)(uintptr_t)obj * 2654435761u;
+
+    return (uint16_t)((h >> 16) % EZOS_PROF_WAKE_SLOTS);
+}
+
+// 临界区内调用
+static prof_wake_t *prof_wake_find(const void *obj)
+{
+    uint16_t i = prof_wake_hash(obj);
+    prof_wake_t *a = &g_prof_wake[i];
+    prof_wake_t *b = &g_prof_wake[(i + 1) % EZOS_PROF_WAKE_SLOTS];
+
+    if (a->obj == obj)
+        return a;
+    if (b->obj == obj)
+        return b;
+    return NULL;
+}
+
+// 临界区内调用，找不到时占用一个空项，表满返回NULL
+static prof_task_t *prof_task_find(ezos_thread_id_t id)
+{
+    prof_task_t *empty = NULL;
+
+    for (uint16_t i = 0; i < EZOS_PROF_TASKS; i++)
+    {
+        if (g_prof_tasks[i].id == id)
+            return &g_prof_tasks[i];
+        if (g_prof_tasks[i].id == NULL && empty == NULL)
+            empty = &g_prof_tasks[i];
+    }
+    if (empty != NULL)
+    {
+        memset(empty, 0, sizeof(prof_task_t));
+        empty->id = id;
+    }
+    return empty;
+}
+
+void ezos_prof_wake_mark(const void *obj)
+{
+    uint16_t i = prof_wake_hash(obj);
+    uint64_t now = ezos_time_us();
+    prof_wake_t *slot;
+
+    ezos_critical_enter();
+    // 两个槽都被别的对象占着时，替换时间戳较旧的
+    slot = prof_wake_find(obj);
+    if (slot == NULL)
+    {
+        prof_wake_t *a = &g_prof_wake[i];
+        prof_wake_t *b = &g_prof_wake[(i + 1) % EZOS_PROF_WAKE_SLOTS];
+
+        slot = a->stamp <= b->stamp ? a : b;
+        slot->obj = obj;
+    }
+    slot->stamp = now;
+    ezos_critical_exit();
+}
+
+void ezos_prof_wake_done(const void *obj, uint64_t wait_start)
+{
+    ezos_thread_id_t self = ezos_thread_self();
+    uint64_t now = ezos_time_us();
+    prof_wake_t *slot;
+    prof_task_t *task;
+    uint32_t lat;
+
+    if (self == NULL)
+        return;
+
+    ezos_critical_enter();
+    slot = prof_wake_find(obj);
+    // 时间戳早于开始等待，说明对象在等待前已经可用，没有阻塞
+    if (slot == NULL || slot->stamp < wait_start || slot->stamp > now)
+    {
+        ezos_critical_exit();
+        return;
+    }
+    lat = (uint32_t)(now - slot->stamp);
+    g_prof_wakeups++;
+    task = prof_task_find(self);
+    if (task != NULL)
+    {
+        task->wakeups++;
+        task->lat_sum += lat;
+        if (lat > task->lat_max)
+            task->lat_max = lat;
+    }
+    ezos_critical_exit();
+}
+
+uint16_t ezos_prof_get(ezos_prof_task_t *tasks, uint16_t max, ezos_prof_stat_t *stat)
+{
+    uint32_t switches = 0;
+    uint16_t total;
+    uint16_t n;
+    uint64_t now;
+    uint32_t window;
+
+    if (tasks == NULL)
+        max = 0;
+    total = ezos_prof_tasks_snapshot(tasks, max, &switches);
+    n = total < max ? total : max;
+    now = ezos_time_us();
+    window = (uint32_t)(now - g_prof_last_us);
+
+    ezos_critical_enter();
+    for (uint16_t i = 0; i < n; i++)
+    {
+        prof_task_t *task = prof_task_find(tasks[i].id);
+        uint32_t ran;
+
+        tasks[i].cpu_permille = 0;
+        tasks[i].wakeups = 0;
+        tasks[i].wake_lat_avg_us = 0;
+        tasks[i].wake_lat_max_us = 0;
+        if (task == NULL)
+            continue;
+
+        ran = task->seen ? tasks[i].runtime_us - task->last_runtime : tasks[i].runtime_us;
+        if (window != 0)
+            tasks[i].cpu_permille = (uint16_t)((uint64_t)ran * 1000 / window);
+        task->last_runtime = tasks[i].runtime_us;
+        task->seen = 1;
+
+        tasks[i].wakeups = task->wakeups;
+        tasks[i].wake_lat_max_us = task->lat_max;
+        if (task->wakeups != 0)
+            tasks[i].wake_lat_avg_us = (uint32_t)(task->lat_sum / task->wakeups);
+    }
+
+    if (stat != NULL)
+    {
+        stat->window_us = window;
+        stat->switches = switches - g_prof_last_switches;
+        stat->wakeups = g_prof_wakeups - g_prof_last_wakeups;
+        stat->tasks = total;
+    }
+    g_prof_last_switches = switches;
+    g_prof_last_wakeups = g_prof_wakeups;
+    g_prof_last_us = now;
+    ezos_critical_exit();
+    return n;
+}
+
+void ezos_prof_reset(void)
+{
+    ezos_critical_enter();
+    for (uint16_t i = 0; i < EZOS_PROF_TASKS; i++)
+    {
+        g_prof_tasks[i].wakeups = 0;
+        g_prof_tasks[i].lat_max = 0;
+        g_prof_tasks[i].lat_sum = 0;
+    }
+    ezos_critical_exit();
+}
+
+#else
+
+uint16_t ezos_prof_get(ezos_prof_task_t *tasks, uint16_t max, ezos_prof_stat_t *stat)
+{
+    (void)tasks;
+    (void)max;
+    if (stat != NULL)
+        memset(stat, 0, sizeof(ezos_prof_stat_t));
+    return 0;
+}
+
+void ezos_prof_reset(void)
+{
+}
+
+#endif
+
+void ezos_prof_dump(void)
+{
+#if EZOS_PROF
+    ezos_prof_task_t *tasks;
+    ezos_prof_stat_t stat;
+    uint16_t n;
+
+    // 整张表放栈上有1KB多，从堆上取
+    tasks = ezos_malloc(sizeof(ezos_prof_task_t) * EZOS_PROF_TASKS);
+    if (tasks == NULL)
+        return;
+    n = ezos_prof_get(tasks, EZOS_PROF_TASKS, &stat);
+    ezos_printf("prof window=%ums tasks=%u switches=%u wakeups=%u\r\n", (unsigned)(stat.window_us / 1000),
+                stat.tasks, (unsigned)stat.switches, (unsigned)stat.wakeups);
+    for (uint16_t i = 0; i < n; i++)
+    {
+        ezos_printf("  %-15s prio=%u cpu=%u.%u%% stack_free=%u wake=%u lat=%u/%uus\r\n", tasks[i].name,
+                    tasks[i].priority, tasks[i].cpu_permille / 10, tasks[i].cpu_permille % 10,
+                    (unsigned)tasks[i].stack_free_min, (unsigned)tasks[i].wakeups,
+                    (unsigned)tasks[i].wake_lat_avg_us, (unsigned)tasks[i].wake_lat_max_us);
+    }
+    ezos_free(tasks);
+#endif
+}
@@ -0,0 +1,16 @@
+#ifndef __EZOS_SIM_H__
+#define __EZOS_SIM_H__
+
+#include <stdint.h>
+
+// 虚拟时间仿真，只在主机后端(ezos_posix.c)中实现
+
+/// @brief 开启仿真模式：任务逐个运行，延时、超时和定时器使用虚拟时钟
+/// 必须在创建任何ezos任务、定时器之前由主线程调用，调用者成为第一个仿真任务
+void ezos_sim_enable(void);
+
+/// @brief 获取虚拟时间
+/// @return 仿真开始以来的毫秒数
+uint64_t ezos_sim_now_ms(void);
+
+#endif
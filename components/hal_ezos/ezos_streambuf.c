@@ -0,0 +1,601 @@
+#include "ezos.h"
+
+#include <string.h>
+
+/*
+ * 流缓冲区和消息缓冲区共用一个单读单写的环形缓冲区，只依赖临界区和信号量，各后端通用。
+ * FreeRTOS自带的stream/message buffer只能拷贝进出，没有借出空间的接口，所以这里自己实现。
+ *
+ * 写端只移动wr，读端只移动rd，used是已占用的字节数，三者都在临界区内更新。
+ * used为0时把wr、rd拉回起点，让下一次借出的连续空间尽量大。
+ * 两个二值信号量只做唤醒，醒来后重新检查条件，多余的唤醒没有副作用。
+ *
+ * 消息缓冲区中一条消息：长度(4BYTE) | 数据，按4字节对齐，不跨越缓冲区末尾。
+ * 尾部放不下时写一个回绕标记，剩余的尾部空间计入used，读端遇到标记后跳回起点。
+ */
+
+#define MSGBUF_WRAP 0xFFFFFFFFu
+
+typedef struct
+{
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t wr;
+    uint32_t rd;
+    uint32_t used;
+    uint32_t trigger; // 流缓冲区读端的唤醒门限
+    uint32_t count;   // 消息缓冲区中的消息数
+
+    // 写端借出的空间
+    uint32_t res_off;
+    uint32_t res_len;
+    uint32_t res_pad; // 回绕时跳过的尾部空间
+    // 读端查看的数据
+    uint32_t peek_len;
+
+    uint8_t is_static;
+    uint8_t reserving;
+    uint8_t peeking;
+
+    ezos_sem_id_t data;  // 有新数据，唤醒读端
+    ezos_sem_id_t space; // 有空间释放，唤醒写端
+    ezos_sem_static_t data_scb;
+    ezos_sem_static_t space_scb;
+} ringbuf_t;
+
+_Static_assert(sizeof(ringbuf_t) <= sizeof(ezos_streambuf_static_t), "EZOS_STREAMBUF_STATIC_SIZE too small");
+_Static_assert(sizeof(ringbuf_t) <= sizeof(ezos_msgbuf_static_t), "EZOS_MSGBUF_STATIC_SIZE too small");
+
+static uint32_t ringbuf_ms(void)
+{
+    return (uint32_t)((uint64_t)ezos_tick_conut_get() * 1000 / ezos_tick_freq_get());
+}
+
+// 在sem上等待剩余的时间，start为开始等待的时刻
+static ezos_status_t ringbuf_wait(ezos_sem_id_t sem, uint32_t start, uint32_t timeout)
+{
+    uint32_t elapsed;
+
+    if (timeout == 0)
+        return EZOS_TIMEOUT;
+    if (timeout == EZOS_DELAY_FOREVER)
+        return ezos_sem_take(sem, EZOS_DELAY_FOREVER) == EZOS_SUCCESS ? EZOS_SUCCESS : EZOS_TIMEOUT;
+
+    elapsed = ringbuf_ms() - start;
+    if (elapsed >= timeout)
+        return EZOS_TIMEOUT;
+    return ezos_sem_take(sem, timeout - elapsed) == EZOS_SUCCESS ? EZOS_SUCCESS : EZOS_TIMEOUT;
+}
+
+static ringbuf_t *ringbuf_init(ringbuf_t *rb, uint32_t size, uint8_t *buf, uint8_t is_static)
+{
+    memset(rb, 0, sizeof(ringbuf_t));
+    rb->buf = buf;
+    rb->size = size;
+    rb->trigger = 1;
+    rb->is_static = is_static;
+    rb->data = ezos_sem_create_static(1, 0, &rb->data_scb);
+    rb->space = ezos_sem_create_static(1, 0, &rb->space_scb);
+    if (rb->data == NULL || rb->space == NULL)
+    {
+        if (rb->data != NULL)
+            ezos_sem_destroy(rb->data);
+        if (rb->space != NULL)
+            ezos_sem_destroy(rb->space);
+        return NULL;
+    }
+    return rb;
+}
+
+static ringbuf_t *ringbuf_create(uint32_t size)
+{
+    ringbuf_t *rb;
+    uint8_t *buf;
+
+    rb = ezos_malloc(sizeof(ringbuf_t));
+    if (rb == NULL)
+        return NULL;
+
+    buf = ezos_malloc(size);
+    if (buf == NULL)
+    {
+        ezos_free(rb);
+        return NULL;
+    }
+
+    if (ringbuf_init(rb, size, buf, 0) == NULL)
+    {
+        ezos_free(buf);
+        ezos_free(rb);
+        return NULL;
+    }
+    return rb;
+}
+
+static void ringbuf_destroy(ringbuf_t *rb)
+{
+    if (rb == NULL)
+        return;
+
+    ezos_sem_destroy(rb->data);
+    ezos_sem_destroy(rb->space);
+    if (!rb->is_static)
+    {
+        ezos_free(rb->buf);
+        ezos_free(rb);
+    }
+}
+
+// 临界区内调用，缓冲区空时回到起点
+static void ringbuf_rewind(ringbuf_t *rb)
+{
+    if (rb->used == 0)
+    {
+        rb->wr = 0;
+        rb->rd = 0;
+    }
+}
+
+//  ==== Stream Buffer ====
+static void *stream_reserve(ringbuf_t *rb, uint32_t *len, uint32_t start, uint32_t timeout)
+{
+    uint32_t contig;
+    void *ptr;
+
+    for (;;)
+    {
+        ezos_critical_enter();
+        if (rb->reserving)
+        {
+            ezos_critical_exit();
+            return NULL;
+        }
+        ringbuf_rewind(rb);
+        if (rb->used < rb->size)
+        {
+            contig = rb->wr >= rb->rd ? rb->size - rb->wr : rb->rd - rb->wr;
+            if (contig > *len)
+                contig = *len;
+            rb->res_off = rb->wr;
+            rb->res_len = contig;
+            rb->reserving = 1;
+            ptr = rb->buf + rb->wr;
+            ezos_critical_exit();
+            *len = contig;
+            return ptr;
+        }
+        ezos_critical_exit();
+
+        if (ringbuf_wait(rb->space, start, timeout) != EZOS_SUCCESS)
+            return NULL;
+    }
+}
+
+static const void *stream_peek(ringbuf_t *rb, uint32_t *len, uint32_t start, uint32_t timeout)
+{
+    uint32_t contig;
+    const void *ptr;
+    int expired = 0;
+
+    for (;;)
+    {
+        ezos_critical_enter();
+        if (rb->peeking)
+        {
+            ezos_critical_exit();
+            return NULL;
+        }
+        // 超时后有多少给多少
+        if (rb->used >= rb->trigger || (expired && rb->used > 0))
+        {
+            contig = rb->size - rb->rd;
+            if (contig > rb->used)
+                contig = rb->used;
+            rb->peek_len = contig;
+            rb->peeking = 1;
+            ptr = rb->buf + rb->rd;
+            ezos_critical_exit();
+            *len = contig;
+            return ptr;
+        }
+        ezos_critical_exit();
+
+        if (expired)
+            return NULL;
+        if (ringbuf_wait(rb->data, start, timeout) != EZOS_SUCCESS)
+            expired = 1;
+    }
+}
+
+ezos_streambuf_id_t ezos_streambuf_create(uint32_t size, uint32_t trigger)
+{
+    ringbuf_t *rb;
+
+    if (size == 0)
+        return NULL;
+
+    rb = ringbuf_create(size);
+    if (rb != NULL && trigger > 1)
+        rb->trigger = trigger > size ? size : trigger;
+    return rb;
+}
+
+ezos_streambuf_id_t ezos_streambuf_create_static(uint32_t size, uint32_t trigger,
+                                                 ezos_streambuf_static_t *storage, void *buf)
+{
+    ringbuf_t *rb = (ringbuf_t *)storage;
+
+    if (size == 0 || storage == NULL || buf == NULL)
+        return NULL;
+
+    if (ringbuf_init(rb, size, buf, 1) == NULL)
+        return NULL;
+    if (trigger > 1)
+        rb->trigger = trigger > size ? size : trigger;
+    return rb;
+}
+
+void ezos_streambuf_destroy(ezos_streambuf_id_t sb)
+{
+    ringbuf_destroy(sb);
+}
+
+void *ezos_streambuf_reserve(ezos_streambuf_id_t sb, uint32_t *len, uint32_t timeout)
+{
+    if (sb == NULL || len == NULL || *len == 0)
+        return NULL;
+
+    return stream_reserve(sb, len, ringbuf_ms(), timeout);
+}
+
+ezos_status_t ezos_streambuf_commit(ezos_streambuf_id_t sb, uint32_t len)
+{
+    ringbuf_t *rb = sb;
+
+    if (rb == NULL)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+    if (!rb->reserving || len > rb->res_len)
+    {
+        ezos_critical_exit();
+        return EZOS_EINVAL;
+    }
+    rb->wr = (rb->res_off + len) % rb->size;
+    rb->used += len;
+    rb->reserving = 0;
+    ezos_critical_exit();
+
+    if (len > 0)
+        ezos_sem_give(rb->data);
+    return EZOS_SUCCESS;
+}
+
+const void *ezos_streambuf_peek(ezos_streambuf_id_t sb, uint32_t *len, uint32_t timeout)
+{
+    if (sb == NULL || len == NULL)
+        return NULL;
+
+    return stream_peek(sb, len, ringbuf_ms(), timeout);
+}
+
+ezos_status_t ezos_streambuf_release(ezos_streambuf_id_t sb, uint32_t len)
+{
+    ringbuf_t *rb = sb;
+
+    if (rb == NULL)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+    if (!rb->peeking || len > rb->peek_len)
+    {
+        ezos_critical_exit();
+        return EZOS_EINVAL;
+    }
+    rb->rd = (rb->rd + len) % rb->size;
+    rb->used -= len;
+    rb->peeking = 0;
+    ezos_critical_exit();
+
+    if (len > 0)
+        ezos_sem_give(rb->space);
+    return EZOS_SUCCESS;
+}
+
+uint32_t ezos_streambuf_send(ezos_streambuf_id_t sb, const void *data, uint32_t len, uint32_t timeout)
+{
+    ringbuf_t *rb = sb;
+    const uint8_t *src = data;
+    uint32_t start = ringbuf_ms();
+    uint32_t done = 0;
+
+    if (rb == NULL || data == NULL)
+        return 0;
+
+    while (done < len)
+    {
+        uint32_t n = len - done;
+        void *dst = stream_reserve(rb, &n, start, timeout);
+
+        if (dst == NULL)
+            break;
+        memcpy(dst, src + done, n);
+        ezos_streambuf_commit(rb, n);
+        done += n;
+    }
+    return done;
+}
+
+uint32_t ezos_streambuf_recv(ezos_streambuf_id_t sb, void *buf, uint32_t len, uint32_t timeout)
+{
+    ringbuf_t *rb = sb;
+    uint8_t *dst = buf;
+    uint32_t done = 0;
+
+    if (rb == NULL || buf == NULL)
+        return 0;
+
+    // 第一段按trigger等待，回绕后的第二段不再等待
+    while (done < len)
+    {
+        uint32_t n;
+        const void *src = stream_peek(rb, &n, ringbuf_ms(), done == 0 ? timeout : 0);
+
+        if (src == NULL)
+            break;
+        if (n > len - done)
+            n = len - done;
+        memcpy(dst + done, src, n);
+        ezos_streambuf_release(rb, n);
+        done += n;
+    }
+    return done;
+}
+
+uint32_t ezos_streambuf_bytes_get(ezos_streambuf_id_t sb)
+{
+    ringbuf_t *rb = sb;
+    uint32_t used;
+
+    if (rb == NULL)
+        return 0;
+
+    ezos_critical_enter();
+    used = rb->used;
+    ezos_critical_exit();
+    return used;
+}
+
+//  ==== Message Buffer ====
+static void *msg_reserve(ringbuf_t *rb, uint32_t len, uint32_t start, uint32_t timeout)
+{
+    uint32_t need = EZOS_MSGBUF_ITEM_SIZE(len);
+    uint32_t off = 0;
+    uint32_t pad = 0;
+    int found;
+
+    if (need > rb->size)
+        return NULL;
+
+    for (;;)
+    {
+        ezos_critical_enter();
+        if (rb->reserving)
+        {
+            ezos_critical_exit();
+            return NULL;
+        }
+        ringbuf_rewind(rb);
+        found = 0;
+        if (rb->used < rb->size)
+        {
+            if (rb->wr >= rb->rd)
+            {
+                // 空闲区为[wr, size)和[0, rd)
+                if (rb->size - rb->wr >= need)
+                {
+                    off = rb->wr;
+                    pad = 0;
+                    found = 1;
+                }
+                else if (rb->rd >= need)
+                {
+                    off = 0;
+                    pad = rb->size - rb->wr;
+                    found = 1;
+                }
+            }
+            else if (rb->rd - rb->wr >= need)
+            {
+                off = rb->wr;
+                pad = 0;
+                found = 1;
+            }
+        }
+        if (found)
+        {
+            rb->res_off = off;
+            rb->res_len = len;
+            rb->res_pad = pad;
+            rb->reserving = 1;
+            ezos_critical_exit();
+            return rb->buf + off + 4;
+        }
+        ezos_critical_exit();
+
+        if (ringbuf_wait(rb->space, start, timeout) != EZOS_SUCCESS)
+            return NULL;
+    }
+}
+
+ezos_msgbuf_id_t ezos_msgbuf_create(uint32_t size)
+{
+    size &= ~(uint32_t)(EZOS_MSGBUF_ALIGN - 1);
+    if (size < EZOS_MSGBUF_ITEM_SIZE(1))
+        return NULL;
+
+    return ringbuf_create(size);
+}
+
+ezos_msgbuf_id_t ezos_msgbuf_create_static(uint32_t size, ezos_msgbuf_static_t *storage, void *buf)
+{
+    size &= ~(uint32_t)(EZOS_MSGBUF_ALIGN - 1);
+    if (size < EZOS_MSGBUF_ITEM_SIZE(1) || storage == NULL || buf == NULL)
+        return NULL;
+    if (((uintptr_t)buf & (EZOS_MSGBUF_ALIGN - 1)) != 0)
+        return NULL;
+
+    return ringbuf_init((ringbuf_t *)storage, size, buf, 1);
+}
+
+void ezos_msgbuf_destroy(ezos_msgbuf_id_t mb)
+{
+    ringbuf_destroy(mb);
+}
+
+void *ezos_msgbuf_reserve(ezos_msgbuf_id_t mb, uint32_t len, uint32_t timeout)
+{
+    if (mb == NULL)
+        return NULL;
+
+    return msg_reserve(mb, len, ringbuf_ms(), timeout);
+}
+
+ezos_status_t ezos_msgbuf_commit(ezos_msgbuf_id_t mb, uint32_t len)
+{
+    ringbuf_t *rb = mb;
+
+    if (rb == NULL)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+    if (!rb->reserving || len > rb->res_len)
+    {
+        ezos_critical_exit();
+        return EZOS_EINVAL;
+    }
+    if (rb->res_pad != 0)
+        *(uint32_t *)(rb->buf + rb->wr) = MSGBUF_WRAP;
+    *(uint32_t *)(rb->buf + rb->res_off) = len;
+    rb->used += rb->res_pad + EZOS_MSGBUF_ITEM_SIZE(len);
+    rb->wr = (rb->res_off + EZOS_MSGBUF_ITEM_SIZE(len)) % rb->size;
+    rb->count++;
+    rb->reserving = 0;
+    ezos_critical_exit();
+
+    ezos_sem_give(rb->data);
+    return EZOS_SUCCESS;
+}
+
+const void *ezos_msgbuf_peek(ezos_msgbuf_id_t mb, uint32_t *len, uint32_t timeout)
+{
+    ringbuf_t *rb = mb;
+    uint32_t start = ringbuf_ms();
+    uint32_t hdr;
+
+    if (rb == NULL || len == NULL)
+        return NULL;
+
+    for (;;)
+    {
+        ezos_critical_enter();
+        if (rb->peeking)
+        {
+            ezos_critical_exit();
+            return NULL;
+        }
+        if (rb->count > 0)
+        {
+            hdr = *(uint32_t *)(rb->buf + rb->rd);
+            if (hdr == MSGBUF_WRAP)
+            {
+                rb->used -= rb->size - rb->rd;
+                rb->rd = 0;
+                hdr = *(uint32_t *)rb->buf;
+            }
+            rb->peek_len = hdr;
+            rb->peeking = 1;
+            ezos_critical_exit();
+            *len = hdr;
+            return rb->buf + rb->rd + 4;
+        }
+        ezos_critical_exit();
+
+        if (ringbuf_wait(rb->data, start, timeout) != EZOS_SUCCESS)
+            return NULL;
+    }
+}
+
+ezos_status_t ezos_msgbuf_release(ezos_msgbuf_id_t mb)
+{
+    ringbuf_t *rb = mb;
+
+    if (rb == NULL)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+    if (!rb->peeking)
+    {
+        ezos_critical_exit();
+        return EZOS_EINVAL;
+    }
+    rb->rd = (rb->rd + EZOS_MSGBUF_ITEM_SIZE(rb->peek_len)) % rb->size;
+    rb->used -= EZOS_MSGBUF_ITEM_SIZE(rb->peek_len);
+    rb->count--;
+    rb->peeking = 0;
+    ezos_critical_exit();
+
+    ezos_sem_give(rb->space);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_msgbuf_send(ezos_msgbuf_id_t mb, const void *data, uint32_t len, uint32_t timeout)
+{
+    ringbuf_t *rb = mb;
+    void *dst;
+
+    if (rb == NULL || (data == NULL && len != 0))
+        return EZOS_EINVAL;
+    if (EZOS_MSGBUF_ITEM_SIZE(len) > rb->size)
+        return EZOS_EINVAL;
+
+    dst = msg_reserve(rb, len, ringbuf_ms(), timeout);
+    if (dst == NULL)
+        return EZOS_TIMEOUT;
+
+    memcpy(dst, data, len);
+    return ezos_msgbuf_commit(rb, len);
+}
+
+uint32_t ezos_msgbuf_recv(ezos_msgbuf_id_t mb, void *buf, uint32_t len, uint32_t timeout)
+{
+    const void *src;
+    uint32_t n;
+
+    if (mb == NULL || buf == NULL)
+        return 0;
+
+    src = ezos_msgbuf_peek(mb, &n, timeout);
+    if (src == NULL)
+        return 0;
+
+    if (n > len)
+        n = len;
+    memcpy(buf, src, n);
+    ezos_msgbuf_release(mb);
+    return n;
+}
+
+uint32_t ezos_msgbuf_count_get(ezos_msgbuf_id_t mb)
+{
+    ringbuf_t *rb = mb;
+    uint32_t count;
+
+    if (rb == NULL)
+        return 0;
+
+    ezos_critical_enter();
+    count = rb->count;
+    ezos_critical_exit();
+    return count;
+}
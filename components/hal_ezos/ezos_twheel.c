@@ -0,0 +1,346 @@
+#include "ezos.h"
+
+#include <string.h>
+
+/*
+ * 分层时间轮，4级，每级64个槽，时间单位为EZOS_TWHEEL_TICK_MS，最长约2^24个tick。
+ *
+ * 定时器按剩余时间放到能容纳它的最低一级，槽号取到期时刻在该级对应的6位。
+ * 第0级每个tick处理一个槽；第0级转完一圈时，把上一级当前槽中的定时器按剩余时间
+ * 重新分配到下面各级(级联)，依此类推。启动和停止只是双向链表的插入和摘除。
+ *
+ * 槽是单指针表头的双向链表，节点记录指向自己的那个指针，表头只占一个指针，摘除仍是O(1)。
+ *
+ * 链表操作在ezos_critical_enter/exit内完成，回调在临界区外执行。
+ * 时间轮不单独占任务：由一个周期为一个tick的ezos定时器(FreeRTOS的定时器服务任务)或esp_timer驱动，
+ * 每次把落后的tick一次处理完；轮上没有定时器时停掉驱动定时器，有人启动定时器时再开。
+ */
+
+#if EZOS_TWHEEL_HRTIMER && !(defined(__linux__) || defined(__APPLE__))
+#define TWHEEL_USE_ESP_TIMER 1
+#include "esp_timer.h"
+#else
+#define TWHEEL_USE_ESP_TIMER 0
+#endif
+
+#define TWHEEL_BITS 6
+#define TWHEEL_SIZE (1u << TWHEEL_BITS)
+#define TWHEEL_MASK (TWHEEL_SIZE - 1)
+#define TWHEEL_LEVELS 4
+#define TWHEEL_MAX_TICKS ((1u << (TWHEEL_BITS * TWHEEL_LEVELS)) - 1)
+
+typedef struct
+{
+    ezos_wtimer_node_t *slot[TWHEEL_LEVELS][TWHEEL_SIZE];
+    uint32_t now;     // 下一个待处理的tick
+    uint32_t active;  // 在轮上的定时器数
+    uint8_t ready;    // 已初始化
+    uint8_t running;  // 驱动定时器已启动
+#if TWHEEL_USE_ESP_TIMER
+    esp_timer_handle_t drv;
+#else
+    ezos_timer_id_t drv;
+#endif
+} twheel_t;
+
+static twheel_t g_twheel;
+#if !TWHEEL_USE_ESP_TIMER
+EZOS_TIMER_STATIC_DEFINE(g_twheel_drv);
+#endif
+
+static uint64_t twheel_clock_ms(void)
+{
+#if TWHEEL_USE_ESP_TIMER
+    return (uint64_t)esp_timer_get_time() / 1000;
+#else
+    return (uint64_t)ezos_tick_conut_get() * 1000 / ezos_tick_freq_get();
+#endif
+}
+
+static uint32_t twheel_clock(void)
+{
+    return (uint32_t)(twheel_clock_ms() / EZOS_TWHEEL_TICK_MS);
+}
+
+static uint32_t twheel_ms_to_ticks(uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)ms + EZOS_TWHEEL_TICK_MS - 1) / EZOS_TWHEEL_TICK_MS);
+}
+
+//  ==== 链表，均在临界区内调用 ====
+static void twheel_list_add(ezos_wtimer_node_t **head, ezos_wtimer_node_t *node)
+{
+    node->next = *head;
+    if (node->next != NULL)
+        node->next->pprev = &node->next;
+    *head = node;
+    node->pprev = head;
+}
+
+static void twheel_list_del(ezos_wtimer_node_t *node)
+{
+    *node->pprev = node->next;
+    if (node->next != NULL)
+        node->next->pprev = node->pprev;
+    node->next = NULL;
+    node->pprev = NULL;
+}
+
+// 把from整条链表移到to上，from置空
+static void twheel_list_move(ezos_wtimer_node_t **from, ezos_wtimer_node_t **to)
+{
+    *to = *from;
+    if (*to != NULL)
+        (*to)->pprev = to;
+    *from = NULL;
+}
+
+//  ==== 时间轮，均在临界区内调用 ====
+static void twheel_place(ezos_wtimer_t *timer)
+{
+    twheel_t *w = &g_twheel;
+    uint32_t delta = timer->expire - w->now;
+    uint32_t level;
+
+    // 已经过期的放到当前槽，这一轮就处理
+    if ((int32_t)delta < 0)
+    {
+        timer->expire = w->now;
+        delta = 0;
+    }
+    if (delta > TWHEEL_MAX_TICKS)
+    {
+        timer->expire = w->now + TWHEEL_MAX_TICKS;
+        delta = TWHEEL_MAX_TICKS;
+    }
+
+    for (level = 0; level < TWHEEL_LEVELS - 1; level++)
+    {
+        if (delta < (1u << (TWHEEL_BITS * (level + 1))))
+            break;
+    }
+    twheel_list_add(&w->slot[level][(timer->expire >> (TWHEEL_BITS * level)) & TWHEEL_MASK], &timer->node);
+}
+
+static void twheel_cascade(uint32_t level, uint32_t idx)
+{
+    ezos_wtimer_node_t *list;
+
+    twheel_list_move(&g_twheel.slot[level][idx], &list);
+    while (list != NULL)
+    {
+        ezos_wtimer_t *timer = (ezos_wtimer_t *)list;
+
+        twheel_list_del(&timer->node);
+        twheel_place(timer);
+    }
+}
+
+// 处理一个tick，回调执行期间不持有临界区
+static void twheel_tick(void)
+{
+    twheel_t *w = &g_twheel;
+    ezos_wtimer_node_t *expired;
+    uint32_t idx;
+
+    ezos_critical_enter();
+    idx = w->now & TWHEEL_MASK;
+    if (idx == 0)
+    {
+        for (uint32_t level = 1; level < TWHEEL_LEVELS; level++)
+        {
+            uint32_t i = (w->now >> (TWHEEL_BITS * level)) & TWHEEL_MASK;
+
+            twheel_cascade(level, i);
+            if (i != 0)
+                break;
+        }
+    }
+    // 摘到本地链表上逐个执行，执行期间别处停止的定时器会从本地链表上摘掉
+    twheel_list_move(&w->slot[0][idx], &expired);
+    w->now++;
+
+    while (expired != NULL)
+    {
+        ezos_wtimer_t *timer = (ezos_wtimer_t *)expired;
+        ezos_thread_timer_cb cb = timer->cb;
+        void *arg = timer->arg;
+
+        twheel_list_del(&timer->node);
+        // 周期定时器先重新挂上，回调里可以直接停止
+        if (timer->period != 0)
+        {
+            timer->expire += timer->period;
+            twheel_place(timer);
+        }
+        else
+        {
+            w->active--;
+        }
+        ezos_critical_exit();
+
+        if (cb != NULL)
+            cb(arg);
+
+        ezos_critical_enter();
+    }
+    ezos_critical_exit();
+}
+
+static ezos_status_t twheel_drv_start(void)
+{
+#if TWHEEL_USE_ESP_TIMER
+    esp_err_t err = esp_timer_start_periodic(g_twheel.drv, EZOS_TWHEEL_TICK_MS * 1000);
+
+    // 已经在运行
+    return (err == ESP_OK || err == ESP_ERR_INVALID_STATE) ? EZOS_SUCCESS : EZOS_FAILURE;
+#else
+    return ezos_timer_start(g_twheel.drv, EZOS_TWHEEL_TICK_MS);
+#endif
+}
+
+static void twheel_drv_stop(void)
+{
+#if TWHEEL_USE_ESP_TIMER
+    esp_timer_stop(g_twheel.drv);
+#else
+    ezos_timer_stop(g_twheel.drv);
+#endif
+}
+
+// 驱动定时器的回调，补完落后的tick；轮上空了就停掉驱动定时器。
+// 停止和别处的启动可能交错，停止后再看一眼，期间有人启动过就重新启动，保证最后一条命令是启动
+static void twheel_drv_cb(void *arg)
+{
+    twheel_t *w = &g_twheel;
+    uint8_t idle;
+
+    (void)arg;
+    for (uint32_t clock = twheel_clock(); (int32_t)(clock - w->now) >= 0;)
+    {
+        twheel_tick();
+    }
+
+    ezos_critical_enter();
+    idle = w->active == 0;
+    if (idle)
+        w->running = 0;
+    ezos_critical_exit();
+    if (!idle)
+        return;
+
+    twheel_drv_stop();
+    ezos_critical_enter();
+    idle = w->running == 0;
+    ezos_critical_exit();
+    if (!idle)
+        twheel_drv_start();
+}
+
+ezos_status_t ezos_twheel_init(void)
+{
+    twheel_t *w = &g_twheel;
+
+    if (w->ready)
+        return EZOS_SUCCESS;
+
+    memset(w->slot, 0, sizeof(w->slot));
+    w->now = twheel_clock();
+    w->active = 0;
+    w->running = 0;
+
+#if TWHEEL_USE_ESP_TIMER
+    {
+        esp_timer_create_args_t args = {
+            .callback = twheel_drv_cb,
+            .name = "ezos_twheel",
+        };
+
+        if (esp_timer_create(&args, &w->drv) != ESP_OK)
+            return EZOS_FAILURE;
+    }
+#else
+    w->drv = EZOS_TIMER_CREATE_STATIC(g_twheel_drv, twheel_drv_cb, NULL, 1);
+    if (w->drv == NULL)
+        return EZOS_FAILURE;
+#endif
+    w->ready = 1;
+    return EZOS_SUCCESS;
+}
+
+void ezos_wtimer_init(ezos_wtimer_t *timer, ezos_thread_timer_cb cb, void *arg)
+{
+    if (timer == NULL)
+        return;
+
+    memset(timer, 0, sizeof(ezos_wtimer_t));
+    timer->cb = cb;
+    timer->arg = arg;
+}
+
+ezos_status_t ezos_wtimer_start(ezos_wtimer_t *timer, uint32_t ms, uint32_t period_ms)
+{
+    twheel_t *w = &g_twheel;
+    uint8_t kick = 0;
+
+    if (timer == NULL)
+        return EZOS_EINVAL;
+    if (!w->ready)
+        return EZOS_EPERM;
+
+    ezos_critical_enter();
+    if (timer->node.pprev != NULL)
+        twheel_list_del(&timer->node);
+    else
+        w->active++;
+    // 驱动定时器停着时轮上没有定时器，直接跳到当前时刻，启动后不用逐个补空tick
+    if (!w->running)
+    {
+        w->now = twheel_clock();
+        w->running = 1;
+        kick = 1;
+    }
+    // 从未取整的当前时刻算起再向上取整，当前tick已经过去的部分不计入定时，不会提前到期
+    timer->expire = (uint32_t)((twheel_clock_ms() + ms + EZOS_TWHEEL_TICK_MS - 1) / EZOS_TWHEEL_TICK_MS);
+    timer->period = twheel_ms_to_ticks(period_ms);
+    twheel_place(timer);
+    ezos_critical_exit();
+
+    // 启动失败时定时器留在轮上，下一次启动任意定时器时再试
+    if (kick && twheel_drv_start() != EZOS_SUCCESS)
+    {
+        ezos_critical_enter();
+        w->running = 0;
+        ezos_critical_exit();
+        return EZOS_FAILURE;
+    }
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_wtimer_stop(ezos_wtimer_t *timer)
+{
+    if (timer == NULL)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+    if (timer->node.pprev != NULL)
+    {
+        twheel_list_del(&timer->node);
+        g_twheel.active--;
+    }
+    ezos_critical_exit();
+    return EZOS_SUCCESS;
+}
+
+uint8_t ezos_wtimer_is_active(ezos_wtimer_t *timer)
+{
+    uint8_t active;
+
+    if (timer == NULL)
+        return 0;
+
+    ezos_critical_enter();
+    active = timer->node.pprev != NULL;
+    ezos_critical_exit();
+    return active;
+}
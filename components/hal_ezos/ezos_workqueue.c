@@ -0,0 +1,318 @@
+#include "ezos.h"
+
+#include <string.h>
+
+/*
+ * 工作队列：每个优先级一条单链表FIFO，工作任务按优先级从高到低取作业。
+ * 链表和作业状态在ezos_critical_enter/exit内修改，提交可以在中断中进行。
+ * 计数信号量只负责唤醒工作任务，醒来后把队列取空再睡，多余的计数只会造成一次空转。
+ *
+ * 作业状态：
+ *   PENDING  在队列中，或正在执行且执行完需要再执行一次
+ *   RUNNING  正在某个工作任务中执行
+ *   DELAYED  时间轮定时器已启动，到期后提交
+ */
+
+#define WORK_PENDING 0x01
+#define WORK_RUNNING 0x02
+#define WORK_DELAYED 0x04
+
+// 唤醒信号量的最大计数，超过后提交仍然成功，只是不再累加
+#define WORKQ_SEM_MAX 0xFFFF
+
+typedef struct
+{
+    ezos_work_t *head[EZOS_WORK_PRIO_NUM];
+    ezos_work_t *tail[EZOS_WORK_PRIO_NUM];
+    ezos_sem_id_t sem;
+} workqueue_t;
+
+static workqueue_t *g_sysworkq = NULL;
+
+// 临界区内调用
+static void workq_push(workqueue_t *wq, ezos_work_t *work)
+{
+    work->next = NULL;
+    if (wq->tail[work->prio] != NULL)
+        wq->tail[work->prio]->next = work;
+    else
+        wq->head[work->prio] = work;
+    wq->tail[work->prio] = work;
+}
+
+// 临界区内调用，取出优先级最高的作业并标记为正在执行
+static ezos_work_t *workq_pop(workqueue_t *wq)
+{
+    for (uint32_t prio = 0; prio < EZOS_WORK_PRIO_NUM; prio++)
+    {
+        ezos_work_t *work = wq->head[prio];
+
+        if (work == NULL)
+            continue;
+        wq->head[prio] = work->next;
+        if (wq->head[prio] == NULL)
+            wq->tail[prio] = NULL;
+        work->next = NULL;
+        work->state = (work->state & ~WORK_PENDING) | WORK_RUNNING;
+        return work;
+    }
+    return NULL;
+}
+
+// 临界区内调用
+static void workq_remove(workqueue_t *wq, ezos_work_t *work)
+{
+    ezos_work_t *prev = NULL;
+
+    for (ezos_work_t *cur = wq->head[work->prio]; cur != NULL; prev = cur, cur = cur->next)
+    {
+        if (cur != work)
+            continue;
+        if (prev != NULL)
+            prev->next = cur->next;
+        else
+            wq->head[work->prio] = cur->next;
+        if (wq->tail[work->prio] == cur)
+            wq->tail[work->prio] = prev;
+        cur->next = NULL;
+        return;
+    }
+}
+
+static void workq_worker(void *arg)
+{
+    workqueue_t *wq = arg;
+    ezos_work_t *work;
+
+    for (;;)
+    {
+        ezos_sem_take(wq->sem, EZOS_DELAY_FOREVER);
+
+        for (;;)
+        {
+            uint8_t again = 0;
+
+            ezos_critical_enter();
+            work = workq_pop(wq);
+            ezos_critical_exit();
+            if (work == NULL)
+                break;
+
+            work->func(work->arg);
+
+            // 执行期间又被提交过，重新排队；可能已被提交到别的工作队列
+            ezos_critical_enter();
+            work->state &= ~WORK_RUNNING;
+            if (work->state & WORK_PENDING)
+            {
+                workq_push(work->wq, work);
+                again = 1;
+            }
+            ezos_critical_exit();
+            if (again)
+                ezos_sem_give(((workqueue_t *)work->wq)->sem);
+        }
+    }
+}
+
+ezos_workqueue_id_t ezos_workqueue_create(const char *name, uint32_t workers, uint16_t priority, uint32_t stack_size)
+{
+    workqueue_t *wq;
+    ezos_thread_params_t param = {
+        .thread_name = (char *)name,
+        .priority = priority,
+        .stack_size = stack_size,
+    };
+
+    if (workers == 0)
+        return NULL;
+    if (ezos_twheel_init() != EZOS_SUCCESS)
+        return NULL;
+
+    wq = ezos_malloc(sizeof(workqueue_t));
+    if (wq == NULL)
+        return NULL;
+    memset(wq, 0, sizeof(workqueue_t));
+
+    wq->sem = ezos_sem_create(WORKQ_SEM_MAX, 0);
+    if (wq->sem == NULL)
+    {
+        ezos_free(wq);
+        return NULL;
+    }
+
+    // 工作任务不会退出，创建失败时已创建的任务留着也能正常工作
+    param.user_arg = wq;
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        if (ezos_thread_create(workq_worker, &param) == NULL)
+        {
+            if (i == 0)
+            {
+                ezos_sem_destroy(wq->sem);
+                ezos_free(wq);
+                return NULL;
+            }
+            break;
+        }
+    }
+    return wq;
+}
+
+ezos_status_t ezos_sysworkq_init(void)
+{
+    if (g_sysworkq != NULL)
+        return EZOS_SUCCESS;
+
+    g_sysworkq = ezos_workqueue_create("ezos_sysworkq", EZOS_SYSWORKQ_WORKERS, EZOS_SYSWORKQ_PRIORITY,
+                                       EZOS_SYSWORKQ_STACK_SIZE);
+    return g_sysworkq != NULL ? EZOS_SUCCESS : EZOS_FAILURE;
+}
+
+static void workq_timer_cb(void *arg)
+{
+    ezos_work_t *work = arg;
+    uint8_t due;
+
+    // 定时器回调和取消可能同时发生，以DELAYED标记为准
+    ezos_critical_enter();
+    due = (work->state & WORK_DELAYED) != 0;
+    work->state &= ~WORK_DELAYED;
+    ezos_critical_exit();
+
+    if (due)
+        ezos_work_submit(work->wq, work);
+}
+
+void ezos_work_init(ezos_work_t *work, ezos_thread_func_cb func, void *arg, ezos_work_prio_t prio)
+{
+    if (work == NULL)
+        return;
+
+    memset(work, 0, sizeof(ezos_work_t));
+    work->func = func;
+    work->arg = arg;
+    work->prio = prio < EZOS_WORK_PRIO_NUM ? prio : EZOS_WORK_PRIO_NORMAL;
+    ezos_wtimer_init(&work->timer, workq_timer_cb, work);
+}
+
+ezos_status_t ezos_work_submit(ezos_workqueue_id_t wq, ezos_work_t *work)
+{
+    workqueue_t *q = wq != NULL ? wq : g_sysworkq;
+    uint8_t queued = 0;
+
+    if (work == NULL || work->func == NULL)
+        return EZOS_EINVAL;
+    if (q == NULL)
+        return EZOS_EPERM;
+
+    ezos_critical_enter();
+    if (!(work->state & WORK_PENDING))
+    {
+        work->state |= WORK_PENDING;
+        work->wq = q;
+        // 正在执行的由工作任务在执行完后重新排队
+        if (!(work->state & WORK_RUNNING))
+        {
+            workq_push(q, work);
+            queued = 1;
+        }
+    }
+    ezos_critical_exit();
+
+    if (queued)
+        ezos_sem_give(q->sem);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_work_submit_delayed(ezos_workqueue_id_t wq, ezos_work_t *work, uint32_t ms)
+{
+    workqueue_t *q = wq != NULL ? wq : g_sysworkq;
+    uint8_t start = 0;
+
+    if (work == NULL || work->func == NULL)
+        return EZOS_EINVAL;
+    if (q == NULL)
+        return EZOS_EPERM;
+    if (ms == 0)
+        return ezos_work_submit(q, work);
+
+    ezos_critical_enter();
+    if (!(work->state & (WORK_PENDING | WORK_DELAYED)))
+    {
+        work->state |= WORK_DELAYED;
+        work->wq = q;
+        start = 1;
+    }
+    ezos_critical_exit();
+
+    if (start)
+        ezos_wtimer_start(&work->timer, ms, 0);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_work_reschedule(ezos_workqueue_id_t wq, ezos_work_t *work, uint32_t ms)
+{
+    workqueue_t *q = wq != NULL ? wq : g_sysworkq;
+    uint8_t start = 0;
+
+    if (work == NULL || work->func == NULL)
+        return EZOS_EINVAL;
+    if (q == NULL)
+        return EZOS_EPERM;
+
+    ezos_critical_enter();
+    if (work->state & WORK_DELAYED)
+    {
+        ezos_wtimer_stop(&work->timer);
+        work->state &= ~WORK_DELAYED;
+    }
+    // 已在排队的马上就会执行，不再启动定时器
+    if (ms != 0 && ms != EZOS_DELAY_FOREVER && !(work->state & WORK_PENDING))
+    {
+        work->state |= WORK_DELAYED;
+        work->wq = q;
+        start = 1;
+    }
+    ezos_critical_exit();
+
+    if (ms == 0)
+        return ezos_work_submit(q, work);
+    if (start)
+        ezos_wtimer_start(&work->timer, ms, 0);
+    return EZOS_SUCCESS;
+}
+
+ezos_status_t ezos_work_cancel(ezos_work_t *work)
+{
+    ezos_status_t ret;
+
+    if (work == NULL)
+        return EZOS_EINVAL;
+
+    ezos_critical_enter();
+    if (work->state & WORK_DELAYED)
+    {
+        ezos_wtimer_stop(&work->timer);
+        work->state &= ~WORK_DELAYED;
+    }
+    if ((work->state & WORK_PENDING) && !(work->state & WORK_RUNNING))
+        workq_remove(work->wq, work);
+    work->state &= ~WORK_PENDING;
+    ret = (work->state & WORK_RUNNING) ? EZOS_EBUZY : EZOS_SUCCESS;
+    ezos_critical_exit();
+    return ret;
+}
+
+uint8_t ezos_work_is_pending(ezos_work_t *work)
+{
+    uint8_t pending;
+
+    if (work == NULL)
+        return 0;
+
+    ezos_critical_enter();
+    pending = (work->state & (WORK_PENDING | WORK_DELAYED)) != 0;
+    ezos_critical_exit();
+    return pending;
+}
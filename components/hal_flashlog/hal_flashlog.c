@@ -0,0 +1,619 @@
+#include <stdio.h>
+#include <string.h>
+#include "hal_flashlog.h"
+#include "ezos.h"
+
+#include "esp_partition.h"
+#include "esp_log.h"
+
+#define TAG "hal_flashlog"
+
+#define FLASHLOG_MAGIC 0x474c5354 // "TSLG"
+#define FLASHLOG_SECTOR_SIZE 4096
+#define FLASHLOG_HDR_SIZE 16
+#define FLASHLOG_REC_SIZE sizeof(hal_flashlog_rec_t)
+#define FLASHLOG_REC_PER_SECTOR ((FLASHLOG_SECTOR_SIZE - FLASHLOG_HDR_SIZE) / FLASHLOG_REC_SIZE)
+
+// 查询时一次读出的记录数，也是一个上报帧的记录数
+#define FLASHLOG_READ_CHUNK (MAX_PROTOCOL_CMD_DATA_LEN / FLASHLOG_REC_SIZE)
+
+_Static_assert(sizeof(hal_flashlog_rec_t) == 16, "flashlog record must be 16 bytes");
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t gen;
+    uint8_t rsv[8];
+} flashlog_sector_hdr_t;
+
+// 扇区索引，gen为0表示扇区未使用
+typedef struct
+{
+    uint32_t gen;
+    uint32_t min_ts;
+    uint32_t max_ts;
+    uint16_t used;  // 已占用的记录位，包括crc错误的
+    uint16_t valid; // 有效记录数
+} flashlog_index_t;
+
+static const esp_partition_t *g_part = NULL;
+static ezos_mutex_id_t g_mutex = NULL;
+EZOS_MUTEX_STATIC_DEFINE(g_flashlog);
+static flashlog_index_t g_index[HAL_FLASHLOG_MAX_SECTORS];
+static uint16_t g_sectors = 0;
+static uint16_t g_head = 0; // 正在写入的扇区
+static uint32_t g_gen = 0;  // 最新扇区的代号
+static hal_flashlog_rec_t g_batch[HAL_FLASHLOG_BATCH]; // 从队列取出待写flash的记录，持有g_mutex时使用
+
+// 日志时钟：挂载时flash中最新记录的时间+1，加上开机以来的秒数
+static uint32_t g_clock_base = 0;
+static uint8_t g_boot = 0;
+
+// 追加和写flash之间的队列，用临界区保护，里面不访问flash
+static hal_flashlog_rec_t g_queue[HAL_FLASHLOG_QUEUE];
+static uint16_t g_queue_head = 0;
+static uint16_t g_queue_len = 0;
+static uint32_t g_queue_dropped = 0;
+static ezos_work_t g_flush_work;
+
+// 查询游标：从开始查询时最旧的扇区读到当时的写入位置，之后写入的记录不包括在内
+typedef struct
+{
+    uint32_t start;
+    uint32_t end;
+    uint32_t gen;       // 正在读的扇区的代号，读的过程中扇区被覆盖时跳过剩下的部分
+    uint16_t head;      // 开始查询时正在写入的扇区
+    uint16_t head_used; // 开始查询时写入扇区已占用的记录位
+    uint16_t k;         // 正在读第k旧的扇区，1..g_sectors，超过g_sectors表示读完
+    uint16_t slot;      // 扇区内下一个要读的记录位
+} flashlog_cursor_t;
+
+static uint8_t flashlog_crc8(const uint8_t *data, uint16_t len)
+{
+    uint8_t crc = 0;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t flashlog_rec_crc(const hal_flashlog_rec_t *rec)
+{
+    hal_flashlog_rec_t tmp = *rec;
+    tmp.crc = 0;
+    return flashlog_crc8((const uint8_t *)&tmp, sizeof(tmp));
+}
+
+static int flashlog_rec_empty(const hal_flashlog_rec_t *rec)
+{
+    const uint8_t *p = (const uint8_t *)rec;
+    for (size_t i = 0; i < sizeof(*rec); i++)
+    {
+        if (p[i] != 0xff)
+            return 0;
+    }
+    return 1;
+}
+
+static uint32_t flashlog_rec_addr(uint16_t sector, uint16_t slot)
+{
+    return (uint32_t)sector * FLASHLOG_SECTOR_SIZE + FLASHLOG_HDR_SIZE + slot * FLASHLOG_REC_SIZE;
+}
+
+static void flashlog_index_add(flashlog_index_t *idx, const hal_flashlog_rec_t *rec)
+{
+    if (idx->valid == 0 || rec->ts < idx->min_ts)
+        idx->min_ts = rec->ts;
+    if (idx->valid == 0 || rec->ts > idx->max_ts)
+        idx->max_ts = rec->ts;
+    idx->valid++;
+}
+
+// 挂载时找最新的记录，日志时钟和开机计数从它接着走
+static void flashlog_clock_restore(const hal_flashlog_rec_t *rec)
+{
+    if (rec->ts >= g_clock_base)
+    {
+        g_clock_base = rec->ts + 1;
+        g_boot = (uint8_t)(rec->boot + 1);
+    }
+}
+
+// 读扇区建立索引，记录按顺序写入，遇到第一个空记录即结束
+static int flashlog_sector_load(uint16_t sector)
+{
+    flashlog_index_t *idx = &g_index[sector];
+    flashlog_sector_hdr_t hdr;
+    hal_flashlog_rec_t recs[FLASHLOG_READ_CHUNK];
+
+    memset(idx, 0, sizeof(*idx));
+    if (esp_partition_read(g_part, (uint32_t)sector * FLASHLOG_SECTOR_SIZE, &hdr, sizeof(hdr)) != ESP_OK)
+        return -1;
+    if (hdr.magic != FLASHLOG_MAGIC || hdr.gen == 0 || hdr.gen == 0xffffffff)
+        return 0;
+
+    idx->gen = hdr.gen;
+    for (uint16_t slot = 0; slot < FLASHLOG_REC_PER_SECTOR; slot += FLASHLOG_READ_CHUNK)
+    {
+        uint16_t n = FLASHLOG_REC_PER_SECTOR - slot;
+        if (n > FLASHLOG_READ_CHUNK)
+            n = FLASHLOG_READ_CHUNK;
+
+        if (esp_partition_read(g_part, flashlog_rec_addr(sector, slot), recs, n * FLASHLOG_REC_SIZE) != ESP_OK)
+            return -1;
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            if (flashlog_rec_empty(&recs[i]))
+                return 0;
+
+            idx->used++;
+            if (recs[i].crc == flashlog_rec_crc(&recs[i]))
+            {
+                flashlog_index_add(idx, &recs[i]);
+                flashlog_clock_restore(&recs[i]);
+            }
+        }
+    }
+    return 0;
+}
+
+// 擦除扇区并写入新代号的头
+static int flashlog_sector_open(uint16_t sector)
+{
+    flashlog_sector_hdr_t hdr;
+
+    if (esp_partition_erase_range(g_part, (uint32_t)sector * FLASHLOG_SECTOR_SIZE, FLASHLOG_SECTOR_SIZE) != ESP_OK)
+        return -1;
+
+    memset(&hdr, 0xff, sizeof(hdr));
+    hdr.magic = FLASHLOG_MAGIC;
+    hdr.gen = ++g_gen;
+    if (esp_partition_write(g_part, (uint32_t)sector * FLASHLOG_SECTOR_SIZE, &hdr, sizeof(hdr)) != ESP_OK)
+        return -1;
+
+    memset(&g_index[sector], 0, sizeof(g_index[sector]));
+    g_index[sector].gen = hdr.gen;
+    g_head = sector;
+    return 0;
+}
+
+static uint16_t flashlog_queue_pop(hal_flashlog_rec_t *recs, uint16_t max)
+{
+    uint16_t n = 0;
+
+    ezos_critical_enter();
+    while (n < max && g_queue_len > 0)
+    {
+        recs[n++] = g_queue[g_queue_head];
+        g_queue_head = (g_queue_head + 1) % HAL_FLASHLOG_QUEUE;
+        g_queue_len--;
+    }
+    ezos_critical_exit();
+    return n;
+}
+
+static int flashlog_write_locked(const hal_flashlog_rec_t *recs, uint16_t len)
+{
+    uint16_t done = 0;
+
+    while (done < len)
+    {
+        flashlog_index_t *idx = &g_index[g_head];
+        uint16_t n = len - done;
+
+        if (idx->used >= FLASHLOG_REC_PER_SECTOR)
+        {
+            // 写满后覆盖最旧的扇区
+            if (flashlog_sector_open((g_head + 1) % g_sectors) != 0)
+                break;
+            continue;
+        }
+
+        if (n > FLASHLOG_REC_PER_SECTOR - idx->used)
+            n = FLASHLOG_REC_PER_SECTOR - idx->used;
+
+        // 失败时记录位也算占用，避免在写坏的位置上重写
+        esp_err_t err = esp_partition_write(g_part, flashlog_rec_addr(g_head, idx->used), &recs[done], n * FLASHLOG_REC_SIZE);
+        idx->used += n;
+        if (err != ESP_OK)
+            break;
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            flashlog_index_add(idx, &recs[done + i]);
+        }
+        done += n;
+    }
+
+    // 写失败的记录丢弃，不阻塞后续写入
+    return done < len ? -1 : 0;
+}
+
+static int flashlog_flush_locked(void)
+{
+    uint16_t n;
+    uint32_t dropped;
+    int ret = 0;
+
+    while ((n = flashlog_queue_pop(g_batch, HAL_FLASHLOG_BATCH)) > 0)
+    {
+        if (flashlog_write_locked(g_batch, n) != 0)
+            ret = -1;
+    }
+
+    ezos_critical_enter();
+    dropped = g_queue_dropped;
+    g_queue_dropped = 0;
+    ezos_critical_exit();
+    if (dropped > 0)
+        ESP_LOGW(TAG, "queue full, %u records dropped", (unsigned)dropped);
+    return ret;
+}
+
+static void flashlog_flush_work(void *arg)
+{
+    (void)arg;
+    hal_flashlog_flush();
+}
+
+int hal_flashlog_init(void)
+{
+    int32_t newest = -1;
+
+    if (g_part != NULL)
+        return 0;
+
+    g_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HAL_FLASHLOG_PARTITION);
+    if (g_part == NULL)
+    {
+        ESP_LOGW(TAG, "partition %s not found", HAL_FLASHLOG_PARTITION);
+        return -1;
+    }
+
+    g_sectors = g_part->size / FLASHLOG_SECTOR_SIZE;
+    if (g_sectors > HAL_FLASHLOG_MAX_SECTORS)
+        g_sectors = HAL_FLASHLOG_MAX_SECTORS;
+    if (g_sectors < 2)
+    {
+        g_part = NULL;
+        return -1;
+    }
+
+    if (g_mutex == NULL)
+        g_mutex = EZOS_MUTEX_CREATE_STATIC(g_flashlog);
+    if (g_mutex == NULL || ezos_sysworkq_init() != EZOS_SUCCESS)
+    {
+        g_part = NULL;
+        return -1;
+    }
+    ezos_work_init(&g_flush_work, flashlog_flush_work, NULL, EZOS_WORK_PRIO_LOW);
+
+    g_gen = 0;
+    g_clock_base = 0;
+    g_boot = 0;
+    for (uint16_t s = 0; s < g_sectors; s++)
+    {
+        if (flashlog_sector_load(s) != 0)
+        {
+            ESP_LOGW(TAG, "read sector %u failed", s);
+            continue;
+        }
+        if (g_index[s].gen > g_gen)
+        {
+            g_gen = g_index[s].gen;
+            newest = s;
+        }
+    }
+
+    if (newest < 0)
+    {
+        if (flashlog_sector_open(0) != 0)
+        {
+            g_part = NULL;
+            return -1;
+        }
+    }
+    else
+    {
+        g_head = (uint16_t)newest;
+    }
+    return 0;
+}
+
+uint32_t hal_flashlog_now(void)
+{
+    return g_clock_base + (uint32_t)(ezos_time_us() / 1000000);
+}
+
+int hal_flashlog_append(uint8_t tag, uint8_t type, int64_t val)
+{
+    hal_flashlog_rec_t rec;
+    uint16_t len;
+
+    if (g_part == NULL)
+        return -1;
+
+    rec.ts = hal_flashlog_now();
+    rec.boot = g_boot;
+    rec.tag = tag;
+    rec.type = type;
+    rec.val = val;
+    rec.crc = flashlog_rec_crc(&rec);
+
+    ezos_critical_enter();
+    if (g_queue_len >= HAL_FLASHLOG_QUEUE)
+    {
+        g_queue_dropped++;
+        ezos_critical_exit();
+        return -1;
+    }
+    g_queue[(g_queue_head + g_queue_len) % HAL_FLASHLOG_QUEUE] = rec;
+    len = ++g_queue_len;
+    ezos_critical_exit();
+
+    // 写flash放到工作队列中，调用者可能正持有别的锁
+    if (len >= HAL_FLASHLOG_BATCH)
+        ezos_work_submit(NULL, &g_flush_work);
+    return 0;
+}
+
+int hal_flashlog_flush(void)
+{
+    int ret;
+
+    if (g_part == NULL)
+        return -1;
+
+    ezos_mutex_lock(g_mutex);
+    ret = flashlog_flush_locked();
+    ezos_mutex_unlock(g_mutex);
+    return ret;
+}
+
+static void flashlog_cursor_init(flashlog_cursor_t *cur, uint32_t start, uint32_t end)
+{
+    memset(cur, 0, sizeof(*cur));
+    cur->start = start;
+    cur->end = end;
+    cur->k = 1;
+
+    ezos_mutex_lock(g_mutex);
+    flashlog_flush_locked();
+    cur->head = g_head;
+    cur->head_used = g_index[g_head].used;
+    ezos_mutex_unlock(g_mutex);
+}
+
+// 最多读一块记录，把在时间范围内的有效记录放入recs，返回放入的条数，读完时返回-1。
+// 只在读flash时持有g_mutex，调用者在锁外处理记录
+static int flashlog_cursor_read(flashlog_cursor_t *cur, hal_flashlog_rec_t *recs)
+{
+    int n = -1;
+
+    ezos_mutex_lock(g_mutex);
+    while (cur->k <= g_sectors)
+    {
+        uint16_t s = (cur->head + cur->k) % g_sectors;
+        const flashlog_index_t *idx = &g_index[s];
+        uint16_t used = cur->k == g_sectors ? cur->head_used : idx->used;
+        uint16_t cnt;
+
+        if (cur->slot == 0)
+            cur->gen = idx->gen;
+        // 跳过时间范围不相交、读完或读的过程中被覆盖的扇区
+        if (idx->gen == 0 || idx->gen != cur->gen || idx->valid == 0 || idx->max_ts < cur->start ||
+            idx->min_ts > cur->end || cur->slot >= used)
+        {
+            cur->k++;
+            cur->slot = 0;
+            continue;
+        }
+
+        cnt = used - cur->slot;
+        if (cnt > FLASHLOG_READ_CHUNK)
+            cnt = FLASHLOG_READ_CHUNK;
+        if (esp_partition_read(g_part, flashlog_rec_addr(s, cur->slot), recs, cnt * FLASHLOG_REC_SIZE) != ESP_OK)
+        {
+            cur->k++;
+            cur->slot = 0;
+            continue;
+        }
+        cur->slot += cnt;
+
+        n = 0;
+        for (uint16_t i = 0; i < cnt; i++)
+        {
+            if (recs[i].ts < cur->start || recs[i].ts > cur->end || flashlog_rec_empty(&recs[i]) ||
+                recs[i].crc != flashlog_rec_crc(&recs[i]))
+                continue;
+            recs[n++] = recs[i];
+        }
+        break;
+    }
+    ezos_mutex_unlock(g_mutex);
+    return n;
+}
+
+int hal_flashlog_query(uint32_t start, uint32_t end, hal_flashlog_visit_cb_t cb, void *arg)
+{
+    hal_flashlog_rec_t recs[FLASHLOG_READ_CHUNK];
+    flashlog_cursor_t cur;
+    int count = 0;
+    int n;
+
+    if (g_part == NULL)
+        return -1;
+
+    flashlog_cursor_init(&cur, start, end);
+    while ((n = flashlog_cursor_read(&cur, recs)) >= 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            count++;
+            if (cb != NULL && cb(&recs[i], arg) != 0)
+                return count;
+        }
+    }
+    return count;
+}
+
+int hal_flashlog_erase(void)
+{
+    const uint32_t zero = 0;
+    int ret = 0;
+
+    if (g_part == NULL)
+        return -1;
+
+    // 整个分区擦除要几秒，这里只把各扇区头的magic写成0(只把1写成0，不用擦除)，挂载时就不认了，
+    // 只擦除重新开始写的第0个扇区，其余扇区等循环写到时再擦
+    ezos_mutex_lock(g_mutex);
+    ezos_critical_enter();
+    g_queue_len = 0;
+    ezos_critical_exit();
+    for (uint16_t s = 0; s < g_sectors; s++)
+    {
+        if (g_index[s].gen != 0 && esp_partition_write(g_part, (uint32_t)s * FLASHLOG_SECTOR_SIZE, &zero, sizeof(zero)) != ESP_OK)
+            ret = -1;
+    }
+    memset(g_index, 0, sizeof(g_index));
+    g_gen = 0;
+    if (ret == 0)
+        ret = flashlog_sector_open(0);
+    ezos_mutex_unlock(g_mutex);
+    return ret;
+}
+
+void hal_flashlog_monitor_hook(uint8_t tag, uint8_t type, int64_t val)
+{
+    hal_flashlog_append(tag, type, val);
+}
+
+//  ==== TLV查询 ====
+// 查询在系统工作队列的低优先级道上分批进行，每次作业最多读FLASHLOG_QUERY_CHUNKS块，读完一批重新提交自己，
+// 不长时间占住工作任务和g_mutex，写flash的作业可以插在两批之间
+#define FLASHLOG_QUERY_CHUNKS 4
+
+typedef struct
+{
+    uint8_t tag;
+    uint8_t transfer_method;
+    uint16_t max;
+    uint32_t sent;
+    uint16_t len;
+    uint8_t buf[FLASHLOG_READ_CHUNK * FLASHLOG_REC_SIZE];
+} flashlog_tlv_ctx_t;
+
+static flashlog_tlv_ctx_t g_tlv;
+static flashlog_cursor_t g_tlv_cur;
+static uint8_t g_tlv_busy = 0;
+static ezos_work_t g_tlv_work;
+
+static void flashlog_tlv_send(flashlog_tlv_ctx_t *ctx)
+{
+    if (ctx->len == 0)
+        return;
+
+    general_htlvc_protocol_report(ctx->tag, ctx->len, ctx->buf, ctx->transfer_method);
+    ctx->len = 0;
+}
+
+// 9BYTE的结束帧：实际发送的条数(4) | 当前日志时钟(4) | 当前开机计数(1)
+static void flashlog_tlv_finish(flashlog_tlv_ctx_t *ctx)
+{
+    uint8_t val[9];
+    uint32_t now = hal_flashlog_now();
+
+    flashlog_tlv_send(ctx);
+    for (int i = 0; i < 4; i++)
+    {
+        val[i] = (uint8_t)(ctx->sent >> (8 * i));
+        val[4 + i] = (uint8_t)(now >> (8 * i));
+    }
+    val[8] = g_boot;
+    general_htlvc_protocol_report(ctx->tag, sizeof(val), val, ctx->transfer_method);
+}
+
+static int flashlog_tlv_visit(const hal_flashlog_rec_t *rec, void *arg)
+{
+    flashlog_tlv_ctx_t *ctx = (flashlog_tlv_ctx_t *)arg;
+
+    memcpy(&ctx->buf[ctx->len], rec, FLASHLOG_REC_SIZE);
+    ctx->len += FLASHLOG_REC_SIZE;
+    ctx->sent++;
+    if (ctx->len + FLASHLOG_REC_SIZE > sizeof(ctx->buf))
+        flashlog_tlv_send(ctx);
+
+    return ctx->max && ctx->sent >= ctx->max;
+}
+
+static void flashlog_tlv_work(void *arg)
+{
+    hal_flashlog_rec_t recs[FLASHLOG_READ_CHUNK];
+    int n;
+
+    (void)arg;
+    for (int c = 0; c < FLASHLOG_QUERY_CHUNKS; c++)
+    {
+        n = flashlog_cursor_read(&g_tlv_cur, recs);
+        for (int i = 0; i < n; i++)
+        {
+            if (flashlog_tlv_visit(&recs[i], &g_tlv) != 0)
+            {
+                n = -1;
+                break;
+            }
+        }
+        if (n < 0)
+        {
+            flashlog_tlv_finish(&g_tlv);
+            ezos_critical_enter();
+            g_tlv_busy = 0;
+            ezos_critical_exit();
+            return;
+        }
+    }
+    ezos_work_submit(NULL, &g_tlv_work);
+}
+
+static uint32_t flashlog_get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int hal_flashlog_tlv_query(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data)
+{
+    uint8_t busy;
+
+    rsp_tlv_data->transfer_method = cmd_tlv_data->transfer_method;
+    rsp_tlv_data->len = 1;
+    rsp_tlv_data->val[0] = PROTOCOL_RSP_ERR;
+    if (cmd_tlv_data->len < 8 || g_part == NULL)
+        return -1;
+
+    // 同一时间只有一个查询
+    ezos_critical_enter();
+    busy = g_tlv_busy;
+    g_tlv_busy = 1;
+    ezos_critical_exit();
+    if (busy)
+        return -1;
+
+    memset(&g_tlv, 0, sizeof(g_tlv));
+    g_tlv.tag = cmd_tlv_data->tag;
+    g_tlv.transfer_method = cmd_tlv_data->transfer_method;
+    if (cmd_tlv_data->len >= 10)
+        g_tlv.max = cmd_tlv_data->val[8] | (cmd_tlv_data->val[9] << 8);
+    flashlog_cursor_init(&g_tlv_cur, flashlog_get_le32(cmd_tlv_data->val), flashlog_get_le32(&cmd_tlv_data->val[4]));
+
+    ezos_work_init(&g_tlv_work, flashlog_tlv_work, NULL, EZOS_WORK_PRIO_LOW);
+    ezos_work_submit(NULL, &g_tlv_work);
+    rsp_tlv_data->val[0] = PROTOCOL_RSP_OK;
+    return 0;
+}
@@ -0,0 +1,80 @@
+#ifndef __HAL_FLASHLOG_H__
+#define __HAL_FLASHLOG_H__
+
+#include <stdint.h>
+#include "tlv_protocol.h"
+
+/*
+ * 时序日志：按扇区循环写入独立分区，写满后擦除最旧的扇区
+ *
+ * 扇区：头(16BYTE) + 255条记录，头中的代号单调递增，决定扇区先后
+ * 记录：定长16BYTE，小端，掉电写了一半的记录由crc8识别丢弃
+ * 索引：每个扇区的时间范围常驻内存，查询时跳过不相交的扇区
+ * 时间：日志时钟，单位秒，挂载时从flash中最新记录的时间接着走，重启后不回退，
+ *       与墙上时间无关，主机用查询响应中的当前日志时钟换算成自己的时间
+ * 写入：追加只把记录放入内存队列，攒满一批后由系统工作队列中的作业写flash，
+ *       所以可以在持有其他锁的回调(如monitor记录钩子)中调用
+ */
+
+#define HAL_FLASHLOG_PARTITION "tslog"
+
+// 支持的最大扇区数，分区更大时多出的部分不使用
+#ifndef HAL_FLASHLOG_MAX_SECTORS
+#define HAL_FLASHLOG_MAX_SECTORS 64
+#endif
+
+// 攒满这么多条记录提交一次写flash的作业
+#ifndef HAL_FLASHLOG_BATCH
+#define HAL_FLASHLOG_BATCH 8
+#endif
+
+// 内存队列的记录数，写flash跟不上时多出的记录丢弃
+#ifndef HAL_FLASHLOG_QUEUE
+#define HAL_FLASHLOG_QUEUE 32
+#endif
+
+typedef struct
+{
+    uint32_t ts;  // 日志时钟，秒
+    uint8_t boot; // 开机计数低8位，相邻记录不同说明中间重启过
+    uint8_t tag;  // 监控字段的TLV标签
+    uint8_t type; // filed_type
+    uint8_t crc;  // 除本字节外15BYTE的crc8
+    int64_t val;
+} hal_flashlog_rec_t;
+
+typedef int (*hal_flashlog_visit_cb_t)(const hal_flashlog_rec_t *rec, void *arg);
+
+/// @brief 挂载分区、建立索引并恢复日志时钟，同时初始化系统工作队列，需在任务中调用
+/// @return 0:成功 -1:分区不存在或读写失败
+int hal_flashlog_init(void);
+
+/// @brief 当前日志时钟，单位秒
+uint32_t hal_flashlog_now(void);
+
+/// @brief 追加一条记录，只放入内存队列，不访问flash
+/// @return 0:成功 -1:未初始化或队列已满
+int hal_flashlog_append(uint8_t tag, uint8_t type, int64_t val);
+
+/// @brief 把队列中的记录写入flash
+int hal_flashlog_flush(void);
+
+/// @brief 按写入顺序遍历日志时钟在[start, end]内的记录，cb返回非0时停止
+/// 一次读一块记录，cb在不持锁时调用，可以在其中发送；开始查询之后写入的记录不包括在内
+/// @return 遍历的记录数，-1:未初始化
+int hal_flashlog_query(uint32_t start, uint32_t end, hal_flashlog_visit_cb_t cb, void *arg);
+
+/// @brief 擦除全部记录，只作废各扇区头并擦除一个扇区，其余扇区循环写到时再擦
+int hal_flashlog_erase(void);
+
+/// @brief 可直接作为monitor_record_hook_set()的钩子
+void hal_flashlog_monitor_hook(uint8_t tag, uint8_t type, int64_t val);
+
+/// @brief TLV查询处理函数，注册到协议表中使用
+/// 命令：起始时间(4) | 结束时间(4) | [最大条数(2)]，小端，时间为日志时钟
+/// 响应：PROTOCOL_RSP_OK(1)，参数错误或上一个查询还没结束时为PROTOCOL_RSP_ERR(1)
+/// 查询在系统工作队列中分批进行，记录以同一标签的0xCC上报帧发送，每帧最多8条，长度为16BYTE的整数倍；
+/// 最后一帧为9BYTE的结束帧：实际发送的条数(4) | 当前日志时钟(4) | 当前开机计数(1)
+int hal_flashlog_tlv_query(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data);
+
+#endif
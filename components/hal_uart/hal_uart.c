@@ -3,13 +3,12 @@
 #include "hal_uart.h"
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "sdkconfig.h"
 #include "esp_log.h"
 
-#include "freertos/queue.h"
+#include "ezos.h"
 
 #define ECHO_TEST_TXD (3)
 #define ECHO_TEST_RXD (4)
@@ -18,13 +17,57 @@
 
 #define ECHO_UART_PORT_NUM (1)
 #define ECHO_UART_BAUD_RATE (115200)
-#define ECHO_TASK_STACK_SIZE (3072)
 
 #define BUF_SIZE (1024)
 
-static QueueHandle_t g_uart_xQueue;
+// 串口没有事件队列，按这个周期在系统工作队列中取数据，数据先留在驱动的接收缓冲区里
+#define UART_POLL_MS 20
 
-static void uart_task(void *arg)
+#define UART_QUEUE_LEN 10
+#define UART_MSGBUF_SIZE EZOS_MSGBUF_BUF_SIZE(MAX_UART_LEN, UART_QUEUE_LEN)
+
+static ezos_msgbuf_id_t g_uart_msgbuf;
+static volatile hal_uart_rx_cb g_uart_rx_cb = NULL;
+static ezos_work_t g_uart_poll_work;
+EZOS_MSGBUF_STATIC_DEFINE(g_uart_msg, UART_MSGBUF_SIZE);
+
+// 在系统工作队列中执行，不阻塞：消息缓冲区满了就等下一轮，执行完再延时提交自己。
+// 作业不会并发执行，借出的空间可以跨轮保存
+static void uart_poll_work(void *arg)
+{
+    // 直接读到消息缓冲区借出的空间里，没读到数据时这块空间留到下一轮继续用
+    static uint8_t *data = NULL;
+    uint8_t got = 0;
+
+    (void)arg;
+    for (;;)
+    {
+        int len;
+
+        if (data == NULL)
+            data = ezos_msgbuf_reserve(g_uart_msgbuf, MAX_UART_LEN, 0);
+        if (data == NULL)
+            break;
+
+        len = uart_read_bytes(ECHO_UART_PORT_NUM, data, MAX_UART_LEN, 0);
+        if (len <= 0)
+            break;
+        ezos_msgbuf_commit(g_uart_msgbuf, len);
+        data = NULL;
+        got = 1;
+    }
+
+    if (got)
+    {
+        hal_uart_rx_cb cb = g_uart_rx_cb;
+
+        if (cb != NULL)
+            cb();
+    }
+    ezos_work_submit_delayed(NULL, &g_uart_poll_work, UART_POLL_MS);
+}
+
+int hal_uart_init(void)
 {
     /* Configure parameters of an UART driver,
      * communication pins and install the driver */
@@ -42,56 +85,16 @@ static void uart_task(void *arg)
     intr_alloc_flags = ESP_INTR_FLAG_IRAM;
 #endif
 
+    g_uart_msgbuf = EZOS_MSGBUF_CREATE_STATIC(g_uart_msg, UART_MSGBUF_SIZE);
+    if (g_uart_msgbuf == NULL || ezos_sysworkq_init() != EZOS_SUCCESS)
+        return -1;
+
     ESP_ERROR_CHECK(uart_driver_install(ECHO_UART_PORT_NUM, BUF_SIZE * 2, 0, 0, NULL, intr_alloc_flags));
     ESP_ERROR_CHECK(uart_param_config(ECHO_UART_PORT_NUM, &uart_config));
     ESP_ERROR_CHECK(uart_set_pin(ECHO_UART_PORT_NUM, ECHO_TEST_TXD, ECHO_TEST_RXD, ECHO_TEST_RTS, ECHO_TEST_CTS));
 
-    // Configure a temporary buffer for the incoming data
-    uint8_t *data = (uint8_t *)malloc(BUF_SIZE);
-
-    while (1)
-    {
-        // Read data from the UART
-        int len = uart_read_bytes(ECHO_UART_PORT_NUM, data, (BUF_SIZE - 1), 20 / portTICK_PERIOD_MS);
-        if (len > 0)
-        {
-            hal_uart_msg_t *msg = hal_uart_msg_new(data, len);
-            if (msg != NULL)
-                xQueueSend(g_uart_xQueue, &msg, 10 / portTICK_PERIOD_MS);
-        }
-
-        // Write data back to the UART
-        // uart_write_bytes(ECHO_UART_PORT_NUM, (const char *)data, len);
-        // if (len)
-        // {
-        //     data[len] = '\0';
-        //     ESP_LOGI(TAG, "Recv str: %s", (char *)data);
-        // }
-    }
-}
-
-hal_uart_msg_t *hal_uart_msg_new(uint8_t *data, uint32_t len)
-{
-    uint32_t cur_len = len > MAX_UART_LEN ? MAX_UART_LEN : len;
-    hal_uart_msg_t *msg = (hal_uart_msg_t *)malloc(sizeof(hal_uart_msg_t));
-    if (msg == NULL)
-        return NULL;
-    msg->len = cur_len;
-    memcpy(msg->data, data, cur_len);
-
-    return msg;
-}
-
-void hal_uart_msg_del(hal_uart_msg_t *msg)
-{
-    free(msg);
-}
-
-int hal_uart_init(void)
-{
-    xTaskCreate(uart_task, "uart_task", ECHO_TASK_STACK_SIZE, NULL, 10, NULL);
-    g_uart_xQueue = xQueueCreate(10, sizeof(hal_uart_msg_t *));
-
+    ezos_work_init(&g_uart_poll_work, uart_poll_work, NULL, EZOS_WORK_PRIO_NORMAL);
+    ezos_work_submit(NULL, &g_uart_poll_work);
     return 0;
 }
 
@@ -102,17 +105,22 @@ int hal_uart_send(uint8_t *buf, uint32_t len)
 
 int hal_uart_recv(uint8_t *buf, uint32_t buf_len, uint32_t timeout)
 {
+    const void *data;
+    uint32_t len;
+
+    data = ezos_msgbuf_peek(g_uart_msgbuf, &len, timeout);
+    if (data == NULL)
+        return 0;
+
+    if (len > buf_len)
+        len = buf_len;
+    if (buf != NULL)
+        memcpy(buf, data, len);
+    ezos_msgbuf_release(g_uart_msgbuf);
+    return len;
+}
 
-    hal_uart_msg_t *msg = NULL;
-    if (xQueueReceive(g_uart_xQueue, &msg, timeout) == pdTRUE)
-    {
-        uint32_t cur_len = buf_len < msg->len ? buf_len : msg->len;
-        if (buf != NULL)
-        {
-            memcpy(buf, msg->data, cur_len);
-        }
-        hal_uart_msg_del(msg);
-        return cur_len;
-    }
-    return 0;
-}
\ No newline at end of file
+void hal_uart_rx_cb_set(hal_uart_rx_cb cb)
+{
+    g_uart_rx_cb = cb;
+}
@@ -2,19 +2,21 @@
 #define __HAL_UART_H__
 #include <stdint.h>
 
+// 一条消息的最大长度，一次读到的数据超过时拆成多条
 #define MAX_UART_LEN 128
 
-typedef struct
-{
-    char data[MAX_UART_LEN];
-    uint32_t len;
-} hal_uart_msg_t;
-
 int hal_uart_init(void);
 int hal_uart_send(uint8_t *buf, uint32_t len);
+
+/// @brief 读取一条消息，消息比buf长时截断
+/// @param timeout 超时时间，单位ms
+/// @return 读取的字节数，超时返回0
 int hal_uart_recv(uint8_t *buf, uint32_t buf_len, uint32_t timeout);
 
-hal_uart_msg_t *hal_uart_msg_new(uint8_t *data, uint32_t len);
-void hal_uart_msg_del(hal_uart_msg_t *msg);
+typedef void (*hal_uart_rx_cb)(void);
+
+/// @brief 设置收到消息后的通知回调，在系统工作队列中调用，回调里只做提交作业之类的短操作
+/// @param cb 回调，NULL取消
+void hal_uart_rx_cb_set(hal_uart_rx_cb cb);
 
 #endif
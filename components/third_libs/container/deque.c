@@ -0,0 +1,286 @@
+#include <string.h>
+#include "deque.h"
+#include "ezos.h"
+
+#define DEQUE_MIN_CAP 4
+
+#define DEQUE_CAP(self) ((self)->mask + 1)
+#define DEQUE_ELEM(self, pos) ((self)->data + (size_t)((pos) & (self)->mask) * (self)->elem_size)
+
+/*
+ * create deque, return NULL if fail
+ */
+Deque *deque_new(uint16_t elem_size, unsigned int init_cap)
+{
+    Deque *self;
+
+    if (elem_size == 0)
+    {
+        return NULL;
+    }
+
+    self = (Deque *)ezos_malloc(sizeof(Deque));
+    if (!self)
+    {
+        return NULL;
+    }
+    self->data = NULL;
+    self->head = 0;
+    self->len = 0;
+    self->mask = (unsigned int)-1;
+    self->elem_size = elem_size;
+    self->free = NULL;
+    self->match = NULL;
+
+    if (deque_reserve(self, init_cap ? init_cap : DEQUE_MIN_CAP) != 0)
+    {
+        ezos_free(self);
+        return NULL;
+    }
+    return self;
+}
+
+/*
+ * destroy deque
+ */
+void deque_destroy(Deque *self)
+{
+    deque_clear(self);
+    ezos_free(self->data);
+    ezos_free(self);
+}
+
+/*
+ * grow the storage, the elements are unwrapped to start at index 0
+ */
+int deque_reserve(Deque *self, unsigned int cap)
+{
+    unsigned int old_cap = self->data ? DEQUE_CAP(self) : 0;
+    unsigned int new_cap;
+    uint8_t *data;
+
+    if (cap <= old_cap)
+    {
+        return 0;
+    }
+
+    new_cap = old_cap ? old_cap : DEQUE_MIN_CAP;
+    while (new_cap < cap)
+    {
+        new_cap <<= 1;
+    }
+
+    data = (uint8_t *)ezos_malloc((size_t)new_cap * self->elem_size);
+    if (!data)
+    {
+        return -1;
+    }
+
+    if (self->len)
+    {
+        unsigned int first = old_cap - (self->head & self->mask);
+        if (first > self->len)
+        {
+            first = self->len;
+        }
+        memcpy(data, DEQUE_ELEM(self, self->head), (size_t)first * self->elem_size);
+        memcpy(data + (size_t)first * self->elem_size, self->data, (size_t)(self->len - first) * self->elem_size);
+    }
+
+    ezos_free(self->data);
+    self->data = data;
+    self->head = 0;
+    self->mask = new_cap - 1;
+    return 0;
+}
+
+/*
+ * push the element to deque tail, return NULL if fail
+ */
+void *deque_rpush(Deque *self, const void *elem)
+{
+    void *slot;
+
+    if (self->len == DEQUE_CAP(self) && deque_reserve(self, self->len + 1) != 0)
+    {
+        return NULL;
+    }
+
+    slot = DEQUE_ELEM(self, self->head + self->len);
+    memcpy(slot, elem, self->elem_size);
+    ++self->len;
+    return slot;
+}
+
+/*
+ * push the element to deque head, return NULL if fail
+ */
+void *deque_lpush(Deque *self, const void *elem)
+{
+    void *slot;
+
+    if (self->len == DEQUE_CAP(self) && deque_reserve(self, self->len + 1) != 0)
+    {
+        return NULL;
+    }
+
+    self->head = (self->head - 1) & self->mask;
+    slot = DEQUE_ELEM(self, self->head);
+    memcpy(slot, elem, self->elem_size);
+    ++self->len;
+    return slot;
+}
+
+/*
+ * pop the element from deque tail, return -1 if deque empty
+ */
+int deque_rpop(Deque *self, void *out)
+{
+    if (!self->len)
+    {
+        return -1;
+    }
+
+    --self->len;
+    if (out)
+    {
+        memcpy(out, DEQUE_ELEM(self, self->head + self->len), self->elem_size);
+    }
+    return 0;
+}
+
+/*
+ * pop the element from deque head, return -1 if deque empty
+ */
+int deque_lpop(Deque *self, void *out)
+{
+    if (!self->len)
+    {
+        return -1;
+    }
+
+    if (out)
+    {
+        memcpy(out, DEQUE_ELEM(self, self->head), self->elem_size);
+    }
+    self->head = (self->head + 1) & self->mask;
+    --self->len;
+    return 0;
+}
+
+/*
+ * push n elements to deque tail, at most two copies for the wrap
+ */
+int deque_rpush_n(Deque *self, const void *elems, unsigned int n)
+{
+    unsigned int tail;
+    unsigned int first;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    if (deque_reserve(self, self->len + n) != 0)
+    {
+        return -1;
+    }
+
+    tail = (self->head + self->len) & self->mask;
+    first = DEQUE_CAP(self) - tail;
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(DEQUE_ELEM(self, tail), elems, (size_t)first * self->elem_size);
+    memcpy(self->data, (const uint8_t *)elems + (size_t)first * self->elem_size, (size_t)(n - first) * self->elem_size);
+    self->len += n;
+    return 0;
+}
+
+/*
+ * pop up to n elements from deque head, at most two copies for the wrap
+ */
+unsigned int deque_lpop_n(Deque *self, void *out, unsigned int n)
+{
+    unsigned int first;
+
+    if (n > self->len)
+    {
+        n = self->len;
+    }
+
+    if (out && n)
+    {
+        first = DEQUE_CAP(self) - (self->head & self->mask);
+        if (first > n)
+        {
+            first = n;
+        }
+        memcpy(out, DEQUE_ELEM(self, self->head), (size_t)first * self->elem_size);
+        memcpy((uint8_t *)out + (size_t)first * self->elem_size, self->data, (size_t)(n - first) * self->elem_size);
+    }
+
+    self->head = (self->head + n) & self->mask;
+    self->len -= n;
+    return n;
+}
+
+/*
+ * find the element via index, return NULL if not found
+ */
+void *deque_at(Deque *self, int index)
+{
+    if (index < 0)
+    {
+        index = (int)self->len + index;
+        if (index < 0)
+        {
+            return NULL;
+        }
+    }
+
+    if ((unsigned)index < self->len)
+    {
+        return DEQUE_ELEM(self, self->head + index);
+    }
+
+    return NULL;
+}
+
+/*
+ * find the element via value, return NULL if not found
+ */
+void *deque_find(Deque *self, void *val)
+{
+    for (unsigned int i = 0; i < self->len; i++)
+    {
+        uint8_t *elem = DEQUE_ELEM(self, self->head + i);
+        if (self->match)
+        {
+            if (self->match(val, elem))
+            {
+                return elem;
+            }
+        }
+        else if (memcmp(val, elem, self->elem_size) == 0)
+        {
+            return elem;
+        }
+    }
+
+    return NULL;
+}
+
+void deque_clear(Deque *self)
+{
+    if (self->free)
+    {
+        for (unsigned int i = 0; i < self->len; i++)
+        {
+            self->free(DEQUE_ELEM(self, self->head + i));
+        }
+    }
+    self->head = 0;
+    self->len = 0;
+}
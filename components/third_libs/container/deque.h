@@ -0,0 +1,61 @@
+#ifndef __CONTAINER_DEQUE_H__
+#define __CONTAINER_DEQUE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * ring buffer deque, capacity is always a power of two,
+ * elements are stored by value
+ */
+typedef struct {
+    uint8_t *    data;
+    unsigned int head;
+    unsigned int len;
+    unsigned int mask;  // capacity - 1
+    uint16_t     elem_size;
+    /* called with the address of the element before it is dropped */
+    void (*free)(void *elem);
+    /* a: value passed to deque_find, b: address of the element */
+    int (*match)(void *a, void *b);
+} Deque;
+
+/* create deque, init_cap is rounded up to a power of two */
+Deque *deque_new(uint16_t elem_size, unsigned int init_cap);
+
+void deque_destroy(Deque *self);
+
+int deque_reserve(Deque *self, unsigned int cap);
+
+/* copy elem to the tail/head, return the stored element or NULL */
+void *deque_rpush(Deque *self, const void *elem);
+
+void *deque_lpush(Deque *self, const void *elem);
+
+/* pop the tail/head element into out (may be NULL), return 0 if popped */
+int deque_rpop(Deque *self, void *out);
+
+int deque_lpop(Deque *self, void *out);
+
+/* copy n elements to the tail, return 0 on success */
+int deque_rpush_n(Deque *self, const void *elems, unsigned int n);
+
+/* pop up to n elements from the head into out, return popped count */
+unsigned int deque_lpop_n(Deque *self, void *out, unsigned int n);
+
+/* index < 0 counts from the tail like list_at, return NULL if out of range */
+void *deque_at(Deque *self, int index);
+
+void *deque_find(Deque *self, void *val);
+
+/* drop all elements and keep the storage */
+void deque_clear(Deque *self);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // __CONTAINER_DEQUE_H__
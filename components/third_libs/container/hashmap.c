@@ -0,0 +1,371 @@
+#include <string.h>
+#include "hashmap.h"
+#include "ezos.h"
+
+#define HASHMAP_MIN_CAP 8
+
+/*
+ * FNV-1a for byte keys, never returns 0 (marks a deleted entry)
+ */
+static uint32_t hashmap_hash_bytes(const uint8_t *key, uint16_t len)
+{
+    uint32_t hash = 2166136261u;
+    while (len--)
+    {
+        hash ^= *key++;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+/*
+ * murmur3 finalizer for integer keys
+ */
+static uint32_t hashmap_hash_int(uint32_t key)
+{
+    key ^= key >> 16;
+    key *= 0x85ebca6bu;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35u;
+    key ^= key >> 16;
+    return key ? key : 1;
+}
+
+static int hashmap_entry_match(const HashmapEntry *entry, uint32_t hash, const void *key, uint16_t key_len, uint32_t ikey)
+{
+    if (entry->hash != hash || entry->key_len != key_len)
+    {
+        return 0;
+    }
+    if (key_len == 0)
+    {
+        return entry->key.u32 == ikey;
+    }
+    return memcmp(entry->key.ptr, key, key_len) == 0;
+}
+
+/*
+ * return the probe slot holding the key, or -1 if not found
+ */
+static int hashmap_lookup(Hashmap *self, uint32_t hash, const void *key, uint16_t key_len, uint32_t ikey)
+{
+    unsigned int pos = hash & self->index_mask;
+
+    while (1)
+    {
+        uint16_t slot = self->index[pos];
+        if (slot == HASHMAP_SLOT_EMPTY)
+        {
+            return -1;
+        }
+        if (slot != HASHMAP_SLOT_DELETED && hashmap_entry_match(&self->entries[slot - 1], hash, key, key_len, ikey))
+        {
+            return (int)pos;
+        }
+        pos = (pos + 1) & self->index_mask;
+    }
+}
+
+/*
+ * rebuild the probe table, dropping deleted entries and tombstones
+ */
+static void hashmap_rehash(Hashmap *self)
+{
+    unsigned int n = 0;
+
+    memset(self->index, 0, (self->index_mask + 1) * sizeof(uint16_t));
+
+    for (unsigned int i = 0; i < self->used; i++)
+    {
+        unsigned int pos;
+
+        if (self->entries[i].hash == 0)
+        {
+            continue;
+        }
+        if (n != i)
+        {
+            self->entries[n] = self->entries[i];
+        }
+
+        pos = self->entries[n].hash & self->index_mask;
+        while (self->index[pos] != HASHMAP_SLOT_EMPTY)
+        {
+            pos = (pos + 1) & self->index_mask;
+        }
+        self->index[pos] = (uint16_t)(n + 1);
+        n++;
+    }
+
+    self->used = n;
+    self->count = n;
+}
+
+static int hashmap_grow(Hashmap *self)
+{
+    unsigned int cap = self->cap << 1;
+    unsigned int index_size = (self->index_mask + 1) << 1;
+    HashmapEntry *entries;
+    uint16_t *index;
+
+    if (!self->growable || cap > HASHMAP_GROW_MAX_CAP)
+    {
+        return -1;
+    }
+
+    entries = (HashmapEntry *)ezos_realloc(self->entries, cap * sizeof(HashmapEntry));
+    if (!entries)
+    {
+        return -1;
+    }
+    self->entries = entries;
+
+    index = (uint16_t *)ezos_realloc(self->index, index_size * sizeof(uint16_t));
+    if (!index)
+    {
+        return -1;
+    }
+    self->index = index;
+    self->index_mask = index_size - 1;
+    self->cap = cap;
+
+    hashmap_rehash(self);
+    return 0;
+}
+
+static HashmapEntry *hashmap_insert(Hashmap *self, uint32_t hash, const void *key, uint16_t key_len, uint32_t ikey, void *val)
+{
+    HashmapEntry *entry;
+    unsigned int pos;
+    int found = hashmap_lookup(self, hash, key, key_len, ikey);
+
+    if (found >= 0)
+    {
+        entry = &self->entries[self->index[found] - 1];
+        entry->val = val;
+        return entry;
+    }
+
+    if (self->used == self->cap)
+    {
+        // reuse the space of deleted entries before growing
+        if (self->count < self->used)
+        {
+            hashmap_rehash(self);
+        }
+        else if (hashmap_grow(self) != 0)
+        {
+            return NULL;
+        }
+    }
+
+    pos = hash & self->index_mask;
+    while (self->index[pos] != HASHMAP_SLOT_EMPTY && self->index[pos] != HASHMAP_SLOT_DELETED)
+    {
+        pos = (pos + 1) & self->index_mask;
+    }
+
+    entry = &self->entries[self->used];
+    if (key_len == 0)
+    {
+        entry->key.u32 = ikey;
+    }
+    else
+    {
+        entry->key.ptr = key;
+    }
+    entry->key_len = key_len;
+    entry->hash = hash;
+    entry->val = val;
+
+    self->index[pos] = (uint16_t)(++self->used);
+    ++self->count;
+    return entry;
+}
+
+static int hashmap_delete(Hashmap *self, uint32_t hash, const void *key, uint16_t key_len, uint32_t ikey)
+{
+    int pos = hashmap_lookup(self, hash, key, key_len, ikey);
+
+    if (pos < 0)
+    {
+        return -1;
+    }
+
+    self->entries[self->index[pos] - 1].hash = 0;
+    self->index[pos] = HASHMAP_SLOT_DELETED;
+    --self->count;
+    return 0;
+}
+
+/*
+ * init fixed capacity map, index_size must be a power of two and >= 2 * cap
+ */
+int hashmap_init(Hashmap *self, HashmapEntry *entries, uint16_t *index, unsigned int index_size, unsigned int cap)
+{
+    if (!self || !entries || !index || cap == 0 || cap > HASHMAP_MAX_CAP)
+    {
+        return -1;
+    }
+    if ((index_size & (index_size - 1)) != 0 || index_size < cap * 2)
+    {
+        return -1;
+    }
+
+    self->entries = entries;
+    self->index = index;
+    self->index_mask = index_size - 1;
+    self->cap = cap;
+    self->growable = 0;
+    hashmap_clear(self);
+    return 0;
+}
+
+/*
+ * create growable map, return NULL if fail or init_cap is above HASHMAP_GROW_MAX_CAP
+ */
+Hashmap *hashmap_new(unsigned int init_cap)
+{
+    Hashmap *self;
+    unsigned int cap = HASHMAP_MIN_CAP;
+
+    if (init_cap > HASHMAP_GROW_MAX_CAP)
+    {
+        return NULL;
+    }
+    while (cap < init_cap)
+    {
+        cap <<= 1;
+    }
+
+    self = (Hashmap *)ezos_malloc(sizeof(Hashmap));
+    if (!self)
+    {
+        return NULL;
+    }
+    self->entries = (HashmapEntry *)ezos_malloc(cap * sizeof(HashmapEntry));
+    self->index = (uint16_t *)ezos_malloc(cap * 2 * sizeof(uint16_t));
+    if (!self->entries || !self->index)
+    {
+        ezos_free(self->entries);
+        ezos_free(self->index);
+        ezos_free(self);
+        return NULL;
+    }
+
+    self->index_mask = cap * 2 - 1;
+    self->cap = cap;
+    self->growable = 1;
+    hashmap_clear(self);
+    return self;
+}
+
+/*
+ * destroy map, fixed capacity maps only get cleared
+ */
+void hashmap_destroy(Hashmap *self)
+{
+    if (!self->growable)
+    {
+        hashmap_clear(self);
+        return;
+    }
+
+    ezos_free(self->entries);
+    ezos_free(self->index);
+    ezos_free(self);
+}
+
+void hashmap_clear(Hashmap *self)
+{
+    memset(self->index, 0, (self->index_mask + 1) * sizeof(uint16_t));
+    self->used = 0;
+    self->count = 0;
+}
+
+HashmapEntry *hashmap_put(Hashmap *self, const void *key, uint16_t key_len, void *val)
+{
+    if (!key)
+    {
+        return NULL;
+    }
+    if (key_len == 0)
+    {
+        key_len = (uint16_t)strlen((const char *)key);
+        if (key_len == 0)
+        {
+            return NULL;
+        }
+    }
+    return hashmap_insert(self, hashmap_hash_bytes(key, key_len), key, key_len, 0, val);
+}
+
+HashmapEntry *hashmap_find(Hashmap *self, const void *key, uint16_t key_len)
+{
+    int pos;
+
+    if (!key)
+    {
+        return NULL;
+    }
+    if (key_len == 0)
+    {
+        key_len = (uint16_t)strlen((const char *)key);
+        if (key_len == 0)
+        {
+            return NULL;
+        }
+    }
+
+    pos = hashmap_lookup(self, hashmap_hash_bytes(key, key_len), key, key_len, 0);
+    return pos < 0 ? NULL : &self->entries[self->index[pos] - 1];
+}
+
+int hashmap_remove(Hashmap *self, const void *key, uint16_t key_len)
+{
+    if (!key)
+    {
+        return -1;
+    }
+    if (key_len == 0)
+    {
+        key_len = (uint16_t)strlen((const char *)key);
+        if (key_len == 0)
+        {
+            return -1;
+        }
+    }
+    return hashmap_delete(self, hashmap_hash_bytes(key, key_len), key, key_len, 0);
+}
+
+HashmapEntry *hashmap_put_int(Hashmap *self, uint32_t key, void *val)
+{
+    return hashmap_insert(self, hashmap_hash_int(key), NULL, 0, key, val);
+}
+
+HashmapEntry *hashmap_find_int(Hashmap *self, uint32_t key)
+{
+    int pos = hashmap_lookup(self, hashmap_hash_int(key), NULL, 0, key);
+    return pos < 0 ? NULL : &self->entries[self->index[pos] - 1];
+}
+
+int hashmap_remove_int(Hashmap *self, uint32_t key)
+{
+    return hashmap_delete(self, hashmap_hash_int(key), NULL, 0, key);
+}
+
+/*
+ * return next live entry in insertion order, NULL at the end
+ */
+HashmapEntry *hashmap_next(Hashmap *self, unsigned int *iter)
+{
+    while (*iter < self->used)
+    {
+        HashmapEntry *entry = &self->entries[(*iter)++];
+        if (entry->hash != 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,85 @@
+#ifndef __CONTAINER_HASHMAP_H__
+#define __CONTAINER_HASHMAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * open addressing hash map with linear probing.
+ *
+ * entries are kept dense in insertion order, the probe table only stores
+ * entry indexes, so iteration walks a plain array and keeps insertion order.
+ * byte/string keys are not copied, the caller keeps them alive while mapped.
+ */
+#define HASHMAP_SLOT_EMPTY   0x0000
+#define HASHMAP_SLOT_DELETED 0xffff
+#define HASHMAP_MAX_CAP      0xfff0
+/* growable maps double their capacity, the largest power of two <= HASHMAP_MAX_CAP */
+#define HASHMAP_GROW_MAX_CAP 0x8000
+
+/* probe table size for a capacity, load factor stays <= 0.5 */
+#define HASHMAP_INDEX_SIZE(cap) \
+    ((cap) <= 2 ? 4 : (cap) <= 4 ? 8 : (cap) <= 8 ? 16 : (cap) <= 16 ? 32 : (cap) <= 32 ? 64 : \
+     (cap) <= 64 ? 128 : (cap) <= 128 ? 256 : (cap) <= 256 ? 512 : (cap) <= 512 ? 1024 : 2048)
+
+typedef struct {
+    union {
+        const void *ptr;
+        uint32_t    u32;
+    } key;
+    uint16_t key_len;  // 0: integer key
+    uint32_t hash;     // 0: deleted entry
+    void *   val;
+} HashmapEntry;
+
+typedef struct {
+    HashmapEntry *entries;
+    uint16_t *    index;
+    unsigned int  index_mask;
+    unsigned int  cap;    // entries capacity
+    unsigned int  used;   // entries consumed, including deleted ones
+    unsigned int  count;  // live entries
+    uint8_t       growable;
+} Hashmap;
+
+/* fixed capacity map over caller storage, index must hold HASHMAP_INDEX_SIZE(cap) slots */
+#define HASHMAP_DEFINE(name, capacity)                                  \
+    _Static_assert((capacity) > 0 && (capacity) <= 1024, "capacity");  \
+    static HashmapEntry name##_entries[capacity];                      \
+    static uint16_t name##_index[HASHMAP_INDEX_SIZE(capacity)];        \
+    static Hashmap name = {name##_entries, name##_index,               \
+                           HASHMAP_INDEX_SIZE(capacity) - 1, capacity, 0, 0, 0}
+
+int hashmap_init(Hashmap *self, HashmapEntry *entries, uint16_t *index, unsigned int index_size, unsigned int cap);
+
+/* growable map on the heap, return NULL if fail or init_cap > HASHMAP_GROW_MAX_CAP */
+Hashmap *hashmap_new(unsigned int init_cap);
+
+void hashmap_destroy(Hashmap *self);
+
+void hashmap_clear(Hashmap *self);
+
+/* key_len 0 means key is a NUL terminated string, return NULL if full */
+HashmapEntry *hashmap_put(Hashmap *self, const void *key, uint16_t key_len, void *val);
+
+HashmapEntry *hashmap_find(Hashmap *self, const void *key, uint16_t key_len);
+
+int hashmap_remove(Hashmap *self, const void *key, uint16_t key_len);
+
+HashmapEntry *hashmap_put_int(Hashmap *self, uint32_t key, void *val);
+
+HashmapEntry *hashmap_find_int(Hashmap *self, uint32_t key);
+
+int hashmap_remove_int(Hashmap *self, uint32_t key);
+
+/* iterate live entries in insertion order, *iter starts at 0 */
+HashmapEntry *hashmap_next(Hashmap *self, unsigned int *iter);
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // __CONTAINER_HASHMAP_H__
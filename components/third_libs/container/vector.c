@@ -0,0 +1,230 @@
+#include <string.h>
+#include "vector.h"
+#include "ezos.h"
+
+#define VECTOR_MIN_CAP 4
+
+#define VECTOR_ELEM(self, i) ((self)->data + (size_t)(i) * (self)->elem_size)
+
+/*
+ * create vector, return NULL if fail
+ */
+Vector *vector_new(uint16_t elem_size, unsigned int init_cap)
+{
+    Vector *self;
+
+    if (elem_size == 0)
+    {
+        return NULL;
+    }
+
+    self = (Vector *)ezos_malloc(sizeof(Vector));
+    if (!self)
+    {
+        return NULL;
+    }
+    self->data = NULL;
+    self->len = 0;
+    self->cap = 0;
+    self->elem_size = elem_size;
+    self->free = NULL;
+    self->match = NULL;
+
+    if (init_cap && vector_reserve(self, init_cap) != 0)
+    {
+        ezos_free(self);
+        return NULL;
+    }
+    return self;
+}
+
+/*
+ * destroy vector
+ */
+void vector_destroy(Vector *self)
+{
+    vector_clear(self);
+    ezos_free(self->data);
+    ezos_free(self);
+}
+
+/*
+ * grow the storage, existing elements keep their index
+ */
+int vector_reserve(Vector *self, unsigned int cap)
+{
+    unsigned int new_cap;
+    uint8_t *data;
+
+    if (cap <= self->cap)
+    {
+        return 0;
+    }
+
+    new_cap = self->cap ? self->cap : VECTOR_MIN_CAP;
+    while (new_cap < cap)
+    {
+        new_cap <<= 1;
+    }
+
+    data = (uint8_t *)ezos_realloc(self->data, (size_t)new_cap * self->elem_size);
+    if (!data)
+    {
+        return -1;
+    }
+    self->data = data;
+    self->cap = new_cap;
+    return 0;
+}
+
+/*
+ * push the element to vector tail, return NULL if fail
+ */
+void *vector_rpush(Vector *self, const void *elem)
+{
+    void *slot;
+
+    if (self->len == self->cap && vector_reserve(self, self->len + 1) != 0)
+    {
+        return NULL;
+    }
+
+    slot = VECTOR_ELEM(self, self->len);
+    memcpy(slot, elem, self->elem_size);
+    ++self->len;
+    return slot;
+}
+
+/*
+ * push n elements to vector tail with a single copy
+ */
+int vector_rpush_n(Vector *self, const void *elems, unsigned int n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    if (vector_reserve(self, self->len + n) != 0)
+    {
+        return -1;
+    }
+
+    memcpy(VECTOR_ELEM(self, self->len), elems, (size_t)n * self->elem_size);
+    self->len += n;
+    return 0;
+}
+
+/*
+ * pop the element from vector tail, return -1 if vector empty
+ */
+int vector_rpop(Vector *self, void *out)
+{
+    if (!self->len)
+    {
+        return -1;
+    }
+
+    --self->len;
+    if (out)
+    {
+        memcpy(out, VECTOR_ELEM(self, self->len), self->elem_size);
+    }
+    return 0;
+}
+
+/*
+ * pop up to n elements from vector tail, out keeps the original order
+ */
+unsigned int vector_rpop_n(Vector *self, void *out, unsigned int n)
+{
+    if (n > self->len)
+    {
+        n = self->len;
+    }
+
+    self->len -= n;
+    if (out && n)
+    {
+        memcpy(out, VECTOR_ELEM(self, self->len), (size_t)n * self->elem_size);
+    }
+    return n;
+}
+
+/*
+ * find the element via index, return NULL if not found
+ */
+void *vector_at(Vector *self, int index)
+{
+    if (index < 0)
+    {
+        index = (int)self->len + index;
+        if (index < 0)
+        {
+            return NULL;
+        }
+    }
+
+    if ((unsigned)index < self->len)
+    {
+        return VECTOR_ELEM(self, index);
+    }
+
+    return NULL;
+}
+
+/*
+ * find the element via value, return NULL if not found
+ */
+void *vector_find(Vector *self, void *val)
+{
+    uint8_t *elem = self->data;
+
+    for (unsigned int i = 0; i < self->len; i++, elem += self->elem_size)
+    {
+        if (self->match)
+        {
+            if (self->match(val, elem))
+            {
+                return elem;
+            }
+        }
+        else if (memcmp(val, elem, self->elem_size) == 0)
+        {
+            return elem;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * delete the element and release the resource
+ */
+void vector_remove(Vector *self, unsigned int index)
+{
+    if (index >= self->len)
+    {
+        return;
+    }
+
+    if (self->free)
+    {
+        self->free(VECTOR_ELEM(self, index));
+    }
+
+    --self->len;
+    memmove(VECTOR_ELEM(self, index), VECTOR_ELEM(self, index + 1), (size_t)(self->len - index) * self->elem_size);
+}
+
+void vector_clear(Vector *self)
+{
+    if (self->free)
+    {
+        for (unsigned int i = 0; i < self->len; i++)
+        {
+            self->free(VECTOR_ELEM(self, i));
+        }
+    }
+    self->len = 0;
+}
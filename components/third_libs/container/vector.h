@@ -0,0 +1,62 @@
+#ifndef __CONTAINER_VECTOR_H__
+#define __CONTAINER_VECTOR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * contiguous growable array, elements are stored by value
+ */
+typedef struct {
+    uint8_t *    data;
+    unsigned int len;
+    unsigned int cap;
+    uint16_t     elem_size;
+    /* called with the address of the element before it is dropped */
+    void (*free)(void *elem);
+    /* a: value passed to vector_find, b: address of the element */
+    int (*match)(void *a, void *b);
+} Vector;
+
+/* create vector, init_cap may be 0 */
+Vector *vector_new(uint16_t elem_size, unsigned int init_cap);
+
+void vector_destroy(Vector *self);
+
+/* make room for at least cap elements, return 0 on success */
+int vector_reserve(Vector *self, unsigned int cap);
+
+/* copy elem to the tail, return the stored element or NULL */
+void *vector_rpush(Vector *self, const void *elem);
+
+/* copy n elements to the tail, return 0 on success */
+int vector_rpush_n(Vector *self, const void *elems, unsigned int n);
+
+/* pop the tail element into out (may be NULL), return 0 if popped */
+int vector_rpop(Vector *self, void *out);
+
+/* pop up to n elements from the tail into out, return popped count */
+unsigned int vector_rpop_n(Vector *self, void *out, unsigned int n);
+
+/* index < 0 counts from the tail like list_at, return NULL if out of range */
+void *vector_at(Vector *self, int index);
+
+void *vector_find(Vector *self, void *val);
+
+/* remove the element at index and keep the order of the rest */
+void vector_remove(Vector *self, unsigned int index);
+
+/* drop all elements and keep the storage */
+void vector_clear(Vector *self);
+
+#define vector_foreach(self, type, it) \
+    for (type *it = (type *)(self)->data; it < (type *)(self)->data + (self)->len; it++)
+
+#ifdef __cplusplus
+}
+#endif
+#endif  // __CONTAINER_VECTOR_H__
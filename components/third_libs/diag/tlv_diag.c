@@ -0,0 +1,134 @@
+#include <string.h>
+#include "tlv_diag.h"
+#include "ezos.h"
+
+#define DIAG_SITE_SIZE 32
+#define DIAG_SITES_PER_REPORT 4
+#define DIAG_FILE_LEN 16
+
+#define DIAG_TASK_SIZE 36
+#define DIAG_TASKS_PER_REPORT 3
+#define DIAG_NAME_LEN 12
+
+static uint16_t diag_put_le(uint8_t *buf, uint16_t pos, uint32_t val, uint8_t width)
+{
+    for (uint8_t i = 0; i < width; i++)
+    {
+        buf[pos + i] = (uint8_t)(val >> (8 * i));
+    }
+    return pos + width;
+}
+
+#if EZOS_HEAP_TRACE
+static void diag_heap_sites_report(uint8_t tag, uint8_t transfer_method, const ezos_heap_site_t *sites, uint16_t n)
+{
+    uint8_t buf[DIAG_SITE_SIZE * DIAG_SITES_PER_REPORT];
+    uint16_t len = 0;
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        const char *file = sites[i].file != NULL ? sites[i].file : "?";
+        const char *base = strrchr(file, '/');
+
+        file = base != NULL ? base + 1 : file;
+        len = diag_put_le(buf, len, sites[i].live_bytes, 4);
+        len = diag_put_le(buf, len, sites[i].peak_bytes, 4);
+        len = diag_put_le(buf, len, sites[i].allocs, 4);
+        len = diag_put_le(buf, len, sites[i].live_count, 2);
+        len = diag_put_le(buf, len, sites[i].line, 2);
+        memset(&buf[len], 0, DIAG_FILE_LEN);
+        strncpy((char *)&buf[len], file, DIAG_FILE_LEN);
+        len += DIAG_FILE_LEN;
+
+        if ((uint32_t)len + DIAG_SITE_SIZE > sizeof(buf) || i + 1 == n)
+        {
+            general_htlvc_protocol_report(tag, len, buf, transfer_method);
+            len = 0;
+        }
+    }
+}
+#endif
+
+int tlv_diag_heap(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data)
+{
+    ezos_heap_stat_t stat;
+    uint16_t n = 0;
+    uint16_t len = 0;
+#if EZOS_HEAP_TRACE
+    // 调用点表不放在工作任务的栈上，协议处理在同一个作业中串行执行
+    static ezos_heap_site_t sites[EZOS_HEAP_TRACE_SITES];
+#endif
+
+    rsp_tlv_data->transfer_method = cmd_tlv_data->transfer_method;
+    memset(&stat, 0, sizeof(stat));
+    ezos_heap_stat_get(&stat);
+
+#if EZOS_HEAP_TRACE
+    n = ezos_heap_trace_get(sites, EZOS_HEAP_TRACE_SITES);
+    diag_heap_sites_report(cmd_tlv_data->tag, cmd_tlv_data->transfer_method, sites, n);
+#endif
+
+    len = diag_put_le(rsp_tlv_data->val, len, (uint32_t)stat.total, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, (uint32_t)stat.used, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, (uint32_t)stat.used_max, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, (uint32_t)stat.free, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, (uint32_t)stat.largest_free, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, stat.frag_pct, 1);
+    len = diag_put_le(rsp_tlv_data->val, len, stat.fails, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, n, 2);
+    rsp_tlv_data->len = len;
+    return 0;
+}
+
+static void diag_prof_tasks_report(uint8_t tag, uint8_t transfer_method, const ezos_prof_task_t *tasks, uint16_t n)
+{
+    uint8_t buf[DIAG_TASK_SIZE * DIAG_TASKS_PER_REPORT];
+    uint16_t len = 0;
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        memset(&buf[len], 0, DIAG_NAME_LEN);
+        strncpy((char *)&buf[len], tasks[i].name, DIAG_NAME_LEN);
+        len += DIAG_NAME_LEN;
+        len = diag_put_le(buf, len, tasks[i].priority, 1);
+        len = diag_put_le(buf, len, 0, 1);
+        len = diag_put_le(buf, len, tasks[i].cpu_permille, 2);
+        len = diag_put_le(buf, len, tasks[i].stack_free_min, 4);
+        len = diag_put_le(buf, len, tasks[i].runtime_us, 4);
+        len = diag_put_le(buf, len, tasks[i].wakeups, 4);
+        len = diag_put_le(buf, len, tasks[i].wake_lat_avg_us, 4);
+        len = diag_put_le(buf, len, tasks[i].wake_lat_max_us, 4);
+
+        if ((uint32_t)len + DIAG_TASK_SIZE > sizeof(buf) || i + 1 == n)
+        {
+            general_htlvc_protocol_report(tag, len, buf, transfer_method);
+            len = 0;
+        }
+    }
+}
+
+int tlv_diag_prof(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data)
+{
+    ezos_prof_task_t *tasks;
+    ezos_prof_stat_t stat;
+    uint16_t n;
+    uint16_t len = 0;
+
+    rsp_tlv_data->transfer_method = cmd_tlv_data->transfer_method;
+
+    // 任务表有1KB多，不放在栈上
+    tasks = ezos_malloc(sizeof(ezos_prof_task_t) * EZOS_PROF_TASKS);
+    if (tasks == NULL)
+        return -1;
+    n = ezos_prof_get(tasks, EZOS_PROF_TASKS, &stat);
+    diag_prof_tasks_report(cmd_tlv_data->tag, cmd_tlv_data->transfer_method, tasks, n);
+    ezos_free(tasks);
+
+    len = diag_put_le(rsp_tlv_data->val, len, stat.window_us / 1000, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, stat.switches, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, stat.wakeups, 4);
+    len = diag_put_le(rsp_tlv_data->val, len, stat.tasks, 2);
+    len = diag_put_le(rsp_tlv_data->val, len, n, 2);
+    rsp_tlv_data->len = len;
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef __TLV_DIAG_H__
+#define __TLV_DIAG_H__
+
+#include <stdint.h>
+#include "tlv_protocol.h"
+
+/*
+ * 诊断命令，处理函数注册到协议表中使用，标签由应用分配。
+ * 多字节字段均为小端。
+ */
+
+/// @brief 堆快照
+/// 响应：total(4) | used(4) | peak(4) | free(4) | largest(4) | frag(1) | fails(4) | sites(2)
+/// 开启EZOS_HEAP_TRACE时，调用点以同一标签的0xCC上报帧发送，每帧最多4个，每个32BYTE：
+/// live_bytes(4) | peak_bytes(4) | allocs(4) | live_count(2) | line(2) | file(16，去掉路径，不足补0)
+int tlv_diag_heap(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data);
+
+/// @brief 任务剖析快照，需要开启EZOS_PROF，CPU占用按距上次查询的窗口计算
+/// 响应：window_ms(4) | switches(4) | wakeups(4) | tasks(2) | reported(2)
+/// 任务以同一标签的0xCC上报帧发送，每帧最多3个，每个36BYTE：
+/// name(12，不足补0) | priority(1) | rsv(1) | cpu_permille(2) | stack_free_min(4) | runtime_us(4) |
+/// wakeups(4) | wake_lat_avg_us(4) | wake_lat_max_us(4)
+int tlv_diag_prof(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data);
+
+#endif
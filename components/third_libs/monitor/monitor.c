@@ -1,155 +1,1500 @@
 
-
+#include <string.h>
 #include "monitor.h"
+#include "ezos.h"
+#include "tlv_protocol.h"
+
+#define MONITOR_FLAG_ACTIVE 0x01
+#define MONITOR_FLAG_POLLED 0x02
+#define MONITOR_FLAG_TAGGED 0x04
+
+#define MONITOR_FILTER_NONE 0xff
+#define MONITOR_SEQLOCK_NONE 0xff
+#define MONITOR_AGG_NONE 0xff
+
+// 读窗口内被写者打断的重试次数，超过则留到下一次handler
+#define MONITOR_SEQLOCK_RETRY 4
+
+#define MONITOR_BITMAP_WORDS ((MONITOR_MAX_NUM + 31) / 32)
+
+#define MONITOR_BIT_SET(map, id) __atomic_fetch_or(&(map)[(id) >> 5], 1u << ((id) & 31), __ATOMIC_RELEASE)
+#define MONITOR_BIT_CLR(map, id) __atomic_fetch_and(&(map)[(id) >> 5], ~(1u << ((id) & 31)), __ATOMIC_RELEASE)
+
+// 每个id的公共信息，热路径不访问
+typedef struct
+{
+    change_callback changes_callback;
+    char *desc;
+    uint16_t pos; // 在宽度分组中的下标
+    uint8_t type;
+    uint8_t flags;
+    uint8_t filter; // 过滤器下标，MONITOR_FILTER_NONE表示无
+    uint8_t tag;    // 上报标签，MONITOR_FLAG_TAGGED时有效
+    uint8_t seqlock; // 顺序锁下标，MONITOR_SEQLOCK_NONE表示无
+    uint8_t agg;     // 窗口统计下标，MONITOR_AGG_NONE表示无
+} monitor_slot_t;
+
+// 过滤器状态，只有设置了过滤的字段占用
+typedef struct
+{
+    monitor_filter_t cfg;
+    int64_t reported;    // 上次回调的值
+    uint32_t last_cb_ms; // 上次回调的时间
+    int16_t id;          // -1表示空闲
+    int8_t last_dir;     // 上次回调的变化方向
+    uint8_t pending;     // 有被限速延后的变化
+} monitor_filter_ctx_t;
+
+// 窗口统计的一个子桶
+typedef struct
+{
+    int64_t min;
+    int64_t max;
+    int64_t sum;
+    uint32_t count;
+    uint16_t hist[MONITOR_AGG_HIST_BINS];
+} monitor_agg_bucket_t;
+
+// 窗口统计状态，子桶组成环，cur为正在累积的子桶
+typedef struct
+{
+    monitor_agg_cfg_t cfg;
+    monitor_agg_bucket_t bucket[MONITOR_AGG_MAX_BUCKETS];
+    int64_t last;
+    uint32_t bucket_ms;
+    uint32_t bucket_start; // 当前子桶的开始时间
+    int16_t id;            // -1表示空闲
+    uint8_t cur;
+} monitor_agg_ctx_t;
+
+// 顺序锁及其保护的字段集合
+typedef struct
+{
+    monitor_seqlock_t *lock; // NULL表示空闲
+    uint32_t members[MONITOR_BITMAP_WORDS];
+} monitor_seqlock_ctx_t;
+
+// 受顺序锁保护字段的读取快照，内存块另行分配
+typedef union
+{
+    uint64_t raw;
+    uint8_t *blob;
+} monitor_snap_t;
+
+// 按类型分组的结构数组，[0, npoll)为轮询字段，[npoll, count)为事件字段
+#define MONITOR_GROUP_DEF(name, ctype, cap) \
+    static struct                           \
+    {                                       \
+        ctype *ptr[cap];                    \
+        ctype shadow[cap];                  \
+        uint16_t id[cap];                   \
+        uint16_t npoll;                     \
+        uint16_t count;                     \
+    } name
+
+// 带附加参数的分组：浮点的epsilon、位的掩码、内存块的长度
+#define MONITOR_GROUP_DEF_EX(name, ptype, stype, etype, cap) \
+    static struct                                            \
+    {                                                        \
+        ptype *ptr[cap];                                     \
+        stype shadow[cap];                                   \
+        etype extra[cap];                                    \
+        uint16_t id[cap];                                    \
+        uint16_t npoll;                                      \
+        uint16_t count;                                      \
+    } name
+
+MONITOR_GROUP_DEF(g_grp8, uint8_t, MONITOR_MAX_NUM_8);
+MONITOR_GROUP_DEF(g_grp16, uint16_t, MONITOR_MAX_NUM_16);
+MONITOR_GROUP_DEF(g_grp32, uint32_t, MONITOR_MAX_NUM_32);
+MONITOR_GROUP_DEF(g_grp64, uint64_t, MONITOR_MAX_NUM_64);
+MONITOR_GROUP_DEF_EX(g_grpf, float, float, float, MONITOR_MAX_NUM_FLOAT);
+MONITOR_GROUP_DEF_EX(g_grpd, double, double, double, MONITOR_MAX_NUM_DOUBLE);
+MONITOR_GROUP_DEF_EX(g_grpbit, uint32_t, uint32_t, uint32_t, MONITOR_MAX_NUM_BIT);
+MONITOR_GROUP_DEF_EX(g_grpblob, uint8_t, uint8_t *, uint16_t, MONITOR_MAX_NUM_BLOB);
+
+// 分组的通用描述，只用于增删
+typedef struct
+{
+    void **ptr;
+    uint8_t *shadow;
+    uint8_t *extra;
+    uint16_t *id;
+    uint16_t *npoll;
+    uint16_t *count;
+    uint16_t cap;
+    uint8_t width;       // 影子值宽度
+    uint8_t extra_width; // 附加参数宽度
+    uint8_t raw_shadow;  // 1: 影子值是字段的原始拷贝
+} monitor_group_t;
+
+#define MONITOR_GROUP_DESC(grp, cap, raw) \
+    {(void **)grp.ptr, (uint8_t *)grp.shadow, NULL, grp.id, &grp.npoll, &grp.count, cap, sizeof(grp.shadow[0]), 0, raw}
+#define MONITOR_GROUP_DESC_EX(grp, cap, raw) \
+    {(void **)grp.ptr, (uint8_t *)grp.shadow, (uint8_t *)grp.extra, grp.id, &grp.npoll, &grp.count, cap, sizeof(grp.shadow[0]), sizeof(grp.extra[0]), raw}
+
+enum
+{
+    MONITOR_GRP_8,
+    MONITOR_GRP_16,
+    MONITOR_GRP_32,
+    MONITOR_GRP_64,
+    MONITOR_GRP_FLOAT,
+    MONITOR_GRP_DOUBLE,
+    MONITOR_GRP_BIT,
+    MONITOR_GRP_BLOB,
+};
+
+static const monitor_group_t g_groups[] = {
+    [MONITOR_GRP_8] = MONITOR_GROUP_DESC(g_grp8, MONITOR_MAX_NUM_8, 1),
+    [MONITOR_GRP_16] = MONITOR_GROUP_DESC(g_grp16, MONITOR_MAX_NUM_16, 1),
+    [MONITOR_GRP_32] = MONITOR_GROUP_DESC(g_grp32, MONITOR_MAX_NUM_32, 1),
+    [MONITOR_GRP_64] = MONITOR_GROUP_DESC(g_grp64, MONITOR_MAX_NUM_64, 1),
+    [MONITOR_GRP_FLOAT] = MONITOR_GROUP_DESC_EX(g_grpf, MONITOR_MAX_NUM_FLOAT, 1),
+    [MONITOR_GRP_DOUBLE] = MONITOR_GROUP_DESC_EX(g_grpd, MONITOR_MAX_NUM_DOUBLE, 1),
+    [MONITOR_GRP_BIT] = MONITOR_GROUP_DESC_EX(g_grpbit, MONITOR_MAX_NUM_BIT, 0),
+    [MONITOR_GRP_BLOB] = MONITOR_GROUP_DESC_EX(g_grpblob, MONITOR_MAX_NUM_BLOB, 0),
+};
+
+static monitor_slot_t g_slots[MONITOR_MAX_NUM];
+static int16_t g_free_next[MONITOR_MAX_NUM];
+static int16_t g_free_head = -1;
+static uint8_t g_slots_ready = 0;
+
+static monitor_filter_ctx_t g_filters[MONITOR_FILTER_MAX_NUM];
+
+static monitor_agg_ctx_t g_aggs[MONITOR_AGG_MAX_NUM];
+
+static monitor_seqlock_ctx_t g_seqlocks[MONITOR_SEQLOCK_MAX_NUM];
+static monitor_snap_t g_seq_snap[MONITOR_MAX_NUM];
+
+// 注册表锁：保护增删、配置与handler对分组的访问，字段值本身不经过该锁。
+// setter不拿该锁，只在临界区内按id找到字段写入；增删挪动分组项和改动id状态时也进临界区，
+// 写者停在写区间内时setter不会等handler，handler也不会持锁等写者
+static ezos_mutex_id_t g_reg_mutex = NULL;
+EZOS_MUTEX_STATIC_DEFINE(g_reg);
 
-uint8_t monitor_val_ischange(monitor_val_t *monitor_pval);
+#define MONITOR_REG_LOCK()                 \
+    do                                     \
+    {                                      \
+        if (g_reg_mutex != NULL)           \
+            ezos_mutex_lock(g_reg_mutex);  \
+    } while (0)
+#define MONITOR_REG_UNLOCK()                \
+    do                                      \
+    {                                       \
+        if (g_reg_mutex != NULL)            \
+            ezos_mutex_unlock(g_reg_mutex); \
+    } while (0)
+
+#define MONITOR_ID_VALID(id) ((id) >= 0 && (id) < MONITOR_MAX_NUM && (g_slots[id].flags & MONITOR_FLAG_ACTIVE) != 0)
+
+// 每个字段一位：脏位由setter置位
+static uint32_t g_dirty_bitmap[MONITOR_BITMAP_WORDS] = {0};
 
-monitor_val_t monitor_val[MONITOR_MAX_NUM] = {0};
 val_has_been_change_callback val_has_been_change_call;
 static uint8_t g_init_flag = 0;
 
+// 批量上报帧，一次handler内累积，满了先发送
+static uint8_t g_report_enable = 0;
+static uint8_t g_report_method = 0;
+static uint8_t g_report_buf[MAX_PROTOCOL_CMD_DATA_LEN];
+static uint16_t g_report_len = 0;
+
+static monitor_record_callback g_record_hook = NULL;
+
+static uint32_t monitor_now_ms(void)
+{
+    return (uint32_t)((uint64_t)ezos_tick_conut_get() * 1000 / ezos_tick_freq_get());
+}
+
+static const monitor_group_t *monitor_type_group(uint8_t type)
+{
+    switch (type)
+    {
+    case TYPE_U8:
+    case TYPE_I8:
+        return &g_groups[MONITOR_GRP_8];
+    case TYPE_U16:
+    case TYPE_I16:
+        return &g_groups[MONITOR_GRP_16];
+    case TYPE_U32:
+    case TYPE_I32:
+        return &g_groups[MONITOR_GRP_32];
+    case TYPE_U64:
+    case TYPE_I64:
+        return &g_groups[MONITOR_GRP_64];
+    case TYPE_FLOAT:
+        return &g_groups[MONITOR_GRP_FLOAT];
+    case TYPE_DOUBLE:
+        return &g_groups[MONITOR_GRP_DOUBLE];
+    case TYPE_BIT:
+        return &g_groups[MONITOR_GRP_BIT];
+    case TYPE_BLOB:
+        return &g_groups[MONITOR_GRP_BLOB];
+    default:
+        return NULL;
+    }
+}
+
+static void monitor_slots_reset(void)
+{
+    for (int i = 0; i < MONITOR_MAX_NUM; i++)
+    {
+        g_slots[i].changes_callback = NULL;
+        g_slots[i].desc = NULL;
+        g_slots[i].pos = 0;
+        g_slots[i].type = TYPE_NULL;
+        g_slots[i].flags = 0;
+        g_slots[i].filter = MONITOR_FILTER_NONE;
+        g_slots[i].tag = 0;
+        g_slots[i].seqlock = MONITOR_SEQLOCK_NONE;
+        g_slots[i].agg = MONITOR_AGG_NONE;
+        g_free_next[i] = (i + 1 < MONITOR_MAX_NUM) ? (int16_t)(i + 1) : -1;
+    }
+    g_free_head = 0;
+
+    for (size_t i = 0; i < sizeof(g_groups) / sizeof(g_groups[0]); i++)
+    {
+        *g_groups[i].npoll = 0;
+        *g_groups[i].count = 0;
+    }
+    for (int i = 0; i < MONITOR_BITMAP_WORDS; i++)
+    {
+        g_dirty_bitmap[i] = 0;
+    }
+    for (int i = 0; i < MONITOR_FILTER_MAX_NUM; i++)
+    {
+        g_filters[i].id = -1;
+    }
+    for (int i = 0; i < MONITOR_AGG_MAX_NUM; i++)
+    {
+        g_aggs[i].id = -1;
+    }
+    memset(g_seqlocks, 0, sizeof(g_seqlocks));
+
+    g_slots_ready = 1;
+}
+
 int monitor_val_init(val_has_been_change_callback callback)
 {
     if (g_init_flag == 1)
         return -1;
     val_has_been_change_call = callback;
-    for (int i = 0; i < MONITOR_MAX_NUM; i++)
+    monitor_slots_reset();
+
+    if (g_reg_mutex == NULL)
     {
-        monitor_val[i].field_ptr = NULL;
-        monitor_val[i].field_val_old = 0;
-        monitor_val[i].type = TYPE_NULL;
-        monitor_val[i].desc = NULL;
-        monitor_val[i].changes_callback = NULL;
-        monitor_val[i].isactive = 0;
+        g_reg_mutex = EZOS_MUTEX_CREATE_STATIC(g_reg);
+        if (g_reg_mutex == NULL)
+            return -1;
     }
 
     g_init_flag = 1;
     return 0;
 }
 
+// 分组内移动一项，同步更新id到下标的映射
+static void monitor_group_move(const monitor_group_t *grp, uint16_t from, uint16_t to)
+{
+    if (from == to)
+        return;
+
+    grp->ptr[to] = grp->ptr[from];
+    memcpy(&grp->shadow[to * grp->width], &grp->shadow[from * grp->width], grp->width);
+    if (grp->extra != NULL)
+    {
+        memcpy(&grp->extra[to * grp->extra_width], &grp->extra[from * grp->extra_width], grp->extra_width);
+    }
+    grp->id[to] = grp->id[from];
+    g_slots[grp->id[to]].pos = to;
+}
+
+// 返回插入的下标，非原始拷贝的影子值和附加参数由调用者填写
+static int monitor_group_insert(const monitor_group_t *grp, uint16_t id, void *ptr, uint8_t polled)
+{
+    uint16_t pos;
+
+    if (*grp->count >= grp->cap)
+        return -1;
+
+    pos = *grp->count;
+    if (polled)
+    {
+        // 轮询字段保持在前段，把第一个事件字段挪到末尾
+        monitor_group_move(grp, *grp->npoll, pos);
+        pos = (*grp->npoll)++;
+    }
+    (*grp->count)++;
+
+    grp->ptr[pos] = ptr;
+    if (grp->raw_shadow)
+    {
+        memcpy(&grp->shadow[pos * grp->width], ptr, grp->width);
+    }
+    if (grp->extra != NULL)
+    {
+        memset(&grp->extra[pos * grp->extra_width], 0, grp->extra_width);
+    }
+    grp->id[pos] = id;
+    g_slots[id].pos = pos;
+    return pos;
+}
+
+static void monitor_group_remove(const monitor_group_t *grp, uint16_t pos)
+{
+    uint16_t last = *grp->count - 1;
+
+    if (pos < *grp->npoll)
+    {
+        // 用最后一个轮询字段填洞，再用最后一个事件字段填轮询段留下的洞
+        uint16_t last_poll = --(*grp->npoll);
+        monitor_group_move(grp, last_poll, pos);
+        monitor_group_move(grp, last, last_poll);
+    }
+    else
+    {
+        monitor_group_move(grp, last, pos);
+    }
+    *grp->count = last;
+}
+
+static int monitor_val_alloc(void *ptr, filed_type type, change_callback CallBack, char *desc, uint8_t polled)
+{
+    const monitor_group_t *grp = monitor_type_group(type);
+    int id;
+
+    if (ptr == NULL || grp == NULL)
+        return -1;
+
+    if (g_slots_ready == 0)
+        monitor_slots_reset();
+
+    // 空闲链表O(1)分配
+    id = g_free_head;
+    if (id < 0)
+        return -1;
+
+    ezos_critical_enter();
+    g_slots[id].type = type;
+    if (monitor_group_insert(grp, id, ptr, polled) < 0)
+    {
+        ezos_critical_exit();
+        return -1;
+    }
+    g_free_head = g_free_next[id];
+
+    g_slots[id].desc = desc;
+    g_slots[id].changes_callback = CallBack;
+    g_slots[id].flags = MONITOR_FLAG_ACTIVE | (polled ? MONITOR_FLAG_POLLED : 0);
+    ezos_critical_exit();
+    return id;
+}
+
 int monitor_val_add(void *ptr, filed_type type, change_callback CallBack, char *desc)
 {
+    int id;
 
-    for (int i = 0; i < MONITOR_MAX_NUM; i++)
+    // 位和内存块需要额外参数
+    if (type == TYPE_BIT || type == TYPE_BLOB)
+        return -1;
+
+    MONITOR_REG_LOCK();
+    id = monitor_val_alloc(ptr, type, CallBack, desc, 1);
+    MONITOR_REG_UNLOCK();
+    return id;
+}
+
+int monitor_val_add_event(void *ptr, filed_type type, change_callback CallBack, char *desc)
+{
+    int id;
+
+    if (type == TYPE_BIT || type == TYPE_BLOB)
+        return -1;
+
+    MONITOR_REG_LOCK();
+    id = monitor_val_alloc(ptr, type, CallBack, desc, 0);
+    MONITOR_REG_UNLOCK();
+    return id;
+}
+
+int monitor_val_add_float(float *ptr, float epsilon, change_callback CallBack, char *desc)
+{
+    MONITOR_REG_LOCK();
+    int id = monitor_val_alloc(ptr, TYPE_FLOAT, CallBack, desc, 1);
+    if (id >= 0)
+        g_grpf.extra[g_slots[id].pos] = epsilon < 0 ? -epsilon : epsilon;
+    MONITOR_REG_UNLOCK();
+    return id;
+}
+
+int monitor_val_add_double(double *ptr, double epsilon, change_callback CallBack, char *desc)
+{
+    MONITOR_REG_LOCK();
+    int id = monitor_val_alloc(ptr, TYPE_DOUBLE, CallBack, desc, 1);
+    if (id >= 0)
+        g_grpd.extra[g_slots[id].pos] = epsilon < 0 ? -epsilon : epsilon;
+    MONITOR_REG_UNLOCK();
+    return id;
+}
+
+int monitor_val_add_bit(uint32_t *word, uint8_t bit, change_callback CallBack, char *desc)
+{
+    if (word == NULL || bit >= 32)
+        return -1;
+
+    MONITOR_REG_LOCK();
+    int id = monitor_val_alloc(word, TYPE_BIT, CallBack, desc, 1);
+    if (id >= 0)
+    {
+        uint16_t pos = g_slots[id].pos;
+        g_grpbit.extra[pos] = 1u << bit;
+        g_grpbit.shadow[pos] = *word & g_grpbit.extra[pos];
+    }
+    MONITOR_REG_UNLOCK();
+    return id;
+}
+
+int monitor_val_add_blob(void *ptr, uint16_t size, change_callback CallBack, char *desc)
+{
+    uint8_t *copy;
+
+    if (ptr == NULL || size == 0)
+        return -1;
+
+    copy = ezos_malloc(size);
+    if (copy == NULL)
+        return -1;
+    memcpy(copy, ptr, size);
+
+    MONITOR_REG_LOCK();
+    int id = monitor_val_alloc(ptr, TYPE_BLOB, CallBack, desc, 1);
+    if (id >= 0)
+    {
+        g_grpblob.shadow[g_slots[id].pos] = copy;
+        g_grpblob.extra[g_slots[id].pos] = size;
+    }
+    MONITOR_REG_UNLOCK();
+
+    if (id < 0)
+        ezos_free(copy);
+    return id;
+}
+
+double monitor_val_to_double(int64_t val)
+{
+    double d;
+    memcpy(&d, &val, sizeof(d));
+    return d;
+}
+
+static int64_t monitor_double_bits(double d)
+{
+    int64_t val;
+    memcpy(&val, &d, sizeof(val));
+    return val;
+}
+
+static uint32_t monitor_blob_hash(const uint8_t *data, uint16_t size)
+{
+    uint32_t hash = 2166136261u;
+    while (size--)
+    {
+        hash ^= *data++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 字段退出顺序锁，锁上没有字段时释放
+static void monitor_seqlock_detach(int id)
+{
+    monitor_slot_t *slot = &g_slots[id];
+    monitor_seqlock_ctx_t *ctx;
+
+    if (slot->seqlock == MONITOR_SEQLOCK_NONE)
+        return;
+
+    ctx = &g_seqlocks[slot->seqlock];
+    ctx->members[id >> 5] &= ~(1u << (id & 31));
+    if (slot->type == TYPE_BLOB)
+    {
+        ezos_free(g_seq_snap[id].blob);
+        g_seq_snap[id].blob = NULL;
+    }
+    slot->seqlock = MONITOR_SEQLOCK_NONE;
+
+    for (int w = 0; w < MONITOR_BITMAP_WORDS; w++)
+    {
+        if (ctx->members[w] != 0)
+            return;
+    }
+    ctx->lock = NULL;
+}
+
+static int monitor_seqlock_attach(int id, monitor_seqlock_t *lock)
+{
+    monitor_slot_t *slot = &g_slots[id];
+    int idx = -1;
+
+    monitor_seqlock_detach(id);
+    if (lock == NULL)
+        return 0;
+
+    // 同一把锁共用一个表项
+    for (int i = 0; i < MONITOR_SEQLOCK_MAX_NUM; i++)
     {
-        if (monitor_val[i].isactive == 0)
+        if (g_seqlocks[i].lock == lock)
         {
-            monitor_val[i].field_ptr = ptr;
-            monitor_val[i].field_val_old = 0;
-            monitor_val[i].type = type;
-            monitor_val[i].desc = desc;
-            monitor_val_ischange(&monitor_val[i]);
-            monitor_val[i].changes_callback = CallBack;
-            monitor_val[i].isactive = 1;
-            return i;
+            idx = i;
+            break;
         }
+        if (g_seqlocks[i].lock == NULL && idx < 0)
+            idx = i;
+    }
+    if (idx < 0)
+        return -1;
+
+    if (slot->type == TYPE_BLOB)
+    {
+        g_seq_snap[id].blob = ezos_malloc(g_grpblob.extra[slot->pos]);
+        if (g_seq_snap[id].blob == NULL)
+            return -1;
     }
 
-    return -1;
+    g_seqlocks[idx].lock = lock;
+    g_seqlocks[idx].members[id >> 5] |= 1u << (id & 31);
+    slot->seqlock = (uint8_t)idx;
+    return 0;
 }
 
-// void test()
-// {
-//     printf("\r\n------\r\n");
-//     for (int i = 0; i < MONITOR_MAX_NUM; i++)
-//     {
-//         if (monitor_val[i].isactive == 0)
-//             continue;
-//         printf("a%d: old %ld,val %d\r\n", i, monitor_val[i].field_val_old, *(uint32_t *)monitor_val[i].field_ptr);
-//     }
-//     printf("\r\n------\r\n");
-// }
+int monitor_val_set_seqlock(int id, monitor_seqlock_t *lock)
+{
+    int ret = -1;
+
+    MONITOR_REG_LOCK();
+    if (MONITOR_ID_VALID(id))
+        ret = monitor_seqlock_attach(id, lock);
+    MONITOR_REG_UNLOCK();
+    return ret;
+}
 
-uint8_t monitor_val_ischange(monitor_val_t *monitor_pval)
+int monitor_val_remove(int id)
 {
-    filed_type type = monitor_pval->type;
-    int64_t cur_data = 0;
-    uint8_t change_flag = 0;
-    switch (type)
+    MONITOR_REG_LOCK();
+    if (!MONITOR_ID_VALID(id))
     {
-    case TYPE_U8:
+        MONITOR_REG_UNLOCK();
+        return -1;
+    }
+
+    monitor_seqlock_detach(id);
+    if (g_slots[id].type == TYPE_BLOB)
+    {
+        ezos_free(g_grpblob.shadow[g_slots[id].pos]);
+    }
+    ezos_critical_enter();
+    monitor_group_remove(monitor_type_group(g_slots[id].type), g_slots[id].pos);
+    g_slots[id].flags = 0;
+    ezos_critical_exit();
+    MONITOR_BIT_CLR(g_dirty_bitmap, id);
+
+    if (g_slots[id].filter != MONITOR_FILTER_NONE)
+    {
+        g_filters[g_slots[id].filter].id = -1;
+        g_slots[id].filter = MONITOR_FILTER_NONE;
+    }
+    if (g_slots[id].agg != MONITOR_AGG_NONE)
     {
-        cur_data = *((uint8_t *)monitor_pval->field_ptr);
-        if (cur_data != monitor_pval->field_val_old)
+        g_aggs[g_slots[id].agg].id = -1;
+        g_slots[id].agg = MONITOR_AGG_NONE;
+    }
+
+    g_slots[id].tag = 0;
+    g_slots[id].type = TYPE_NULL;
+    g_slots[id].changes_callback = NULL;
+    g_slots[id].desc = NULL;
+
+    g_free_next[id] = g_free_head;
+    g_free_head = (int16_t)id;
+    MONITOR_REG_UNLOCK();
+    return 0;
+}
+
+// 脏位对已删除的id无害，handler只处理有效字段，不用加锁
+int monitor_val_touch(int id)
+{
+    if (!MONITOR_ID_VALID(id))
+        return -1;
+
+    MONITOR_BIT_SET(g_dirty_bitmap, id);
+    return 0;
+}
+
+// 值不变时只写不标记，避免handler空跑。
+// 临界区内写入：删除字段会在临界区内挪动分组中的项，id找到的位置在写入时一定还属于该字段；
+// handler持注册表锁读取分组，与setter不互斥，单个字段由顺序锁或对齐的整字写入保证读到完整值。
+// 顺序锁留给调用者，多个字段需要作为一个整体发布时由调用者在外层write_begin/write_end
+#define MONITOR_SETTER(name, ctype, ftype, grp)                               \
+    int monitor_set_##name(int id, ctype val)                                 \
+    {                                                                         \
+        int ret = -1;                                                         \
+        ezos_critical_enter();                                                \
+        if (MONITOR_ID_VALID(id) && g_slots[id].type == ftype)                \
+        {                                                                     \
+            ctype *field = (ctype *)grp.ptr[g_slots[id].pos];                 \
+            if (*field != val)                                                \
+            {                                                                 \
+                *field = val;                                                 \
+                MONITOR_BIT_SET(g_dirty_bitmap, id);                          \
+            }                                                                 \
+            ret = 0;                                                          \
+        }                                                                     \
+        ezos_critical_exit();                                                 \
+        return ret;                                                           \
+    }
+
+MONITOR_SETTER(u8, uint8_t, TYPE_U8, g_grp8)
+MONITOR_SETTER(i8, int8_t, TYPE_I8, g_grp8)
+MONITOR_SETTER(u16, uint16_t, TYPE_U16, g_grp16)
+MONITOR_SETTER(i16, int16_t, TYPE_I16, g_grp16)
+MONITOR_SETTER(u32, uint32_t, TYPE_U32, g_grp32)
+MONITOR_SETTER(i32, int32_t, TYPE_I32, g_grp32)
+MONITOR_SETTER(u64, uint64_t, TYPE_U64, g_grp64)
+MONITOR_SETTER(i64, int64_t, TYPE_I64, g_grp64)
+MONITOR_SETTER(float, float, TYPE_FLOAT, g_grpf)
+MONITOR_SETTER(double, double, TYPE_DOUBLE, g_grpd)
+
+int monitor_set_bit(int id, uint8_t val)
+{
+    ezos_critical_enter();
+    if (!MONITOR_ID_VALID(id) || g_slots[id].type != TYPE_BIT)
+    {
+        ezos_critical_exit();
+        return -1;
+    }
+
+    uint32_t *word = g_grpbit.ptr[g_slots[id].pos];
+    uint32_t mask = g_grpbit.extra[g_slots[id].pos];
+    uint32_t cur = val ? (*word | mask) : (*word & ~mask);
+    if (cur != *word)
+    {
+        *word = cur;
+        MONITOR_BIT_SET(g_dirty_bitmap, id);
+    }
+    ezos_critical_exit();
+    return 0;
+}
+
+// 轮询段连续比较影子值，变化的字段并入pending
+#define MONITOR_GROUP_SCAN(grp, pending)                              \
+    for (uint16_t k = 0; k < grp.npoll; k++)                          \
+    {                                                                 \
+        if (*grp.ptr[k] != grp.shadow[k])                             \
+        {                                                             \
+            pending[grp.id[k] >> 5] |= 1u << (grp.id[k] & 31);        \
+        }                                                             \
+    }
+
+#define MONITOR_PENDING_SET(pending, id) (pending[(id) >> 5] |= 1u << ((id) & 31))
+
+// 浮点：位模式不同且差值超过epsilon，NaN的变化也能检测到
+#define MONITOR_FLOAT_CHANGED(cur, old, eps) \
+    (memcmp(&(cur), &(old), sizeof(cur)) != 0 && !((cur) - (old) <= (eps) && (old) - (cur) <= (eps)))
+
+#define MONITOR_GROUP_SCAN_FLOAT(grp, ftype, pending)                 \
+    for (uint16_t k = 0; k < grp.npoll; k++)                          \
+    {                                                                 \
+        ftype cur = *grp.ptr[k];                                      \
+        if (MONITOR_FLOAT_CHANGED(cur, grp.shadow[k], grp.extra[k]))  \
+        {                                                             \
+            MONITOR_PENDING_SET(pending, grp.id[k]);                  \
+        }                                                             \
+    }
+
+static void monitor_group_scan_ex(uint32_t *pending)
+{
+    MONITOR_GROUP_SCAN_FLOAT(g_grpf, float, pending);
+    MONITOR_GROUP_SCAN_FLOAT(g_grpd, double, pending);
+
+    for (uint16_t k = 0; k < g_grpbit.npoll; k++)
+    {
+        if ((*g_grpbit.ptr[k] & g_grpbit.extra[k]) != g_grpbit.shadow[k])
         {
+            MONITOR_PENDING_SET(pending, g_grpbit.id[k]);
+        }
+    }
 
-            change_flag = 1;
+    for (uint16_t k = 0; k < g_grpblob.npoll; k++)
+    {
+        if (memcmp(g_grpblob.ptr[k], g_grpblob.shadow[k], g_grpblob.extra[k]) != 0)
+        {
+            MONITOR_PENDING_SET(pending, g_grpblob.id[k]);
         }
     }
-    break;
+}
+
+#define MONITOR_UPDATE_FLOAT(grp, ftype, src, pos)            \
+    {                                                         \
+        ftype cur;                                            \
+        memcpy(&cur, src, sizeof(cur));                       \
+        ftype old = grp.shadow[pos];                          \
+        if (!MONITOR_FLOAT_CHANGED(cur, old, grp.extra[pos])) \
+            return 0;                                         \
+        grp.shadow[pos] = cur;                                \
+        *old_val = monitor_double_bits(old);                  \
+        *new_val = monitor_double_bits(cur);                  \
+        return 1;                                             \
+    }
+
+// 按字段的有无符号类型取出新旧值，并更新影子值
+#define MONITOR_UPDATE(grp, stype, src, pos)         \
+    {                                                \
+        stype cur;                                   \
+        memcpy(&cur, src, sizeof(cur));              \
+        stype old = (stype)grp.shadow[pos];          \
+        if (cur == old)                              \
+            return 0;                                \
+        grp.shadow[pos] = cur;                       \
+        *old_val = old;                              \
+        *new_val = cur;                              \
+        return 1;                                    \
+    }
+
+// src为字段当前内容：直接指向字段，或顺序锁读出的快照
+static uint8_t monitor_val_update(const monitor_slot_t *slot, const void *src, int64_t *old_val, int64_t *new_val)
+{
+    switch (slot->type)
+    {
+    case TYPE_U8:
+        MONITOR_UPDATE(g_grp8, uint8_t, src, slot->pos);
     case TYPE_I8:
-        cur_data = *((int8_t *)monitor_pval->field_ptr);
-        if (cur_data != monitor_pval->field_val_old)
-        {
+        MONITOR_UPDATE(g_grp8, int8_t, src, slot->pos);
+    case TYPE_U16:
+        MONITOR_UPDATE(g_grp16, uint16_t, src, slot->pos);
+    case TYPE_I16:
+        MONITOR_UPDATE(g_grp16, int16_t, src, slot->pos);
+    case TYPE_U32:
+        MONITOR_UPDATE(g_grp32, uint32_t, src, slot->pos);
+    case TYPE_I32:
+        MONITOR_UPDATE(g_grp32, int32_t, src, slot->pos);
+    case TYPE_U64:
+        MONITOR_UPDATE(g_grp64, uint64_t, src, slot->pos);
+    case TYPE_I64:
+        MONITOR_UPDATE(g_grp64, int64_t, src, slot->pos);
+    case TYPE_FLOAT:
+        MONITOR_UPDATE_FLOAT(g_grpf, float, src, slot->pos);
+    case TYPE_DOUBLE:
+        MONITOR_UPDATE_FLOAT(g_grpd, double, src, slot->pos);
+    case TYPE_BIT:
+    {
+        uint32_t cur;
+        memcpy(&cur, src, sizeof(cur));
+        cur &= g_grpbit.extra[slot->pos];
+        if (cur == g_grpbit.shadow[slot->pos])
+            return 0;
+        *old_val = g_grpbit.shadow[slot->pos] != 0;
+        *new_val = cur != 0;
+        g_grpbit.shadow[slot->pos] = cur;
+        return 1;
+    }
+    case TYPE_BLOB:
+    {
+        uint8_t *shadow = g_grpblob.shadow[slot->pos];
+        uint16_t size = g_grpblob.extra[slot->pos];
+        if (memcmp(src, shadow, size) == 0)
+            return 0;
+        *old_val = monitor_blob_hash(shadow, size);
+        memcpy(shadow, src, size);
+        *new_val = monitor_blob_hash(shadow, size);
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
 
-            change_flag = 1;
-        }
-        break;
+// 按字段类型取出影子值
+static int64_t monitor_val_shadow(const monitor_slot_t *slot)
+{
+    switch (slot->type)
+    {
+    case TYPE_U8:
+        return g_grp8.shadow[slot->pos];
+    case TYPE_I8:
+        return (int8_t)g_grp8.shadow[slot->pos];
     case TYPE_U16:
-        cur_data = *((uint16_t *)monitor_pval->field_ptr);
-        if (cur_data != monitor_pval->field_val_old)
-        {
+        return g_grp16.shadow[slot->pos];
+    case TYPE_I16:
+        return (int16_t)g_grp16.shadow[slot->pos];
+    case TYPE_U32:
+        return g_grp32.shadow[slot->pos];
+    case TYPE_I32:
+        return (int32_t)g_grp32.shadow[slot->pos];
+    case TYPE_U64:
+    case TYPE_I64:
+        return (int64_t)g_grp64.shadow[slot->pos];
+    case TYPE_FLOAT:
+        return monitor_double_bits(g_grpf.shadow[slot->pos]);
+    case TYPE_DOUBLE:
+        return monitor_double_bits(g_grpd.shadow[slot->pos]);
+    case TYPE_BIT:
+        return g_grpbit.shadow[slot->pos] != 0;
+    case TYPE_BLOB:
+        return monitor_blob_hash(g_grpblob.shadow[slot->pos], g_grpblob.extra[slot->pos]);
+    default:
+        return 0;
+    }
+}
 
-            change_flag = 1;
-        }
-        break;
+// 上报编码宽度
+static uint16_t monitor_val_width(const monitor_slot_t *slot)
+{
+    switch (slot->type)
+    {
+    case TYPE_U8:
+    case TYPE_I8:
+    case TYPE_BIT:
+        return 1;
+    case TYPE_U16:
     case TYPE_I16:
-        cur_data = *((int16_t *)monitor_pval->field_ptr);
-        if (cur_data != monitor_pval->field_val_old)
+        return 2;
+    case TYPE_U32:
+    case TYPE_I32:
+    case TYPE_FLOAT:
+        return 4;
+    case TYPE_U64:
+    case TYPE_I64:
+    case TYPE_DOUBLE:
+        return 8;
+    case TYPE_BLOB:
+        return g_grpblob.extra[slot->pos];
+    default:
+        return 0;
+    }
+}
+
+int monitor_val_bind_tag(int id, uint8_t tag)
+{
+    if (tag == PROTOCOL_TAG_NESTED)
+        return -1;
+
+    MONITOR_REG_LOCK();
+    if (!MONITOR_ID_VALID(id))
+    {
+        MONITOR_REG_UNLOCK();
+        return -1;
+    }
+    g_slots[id].tag = tag;
+    g_slots[id].flags |= MONITOR_FLAG_TAGGED;
+    MONITOR_REG_UNLOCK();
+    return 0;
+}
+
+void monitor_record_hook_set(monitor_record_callback hook)
+{
+    g_record_hook = hook;
+}
+
+void monitor_report_enable(uint8_t enable, uint8_t transfer_method)
+{
+    g_report_enable = enable;
+    g_report_method = transfer_method;
+    g_report_len = 0;
+}
+
+static void monitor_report_flush(void)
+{
+    if (g_report_len == 0)
+        return;
+
+    general_htlvc_protocol_report(PROTOCOL_TAG_NESTED, g_report_len, g_report_buf, g_report_method);
+    g_report_len = 0;
+}
+
+// 写入TLV头：标签 | 长度(2BYTE)，返回值的写入位置，放不下返回NULL
+static uint8_t *monitor_report_reserve(uint8_t tag, uint16_t len)
+{
+    uint8_t *val;
+
+    if (3 + len > MAX_PROTOCOL_CMD_DATA_LEN)
+        return NULL;
+
+    if (g_report_len + 3 + len > MAX_PROTOCOL_CMD_DATA_LEN)
+    {
+        monitor_report_flush();
+    }
+
+    g_report_buf[g_report_len++] = tag;
+    g_report_buf[g_report_len++] = (len >> 8) & 0xff;
+    g_report_buf[g_report_len++] = len & 0xff;
+    val = &g_report_buf[g_report_len];
+    g_report_len += len;
+    return val;
+}
+
+static uint8_t *monitor_put_le(uint8_t *buf, uint64_t val, uint16_t width)
+{
+    for (uint16_t i = 0; i < width; i++)
+    {
+        *buf++ = (uint8_t)(val >> (8 * i));
+    }
+    return buf;
+}
+
+// 追加一条TLV，值按字段宽度小端编码，内存块为原始内容
+static void monitor_report_append(const monitor_slot_t *slot, int64_t val)
+{
+    uint16_t width = monitor_val_width(slot);
+    uint8_t *buf = monitor_report_reserve(slot->tag, width);
+
+    if (buf == NULL)
+        return;
+
+    if (slot->type == TYPE_BLOB)
+    {
+        memcpy(buf, g_grpblob.shadow[slot->pos], width);
+        return;
+    }
+    if (slot->type == TYPE_FLOAT)
+    {
+        float f = (float)monitor_val_to_double(val);
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        val = bits;
+    }
+    monitor_put_le(buf, (uint64_t)val, width);
+}
+
+// 字段变化通知：记录钩子 + 批量上报 + 用户回调
+// 回调期间释放注册表锁，回调中可以增删字段，返回后slot可能已失效
+static void monitor_val_emit(const monitor_slot_t *slot, int64_t old_val, int64_t new_val)
+{
+    change_callback cb = slot->changes_callback;
+    char *desc = slot->desc;
+
+    if (g_record_hook != NULL && (slot->flags & MONITOR_FLAG_TAGGED))
+    {
+        g_record_hook(slot->tag, slot->type, new_val);
+    }
+    // 有窗口统计的字段只上报摘要
+    if (g_report_enable && (slot->flags & MONITOR_FLAG_TAGGED) && slot->agg == MONITOR_AGG_NONE)
+    {
+        monitor_report_append(slot, new_val);
+    }
+    if (cb != NULL)
+    {
+        MONITOR_REG_UNLOCK();
+        cb(old_val, new_val, desc);
+        MONITOR_REG_LOCK();
+    }
+}
+
+static int monitor_filter_attach(int id, const monitor_filter_t *filter)
+{
+    monitor_slot_t *slot = &g_slots[id];
+
+    if (slot->type >= TYPE_FLOAT)
+        return -1;
+
+    if (filter == NULL)
+    {
+        if (slot->filter != MONITOR_FILTER_NONE)
         {
+            g_filters[slot->filter].id = -1;
+            slot->filter = MONITOR_FILTER_NONE;
+        }
+        return 0;
+    }
 
-            change_flag = 1;
+    if (slot->filter == MONITOR_FILTER_NONE)
+    {
+        for (int i = 0; i < MONITOR_FILTER_MAX_NUM; i++)
+        {
+            if (g_filters[i].id < 0)
+            {
+                slot->filter = i;
+                break;
+            }
         }
-        break;
-    case TYPE_U32:
-        cur_data = *((uint32_t *)monitor_pval->field_ptr);
-        if (cur_data != monitor_pval->field_val_old)
+        if (slot->filter == MONITOR_FILTER_NONE)
+            return -1;
+    }
+
+    monitor_filter_ctx_t *f = &g_filters[slot->filter];
+    f->cfg = *filter;
+    f->reported = monitor_val_shadow(slot);
+    f->last_cb_ms = monitor_now_ms();
+    f->last_dir = 0;
+    f->pending = 0;
+    f->id = (int16_t)id;
+    return 0;
+}
+
+int monitor_val_set_filter(int id, const monitor_filter_t *filter)
+{
+    int ret = -1;
+
+    MONITOR_REG_LOCK();
+    if (MONITOR_ID_VALID(id))
+        ret = monitor_filter_attach(id, filter);
+    MONITOR_REG_UNLOCK();
+    return ret;
+}
+
+static void monitor_filter_fire(monitor_filter_ctx_t *f, const monitor_slot_t *slot, int64_t cur, uint32_t now)
+{
+    int64_t old = f->reported;
+
+    if (cur != old)
+        f->last_dir = cur > old ? 1 : -1;
+    f->reported = cur;
+    f->last_cb_ms = now;
+    f->pending = 0;
+
+    monitor_val_emit(slot, old, cur);
+}
+
+// 死区、回差和最小间隔判断，返回1表示已回调
+static uint8_t monitor_filter_run(monitor_filter_ctx_t *f, const monitor_slot_t *slot, int64_t cur, uint32_t now)
+{
+    int64_t delta = cur - f->reported;
+    int8_t dir = delta > 0 ? 1 : (delta < 0 ? -1 : 0);
+    uint64_t mag = delta >= 0 ? (uint64_t)delta : (uint64_t)(-delta);
+    uint64_t threshold = f->cfg.deadband;
+
+    if (f->cfg.deadband_pct)
+    {
+        uint64_t ref = f->reported >= 0 ? (uint64_t)f->reported : (uint64_t)(-f->reported);
+        uint64_t pct = ref * f->cfg.deadband_pct / 1000;
+        if (pct > threshold)
+            threshold = pct;
+    }
+    if (f->last_dir != 0 && dir != f->last_dir)
+    {
+        threshold += f->cfg.hysteresis;
+    }
+
+    if (dir == 0 || mag <= threshold)
+    {
+        f->pending = 0;
+        return 0;
+    }
+
+    if (f->cfg.min_interval_ms && now - f->last_cb_ms < f->cfg.min_interval_ms)
+    {
+        f->pending = 1;
+        return 0;
+    }
+
+    monitor_filter_fire(f, slot, cur, now);
+    return 1;
+}
+
+// 处理被延后的变化和心跳
+static uint8_t monitor_filter_poll(uint32_t now)
+{
+    uint8_t fired = 0;
+
+    for (int i = 0; i < MONITOR_FILTER_MAX_NUM; i++)
+    {
+        monitor_filter_ctx_t *f = &g_filters[i];
+        if (f->id < 0)
+            continue;
+
+        const monitor_slot_t *slot = &g_slots[f->id];
+        if (f->pending && now - f->last_cb_ms >= f->cfg.min_interval_ms)
         {
+            fired |= monitor_filter_run(f, slot, monitor_val_shadow(slot), now);
+            // 回调中字段可能已被删除
+            if (f->id < 0)
+                continue;
+        }
+        if (f->cfg.max_silence_ms && now - f->last_cb_ms >= f->cfg.max_silence_ms)
+        {
+            monitor_filter_fire(f, slot, monitor_val_shadow(slot), now);
+            fired = 1;
+        }
+    }
+    return fired;
+}
+
+static void monitor_agg_bucket_clear(monitor_agg_bucket_t *b)
+{
+    memset(b, 0, sizeof(*b));
+}
 
-            change_flag = 1;
+// 合并所有子桶得到当前窗口的统计
+static void monitor_agg_merge(const monitor_agg_ctx_t *a, monitor_agg_stat_t *stat)
+{
+    int64_t sum = 0;
+
+    memset(stat, 0, sizeof(*stat));
+    for (uint8_t k = 0; k < a->cfg.buckets; k++)
+    {
+        const monitor_agg_bucket_t *b = &a->bucket[k];
+        if (b->count == 0)
+            continue;
+
+        if (stat->count == 0 || b->min < stat->min)
+            stat->min = b->min;
+        if (stat->count == 0 || b->max > stat->max)
+            stat->max = b->max;
+        stat->count += b->count;
+        sum += b->sum;
+        for (uint8_t h = 0; h < a->cfg.hist_bins; h++)
+        {
+            stat->hist[h] += b->hist[h];
         }
-        break;
-    case TYPE_I32:
-        cur_data = *((int32_t *)(monitor_pval->field_ptr));
-        if (cur_data != monitor_pval->field_val_old)
+    }
+    stat->mean = stat->count ? sum / (int64_t)stat->count : 0;
+    stat->last = a->last;
+}
+
+static void monitor_agg_sample(monitor_agg_ctx_t *a, int64_t val)
+{
+    monitor_agg_bucket_t *b = &a->bucket[a->cur];
+
+    if (b->count == 0 || val < b->min)
+        b->min = val;
+    if (b->count == 0 || val > b->max)
+        b->max = val;
+    b->sum += val;
+    b->count++;
+    a->last = val;
+
+    if (a->cfg.hist_bins)
+    {
+        int64_t bin = val < a->cfg.hist_min ? 0 : (val - a->cfg.hist_min) / a->cfg.hist_step;
+        if (bin >= a->cfg.hist_bins)
+            bin = a->cfg.hist_bins - 1;
+        if (b->hist[bin] != 0xffff)
+            b->hist[bin]++;
+    }
+}
+
+// 摘要：count(4) | min(8) | max(8) | mean(8) | last(8) | hist(2*hist_bins)
+static void monitor_agg_report(const monitor_agg_ctx_t *a, const monitor_slot_t *slot)
+{
+    monitor_agg_stat_t stat;
+    uint8_t *buf;
+
+    monitor_agg_merge(a, &stat);
+    if (stat.count == 0)
+        return;
+
+    buf = monitor_report_reserve(slot->tag, 36 + 2 * a->cfg.hist_bins);
+    if (buf == NULL)
+        return;
+
+    buf = monitor_put_le(buf, stat.count, 4);
+    buf = monitor_put_le(buf, (uint64_t)stat.min, 8);
+    buf = monitor_put_le(buf, (uint64_t)stat.max, 8);
+    buf = monitor_put_le(buf, (uint64_t)stat.mean, 8);
+    buf = monitor_put_le(buf, (uint64_t)stat.last, 8);
+    for (uint8_t h = 0; h < a->cfg.hist_bins; h++)
+    {
+        buf = monitor_put_le(buf, stat.hist[h], 2);
+    }
+}
+
+// 子桶到期后上报并滑到下一个子桶，长时间未运行时最多清空整个窗口
+static void monitor_agg_rotate(monitor_agg_ctx_t *a, const monitor_slot_t *slot, uint32_t now)
+{
+    if (now - a->bucket_start < a->bucket_ms)
+        return;
+
+    if (g_report_enable && (slot->flags & MONITOR_FLAG_TAGGED))
+    {
+        monitor_agg_report(a, slot);
+    }
+
+    for (uint8_t k = 0; k < a->cfg.buckets && now - a->bucket_start >= a->bucket_ms; k++)
+    {
+        a->cur = (a->cur + 1) % a->cfg.buckets;
+        monitor_agg_bucket_clear(&a->bucket[a->cur]);
+        a->bucket_start += a->bucket_ms;
+    }
+    if (now - a->bucket_start >= a->bucket_ms)
+    {
+        a->bucket_start = now;
+    }
+}
+
+// 每次handler对统计字段的影子值采样
+static void monitor_agg_poll(uint32_t now)
+{
+    for (int i = 0; i < MONITOR_AGG_MAX_NUM; i++)
+    {
+        monitor_agg_ctx_t *a = &g_aggs[i];
+        if (a->id < 0)
+            continue;
+
+        const monitor_slot_t *slot = &g_slots[a->id];
+        monitor_agg_rotate(a, slot, now);
+        monitor_agg_sample(a, monitor_val_shadow(slot));
+    }
+}
+
+static void monitor_agg_restart(monitor_agg_ctx_t *a)
+{
+    for (uint8_t k = 0; k < MONITOR_AGG_MAX_BUCKETS; k++)
+    {
+        monitor_agg_bucket_clear(&a->bucket[k]);
+    }
+    a->cur = 0;
+    a->last = 0;
+    a->bucket_start = monitor_now_ms();
+}
+
+static int monitor_agg_attach(int id, const monitor_agg_cfg_t *cfg)
+{
+    monitor_slot_t *slot = &g_slots[id];
+
+    if (slot->type >= TYPE_FLOAT)
+        return -1;
+
+    if (cfg == NULL)
+    {
+        if (slot->agg != MONITOR_AGG_NONE)
         {
+            g_aggs[slot->agg].id = -1;
+            slot->agg = MONITOR_AGG_NONE;
+        }
+        return 0;
+    }
+
+    if (cfg->buckets == 0 || cfg->buckets > MONITOR_AGG_MAX_BUCKETS || cfg->window_ms < cfg->buckets)
+        return -1;
+    if (cfg->hist_bins > MONITOR_AGG_HIST_BINS || (cfg->hist_bins && cfg->hist_step == 0))
+        return -1;
 
-            change_flag = 1;
+    if (slot->agg == MONITOR_AGG_NONE)
+    {
+        for (int i = 0; i < MONITOR_AGG_MAX_NUM; i++)
+        {
+            if (g_aggs[i].id < 0)
+            {
+                slot->agg = i;
+                break;
+            }
         }
-        break;
-    default:
-        break;
+        if (slot->agg == MONITOR_AGG_NONE)
+            return -1;
     }
 
-    if (change_flag == 1)
+    monitor_agg_ctx_t *a = &g_aggs[slot->agg];
+    a->cfg = *cfg;
+    a->bucket_ms = cfg->window_ms / cfg->buckets;
+    monitor_agg_restart(a);
+    a->id = (int16_t)id;
+    return 0;
+}
+
+int monitor_val_set_agg(int id, const monitor_agg_cfg_t *cfg)
+{
+    int ret = -1;
+
+    MONITOR_REG_LOCK();
+    if (MONITOR_ID_VALID(id))
+        ret = monitor_agg_attach(id, cfg);
+    MONITOR_REG_UNLOCK();
+    return ret;
+}
+
+static monitor_agg_ctx_t *monitor_agg_find(uint8_t tag)
+{
+    for (int i = 0; i < MONITOR_AGG_MAX_NUM; i++)
     {
-        monitor_pval->field_val_old = cur_data;
+        const monitor_slot_t *slot;
+        if (g_aggs[i].id < 0)
+            continue;
+
+        slot = &g_slots[g_aggs[i].id];
+        if ((slot->flags & MONITOR_FLAG_TAGGED) && slot->tag == tag)
+            return &g_aggs[i];
     }
+    return NULL;
+}
+
+int monitor_agg_get(uint8_t tag, monitor_agg_stat_t *stat)
+{
+    monitor_agg_ctx_t *a;
 
-    return change_flag;
+    if (stat == NULL)
+        return -1;
+
+    MONITOR_REG_LOCK();
+    a = monitor_agg_find(tag);
+    if (a != NULL)
+        monitor_agg_merge(a, stat);
+    MONITOR_REG_UNLOCK();
+    return a != NULL ? 0 : -1;
 }
 
-void monitor_run_handler()
+int monitor_agg_reset(uint8_t tag)
 {
-    uint8_t callback_flag = 0;
-    for (int i = 0; i < MONITOR_MAX_NUM; i++)
+    monitor_agg_ctx_t *a;
+
+    MONITOR_REG_LOCK();
+    a = monitor_agg_find(tag);
+    if (a != NULL)
+        monitor_agg_restart(a);
+    MONITOR_REG_UNLOCK();
+    return a != NULL ? 0 : -1;
+}
+
+// 比较字段当前内容，变化时经过滤器或直接通知，返回1表示已回调
+static uint8_t monitor_val_check(monitor_slot_t *slot, const void *src, uint32_t now)
+{
+    int64_t old_val, new_val;
+
+    if (!monitor_val_update(slot, src, &old_val, &new_val))
+        return 0;
+
+    if (slot->filter != MONITOR_FILTER_NONE)
+        return monitor_filter_run(&g_filters[slot->filter], slot, new_val, now);
+
+    monitor_val_emit(slot, old_val, new_val);
+    return 1;
+}
+
+static uint8_t *monitor_seq_snap(const monitor_slot_t *slot, int id)
+{
+    return slot->type == TYPE_BLOB ? g_seq_snap[id].blob : (uint8_t *)&g_seq_snap[id].raw;
+}
+
+// 字段原始内容的长度，位字段为整个字
+static uint16_t monitor_val_src_size(const monitor_slot_t *slot)
+{
+    return slot->type == TYPE_BIT ? sizeof(uint32_t) : monitor_val_width(slot);
+}
+
+#define MONITOR_FOREACH_ID(map, id)                                   \
+    for (int w_ = 0; w_ < MONITOR_BITMAP_WORDS; w_++)                \
+        for (uint32_t m_ = (map)[w_]; m_ != 0; m_ &= m_ - 1)         \
+            for (int id = (w_ << 5) + __builtin_ctz(m_), once_ = 1; once_; once_ = 0)
+
+// 受顺序锁保护的字段：只要有一个成员待处理，同一把锁的所有成员在一个读窗口内
+// 整体拷贝到快照，窗口内写者动过则重读，超过重试次数整组留到下一次。
+// 写者停在写区间内(单核上就是被抢占了)时先放开注册表锁再让出CPU，
+// 回来后锁上的成员可能已经变了，重新取一遍
+static uint8_t monitor_seqlock_run(uint32_t *pending, uint32_t now)
+{
+    uint8_t fired = 0;
+
+    for (int l = 0; l < MONITOR_SEQLOCK_MAX_NUM; l++)
     {
-        if (monitor_val[i].isactive == 0)
+        monitor_seqlock_ctx_t *ctx = &g_seqlocks[l];
+        monitor_seqlock_t *lock = ctx->lock;
+        uint32_t members[MONITOR_BITMAP_WORDS];
+        uint8_t hit = 0;
+        uint8_t ok = 0;
+
+        if (lock == NULL)
             continue;
 
-        int64_t old_val = monitor_val[i].field_val_old;
-        if (monitor_val_ischange(&monitor_val[i]))
+        for (int w = 0; w < MONITOR_BITMAP_WORDS; w++)
         {
+            members[w] = ctx->members[w];
+            hit |= (pending[w] & members[w]) != 0;
+            pending[w] &= ~members[w];
+        }
+        if (!hit)
+            continue;
 
-            int64_t new_val = monitor_val[i].field_val_old;
-            char *desc = monitor_val[i].desc;
-            if (monitor_val[i].changes_callback != NULL)
+        for (int t = 0; t < MONITOR_SEQLOCK_RETRY && !ok; t++)
+        {
+            uint32_t seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+            if (seq & 1)
             {
-                monitor_val[i].changes_callback(old_val, new_val, desc);
+                MONITOR_REG_UNLOCK();
+                ezos_thread_yield();
+                MONITOR_REG_LOCK();
+                if (ctx->lock != lock)
+                    break;
+                for (int w = 0; w < MONITOR_BITMAP_WORDS; w++)
+                {
+                    members[w] = ctx->members[w];
+                    pending[w] &= ~members[w];
+                }
+                continue;
             }
-            callback_flag = 1;
+            MONITOR_FOREACH_ID(members, id)
+            {
+                const monitor_slot_t *slot = &g_slots[id];
+                memcpy(monitor_seq_snap(slot, id), monitor_type_group(slot->type)->ptr[slot->pos], monitor_val_src_size(slot));
+            }
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            ok = __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) == seq;
+        }
+
+        if (!ok)
+        {
+            for (int w = 0; w < MONITOR_BITMAP_WORDS; w++)
+            {
+                __atomic_fetch_or(&g_dirty_bitmap[w], members[w], __ATOMIC_RELEASE);
+            }
+            continue;
+        }
+
+        MONITOR_FOREACH_ID(members, id)
+        {
+            monitor_slot_t *slot = &g_slots[id];
+            // 回调中可能删除字段或改绑其他锁
+            if ((slot->flags & MONITOR_FLAG_ACTIVE) == 0 || slot->seqlock != l)
+                continue;
+            fired |= monitor_val_check(slot, monitor_seq_snap(slot, id), now);
         }
     }
+    return fired;
+}
+
+void monitor_run_handler()
+{
+    uint32_t pending[MONITOR_BITMAP_WORDS];
+    uint8_t callback_flag = 0;
+    uint32_t now = monitor_now_ms();
+
+    MONITOR_REG_LOCK();
+
+    for (int w = 0; w < MONITOR_BITMAP_WORDS; w++)
+    {
+        pending[w] = __atomic_exchange_n(&g_dirty_bitmap[w], 0, __ATOMIC_ACQUIRE);
+    }
+
+    MONITOR_GROUP_SCAN(g_grp8, pending);
+    MONITOR_GROUP_SCAN(g_grp16, pending);
+    MONITOR_GROUP_SCAN(g_grp32, pending);
+    MONITOR_GROUP_SCAN(g_grp64, pending);
+    monitor_group_scan_ex(pending);
+
+    // 上面的比较对受保护字段只是提示，以快照为准
+    callback_flag |= monitor_seqlock_run(pending, now);
+
+    // 只访问脏字段和轮询发现变化的字段
+    for (int w = 0; w < MONITOR_BITMAP_WORDS; w++)
+    {
+        while (pending[w])
+        {
+            int i = (w << 5) + __builtin_ctz(pending[w]);
+            pending[w] &= pending[w] - 1;
+
+            monitor_slot_t *slot = &g_slots[i];
+            if ((slot->flags & MONITOR_FLAG_ACTIVE) == 0)
+                continue;
+
+            callback_flag |= monitor_val_check(slot, monitor_type_group(slot->type)->ptr[slot->pos], now);
+        }
+    }
+
+    callback_flag |= monitor_filter_poll(now);
+    monitor_agg_poll(now);
+
+    // 本次所有变化合并为一帧发送
+    monitor_report_flush();
+
+    MONITOR_REG_UNLOCK();
 
     if (val_has_been_change_call != NULL && callback_flag == 1)
     {
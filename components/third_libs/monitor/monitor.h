@@ -5,7 +5,39 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+// 监控字段总数，可在编译选项中覆盖
+#ifndef MONITOR_MAX_NUM
 #define MONITOR_MAX_NUM 5
+#endif
+
+// 各宽度分组的容量，可在编译选项中覆盖。
+// 分组按容量静态分配，每组都按总数分配会让RAM随类型数翻倍，默认按常用程度取总数的一部分：
+// 8位和32位取1/2，16位、64位和float取1/4，double、位和内存块取1/8，至少1个
+#define MONITOR_GRP_CAP(div) ((MONITOR_MAX_NUM + (div) - 1) / (div))
+#ifndef MONITOR_MAX_NUM_8
+#define MONITOR_MAX_NUM_8 MONITOR_GRP_CAP(2)
+#endif
+#ifndef MONITOR_MAX_NUM_16
+#define MONITOR_MAX_NUM_16 MONITOR_GRP_CAP(4)
+#endif
+#ifndef MONITOR_MAX_NUM_32
+#define MONITOR_MAX_NUM_32 MONITOR_GRP_CAP(2)
+#endif
+#ifndef MONITOR_MAX_NUM_64
+#define MONITOR_MAX_NUM_64 MONITOR_GRP_CAP(4)
+#endif
+#ifndef MONITOR_MAX_NUM_FLOAT
+#define MONITOR_MAX_NUM_FLOAT MONITOR_GRP_CAP(4)
+#endif
+#ifndef MONITOR_MAX_NUM_DOUBLE
+#define MONITOR_MAX_NUM_DOUBLE MONITOR_GRP_CAP(8)
+#endif
+#ifndef MONITOR_MAX_NUM_BIT
+#define MONITOR_MAX_NUM_BIT MONITOR_GRP_CAP(8)
+#endif
+#ifndef MONITOR_MAX_NUM_BLOB
+#define MONITOR_MAX_NUM_BLOB MONITOR_GRP_CAP(8)
+#endif
 
 typedef enum
 {
@@ -16,24 +48,163 @@ typedef enum
     TYPE_I16,
     TYPE_U32,
     TYPE_I32,
+    TYPE_U64,
+    TYPE_I64,
+    TYPE_FLOAT,  // 回调值为double的位模式，用monitor_val_to_double()转换
+    TYPE_DOUBLE, // 同上
+    TYPE_BIT,    // uint32_t中的一位，回调值为0/1
+    TYPE_BLOB,   // 定长内存块，回调值为内容的32位哈希
 } filed_type;
 
+// 带过滤器的字段数，可在编译选项中覆盖
+#ifndef MONITOR_FILTER_MAX_NUM
+#define MONITOR_FILTER_MAX_NUM 4
+#endif
+
+// 顺序锁个数，可在编译选项中覆盖
+#ifndef MONITOR_SEQLOCK_MAX_NUM
+#define MONITOR_SEQLOCK_MAX_NUM 2
+#endif
+
+// 窗口统计的字段数、滑动窗口子桶数、直方图桶数，可在编译选项中覆盖
+#ifndef MONITOR_AGG_MAX_NUM
+#define MONITOR_AGG_MAX_NUM 2
+#endif
+#ifndef MONITOR_AGG_MAX_BUCKETS
+#define MONITOR_AGG_MAX_BUCKETS 4
+#endif
+#ifndef MONITOR_AGG_HIST_BINS
+#define MONITOR_AGG_HIST_BINS 8
+#endif
+
 typedef void (*change_callback)(int64_t old_val, int64_t new_val, char *desc);
 typedef void (*val_has_been_change_callback)();
+// 变化记录钩子，type为filed_type
+typedef void (*monitor_record_callback)(uint8_t tag, uint8_t type, int64_t val);
+
+// 变化过滤：相对上次回调的值判断，参数为0表示不启用该项
+typedef struct
+{
+    uint32_t deadband;        // 绝对死区，变化量不超过该值不回调
+    uint16_t deadband_pct;    // 百分比死区，单位0.1%，相对上次回调的值
+    uint32_t hysteresis;      // 与上次变化方向相反时，变化量需额外超过该值
+    uint32_t min_interval_ms; // 两次回调的最小间隔，期间的变化延后回调
+    uint32_t max_silence_ms;  // 超过该时间没有回调则强制回调一次
+} monitor_filter_t;
+
+// 窗口统计：每次monitor_run_handler()对字段当前值采样一次
+typedef struct
+{
+    uint32_t window_ms; // 窗口长度
+    uint8_t buckets;    // 1:滚动窗口 >1:滑动窗口，按子桶滑动，不超过MONITOR_AGG_MAX_BUCKETS
+    uint8_t hist_bins;  // 直方图桶数，0不统计，不超过MONITOR_AGG_HIST_BINS
+    int32_t hist_min;   // 第一个桶的下界，小于它的计入第一个桶
+    uint32_t hist_step; // 桶宽度，超出范围的计入最后一个桶
+} monitor_agg_cfg_t;
+
+typedef struct
+{
+    uint32_t count;
+    int64_t min;
+    int64_t max;
+    int64_t mean;
+    int64_t last;
+    uint16_t hist[MONITOR_AGG_HIST_BINS];
+} monitor_agg_stat_t;
+
+// 顺序锁：写者修改受保护的字段前后调用write_begin/write_end，
+// monitor_run_handler()无锁读取，读到写入过程中的数据会重读，保证快照一致。
+// 同一把锁同一时刻只能有一个写者，多个字段可以共用一把锁。
+// 写区间不能嵌套；写区间内可以调用monitor_set_xxx()，几个字段一起发布
+typedef struct
+{
+    uint32_t seq;
+} monitor_seqlock_t;
+
+#define MONITOR_SEQLOCK_INIT {0}
+
+static inline void monitor_seqlock_write_begin(monitor_seqlock_t *lock)
+{
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
 
-typedef struct _monitor_val
+static inline void monitor_seqlock_write_end(monitor_seqlock_t *lock)
 {
-    void *field_ptr;
-    filed_type type;
-    char *desc;
-    int64_t field_val_old;
-    change_callback changes_callback;
-    uint8_t isactive;
-} monitor_val_t;
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+}
 
+// 增删与配置接口由内部互斥锁保护，多任务调用前需先monitor_val_init()；
+// 字段回调期间不持有该锁，回调中可以增删字段
 int monitor_val_init(val_has_been_change_callback callback);
 int monitor_val_add(void *ptr, filed_type type, change_callback CallBack, char *desc);
 void monitor_run_handler(void);
 
+// 删除字段，id可被再次分配
+int monitor_val_remove(int id);
+
+// 浮点字段，变化超过epsilon才算变化
+int monitor_val_add_float(float *ptr, float epsilon, change_callback CallBack, char *desc);
+int monitor_val_add_double(double *ptr, double epsilon, change_callback CallBack, char *desc);
+
+// 监控word中的第bit位
+int monitor_val_add_bit(uint32_t *word, uint8_t bit, change_callback CallBack, char *desc);
+
+// 监控size字节的内存块，内部缓存一份影子副本
+int monitor_val_add_blob(void *ptr, uint16_t size, change_callback CallBack, char *desc);
+
+// TYPE_FLOAT/TYPE_DOUBLE回调值转换
+double monitor_val_to_double(int64_t val);
+
+// 事件驱动字段：不参与轮询，只能通过monitor_set_xxx()修改，修改时标记脏位，
+// monitor_run_handler()只检查被标记的字段
+int monitor_val_add_event(void *ptr, filed_type type, change_callback CallBack, char *desc);
+
+// 写入字段并标记脏位，返回0成功，-1 id无效或类型不匹配。
+// 只在短临界区内写入，不拿注册表锁，顺序锁写区间内调用也不会等handler，中断中也可调用
+int monitor_set_u8(int id, uint8_t val);
+int monitor_set_i8(int id, int8_t val);
+int monitor_set_u16(int id, uint16_t val);
+int monitor_set_i16(int id, int16_t val);
+int monitor_set_u32(int id, uint32_t val);
+int monitor_set_i32(int id, int32_t val);
+int monitor_set_u64(int id, uint64_t val);
+int monitor_set_i64(int id, int64_t val);
+int monitor_set_float(int id, float val);
+int monitor_set_double(int id, double val);
+int monitor_set_bit(int id, uint8_t val);
+
+// 字段已被直接修改，标记脏位让下一次monitor_run_handler()检查，不加锁，中断中也可调用
+int monitor_val_touch(int id);
+
+// 设置字段的变化过滤，filter为NULL时取消过滤，只支持整数类型
+int monitor_val_set_filter(int id, const monitor_filter_t *filter);
+
+// 字段由顺序锁保护，lock为NULL时取消；共用一把锁的字段作为一个整体读取。
+// setter不加写锁，单独一次setter本身就是完整的；要让几个字段一起变化，
+// 在外层用write_begin/write_end包住这几次写入
+int monitor_val_set_seqlock(int id, monitor_seqlock_t *lock);
+
+// 设置字段的窗口统计，cfg为NULL时取消，只支持整数类型。
+// 开启批量上报后，每个子桶(滚动窗口为整个窗口)结束时上报一次窗口摘要：
+// count(4) | min(8) | max(8) | mean(8) | last(8) | hist(2*hist_bins)，小端，
+// 同时不再上报该字段的每次变化
+int monitor_val_set_agg(int id, const monitor_agg_cfg_t *cfg);
+
+// 按TLV标签读取/清空当前窗口的统计，返回0成功，-1没有该标签的统计字段
+int monitor_agg_get(uint8_t tag, monitor_agg_stat_t *stat);
+int monitor_agg_reset(uint8_t tag);
+
+// 绑定TLV标签，开启批量上报后字段的每次回调都会按字段宽度(小端)编码进上报帧
+int monitor_val_bind_tag(int id, uint8_t tag);
+
+// 批量上报开关：一次monitor_run_handler()中所有变化的绑定字段
+// 合并为一个0xCC嵌套帧，通过general_htlvc_protocol_report()发送
+void monitor_report_enable(uint8_t enable, uint8_t transfer_method);
+
+// 绑定了标签的字段每次回调前先调用记录钩子，用于落盘等，钩子中不能再调用monitor接口
+// 钩子在持有登记锁时调用，不能阻塞，写flash之类的慢操作要转到作业中做
+void monitor_record_hook_set(monitor_record_callback hook);
+
 void test();
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,246 @@
+#include <string.h>
+#include "spsc_ringbuf.h"
+
+#define RB_LOAD_ACQ(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RB_STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#define MSG_HDR_SIZE 4
+#define MSG_PAD_MARK 0xffffffffu
+#define MSG_ALIGN(x) (((x) + 3u) & ~3u)
+
+//  ==== 字节流 ====
+int spsc_ringbuf_init(spsc_ringbuf_t *rb, void *buf, uint32_t size)
+{
+    if (rb == NULL || buf == NULL || size == 0 || (size & (size - 1)) != 0)
+        return -1;
+
+    rb->buf = (uint8_t *)buf;
+    rb->size = size;
+    rb->head = 0;
+    rb->tail = 0;
+    return 0;
+}
+
+void spsc_ringbuf_reset(spsc_ringbuf_t *rb)
+{
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+uint32_t spsc_ringbuf_used(const spsc_ringbuf_t *rb)
+{
+    return RB_LOAD_ACQ(&rb->head) - RB_LOAD_ACQ(&rb->tail);
+}
+
+uint32_t spsc_ringbuf_free(const spsc_ringbuf_t *rb)
+{
+    return rb->size - spsc_ringbuf_used(rb);
+}
+
+uint32_t spsc_ringbuf_write(spsc_ringbuf_t *rb, const void *data, uint32_t len)
+{
+    uint32_t head = rb->head;
+    uint32_t free_len = rb->size - (head - RB_LOAD_ACQ(&rb->tail));
+    uint32_t off = head & (rb->size - 1);
+    uint32_t first;
+
+    if (len > free_len)
+        len = free_len;
+    if (len == 0)
+        return 0;
+
+    first = rb->size - off;
+    if (first > len)
+        first = len;
+
+    memcpy(&rb->buf[off], data, first);
+    memcpy(rb->buf, (const uint8_t *)data + first, len - first);
+
+    RB_STORE_REL(&rb->head, head + len);
+    return len;
+}
+
+uint32_t spsc_ringbuf_read(spsc_ringbuf_t *rb, void *data, uint32_t len)
+{
+    uint32_t tail = rb->tail;
+    uint32_t used = RB_LOAD_ACQ(&rb->head) - tail;
+    uint32_t off = tail & (rb->size - 1);
+    uint32_t first;
+
+    if (len > used)
+        len = used;
+    if (len == 0)
+        return 0;
+
+    first = rb->size - off;
+    if (first > len)
+        first = len;
+
+    memcpy(data, &rb->buf[off], first);
+    memcpy((uint8_t *)data + first, rb->buf, len - first);
+
+    RB_STORE_REL(&rb->tail, tail + len);
+    return len;
+}
+
+uint8_t *spsc_ringbuf_reserve(spsc_ringbuf_t *rb, uint32_t *len)
+{
+    uint32_t head = rb->head;
+    uint32_t free_len = rb->size - (head - RB_LOAD_ACQ(&rb->tail));
+    uint32_t off = head & (rb->size - 1);
+    uint32_t contig = rb->size - off;
+
+    *len = free_len < contig ? free_len : contig;
+    return *len ? &rb->buf[off] : NULL;
+}
+
+void spsc_ringbuf_commit(spsc_ringbuf_t *rb, uint32_t len)
+{
+    RB_STORE_REL(&rb->head, rb->head + len);
+}
+
+const uint8_t *spsc_ringbuf_peek(spsc_ringbuf_t *rb, uint32_t *len)
+{
+    uint32_t tail = rb->tail;
+    uint32_t used = RB_LOAD_ACQ(&rb->head) - tail;
+    uint32_t off = tail & (rb->size - 1);
+    uint32_t contig = rb->size - off;
+
+    *len = used < contig ? used : contig;
+    return *len ? &rb->buf[off] : NULL;
+}
+
+void spsc_ringbuf_release(spsc_ringbuf_t *rb, uint32_t len)
+{
+    RB_STORE_REL(&rb->tail, rb->tail + len);
+}
+
+//  ==== 变长消息 ====
+int spsc_msgbuf_init(spsc_msgbuf_t *mb, void *buf, uint32_t size)
+{
+    if (((uintptr_t)buf & 3u) != 0 || size < 2 * MSG_HDR_SIZE)
+        return -1;
+
+    mb->reserve_pad = 0;
+    mb->reserve_len = 0;
+    return spsc_ringbuf_init(&mb->rb, buf, size);
+}
+
+void spsc_msgbuf_reset(spsc_msgbuf_t *mb)
+{
+    spsc_ringbuf_reset(&mb->rb);
+    mb->reserve_pad = 0;
+    mb->reserve_len = 0;
+}
+
+uint8_t *spsc_msgbuf_reserve(spsc_msgbuf_t *mb, uint32_t max_len)
+{
+    spsc_ringbuf_t *rb = &mb->rb;
+    uint32_t head = rb->head;
+    uint32_t free_len = rb->size - (head - RB_LOAD_ACQ(&rb->tail));
+    uint32_t off = head & (rb->size - 1);
+    uint32_t contig = rb->size - off;
+    uint32_t need = MSG_HDR_SIZE + MSG_ALIGN(max_len);
+
+    // 尾部不够时要连尾部一起占用，超过半个缓冲区的消息在某些写位置上即使缓冲区空了也放不下
+    if (need > rb->size / 2)
+        return NULL;
+
+    if (contig >= need)
+    {
+        if (free_len < need)
+            return NULL;
+        mb->reserve_pad = 0;
+    }
+    else
+    {
+        // 尾部不够连续空间，跳到缓冲区开头
+        if (free_len < contig + need)
+            return NULL;
+        mb->reserve_pad = contig;
+        off = 0;
+    }
+
+    mb->reserve_len = max_len;
+    return &rb->buf[off + MSG_HDR_SIZE];
+}
+
+void spsc_msgbuf_commit(spsc_msgbuf_t *mb, uint32_t len)
+{
+    spsc_ringbuf_t *rb = &mb->rb;
+    uint32_t head = rb->head;
+    uint32_t off = head & (rb->size - 1);
+
+    if (len > mb->reserve_len)
+        len = mb->reserve_len;
+
+    if (mb->reserve_pad)
+    {
+        *(uint32_t *)&rb->buf[off] = MSG_PAD_MARK;
+        off = 0;
+    }
+    *(uint32_t *)&rb->buf[off] = len;
+
+    RB_STORE_REL(&rb->head, head + mb->reserve_pad + MSG_HDR_SIZE + MSG_ALIGN(len));
+    mb->reserve_pad = 0;
+    mb->reserve_len = 0;
+}
+
+int spsc_msgbuf_send(spsc_msgbuf_t *mb, const void *data, uint32_t len)
+{
+    uint8_t *msg = spsc_msgbuf_reserve(mb, len);
+    if (msg == NULL)
+        return -1;
+
+    memcpy(msg, data, len);
+    spsc_msgbuf_commit(mb, len);
+    return 0;
+}
+
+const uint8_t *spsc_msgbuf_peek(spsc_msgbuf_t *mb, uint32_t *len)
+{
+    spsc_ringbuf_t *rb = &mb->rb;
+    uint32_t tail = rb->tail;
+    uint32_t head = RB_LOAD_ACQ(&rb->head);
+    uint32_t off;
+    uint32_t hdr;
+
+    if (head == tail)
+        return NULL;
+
+    off = tail & (rb->size - 1);
+    hdr = *(uint32_t *)&rb->buf[off];
+    if (hdr == MSG_PAD_MARK)
+    {
+        // 跳过尾部填充，填充后面一定跟着一条消息
+        tail += rb->size - off;
+        RB_STORE_REL(&rb->tail, tail);
+        off = 0;
+        hdr = *(uint32_t *)rb->buf;
+    }
+
+    *len = hdr;
+    return &rb->buf[off + MSG_HDR_SIZE];
+}
+
+void spsc_msgbuf_release(spsc_msgbuf_t *mb)
+{
+    spsc_ringbuf_t *rb = &mb->rb;
+    uint32_t tail = rb->tail;
+    uint32_t hdr = *(uint32_t *)&rb->buf[tail & (rb->size - 1)];
+
+    RB_STORE_REL(&rb->tail, tail + MSG_HDR_SIZE + MSG_ALIGN(hdr));
+}
+
+int spsc_msgbuf_recv(spsc_msgbuf_t *mb, void *buf, uint32_t buf_len)
+{
+    uint32_t len;
+    const uint8_t *msg = spsc_msgbuf_peek(mb, &len);
+
+    if (msg == NULL)
+        return -1;
+
+    memcpy(buf, msg, len < buf_len ? len : buf_len);
+    spsc_msgbuf_release(mb);
+    return (int)len;
+}
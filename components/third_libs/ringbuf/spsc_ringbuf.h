@@ -0,0 +1,96 @@
+#ifndef __SPSC_RINGBUF_H__
+#define __SPSC_RINGBUF_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 单生产者/单消费者无锁环形缓冲区
+ *
+ * 生产者与消费者各自只写自己的索引，无需加锁，生产者可以在中断中调用。
+ * 索引自由递增，缓冲区大小必须为2的幂。
+ *
+ * spsc_ringbuf_t: 字节流，读写长度任意
+ * spsc_msgbuf_t:  变长消息，每条消息带4字节长度头，按4字节对齐，
+ *                 消息在缓冲区中始终连续，可以原地读写。
+ *                 尾部放不下时跳到开头，要保证任何写位置上都能放下，一条消息(含头)最多占半个缓冲区
+ */
+
+// size字节的消息缓冲区能预留的最大消息长度
+#define SPSC_MSGBUF_MAX_LEN(size) ((size) / 2 - 4)
+
+typedef struct
+{
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t head; // 写索引，仅生产者修改
+    uint32_t tail; // 读索引，仅消费者修改
+} spsc_ringbuf_t;
+
+typedef struct
+{
+    spsc_ringbuf_t rb;
+    uint32_t reserve_pad; // 生产者私有：本次预留跳过的尾部字节数
+    uint32_t reserve_len; // 生产者私有：本次预留的最大消息长度
+} spsc_msgbuf_t;
+
+// ==== 字节流 ====
+/// @brief 初始化，buf由调用者提供
+/// @param size 缓冲区大小，必须为2的幂
+/// @return 0:成功 -1:参数错误
+int spsc_ringbuf_init(spsc_ringbuf_t *rb, void *buf, uint32_t size);
+
+/// @brief 复位，只能在生产者与消费者都不访问时调用
+void spsc_ringbuf_reset(spsc_ringbuf_t *rb);
+
+uint32_t spsc_ringbuf_used(const spsc_ringbuf_t *rb);
+uint32_t spsc_ringbuf_free(const spsc_ringbuf_t *rb);
+
+/// @brief 写入数据，空间不足时只写入能写下的部分
+/// @return 实际写入字节数
+uint32_t spsc_ringbuf_write(spsc_ringbuf_t *rb, const void *data, uint32_t len);
+
+/// @brief 读出数据
+/// @return 实际读出字节数
+uint32_t spsc_ringbuf_read(spsc_ringbuf_t *rb, void *data, uint32_t len);
+
+/// @brief 获取一段连续可写空间，填充后调用spsc_ringbuf_commit
+/// @param len 输出连续可写长度
+/// @return 可写地址，空间满返回NULL
+uint8_t *spsc_ringbuf_reserve(spsc_ringbuf_t *rb, uint32_t *len);
+void spsc_ringbuf_commit(spsc_ringbuf_t *rb, uint32_t len);
+
+/// @brief 获取一段连续可读数据，使用后调用spsc_ringbuf_release
+/// @param len 输出连续可读长度
+/// @return 可读地址，空返回NULL
+const uint8_t *spsc_ringbuf_peek(spsc_ringbuf_t *rb, uint32_t *len);
+void spsc_ringbuf_release(spsc_ringbuf_t *rb, uint32_t len);
+
+// ==== 变长消息 ====
+int spsc_msgbuf_init(spsc_msgbuf_t *mb, void *buf, uint32_t size);
+void spsc_msgbuf_reset(spsc_msgbuf_t *mb);
+
+/// @brief 预留一条最大长度为max_len的消息空间，原地填充后调用spsc_msgbuf_commit
+/// @param max_len 不超过SPSC_MSGBUF_MAX_LEN(size)
+/// @return 消息地址，空间不足或max_len过大返回NULL
+uint8_t *spsc_msgbuf_reserve(spsc_msgbuf_t *mb, uint32_t max_len);
+
+/// @brief 提交预留的消息
+/// @param len 实际消息长度，不能大于预留长度
+void spsc_msgbuf_commit(spsc_msgbuf_t *mb, uint32_t len);
+
+/// @brief 复制写入一条消息，len不超过SPSC_MSGBUF_MAX_LEN(size)
+/// @return 0:成功 -1:空间不足或消息过长
+int spsc_msgbuf_send(spsc_msgbuf_t *mb, const void *data, uint32_t len);
+
+/// @brief 查看下一条消息，使用后调用spsc_msgbuf_release
+/// @param len 输出消息长度
+/// @return 消息地址，空返回NULL
+const uint8_t *spsc_msgbuf_peek(spsc_msgbuf_t *mb, uint32_t *len);
+void spsc_msgbuf_release(spsc_msgbuf_t *mb);
+
+/// @brief 复制读出一条消息，buf不足时截断
+/// @return 消息长度，空返回-1
+int spsc_msgbuf_recv(spsc_msgbuf_t *mb, void *buf, uint32_t buf_len);
+
+#endif
@@ -24,16 +24,18 @@ extern "C"
 #endif
 
 #include "utils_list.h"
+#include "ezos.h"
 
+    // 对外导出的分配接口，与ezos的其他模块共用一个堆
     void HAL_Free(void *ptr)
     {
         if (ptr)
-            free(ptr);
+            ezos_free(ptr);
     }
 
     void *HAL_Malloc(uint32_t size)
     {
-        return malloc(size);
+        return ezos_malloc(size);
     }
 
     /*
@@ -1,20 +1,14 @@
 #include "tlv_protocol.h"
-#include "utils_list.h"
+#include "vector.h"
+#include "ezos.h"
 
 // #include "hal_ble_slave.h"
 
 #define TAG "protocol cmd"
 
-static void hal_free(void *ptr)
-{
-    if (ptr)
-        free(ptr);
-}
-
-static void *hal_malloc(uint32_t size)
-{
-    return malloc(size + 4);
-}
+// 宏展开在调用处，开启EZOS_HEAP_TRACE时按调用点统计
+#define hal_free(ptr) ezos_free(ptr)
+#define hal_malloc(size) ezos_malloc((size) + 4)
 
 #define PROTOCOL_TAG_NESTED 0xff // 嵌合结构标签
 
@@ -24,7 +18,7 @@ void protocol_general_data_distory(protocol_general_data_t **protocol_data);
 void protocol_htlvc_packet_distory(void *protocol_pack);
 
 static int protocol_tag_handle(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_data_t *rsp_tlv_data);
-static int protocol_list_tlv_2_bytes(List *list_nested, uint8_t *rsp_byte_val, uint16_t *rsp_len);
+static int protocol_list_tlv_2_bytes(Vector *list_nested, uint8_t *rsp_byte_val, uint16_t *rsp_len);
 
 static general_protocol_t *g_htlvc_tabs = NULL;
 static uint16_t g_htlvc_tabs_size = 0;
@@ -265,8 +259,14 @@ protocol_general_data_t *protocol_htlvc_packet_create(uint8_t *head, uint8_t tag
     return protocol_packet;
 }
 
-// 嵌入结构数据处理，递归处理每一条tlv数据，处理结束返回的响应数据包添加到链表中
-static void protocol_nested_packet_handle(uint8_t *nested_byte_data, uint16_t data_len, List *list_nested)
+// 释放数组中保存的响应数据包
+static void protocol_nested_rsp_free(void *elem)
+{
+    protocol_general_data_distory((protocol_general_data_t **)elem);
+}
+
+// 嵌入结构数据处理，递归处理每一条tlv数据，处理结束返回的响应数据包添加到数组中
+static void protocol_nested_packet_handle(uint8_t *nested_byte_data, uint16_t data_len, Vector *list_nested)
 {
 
     if (data_len == 0)
@@ -282,30 +282,22 @@ static void protocol_nested_packet_handle(uint8_t *nested_byte_data, uint16_t da
     protocol_tag_handle(&cmd_tlv, &rsp_val);
 
     protocol_general_data_t *rsp_tlv_byte_packet = protocol_htlvc_packet_create(NULL, rsp_val.tag, rsp_val.len, rsp_val.val, NULL);
-    list_rpush(list_nested, list_node_new(rsp_tlv_byte_packet));
+    if (rsp_tlv_byte_packet != NULL && vector_rpush(list_nested, &rsp_tlv_byte_packet) == NULL)
+    {
+        protocol_general_data_distory(&rsp_tlv_byte_packet);
+    }
 
     protocol_nested_packet_handle(&nested_byte_data[3 + cmd_tlv.len], data_len - 3 - cmd_tlv.len, list_nested);
 }
 
-// 将链表中的所有响应回复数据统一转化为一块字节数据
-static int protocol_list_tlv_2_bytes(List *list_nested, uint8_t *rsp_byte_val, uint16_t *rsp_len)
+// 将数组中的所有响应回复数据统一转化为一块字节数据
+static int protocol_list_tlv_2_bytes(Vector *list_nested, uint8_t *rsp_byte_val, uint16_t *rsp_len)
 {
-    ListIterator *it;
-    ListNode *node;
-
-    if (NULL == (it = list_iterator_new(list_nested, LIST_HEAD)))
-    {
-        printf("Error : Can't malloc iterator\r\n");
-        return -1;
-    }
-
     uint16_t rsp_byte_index = 0;
-    while (1)
+
+    vector_foreach(list_nested, protocol_general_data_t *, it)
     {
-        node = list_iterator_next(it);
-        if (node == NULL)
-            break;
-        protocol_general_data_t *tlv_byte_data = (protocol_general_data_t *)node->val;
+        protocol_general_data_t *tlv_byte_data = *it;
 
         if (rsp_byte_index + tlv_byte_data->len > MAX_PROTOCOL_CMD_DATA_LEN)
             break;
@@ -316,8 +308,6 @@ static int protocol_list_tlv_2_bytes(List *list_nested, uint8_t *rsp_byte_val, u
 
     *rsp_len = rsp_byte_index;
 
-    list_iterator_destroy(it);
-
     return 0;
 }
 
@@ -331,31 +321,31 @@ static int protocol_tag_handle(protocol_tlv_data_t *cmd_tlv_data, protocol_tlv_d
 
     rsp_tlv_data->tag = tag;
 
-    // 嵌合结构处理，链表+递归
+    // 嵌合结构处理，数组+递归
     if (tag == PROTOCOL_TAG_NESTED)
     {
-        List *list_nested = list_new();
+        Vector *list_nested = vector_new(sizeof(protocol_general_data_t *), 8);
         if (list_nested == NULL)
         {
             printf("Error : Can't malloc LightLine_list_vec\r\n");
             return 0;
         }
-        list_nested->free = protocol_htlvc_packet_distory;
+        list_nested->free = protocol_nested_rsp_free;
 
         protocol_nested_packet_handle(val_data, val_length, list_nested);
 
         if (list_nested->len == 0)
         {
             // 处理异常
-            list_destroy(list_nested);
+            vector_destroy(list_nested);
             return -1;
         }
         else
         {
-            // 将链表中的数据合并到二进制数据
+            // 将数组中的数据合并到二进制数据
             protocol_list_tlv_2_bytes(list_nested, rsp_tlv_data->val, &rsp_tlv_data->len);
-            // 释放链表
-            list_destroy(list_nested);
+            // 释放数组
+            vector_destroy(list_nested);
         }
     }
     else // 非嵌合结构处理
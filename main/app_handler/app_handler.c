@@ -3,34 +3,65 @@
 #include "ezos.h"
 
 #include "hal_uart.h"
+#include "hal_flashlog.h"
+#include "monitor.h"
+#include "tlv_diag.h"
 
-static void data_proc_task(void *pvParameters)
+#include "app_handler.h"
+
+// 协议表，标签由应用分配
+static general_protocol_t g_protocol_tabs[] = {
+    {APP_TAG_FLASHLOG_QUERY, hal_flashlog_tlv_query},
+    {APP_TAG_DIAG_HEAP, tlv_diag_heap},
+    {APP_TAG_DIAG_PROF, tlv_diag_prof},
+};
+
+static int app_protocol_send(uint8_t *buffer, uint16_t buffer_length, uint8_t transfer_method)
+{
+    (void)transfer_method;
+    return hal_uart_send(buffer, buffer_length);
+}
+
+// 收到串口数据时提交到系统工作队列，不再单独占一个任务和栈
+static ezos_work_t g_data_proc_work;
+
+static void data_proc_work(void *arg)
 {
+    // 同一个作业不会并发执行，缓冲区可以是静态的
+    static uint8_t buf[MAX_UART_LEN];
+    uint16_t len;
 
-    while (1)
+    (void)arg;
+    while ((len = hal_uart_recv(buf, sizeof(buf), 0)) > 0)
     {
-        // ezos_printf("task1 run\r\n");
-        // printf("task2 run\r\n");
-
-      //  hal_uart_send((uint8_t *)"hello world\r\n",strlen("hello world\r\n"));
-        uint8_t buf[128]={0};
-        uint16_t len= hal_uart_recv(buf,sizeof(buf),0xffffffffUL);
-        hal_uart_send(buf,len);
-        ezos_delayms(100);
+        // 命令帧交给协议处理，其他数据照旧回显
+        if (buf[0] == PROTOCOL_HEADER_CMD)
+            general_htlvc_protocol_process(buf, len, APP_TRANSFER_UART);
+        else
+            hal_uart_send(buf, len);
     }
 }
 
+static void data_proc_rx_cb(void)
+{
+    ezos_work_submit(NULL, &g_data_proc_work);
+}
+
 int app_proc_start()
 {
+    if (ezos_sysworkq_init() != EZOS_SUCCESS)
+        return -1;
 
-    ezos_thread_params_t tmp_param = {0};
+    general_htlvc_protocol_register(g_protocol_tabs, sizeof(g_protocol_tabs) / sizeof(g_protocol_tabs[0]), app_protocol_send);
 
-    tmp_param.user_arg = NULL;
-    tmp_param.priority = 16;
-    tmp_param.thread_name = NULL;
-    tmp_param.stack_size = 2048;
+    // 没有tslog分区时只是不记录
+    if (hal_flashlog_init() == 0)
+        monitor_record_hook_set(hal_flashlog_monitor_hook);
 
-    ezos_thread_create(data_proc_task, &tmp_param);
+    ezos_work_init(&g_data_proc_work, data_proc_work, NULL, EZOS_WORK_PRIO_NORMAL);
+    hal_uart_rx_cb_set(data_proc_rx_cb);
+    // 设置回调前已经收到的数据
+    ezos_work_submit(NULL, &g_data_proc_work);
 
     return 0;
-}
\ No newline at end of file
+}
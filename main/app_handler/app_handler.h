@@ -11,6 +11,14 @@ typedef struct
    
 }app_wifi_param_t;
 
+// 命令的传输通道，透传给上报回调
+#define APP_TRANSFER_UART 0
+
+// 协议标签
+#define APP_TAG_FLASHLOG_QUERY 0x30 // 时序日志查询，见hal_flashlog_tlv_query()
+#define APP_TAG_DIAG_HEAP 0x31      // 堆快照，见tlv_diag_heap()
+#define APP_TAG_DIAG_PROF 0x32      // 任务剖析快照，见tlv_diag_prof()
+
 
 int app_proc_start();
 
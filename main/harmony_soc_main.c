@@ -35,6 +35,8 @@ void app_main(void)
 {
     hal_platform_init();
 
+    ezos_log_init();
+
     app_info_printf();
 
     hal_uart_init();
@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include "test.h"
+#include "utils_list.h"
+#include "vector.h"
+#include "deque.h"
+
+// Vector/Deque与utils_list的List对比：尾部追加、顺序遍历、随机下标访问，单位ns/元素
+
+#define ROUNDS 20
+
+static volatile uint32_t g_sink;
+
+typedef struct
+{
+    uint64_t push;
+    uint64_t iter;
+    uint64_t at;
+} bench_ns_t;
+
+static void bench_list(uint32_t n, bench_ns_t *ns)
+{
+    uint32_t seed = 1;
+    uint32_t sum = 0;
+
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        List *list = list_new();
+        ListIterator *it;
+        ListNode *node;
+        uint64_t t0 = test_now_ns();
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            list_rpush(list, list_node_new((void *)(uintptr_t)i));
+        }
+        ns->push += test_now_ns() - t0;
+
+        t0 = test_now_ns();
+        it = list_iterator_new(list, LIST_HEAD);
+        while ((node = list_iterator_next(it)) != NULL)
+        {
+            sum += (uint32_t)(uintptr_t)node->val;
+        }
+        list_iterator_destroy(it);
+        ns->iter += test_now_ns() - t0;
+
+        t0 = test_now_ns();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            sum += (uint32_t)(uintptr_t)list_at(list, (int)(test_rand(&seed) % n))->val;
+        }
+        ns->at += test_now_ns() - t0;
+
+        list_destroy(list);
+    }
+    g_sink = sum;
+}
+
+static void bench_vector(uint32_t n, bench_ns_t *ns)
+{
+    uint32_t seed = 1;
+    uint32_t sum = 0;
+
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        Vector *vec = vector_new(sizeof(uint32_t), 0);
+        uint64_t t0 = test_now_ns();
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            vector_rpush(vec, &i);
+        }
+        ns->push += test_now_ns() - t0;
+
+        t0 = test_now_ns();
+        vector_foreach(vec, uint32_t, it)
+        {
+            sum += *it;
+        }
+        ns->iter += test_now_ns() - t0;
+
+        t0 = test_now_ns();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            sum += *(uint32_t *)vector_at(vec, (int)(test_rand(&seed) % n));
+        }
+        ns->at += test_now_ns() - t0;
+
+        vector_destroy(vec);
+    }
+    g_sink = sum;
+}
+
+static void bench_deque(uint32_t n, bench_ns_t *ns)
+{
+    uint32_t seed = 1;
+    uint32_t sum = 0;
+
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        Deque *dq = deque_new(sizeof(uint32_t), 0);
+        uint64_t t0 = test_now_ns();
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            deque_rpush(dq, &i);
+        }
+        ns->push += test_now_ns() - t0;
+
+        t0 = test_now_ns();
+        for (uint32_t i = 0; i < dq->len; i++)
+        {
+            sum += *(uint32_t *)deque_at(dq, (int)i);
+        }
+        ns->iter += test_now_ns() - t0;
+
+        t0 = test_now_ns();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            sum += *(uint32_t *)deque_at(dq, (int)(test_rand(&seed) % n));
+        }
+        ns->at += test_now_ns() - t0;
+
+        deque_destroy(dq);
+    }
+    g_sink = sum;
+}
+
+static void bench_print(const char *name, uint32_t n, const bench_ns_t *ns)
+{
+    double div = (double)n * ROUNDS;
+
+    printf("%-6s n=%-5u push %8.1f  iterate %8.1f  at %10.1f\n", name, (unsigned)n, ns->push / div, ns->iter / div,
+           ns->at / div);
+}
+
+int main(void)
+{
+    static const uint32_t sizes[] = {16, 256, 4096};
+
+    printf("ns/element, %d rounds\n", ROUNDS);
+    for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    {
+        bench_ns_t list = {0}, vec = {0}, dq = {0};
+
+        bench_list(sizes[k], &list);
+        bench_vector(sizes[k], &vec);
+        bench_deque(sizes[k], &dq);
+        bench_print("list", sizes[k], &list);
+        bench_print("vector", sizes[k], &vec);
+        bench_print("deque", sizes[k], &dq);
+    }
+    return TEST_RESULT();
+}
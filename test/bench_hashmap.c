@@ -0,0 +1,96 @@
+#include <string.h>
+#include "test.h"
+#include "utils_list.h"
+#include "hashmap.h"
+
+// Hashmap与list_find按名字查找对比，键为设备名字符串，命中和不命中各一半，单位ns/次
+
+#define LOOKUPS 200000
+
+static char g_names[1000][16];
+static char g_misses[1000][16];
+static volatile uintptr_t g_sink;
+
+static int match_name(void *a, void *b)
+{
+    return strcmp((const char *)a, (const char *)b) == 0;
+}
+
+static uint64_t bench_list(unsigned int n)
+{
+    List *list = list_new();
+    uint32_t seed = 3;
+    uintptr_t hits = 0;
+    uint64_t t0;
+
+    list->match = match_name;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        list_rpush(list, list_node_new(g_names[i]));
+    }
+
+    t0 = test_now_ns();
+    for (int k = 0; k < LOOKUPS; k++)
+    {
+        uint32_t r = test_rand(&seed);
+        const char *key = (r & 1) ? g_misses[r % n] : g_names[r % n];
+
+        hits += list_find(list, (void *)key) != NULL;
+    }
+    t0 = test_now_ns() - t0;
+
+    TEST_CHECK(hits > 0 && hits < LOOKUPS);
+    g_sink = hits;
+    list_destroy(list);
+    return t0;
+}
+
+static uint64_t bench_hashmap(unsigned int n)
+{
+    Hashmap *map = hashmap_new(0);
+    uint32_t seed = 3;
+    uintptr_t hits = 0;
+    uint64_t t0;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        hashmap_put(map, g_names[i], 0, g_names[i]);
+    }
+
+    t0 = test_now_ns();
+    for (int k = 0; k < LOOKUPS; k++)
+    {
+        uint32_t r = test_rand(&seed);
+        const char *key = (r & 1) ? g_misses[r % n] : g_names[r % n];
+
+        hits += hashmap_find(map, key, 0) != NULL;
+    }
+    t0 = test_now_ns() - t0;
+
+    TEST_CHECK(hits > 0 && hits < LOOKUPS);
+    g_sink = hits;
+    hashmap_destroy(map);
+    return t0;
+}
+
+int main(void)
+{
+    static const unsigned int sizes[] = {10, 100, 1000};
+
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        snprintf(g_names[i], sizeof(g_names[i]), "dev-%u", i);
+        snprintf(g_misses[i], sizeof(g_misses[i]), "dev-x%u", i);
+    }
+
+    printf("ns/lookup, half misses\n");
+    for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    {
+        uint64_t list_ns = bench_list(sizes[k]);
+        uint64_t map_ns = bench_hashmap(sizes[k]);
+
+        printf("n=%-5u list_find %9.1f  hashmap_find %6.1f\n", sizes[k], (double)list_ns / LOOKUPS,
+               (double)map_ns / LOOKUPS);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * 同一条随机分配轨迹分别在TLSF堆和libc上回放，统计每次操作的耗时分布，单位ns。
+ * 轨迹：malloc/realloc/free，8B到6KB，最多400个块同时存活。
+ */
+
+#define EVENTS 200000
+#define SLOTS 400
+
+enum
+{
+    EV_MALLOC,
+    EV_REALLOC,
+    EV_FREE,
+};
+
+typedef struct
+{
+    uint8_t op;
+    uint16_t slot;
+    uint32_t size;
+} event_t;
+
+static event_t g_events[EVENTS];
+static uint32_t g_ns[EVENTS];
+static void *g_slots[SLOTS];
+
+static void trace_build(void)
+{
+    uint8_t live[SLOTS] = {0};
+    uint32_t seed = 77;
+
+    for (int i = 0; i < EVENTS; i++)
+    {
+        uint32_t r = test_rand(&seed);
+        uint16_t slot = (uint16_t)(r % SLOTS);
+        uint32_t size = (r & 0x30000) ? r % 120 + 8 : r % 6144 + 8;
+
+        g_events[i].slot = slot;
+        g_events[i].size = size;
+        if (!live[slot])
+            g_events[i].op = EV_MALLOC;
+        else
+            g_events[i].op = (r & 0x40000) ? EV_REALLOC : EV_FREE;
+        live[slot] = g_events[i].op != EV_FREE;
+    }
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char *name)
+{
+    qsort(g_ns, EVENTS, sizeof(g_ns[0]), cmp_u32);
+    printf("%-6s p50 %5u  p99 %5u  p99.99 %6u  max %7u\n", name, (unsigned)g_ns[EVENTS / 2],
+           (unsigned)g_ns[EVENTS * 99 / 100], (unsigned)g_ns[EVENTS - EVENTS / 10000], (unsigned)g_ns[EVENTS - 1]);
+}
+
+#define REPLAY(do_malloc, do_realloc, do_free)                                                                 \
+    for (int i = 0; i < EVENTS; i++)                                                                           \
+    {                                                                                                          \
+        event_t *ev = &g_events[i];                                                                            \
+        uint64_t t0 = test_now_ns();                                                                           \
+                                                                                                               \
+        if (ev->op == EV_MALLOC)                                                                               \
+            g_slots[ev->slot] = do_malloc(ev->size);                                                           \
+        else if (ev->op == EV_REALLOC)                                                                         \
+            g_slots[ev->slot] = do_realloc(g_slots[ev->slot], ev->size);                                       \
+        else                                                                                                   \
+        {                                                                                                      \
+            do_free(g_slots[ev->slot]);                                                                        \
+            g_slots[ev->slot] = NULL;                                                                          \
+        }                                                                                                      \
+        g_ns[i] = (uint32_t)(test_now_ns() - t0);                                                              \
+        TEST_CHECK(ev->op == EV_FREE || g_slots[ev->slot] != NULL);                                            \
+    }                                                                                                          \
+    for (int i = 0; i < SLOTS; i++)                                                                            \
+    {                                                                                                          \
+        do_free(g_slots[i]);                                                                                   \
+        g_slots[i] = NULL;                                                                                     \
+    }
+
+int main(void)
+{
+    ezos_heap_stat_t st;
+
+    trace_build();
+    printf("ns per operation, %d events\n", EVENTS);
+
+    // 预热一遍，两边的页都已经映射过
+    REPLAY(ezos_malloc, ezos_realloc, ezos_free);
+    REPLAY(ezos_malloc, ezos_realloc, ezos_free);
+    report("tlsf");
+    TEST_CHECK(ezos_heap_stat_get(&st) == EZOS_SUCCESS);
+    TEST_CHECK(st.used == 0 && st.free_blocks == 1);
+
+    REPLAY(malloc, realloc, free);
+    REPLAY(malloc, realloc, free);
+    report("libc");
+    return TEST_RESULT();
+}
@@ -0,0 +1,141 @@
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * 唤醒延迟，单位us：发起方打时间戳后唤醒阻塞的任务，任务醒来后计算差值
+ *   sem        ezos_sem_give -> ezos_sem_take
+ *   queue      ezos_queue_write -> ezos_queue_read，4字节消息
+ *   event      ezos_event_set -> ezos_event_wait
+ *   notify     ezos_notify_give -> ezos_notify_take
+ * 主机上的数字只用来比较各接口的相对开销，目标板上的绝对值要在板子上测。
+ */
+
+#define RUNS 10000
+
+static ezos_sem_id_t g_done;
+static ezos_sem_id_t g_sem;
+static ezos_queue_id_t g_queue;
+static ezos_event_id_t g_event;
+static volatile uint64_t g_kick_ns;
+static uint64_t g_sum_ns, g_max_ns;
+
+static void record(void)
+{
+    uint64_t ns = test_now_ns() - g_kick_ns;
+
+    g_sum_ns += ns;
+    if (ns > g_max_ns)
+        g_max_ns = ns;
+    ezos_sem_give(g_done);
+}
+
+static void sem_task(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        ezos_sem_take(g_sem, EZOS_DELAY_FOREVER);
+        record();
+    }
+}
+
+static void queue_task(void *arg)
+{
+    uint32_t msg;
+
+    (void)arg;
+    for (;;)
+    {
+        ezos_queue_read(g_queue, &msg, sizeof(msg), EZOS_DELAY_FOREVER);
+        record();
+    }
+}
+
+static void event_task(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        ezos_event_wait(g_event, 0x01, EZOS_EVENT_WAIT_ANY | EZOS_EVENT_CLEAR, NULL, EZOS_DELAY_FOREVER);
+        record();
+    }
+}
+
+static void notify_task(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        ezos_notify_take(1, NULL, EZOS_DELAY_FOREVER);
+        record();
+    }
+}
+
+static ezos_thread_id_t start_task(char *name, ezos_thread_func_cb func)
+{
+    ezos_thread_params_t param = {
+        .thread_name = name,
+        .priority = 5,
+        .stack_size = 2048,
+    };
+
+    return ezos_thread_create(func, &param);
+}
+
+static void bench_print(const char *name)
+{
+    printf("%-8s avg %6.1f  max %8.1f\n", name, (double)g_sum_ns / RUNS / 1000, (double)g_max_ns / 1000);
+    g_sum_ns = 0;
+    g_max_ns = 0;
+}
+
+int main(void)
+{
+    ezos_thread_id_t notify_id;
+    uint32_t msg = 0;
+
+    g_done = ezos_sem_create(1, 0);
+    g_sem = ezos_sem_create(1, 0);
+    g_queue = ezos_queue_create(1, sizeof(uint32_t));
+    g_event = ezos_event_create();
+    TEST_CHECK(g_done != NULL && g_sem != NULL && g_queue != NULL && g_event != NULL);
+    TEST_CHECK(start_task("sem", sem_task) != NULL);
+    TEST_CHECK(start_task("queue", queue_task) != NULL);
+    TEST_CHECK(start_task("event", event_task) != NULL);
+    notify_id = start_task("notify", notify_task);
+    TEST_CHECK(notify_id != NULL);
+
+    printf("wakeup latency, us, %d runs\n", RUNS);
+    for (int i = 0; i < RUNS; i++)
+    {
+        g_kick_ns = test_now_ns();
+        ezos_sem_give(g_sem);
+        ezos_sem_take(g_done, EZOS_DELAY_FOREVER);
+    }
+    bench_print("sem");
+
+    for (int i = 0; i < RUNS; i++)
+    {
+        g_kick_ns = test_now_ns();
+        ezos_queue_write(g_queue, &msg, sizeof(msg), EZOS_DELAY_FOREVER);
+        ezos_sem_take(g_done, EZOS_DELAY_FOREVER);
+    }
+    bench_print("queue");
+
+    for (int i = 0; i < RUNS; i++)
+    {
+        g_kick_ns = test_now_ns();
+        ezos_event_set(g_event, 0x01);
+        ezos_sem_take(g_done, EZOS_DELAY_FOREVER);
+    }
+    bench_print("event");
+
+    for (int i = 0; i < RUNS; i++)
+    {
+        g_kick_ns = test_now_ns();
+        ezos_notify_give(notify_id);
+        ezos_sem_take(g_done, EZOS_DELAY_FOREVER);
+    }
+    bench_print("notify");
+    return TEST_RESULT();
+}
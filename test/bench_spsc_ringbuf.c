@@ -0,0 +1,117 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+#include "spsc_ringbuf.h"
+
+/*
+ * 一次写一块再读出来的吞吐，单位MB/s，只比较每块数据交接本身的开销：
+ *   malloc+queue   原来hal_uart的做法，每块malloc一份拷贝，指针过ezos_queue，读出后free
+ *   ezos_msgbuf    带锁的消息缓冲区
+ *   spsc_ringbuf   字节流，write/read
+ *   spsc_msgbuf    变长消息，reserve/commit + peek/release原地读写
+ */
+
+#define TOTAL_BYTES (64u << 20)
+
+static uint8_t g_src[256];
+static uint8_t g_dst[256];
+static uint8_t g_buf[4096] __attribute__((aligned(4)));
+static volatile uint32_t g_sink;
+
+static double mbps(uint64_t ns)
+{
+    return (double)TOTAL_BYTES / 1048576.0 / ((double)ns / 1e9);
+}
+
+static uint64_t bench_malloc_queue(uint32_t chunk)
+{
+    ezos_queue_id_t q = ezos_queue_create(8, sizeof(uint8_t *));
+    uint64_t t0 = test_now_ns();
+
+    for (uint32_t done = 0; done < TOTAL_BYTES; done += chunk)
+    {
+        uint8_t *msg = ezos_malloc(chunk);
+
+        memcpy(msg, g_src, chunk);
+        ezos_queue_write(q, &msg, sizeof(msg), 0);
+        ezos_queue_read(q, &msg, sizeof(msg), 0);
+        memcpy(g_dst, msg, chunk);
+        ezos_free(msg);
+    }
+    t0 = test_now_ns() - t0;
+    ezos_queue_destroy(q);
+    return t0;
+}
+
+static uint64_t bench_ezos_msgbuf(uint32_t chunk)
+{
+    ezos_msgbuf_id_t mb = ezos_msgbuf_create(sizeof(g_buf));
+    uint64_t t0 = test_now_ns();
+
+    for (uint32_t done = 0; done < TOTAL_BYTES; done += chunk)
+    {
+        ezos_msgbuf_send(mb, g_src, chunk, 0);
+        g_sink += ezos_msgbuf_recv(mb, g_dst, sizeof(g_dst), 0);
+    }
+    t0 = test_now_ns() - t0;
+    ezos_msgbuf_destroy(mb);
+    return t0;
+}
+
+static uint64_t bench_spsc_ringbuf(uint32_t chunk)
+{
+    spsc_ringbuf_t rb;
+    uint64_t t0;
+
+    spsc_ringbuf_init(&rb, g_buf, sizeof(g_buf));
+    t0 = test_now_ns();
+    for (uint32_t done = 0; done < TOTAL_BYTES; done += chunk)
+    {
+        spsc_ringbuf_write(&rb, g_src, chunk);
+        g_sink += spsc_ringbuf_read(&rb, g_dst, chunk);
+    }
+    return test_now_ns() - t0;
+}
+
+static uint64_t bench_spsc_msgbuf(uint32_t chunk)
+{
+    spsc_msgbuf_t mb;
+    uint64_t t0;
+
+    spsc_msgbuf_init(&mb, g_buf, sizeof(g_buf));
+    t0 = test_now_ns();
+    for (uint32_t done = 0; done < TOTAL_BYTES; done += chunk)
+    {
+        uint8_t *p = spsc_msgbuf_reserve(&mb, chunk);
+        const uint8_t *msg;
+        uint32_t len = 0;
+
+        memcpy(p, g_src, chunk);
+        spsc_msgbuf_commit(&mb, chunk);
+        msg = spsc_msgbuf_peek(&mb, &len);
+        g_sink += msg[len - 1];
+        spsc_msgbuf_release(&mb);
+    }
+    return test_now_ns() - t0;
+}
+
+int main(void)
+{
+    static const uint32_t chunks[] = {16, 64, 256};
+
+    for (uint32_t i = 0; i < sizeof(g_src); i++)
+    {
+        g_src[i] = (uint8_t)i;
+    }
+
+    printf("MB/s, %u MiB per run\n", (unsigned)(TOTAL_BYTES >> 20));
+    for (unsigned int k = 0; k < sizeof(chunks) / sizeof(chunks[0]); k++)
+    {
+        uint32_t chunk = chunks[k];
+
+        printf("chunk=%-4u malloc+queue %7.0f  ezos_msgbuf %7.0f  spsc_ringbuf %7.0f  spsc_msgbuf %7.0f\n",
+               (unsigned)chunk, mbps(bench_malloc_queue(chunk)), mbps(bench_ezos_msgbuf(chunk)),
+               mbps(bench_spsc_ringbuf(chunk)), mbps(bench_spsc_msgbuf(chunk)));
+    }
+    return TEST_RESULT();
+}
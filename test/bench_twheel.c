@@ -0,0 +1,86 @@
+#include "test.h"
+#include "ezos.h"
+
+// 已有N个定时器在运行时，随机挑一个停止再启动的开销，ezos_timer与时间轮对比，单位ns/对
+// 定时时间很长，测量期间不会到期
+
+#define PAIRS 100000
+#define MAX_N 1000
+
+static ezos_timer_id_t g_timers[MAX_N];
+static ezos_wtimer_t g_wtimers[MAX_N];
+
+static void timer_cb(void *arg)
+{
+    (void)arg;
+}
+
+static double bench_timer(uint32_t n)
+{
+    uint32_t seed = 17;
+    uint64_t t0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        g_timers[i] = ezos_timer_create(timer_cb, NULL, 0);
+        ezos_timer_start(g_timers[i], 60000 + i);
+    }
+
+    t0 = test_now_ns();
+    for (int k = 0; k < PAIRS; k++)
+    {
+        ezos_timer_id_t t = g_timers[test_rand(&seed) % n];
+
+        ezos_timer_stop(t);
+        ezos_timer_start(t, 60000 + (uint32_t)k % 1000);
+    }
+    t0 = test_now_ns() - t0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ezos_timer_destroy(g_timers[i]);
+    }
+    return (double)t0 / PAIRS;
+}
+
+static double bench_wtimer(uint32_t n)
+{
+    uint32_t seed = 17;
+    uint64_t t0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ezos_wtimer_init(&g_wtimers[i], timer_cb, NULL);
+        ezos_wtimer_start(&g_wtimers[i], 60000 + i, 0);
+    }
+
+    t0 = test_now_ns();
+    for (int k = 0; k < PAIRS; k++)
+    {
+        ezos_wtimer_t *t = &g_wtimers[test_rand(&seed) % n];
+
+        ezos_wtimer_stop(t);
+        ezos_wtimer_start(t, 60000 + (uint32_t)k % 1000, 0);
+    }
+    t0 = test_now_ns() - t0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ezos_wtimer_stop(&g_wtimers[i]);
+    }
+    return (double)t0 / PAIRS;
+}
+
+int main(void)
+{
+    static const uint32_t sizes[] = {10, 100, MAX_N};
+
+    TEST_CHECK(ezos_twheel_init() == EZOS_SUCCESS);
+    printf("ns per stop+start pair\n");
+    for (unsigned int k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    {
+        printf("n=%-5u ezos_timer %8.0f  wtimer %5.0f\n", (unsigned)sizes[k], bench_timer(sizes[k]),
+               bench_wtimer(sizes[k]));
+    }
+    return TEST_RESULT();
+}
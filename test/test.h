@@ -0,0 +1,44 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+// 主机测试的公共宏：检查失败只打印并计数，测试跑完后由TEST_RESULT()给出退出码
+
+static int g_test_fails = 0;
+
+#define TEST_CHECK(cond)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(cond))                                                            \
+        {                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);    \
+            g_test_fails++;                                                     \
+        }                                                                       \
+    } while (0)
+
+#define TEST_RESULT() (printf("%s: %s\n", __FILE__, g_test_fails == 0 ? "ok" : "FAILED"), g_test_fails != 0)
+
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// 可复现的伪随机数(xorshift32)，种子相同时测试序列相同
+static inline uint32_t test_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+#endif /* __TEST_H__ */
@@ -0,0 +1,215 @@
+#include <string.h>
+#include "test.h"
+#include "vector.h"
+#include "deque.h"
+
+// Vector和Deque与一个简单的数组模型对照做随机操作，覆盖扩容、环形回绕和批量拷贝
+
+#define OPS 200000
+#define MODEL_CAP 4096
+
+static uint32_t g_model[MODEL_CAP * 2];
+static uint32_t g_head, g_len; // 模型的有效区间是g_model[g_head, g_head + g_len)
+
+static void model_reset(void)
+{
+    g_head = MODEL_CAP;
+    g_len = 0;
+}
+
+static int match_u32(void *a, void *b)
+{
+    return *(uint32_t *)a == *(uint32_t *)b;
+}
+
+static void test_vector(void)
+{
+    Vector *vec = vector_new(sizeof(uint32_t), 0);
+    uint32_t seed = 7;
+    uint32_t buf[16];
+    uint32_t next = 1;
+
+    TEST_CHECK(vec != NULL);
+    if (vec == NULL)
+        return;
+    vec->match = match_u32;
+    model_reset();
+
+    for (int op = 0; op < OPS && g_test_fails == 0; op++)
+    {
+        uint32_t r = test_rand(&seed);
+        uint32_t n = r % 16 + 1;
+
+        switch ((r >> 8) % 6)
+        {
+        case 0:
+        case 1:
+            if (g_len < MODEL_CAP)
+            {
+                TEST_CHECK(vector_rpush(vec, &next) != NULL);
+                g_model[g_head + g_len++] = next++;
+            }
+            break;
+        case 2:
+            if (g_len + n <= MODEL_CAP)
+            {
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    buf[i] = next;
+                    g_model[g_head + g_len++] = next++;
+                }
+                TEST_CHECK(vector_rpush_n(vec, buf, n) == 0);
+            }
+            break;
+        case 3:
+        {
+            uint32_t out = 0;
+
+            TEST_CHECK((vector_rpop(vec, &out) == 0) == (g_len > 0));
+            if (g_len)
+                TEST_CHECK(out == g_model[g_head + --g_len]);
+            break;
+        }
+        case 4:
+        {
+            uint32_t got = vector_rpop_n(vec, buf, n);
+
+            TEST_CHECK(got == (n < g_len ? n : g_len));
+            g_len -= got;
+            TEST_CHECK(memcmp(buf, &g_model[g_head + g_len], got * sizeof(uint32_t)) == 0);
+            break;
+        }
+        default:
+            if (g_len)
+            {
+                uint32_t i = r % g_len;
+                uint32_t *p = vector_find(vec, &g_model[g_head + i]);
+
+                TEST_CHECK(*(uint32_t *)vector_at(vec, (int)i) == g_model[g_head + i]);
+                TEST_CHECK(*(uint32_t *)vector_at(vec, -1) == g_model[g_head + g_len - 1]);
+                TEST_CHECK(p == vector_at(vec, (int)i));
+                vector_remove(vec, i);
+                memmove(&g_model[g_head + i], &g_model[g_head + i + 1], (g_len - i - 1) * sizeof(uint32_t));
+                g_len--;
+            }
+            TEST_CHECK(vector_at(vec, (int)g_len) == NULL);
+            TEST_CHECK(vector_at(vec, -(int)g_len - 1) == NULL);
+            break;
+        }
+        TEST_CHECK(vec->len == g_len);
+    }
+    TEST_CHECK(memcmp(vec->data, &g_model[g_head], g_len * sizeof(uint32_t)) == 0);
+    vector_destroy(vec);
+}
+
+static void test_deque(void)
+{
+    Deque *dq = deque_new(sizeof(uint32_t), 5);
+    uint32_t seed = 11;
+    uint32_t buf[16];
+    uint32_t next = 1;
+
+    TEST_CHECK(dq != NULL);
+    if (dq == NULL)
+        return;
+    TEST_CHECK(dq->mask == 7);
+    dq->match = match_u32;
+    model_reset();
+
+    for (int op = 0; op < OPS && g_test_fails == 0; op++)
+    {
+        uint32_t r = test_rand(&seed);
+        uint32_t n = r % 16 + 1;
+        uint32_t kind = (r >> 8) % 7;
+        uint32_t out = 0;
+
+        // 超过模型容量一半后偏向出队，长度不会一直涨上去
+        if (g_len > MODEL_CAP / 2 && (r & 1))
+            kind = 3;
+
+        switch (kind)
+        {
+        case 0:
+            if (g_len < MODEL_CAP && g_head + g_len < MODEL_CAP * 2)
+            {
+                TEST_CHECK(deque_rpush(dq, &next) != NULL);
+                g_model[g_head + g_len++] = next++;
+            }
+            break;
+        case 1:
+            if (g_len < MODEL_CAP && g_head > 0)
+            {
+                TEST_CHECK(deque_lpush(dq, &next) != NULL);
+                g_model[--g_head] = next++;
+                g_len++;
+            }
+            break;
+        case 2:
+            if (g_len + n <= MODEL_CAP && g_head + g_len + n <= MODEL_CAP * 2)
+            {
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    buf[i] = next;
+                    g_model[g_head + g_len++] = next++;
+                }
+                TEST_CHECK(deque_rpush_n(dq, buf, n) == 0);
+            }
+            break;
+        case 3:
+        {
+            uint32_t got = deque_lpop_n(dq, buf, n);
+
+            TEST_CHECK(got == (n < g_len ? n : g_len));
+            TEST_CHECK(memcmp(buf, &g_model[g_head], got * sizeof(uint32_t)) == 0);
+            g_head += got;
+            g_len -= got;
+            break;
+        }
+        case 4:
+            TEST_CHECK((deque_lpop(dq, &out) == 0) == (g_len > 0));
+            if (g_len)
+            {
+                TEST_CHECK(out == g_model[g_head]);
+                g_head++;
+                g_len--;
+            }
+            break;
+        case 5:
+            TEST_CHECK((deque_rpop(dq, &out) == 0) == (g_len > 0));
+            if (g_len)
+                TEST_CHECK(out == g_model[g_head + --g_len]);
+            break;
+        default:
+            if (g_len)
+            {
+                uint32_t i = r % g_len;
+
+                TEST_CHECK(*(uint32_t *)deque_at(dq, (int)i) == g_model[g_head + i]);
+                TEST_CHECK(*(uint32_t *)deque_at(dq, -1) == g_model[g_head + g_len - 1]);
+                TEST_CHECK(deque_find(dq, &g_model[g_head + i]) == deque_at(dq, (int)i));
+            }
+            TEST_CHECK(deque_at(dq, (int)g_len) == NULL);
+            break;
+        }
+        TEST_CHECK(dq->len == g_len);
+
+        // 模型两端用完时把内容挪回中间
+        if (g_head < 16 || g_head + g_len > MODEL_CAP * 2 - 16)
+        {
+            memmove(&g_model[MODEL_CAP - g_len / 2], &g_model[g_head], g_len * sizeof(uint32_t));
+            g_head = MODEL_CAP - g_len / 2;
+        }
+    }
+    for (uint32_t i = 0; i < g_len; i++)
+    {
+        TEST_CHECK(*(uint32_t *)deque_at(dq, (int)i) == g_model[g_head + i]);
+    }
+    deque_destroy(dq);
+}
+
+int main(void)
+{
+    test_vector();
+    test_deque();
+    return TEST_RESULT();
+}
@@ -0,0 +1,238 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+#include "ezos_sim.h"
+
+/*
+ * 仿真模式下协程等待ezos对象：
+ *   永久等待期间协程不被轮询，释放信号量、写队列、读队列、置事件位的同一时刻协程就运行
+ *   超时按时返回，超时后从等待链表上摘下，之后的释放不再唤醒它
+ *   多个协程等同一个信号量，每次释放只有一个拿到，没拿到的挂回去继续等
+ * 工作任务优先级低于主任务，主任务延时时协程才运行。
+ */
+
+#define WQ_PRIORITY (EZ_DEFAULT_PRIORITY - 2)
+#define TICK EZOS_TWHEEL_TICK_MS
+
+typedef struct
+{
+    ezos_coro_t co;
+    uint32_t steps;   // 协程函数被调用的次数
+    uint32_t done;    // 完成等待的次数
+    ezos_status_t ret;
+    ezos_status_t result; // 最近一次等待的结果，ret会被下一次等待的尝试改写
+    uint64_t done_at;     // 最近一次完成等待的虚拟时间
+    uint32_t msg;
+} waiter_t;
+
+static ezos_workqueue_id_t g_wq;
+static ezos_sem_id_t g_sem;
+static ezos_queue_id_t g_queue;
+static ezos_event_id_t g_event;
+static uint32_t g_timeout;
+
+static void waiter_done(waiter_t *w)
+{
+    w->done++;
+    w->result = w->ret;
+    w->done_at = ezos_sim_now_ms();
+}
+
+static ezos_coro_ret_t sem_coro(ezos_coro_t *co, void *arg)
+{
+    waiter_t *w = arg;
+
+    w->steps++;
+    EZOS_CORO_BEGIN(co);
+    for (;;)
+    {
+        EZOS_CORO_SEM_TAKE(co, g_sem, w->ret, g_timeout);
+        waiter_done(w);
+        if (w->ret != EZOS_SUCCESS)
+            break;
+    }
+    EZOS_CORO_END(co);
+}
+
+static ezos_coro_ret_t read_coro(ezos_coro_t *co, void *arg)
+{
+    waiter_t *w = arg;
+
+    w->steps++;
+    EZOS_CORO_BEGIN(co);
+    EZOS_CORO_QUEUE_READ(co, g_queue, &w->msg, sizeof(w->msg), w->ret, EZOS_DELAY_FOREVER);
+    waiter_done(w);
+    EZOS_CORO_END(co);
+}
+
+static ezos_coro_ret_t write_coro(ezos_coro_t *co, void *arg)
+{
+    waiter_t *w = arg;
+
+    w->steps++;
+    EZOS_CORO_BEGIN(co);
+    EZOS_CORO_QUEUE_WRITE(co, g_queue, &w->msg, sizeof(w->msg), w->ret, EZOS_DELAY_FOREVER);
+    waiter_done(w);
+    EZOS_CORO_END(co);
+}
+
+static ezos_coro_ret_t event_coro(ezos_coro_t *co, void *arg)
+{
+    waiter_t *w = arg;
+
+    w->steps++;
+    EZOS_CORO_BEGIN(co);
+    EZOS_CORO_EVENT_WAIT(co, g_event, 0x03, EZOS_EVENT_WAIT_ALL | EZOS_EVENT_CLEAR, NULL, w->ret, EZOS_DELAY_FOREVER);
+    waiter_done(w);
+    EZOS_CORO_END(co);
+}
+
+static void waiter_start(waiter_t *w, ezos_coro_func_t func)
+{
+    memset(w, 0, sizeof(*w));
+    ezos_coro_init(&w->co, func, w, EZOS_WORK_PRIO_NORMAL);
+    TEST_CHECK(ezos_coro_start(g_wq, &w->co) == EZOS_SUCCESS);
+}
+
+static void test_sem(void)
+{
+    waiter_t w;
+    uint64_t t0;
+
+    g_timeout = EZOS_DELAY_FOREVER;
+    waiter_start(&w, sem_coro);
+    ezos_delayms(1);
+    TEST_CHECK(w.steps == 1 && w.done == 0);
+
+    // 等了1秒也只运行过一次，释放的同一时刻就拿到
+    ezos_delayms(1000);
+    TEST_CHECK(w.steps == 1);
+    t0 = ezos_sim_now_ms();
+    ezos_delayms(33);
+    ezos_sem_give(g_sem);
+    ezos_delayms(1);
+    TEST_CHECK(w.done == 1 && w.result == EZOS_SUCCESS && w.done_at == t0 + 33);
+    TEST_CHECK(w.steps == 2);
+
+    ezos_coro_stop(&w.co);
+    ezos_delayms(1);
+}
+
+static void test_sem_timeout(void)
+{
+    waiter_t w;
+    uint64_t t0;
+
+    g_timeout = 50;
+    t0 = ezos_sim_now_ms();
+    waiter_start(&w, sem_coro);
+    ezos_delayms(100);
+    TEST_CHECK(w.done == 1 && w.result == EZOS_TIMEOUT);
+    TEST_CHECK(w.done_at >= t0 + 50 && w.done_at <= t0 + 50 + TICK);
+    // 超时的一次等待只有开始和到期两步
+    TEST_CHECK(w.steps == 2);
+    TEST_CHECK(ezos_coro_is_done(&w.co));
+
+    // 已经不在等待链表上
+    ezos_sem_give(g_sem);
+    ezos_delayms(1);
+    TEST_CHECK(w.steps == 2);
+    TEST_CHECK(ezos_sem_take(g_sem, 0) == EZOS_SUCCESS);
+}
+
+static void test_sem_many(void)
+{
+    waiter_t w[3];
+    uint32_t done, steps;
+
+    g_timeout = EZOS_DELAY_FOREVER;
+    for (int i = 0; i < 3; i++)
+    {
+        waiter_start(&w[i], sem_coro);
+    }
+    ezos_delayms(1);
+    for (int k = 1; k <= 3; k++)
+    {
+        ezos_sem_give(g_sem);
+        ezos_delayms(1);
+        done = w[0].done + w[1].done + w[2].done;
+        TEST_CHECK(done == (uint32_t)k);
+    }
+    // 没拿到的醒来后挂回去继续等，不轮询
+    steps = w[0].steps + w[1].steps + w[2].steps;
+    ezos_delayms(500);
+    TEST_CHECK(w[0].steps + w[1].steps + w[2].steps == steps);
+    for (int i = 0; i < 3; i++)
+    {
+        ezos_coro_stop(&w[i].co);
+    }
+    ezos_delayms(1);
+}
+
+static void test_queue(void)
+{
+    waiter_t r, wr;
+    uint32_t msg = 0x5a5a;
+    uint64_t t0;
+
+    waiter_start(&r, read_coro);
+    ezos_delayms(200);
+    TEST_CHECK(r.steps == 1);
+    t0 = ezos_sim_now_ms();
+    ezos_delayms(17);
+    TEST_CHECK(ezos_queue_write(g_queue, &msg, sizeof(msg), 0) == EZOS_SUCCESS);
+    ezos_delayms(1);
+    TEST_CHECK(r.done == 1 && r.msg == 0x5a5a && r.done_at == t0 + 17);
+
+    // 队列满时写等待，读出一条的同一时刻写进去
+    TEST_CHECK(ezos_queue_write(g_queue, &msg, sizeof(msg), 0) == EZOS_SUCCESS);
+    waiter_start(&wr, write_coro);
+    wr.msg = 0x1234;
+    ezos_delayms(200);
+    TEST_CHECK(wr.steps == 1 && wr.done == 0);
+    t0 = ezos_sim_now_ms();
+    ezos_delayms(25);
+    TEST_CHECK(ezos_queue_read(g_queue, &msg, sizeof(msg), 0) == EZOS_SUCCESS);
+    ezos_delayms(1);
+    TEST_CHECK(wr.done == 1 && wr.done_at == t0 + 25);
+    TEST_CHECK(ezos_queue_read(g_queue, &msg, sizeof(msg), 0) == EZOS_SUCCESS && msg == 0x1234);
+}
+
+static void test_event(void)
+{
+    waiter_t w;
+    uint64_t t0;
+
+    waiter_start(&w, event_coro);
+    ezos_delayms(1);
+    t0 = ezos_sim_now_ms();
+    // 只置一位，醒来检查不满足，继续等
+    ezos_delayms(10);
+    ezos_event_set(g_event, 0x01);
+    ezos_delayms(1);
+    TEST_CHECK(w.done == 0 && w.steps == 2);
+    ezos_delayms(9);
+    ezos_event_set(g_event, 0x02);
+    ezos_delayms(1);
+    TEST_CHECK(w.done == 1 && w.done_at == t0 + 20 && w.steps == 3);
+    TEST_CHECK(ezos_event_get(g_event) == 0);
+}
+
+int main(void)
+{
+    ezos_sim_enable();
+    g_wq = ezos_workqueue_create("coro", 2, WQ_PRIORITY, 2048);
+    g_sem = ezos_sem_create(1, 0);
+    g_queue = ezos_queue_create(1, sizeof(uint32_t));
+    g_event = ezos_event_create();
+    TEST_CHECK(g_wq != NULL && g_sem != NULL && g_queue != NULL && g_event != NULL);
+    if (g_wq == NULL)
+        return TEST_RESULT();
+
+    test_sem();
+    test_sem_timeout();
+    test_sem_many();
+    test_queue();
+    test_event();
+    return TEST_RESULT();
+}
@@ -0,0 +1,75 @@
+#include <time.h>
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * ezos_delay_us：
+ *   任何时长都不短于要求的时间，平均超出不多
+ *   长的延时大部分时间在睡眠，忙等只占最后一小段，用线程CPU时间检查
+ */
+
+#define RUNS 20
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void test_accuracy(void)
+{
+    static const uint32_t delays[] = {0, 1, 10, 100, EZOS_DELAY_US_SPIN_MAX - 1, EZOS_DELAY_US_SPIN_MAX, 2500, 10000, 25000};
+
+    for (unsigned int k = 0; k < sizeof(delays) / sizeof(delays[0]); k++)
+    {
+        uint32_t us = delays[k];
+        uint64_t over = 0, max_over = 0;
+        uint32_t early = 0;
+
+        for (int i = 0; i < RUNS; i++)
+        {
+            uint64_t t0 = test_now_ns();
+            uint64_t dt;
+
+            ezos_delay_us(us);
+            dt = test_now_ns() - t0;
+            if (dt < (uint64_t)us * 1000)
+            {
+                early++;
+                continue;
+            }
+            over += dt - (uint64_t)us * 1000;
+            if (dt - (uint64_t)us * 1000 > max_over)
+                max_over = dt - (uint64_t)us * 1000;
+        }
+        printf("%6u us: avg over %6.1f us, max over %7.1f us\n", (unsigned)us, (double)over / RUNS / 1000,
+               (double)max_over / 1000);
+        TEST_CHECK(early == 0);
+        // 主机调度有抖动，只检查平均值不离谱
+        TEST_CHECK(over / RUNS < 5000000);
+    }
+}
+
+static void test_sleeps(void)
+{
+    uint64_t cpu0, cpu;
+
+    // 25ms里忙等的部分不超过四分之一
+    cpu0 = thread_cpu_ns();
+    for (int i = 0; i < RUNS; i++)
+    {
+        ezos_delay_us(25000);
+    }
+    cpu = thread_cpu_ns() - cpu0;
+    printf("cpu per 25 ms delay: %.1f us\n", (double)cpu / RUNS / 1000);
+    TEST_CHECK(cpu / RUNS < 25000000 / 4);
+}
+
+int main(void)
+{
+    test_accuracy();
+    test_sleeps();
+    return TEST_RESULT();
+}
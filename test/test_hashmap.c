@@ -0,0 +1,146 @@
+#include <string.h>
+#include <stdlib.h>
+#include "test.h"
+#include "hashmap.h"
+
+// 基本操作，以及容量边界：条目编号+1存在16位的探测表中，不能碰到HASHMAP_SLOT_DELETED
+
+static void test_basic(void)
+{
+    static const char *names[] = {"Xiaomi 12S", "Xiaom22222", "dev-a", "dev-b", "dev-c"};
+    Hashmap *map = hashmap_new(0);
+    unsigned int iter = 0;
+    unsigned int i = 0;
+    HashmapEntry *entry;
+    uint8_t addr[6] = {1, 2, 3, 4, 5, 6};
+
+    TEST_CHECK(map != NULL);
+    if (map == NULL)
+        return;
+
+    for (i = 0; i < 5; i++)
+    {
+        TEST_CHECK(hashmap_put(map, names[i], 0, (void *)(uintptr_t)(i + 1)) != NULL);
+    }
+    TEST_CHECK(hashmap_put(map, addr, sizeof(addr), (void *)(uintptr_t)100) != NULL);
+    TEST_CHECK(map->count == 6);
+
+    // 覆盖已有的键不增加条目
+    TEST_CHECK(hashmap_put(map, "dev-a", 0, (void *)(uintptr_t)33) != NULL);
+    TEST_CHECK(map->count == 6);
+    entry = hashmap_find(map, "dev-a", 0);
+    TEST_CHECK(entry != NULL && entry->val == (void *)(uintptr_t)33);
+    entry = hashmap_find(map, addr, sizeof(addr));
+    TEST_CHECK(entry != NULL && entry->val == (void *)(uintptr_t)100);
+    TEST_CHECK(hashmap_find(map, "dev-d", 0) == NULL);
+
+    TEST_CHECK(hashmap_remove(map, "Xiaom22222", 0) == 0);
+    TEST_CHECK(hashmap_remove(map, "Xiaom22222", 0) != 0);
+    TEST_CHECK(hashmap_find(map, "Xiaom22222", 0) == NULL);
+
+    // 按插入顺序遍历，跳过删除的条目
+    i = 0;
+    while ((entry = hashmap_next(map, &iter)) != NULL)
+    {
+        static const uintptr_t order[] = {1, 33, 4, 5, 100};
+
+        TEST_CHECK(i < 5 && (uintptr_t)entry->val == order[i]);
+        i++;
+    }
+    TEST_CHECK(i == 5);
+
+    hashmap_destroy(map);
+}
+
+static void test_grow_limit(void)
+{
+    Hashmap *map;
+    unsigned int found = 0;
+
+    TEST_CHECK(hashmap_new(HASHMAP_GROW_MAX_CAP + 1) == NULL);
+    TEST_CHECK(hashmap_new(HASHMAP_MAX_CAP) == NULL);
+
+    map = hashmap_new(HASHMAP_GROW_MAX_CAP);
+    TEST_CHECK(map != NULL);
+    if (map == NULL)
+        return;
+    TEST_CHECK(map->cap == HASHMAP_GROW_MAX_CAP);
+    hashmap_destroy(map);
+
+    // 从最小容量一路增长到上限，再多一个就失败
+    map = hashmap_new(0);
+    TEST_CHECK(map != NULL);
+    if (map == NULL)
+        return;
+    for (uint32_t k = 0; k < HASHMAP_GROW_MAX_CAP; k++)
+    {
+        if (hashmap_put_int(map, k * 7919u, (void *)(uintptr_t)(k + 1)) == NULL)
+        {
+            TEST_CHECK(0);
+            break;
+        }
+    }
+    TEST_CHECK(map->cap == HASHMAP_GROW_MAX_CAP);
+    TEST_CHECK(hashmap_put_int(map, 0xdeadbeef, NULL) == NULL);
+    for (uint32_t k = 0; k < HASHMAP_GROW_MAX_CAP; k++)
+    {
+        HashmapEntry *entry = hashmap_find_int(map, k * 7919u);
+
+        found += entry != NULL && entry->val == (void *)(uintptr_t)(k + 1);
+    }
+    TEST_CHECK(found == HASHMAP_GROW_MAX_CAP);
+
+    // 满了以后删除再插入，复用删除条目的位置
+    TEST_CHECK(hashmap_remove_int(map, 0) == 0);
+    TEST_CHECK(hashmap_put_int(map, 0xdeadbeef, NULL) != NULL);
+    TEST_CHECK(hashmap_find_int(map, 0xdeadbeef) != NULL);
+    TEST_CHECK(map->count == HASHMAP_GROW_MAX_CAP);
+    hashmap_destroy(map);
+}
+
+static void test_fixed_max(void)
+{
+    Hashmap map;
+    unsigned int index_size = 1;
+    HashmapEntry *entries = calloc(HASHMAP_MAX_CAP, sizeof(HashmapEntry));
+    uint16_t *index;
+    unsigned int found = 0;
+
+    while (index_size < HASHMAP_MAX_CAP * 2)
+        index_size <<= 1;
+    index = calloc(index_size, sizeof(uint16_t));
+
+    TEST_CHECK(hashmap_init(&map, entries, index, index_size, HASHMAP_MAX_CAP + 1) != 0);
+    TEST_CHECK(hashmap_init(&map, entries, index, index_size, HASHMAP_MAX_CAP) == 0);
+    for (uint32_t k = 0; k < HASHMAP_MAX_CAP; k++)
+    {
+        if (hashmap_put_int(&map, k, (void *)(uintptr_t)(k + 1)) == NULL)
+        {
+            TEST_CHECK(0);
+            break;
+        }
+    }
+    TEST_CHECK(hashmap_put_int(&map, HASHMAP_MAX_CAP, NULL) == NULL);
+    for (uint32_t k = 0; k < HASHMAP_MAX_CAP; k++)
+    {
+        HashmapEntry *entry = hashmap_find_int(&map, k);
+
+        found += entry != NULL && entry->val == (void *)(uintptr_t)(k + 1);
+    }
+    TEST_CHECK(found == HASHMAP_MAX_CAP);
+    for (unsigned int i = 0; i < index_size; i++)
+    {
+        TEST_CHECK(index[i] != HASHMAP_SLOT_DELETED);
+    }
+
+    free(entries);
+    free(index);
+}
+
+int main(void)
+{
+    test_basic();
+    test_grow_limit();
+    test_fixed_max();
+    return TEST_RESULT();
+}
@@ -0,0 +1,138 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * TLSF堆的随机分配/扩缩/释放，每块填充自己的图案，释放和扩缩前检查内容没被别的块破坏。
+ * 统计要前后一致，用尽时分配失败并计数，全部释放后合并回一个空闲块。
+ */
+
+#define SLOTS 400
+#define OPS 200000
+
+static struct
+{
+    uint8_t *p;
+    uint32_t len;
+    uint8_t tag;
+} g_blocks[SLOTS];
+
+static void block_fill(int i)
+{
+    memset(g_blocks[i].p, g_blocks[i].tag, g_blocks[i].len);
+}
+
+static int block_ok(int i)
+{
+    for (uint32_t k = 0; k < g_blocks[i].len; k++)
+    {
+        if (g_blocks[i].p[k] != g_blocks[i].tag)
+            return 0;
+    }
+    return 1;
+}
+
+static uint32_t rand_size(uint32_t *seed)
+{
+    uint32_t r = test_rand(seed);
+
+    // 多数是小块，少数到6KB
+    return (r & 3) ? r % 128 + 1 : r % 6144 + 1;
+}
+
+int main(void)
+{
+    ezos_heap_stat_t st0, st;
+    uint32_t seed = 41;
+    uint32_t bad = 0, fails = 0;
+
+    TEST_CHECK(ezos_heap_stat_get(&st0) == EZOS_SUCCESS);
+    TEST_CHECK(st0.used == 0 && st0.free == st0.total && st0.free_blocks == 1);
+
+    for (int op = 0; op < OPS && bad == 0; op++)
+    {
+        uint32_t r = test_rand(&seed);
+        int i = (int)(r % SLOTS);
+
+        if (g_blocks[i].p == NULL)
+        {
+            uint32_t len = rand_size(&seed);
+
+            g_blocks[i].p = (r & 0x100) ? ezos_malloc(len) : ezos_calloc(1, len);
+            if (g_blocks[i].p == NULL)
+            {
+                fails++;
+                continue;
+            }
+            TEST_CHECK(((uintptr_t)g_blocks[i].p & (sizeof(void *) - 1)) == 0);
+            if (!(r & 0x100))
+            {
+                g_blocks[i].tag = 0;
+                g_blocks[i].len = len;
+                bad += !block_ok(i);
+            }
+            g_blocks[i].len = len;
+            g_blocks[i].tag = (uint8_t)(r >> 24);
+            block_fill(i);
+        }
+        else if (r & 0x200)
+        {
+            uint32_t len = rand_size(&seed);
+            uint8_t *p;
+
+            bad += !block_ok(i);
+            p = ezos_realloc(g_blocks[i].p, len);
+            if (p == NULL)
+            {
+                // 失败时原块不变
+                fails++;
+                bad += !block_ok(i);
+                continue;
+            }
+            // 保留的部分内容不变
+            if (len < g_blocks[i].len)
+                g_blocks[i].len = len;
+            g_blocks[i].p = p;
+            bad += !block_ok(i);
+            g_blocks[i].len = len;
+            block_fill(i);
+        }
+        else
+        {
+            bad += !block_ok(i);
+            ezos_free(g_blocks[i].p);
+            g_blocks[i].p = NULL;
+        }
+
+        if (op % 1000 == 0)
+        {
+            TEST_CHECK(ezos_heap_stat_get(&st) == EZOS_SUCCESS);
+            TEST_CHECK(st.total == st0.total && st.used + st.free <= st.total && st.largest_free <= st.free);
+            TEST_CHECK(st.used <= st.used_max);
+        }
+    }
+    TEST_CHECK(bad == 0);
+
+    // 用尽时失败并计数，区域外的指针不会被接收
+    TEST_CHECK(ezos_heap_stat_get(&st) == EZOS_SUCCESS);
+    TEST_CHECK(st.fails == fails);
+    TEST_CHECK(ezos_malloc(st0.total + 1) == NULL);
+    ezos_free(&st);
+    TEST_CHECK(ezos_heap_stat_get(&st) == EZOS_SUCCESS);
+    TEST_CHECK(st.fails == fails + 1);
+
+    for (int i = 0; i < SLOTS; i++)
+    {
+        if (g_blocks[i].p != NULL)
+        {
+            bad += !block_ok(i);
+            ezos_free(g_blocks[i].p);
+        }
+    }
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(ezos_heap_stat_get(&st) == EZOS_SUCCESS);
+    TEST_CHECK(st.used == 0 && st.free_blocks == 1 && st.largest_free == st.total && st.frag_pct == 0);
+    printf("heap %u bytes, peak used %u, fails %u\n", (unsigned)st.total, (unsigned)st.used_max, (unsigned)st.fails);
+
+    return TEST_RESULT();
+}
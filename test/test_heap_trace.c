@@ -0,0 +1,89 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+#include "tlv_diag.h"
+
+// 调用点比表项多，表满后的调用点合并到最后一项，打印和读取都不能访问空文件名
+
+#define SITES (EZOS_HEAP_TRACE_SITES + 8)
+
+static uint16_t g_reported = 0;
+static uint16_t g_reported_other = 0;
+
+// 上报帧：H(1) T(1) L(2，大端) V C(2)，V中每个调用点32BYTE，line在14，file在16
+static int report_cb(uint8_t *buffer, uint16_t buffer_length, uint8_t transfer_method)
+{
+    uint16_t len = (buffer[2] << 8) | buffer[3];
+
+    (void)transfer_method;
+    TEST_CHECK(buffer_length == len + 6);
+    for (uint16_t pos = 4; pos + 32 <= 4 + len; pos += 32)
+    {
+        g_reported++;
+        if (buffer[pos + 14] == 0 && buffer[pos + 15] == 0 && strcmp((char *)&buffer[pos + 16], "?") == 0)
+            g_reported_other++;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    ezos_heap_site_t sites[EZOS_HEAP_TRACE_SITES];
+    void *ptrs[SITES];
+    uint32_t allocs = 0;
+    uint32_t live = 0;
+    uint16_t n;
+    int other = -1;
+
+    for (uint16_t i = 0; i < SITES; i++)
+    {
+        ptrs[i] = ezos_malloc_trace(16, __FILE__, (uint16_t)(100 + i));
+        TEST_CHECK(ptrs[i] != NULL);
+    }
+
+    n = ezos_heap_trace_get(sites, EZOS_HEAP_TRACE_SITES);
+    TEST_CHECK(n == EZOS_HEAP_TRACE_SITES);
+    for (uint16_t i = 0; i < n; i++)
+    {
+        TEST_CHECK(sites[i].file != NULL);
+        allocs += sites[i].allocs;
+        live += sites[i].live_bytes;
+        if (sites[i].line == 0)
+        {
+            TEST_CHECK(strcmp(sites[i].file, "?") == 0);
+            other = i;
+        }
+    }
+    TEST_CHECK(allocs == SITES);
+    TEST_CHECK(live == SITES * 16);
+    TEST_CHECK(other >= 0);
+    if (other >= 0)
+        TEST_CHECK(sites[other].allocs == SITES - (EZOS_HEAP_TRACE_SITES - 1));
+
+    ezos_heap_dump();
+
+    {
+        static general_protocol_t tabs[] = {{0x40, tlv_diag_heap}};
+        protocol_tlv_data_t cmd = {.tag = 0x40};
+        protocol_tlv_data_t rsp = {0};
+
+        general_htlvc_protocol_register(tabs, 1, report_cb);
+        TEST_CHECK(tlv_diag_heap(&cmd, &rsp) == 0);
+        TEST_CHECK(g_reported == EZOS_HEAP_TRACE_SITES);
+        TEST_CHECK(g_reported_other == 1);
+    }
+
+    for (uint16_t i = 0; i < SITES; i++)
+    {
+        ezos_free(ptrs[i]);
+    }
+    n = ezos_heap_trace_get(sites, EZOS_HEAP_TRACE_SITES);
+    live = 0;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        live += sites[i].live_bytes + sites[i].live_count;
+    }
+    TEST_CHECK(live == 0);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,152 @@
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * 异步日志：
+ *   满了以后丢弃新记录并计数，格式化截断时仍以\r\n结尾，0个和6个参数的宏，编译时过滤的级别不对参数求值
+ *   4个线程并发写、主线程读，每个线程的记录保持顺序，读到的 + 丢弃的 = 写入的
+ * 不创建日志任务，记录由ezos_log_read取出。
+ */
+
+#define WRITERS 4
+#define PER_WRITER 200000
+
+static int g_evaluated = 0;
+static uint32_t g_finished = 0;
+
+// 只出现在被编译掉的EZOS_LOGD中，不会被调用
+static __attribute__((unused)) int side_effect(void)
+{
+    g_evaluated++;
+    return 1;
+}
+
+static void drain(void)
+{
+    ezos_log_rec_t rec;
+
+    while (ezos_log_read(&rec) == EZOS_SUCCESS)
+    {
+    }
+}
+
+static void test_basic(void)
+{
+    ezos_log_stat_t st0, st;
+    ezos_log_rec_t rec;
+    char line[160];
+    char small[24];
+    uint32_t n;
+
+    drain();
+    ezos_log_stat_get(&st0);
+
+    EZOS_LOGI("test", "no args");
+    EZOS_LOGW("test", "%d %u %x %c %p %d", -5, 7u, 0xabu, 'z', (void *)0x10, 42);
+    EZOS_LOGD("test", "debug %d", side_effect());
+    TEST_CHECK(g_evaluated == 0);
+
+    TEST_CHECK(ezos_log_read(&rec) == EZOS_SUCCESS);
+    TEST_CHECK(rec.nargs == 0 && rec.level == EZOS_LOG_LEVEL_INFO && strcmp(rec.tag, "test") == 0);
+    TEST_CHECK(rec.time_ms <= ezos_time_us() / 1000 && rec.time_ms + 1000 > ezos_time_us() / 1000);
+    n = ezos_log_format(&rec, line, sizeof(line));
+    TEST_CHECK(n == strlen(line) && n >= 2 && strcmp(&line[n - 2], "\r\n") == 0);
+    TEST_CHECK(strstr(line, "I (") == line && strstr(line, " test: no args\r\n") != NULL);
+
+    TEST_CHECK(ezos_log_read(&rec) == EZOS_SUCCESS);
+    TEST_CHECK(rec.nargs == 6 && rec.level == EZOS_LOG_LEVEL_WARN);
+    ezos_log_format(&rec, line, sizeof(line));
+    TEST_CHECK(strstr(line, "W (") == line && strstr(line, ": -5 7 ab z 0x10 42\r\n") != NULL);
+
+    // 截断后仍以\r\n结尾，不越界
+    n = ezos_log_format(&rec, small, sizeof(small));
+    TEST_CHECK(n == strlen(small) && n < sizeof(small) && strcmp(&small[n - 2], "\r\n") == 0);
+    TEST_CHECK(ezos_log_read(&rec) == EZOS_FAILURE);
+
+    // 没有读者时写满，多出的丢弃
+    for (int i = 0; i < EZOS_LOG_SLOTS + 5; i++)
+    {
+        EZOS_LOGE("test", "fill %d", i);
+    }
+    ezos_log_stat_get(&st);
+    TEST_CHECK(st.written - st0.written == 2 + EZOS_LOG_SLOTS);
+    TEST_CHECK(st.dropped - st0.dropped == 5);
+    for (int i = 0; i < EZOS_LOG_SLOTS; i++)
+    {
+        TEST_CHECK(ezos_log_read(&rec) == EZOS_SUCCESS && rec.nargs == 1 && rec.args[0] == (uintptr_t)i);
+    }
+    TEST_CHECK(ezos_log_read(&rec) == EZOS_FAILURE);
+}
+
+static void *writer(void *arg)
+{
+    uintptr_t id = (uintptr_t)arg;
+
+    for (uint32_t i = 0; i < PER_WRITER; i++)
+    {
+        EZOS_LOGI("w", "%u %u", id, i);
+        if ((i & 63) == 0)
+            sched_yield();
+    }
+    __atomic_fetch_add(&g_finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    pthread_t threads[WRITERS];
+    uint32_t next[WRITERS] = {0};
+    uint32_t reads = 0, bad = 0;
+    ezos_log_stat_t st0, st;
+    ezos_log_rec_t rec;
+    int finished = 0;
+
+    ezos_log_stat_get(&st0);
+    for (uintptr_t k = 0; k < WRITERS; k++)
+    {
+        pthread_create(&threads[k], NULL, writer, (void *)k);
+    }
+
+    for (;;)
+    {
+        if (ezos_log_read(&rec) == EZOS_SUCCESS)
+        {
+            uintptr_t id = rec.args[0];
+            uint32_t i = (uint32_t)rec.args[1];
+
+            reads++;
+            // 丢弃会跳号，但不会倒退
+            if (id >= WRITERS || i < next[id])
+                bad++;
+            else
+                next[id] = i + 1;
+            continue;
+        }
+        // 写者全部结束后再取一遍剩下的
+        if (finished)
+            break;
+        finished = __atomic_load_n(&g_finished, __ATOMIC_ACQUIRE) == WRITERS;
+        sched_yield();
+    }
+    for (int k = 0; k < WRITERS; k++)
+    {
+        pthread_join(threads[k], NULL);
+    }
+
+    ezos_log_stat_get(&st);
+    printf("read %u, dropped %u\n", (unsigned)reads, (unsigned)(st.dropped - st0.dropped));
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(st.written - st0.written == reads);
+    TEST_CHECK(reads + (st.dropped - st0.dropped) == WRITERS * PER_WRITER);
+    TEST_CHECK(reads > 0);
+}
+
+int main(void)
+{
+    test_basic();
+    test_concurrent();
+    return TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+#include <string.h>
+#include <pthread.h>
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * 定长块内存池，打开EZOS_MEMPOOL_DEBUG编译：
+ *   统计：已分配、历史最大、池空失败次数，块大小按对齐向上取整
+ *   释放别的池的块、块中间的地址返回EZOS_EINVAL
+ *   写过块尾、写坏块头的保护字，释放返回EZOS_FAILURE并计入corrupts，重复释放计入double_frees，记下出错的块序号
+ *   4个线程并发分配释放，同一块不会同时分给两个线程，结束后全部归还
+ */
+
+#define BLOCK_SIZE 20
+#define BLOCK_COUNT 8
+#define THREADS 4
+#define ROUNDS 200000
+
+EZOS_MEMPOOL_STATIC_DEFINE(g_static, BLOCK_SIZE, BLOCK_COUNT);
+
+static ezos_mempool_id_t g_pool;
+static uint32_t g_bad = 0;
+
+static void test_stats(void)
+{
+    ezos_mempool_id_t pool = ezos_mempool_create(BLOCK_SIZE, BLOCK_COUNT);
+    ezos_mempool_stat_t st;
+    void *blocks[BLOCK_COUNT];
+
+    TEST_CHECK(pool != NULL);
+    TEST_CHECK(ezos_mempool_stat_get(pool, &st) == EZOS_SUCCESS);
+    TEST_CHECK(st.block_size == EZOS_MEMPOOL_ALIGN_UP(BLOCK_SIZE) && st.total == BLOCK_COUNT);
+    TEST_CHECK(st.used == 0 && st.used_max == 0 && st.fails == 0);
+    TEST_CHECK(st.double_frees == 0 && st.corrupts == 0 && st.bad_block == -1);
+
+    for (int i = 0; i < BLOCK_COUNT; i++)
+    {
+        blocks[i] = ezos_mempool_alloc(pool);
+        TEST_CHECK(blocks[i] != NULL && ((uintptr_t)blocks[i] & (EZOS_MEMPOOL_ALIGN - 1)) == 0);
+        memset(blocks[i], 0x55, BLOCK_SIZE);
+    }
+    TEST_CHECK(ezos_mempool_alloc(pool) == NULL);
+    TEST_CHECK(ezos_mempool_alloc(pool) == NULL);
+    ezos_mempool_stat_get(pool, &st);
+    TEST_CHECK(st.used == BLOCK_COUNT && st.used_max == BLOCK_COUNT && st.fails == 2);
+
+    for (int i = 0; i < BLOCK_COUNT / 2; i++)
+    {
+        TEST_CHECK(ezos_mempool_free(pool, blocks[i]) == EZOS_SUCCESS);
+    }
+    ezos_mempool_stat_get(pool, &st);
+    TEST_CHECK(st.used == BLOCK_COUNT / 2 && st.used_max == BLOCK_COUNT);
+    for (int i = BLOCK_COUNT / 2; i < BLOCK_COUNT; i++)
+    {
+        TEST_CHECK(ezos_mempool_free(pool, blocks[i]) == EZOS_SUCCESS);
+    }
+    ezos_mempool_stat_get(pool, &st);
+    TEST_CHECK(st.used == 0 && st.double_frees == 0 && st.corrupts == 0);
+
+    // 不是本池的块
+    blocks[0] = ezos_mempool_alloc(pool);
+    TEST_CHECK(ezos_mempool_free(pool, (uint8_t *)blocks[0] + 4) == EZOS_EINVAL);
+    TEST_CHECK(ezos_mempool_free(pool, &st) == EZOS_EINVAL);
+    TEST_CHECK(ezos_mempool_free(pool, NULL) == EZOS_EINVAL);
+    TEST_CHECK(ezos_mempool_free(pool, blocks[0]) == EZOS_SUCCESS);
+    ezos_mempool_destroy(pool);
+}
+
+static void test_debug(void)
+{
+    ezos_mempool_id_t pool = EZOS_MEMPOOL_CREATE_STATIC(g_static, BLOCK_SIZE, BLOCK_COUNT);
+    ezos_mempool_stat_t st;
+    uint8_t *a, *b, *c;
+
+    TEST_CHECK(pool != NULL);
+    a = ezos_mempool_alloc(pool);
+    b = ezos_mempool_alloc(pool);
+    c = ezos_mempool_alloc(pool);
+    TEST_CHECK(a != NULL && b != NULL && c != NULL);
+
+    // 重复释放：第二次失败，块只归还一次
+    TEST_CHECK(ezos_mempool_free(pool, a) == EZOS_SUCCESS);
+    TEST_CHECK(ezos_mempool_free(pool, a) == EZOS_FAILURE);
+    ezos_mempool_stat_get(pool, &st);
+    TEST_CHECK(st.double_frees == 1 && st.corrupts == 0 && st.bad_block == 0);
+    TEST_CHECK(st.used == 2);
+
+    // 写过块尾
+    memset(b, 0, EZOS_MEMPOOL_ALIGN_UP(BLOCK_SIZE) + 1);
+    TEST_CHECK(ezos_mempool_free(pool, b) == EZOS_FAILURE);
+    ezos_mempool_stat_get(pool, &st);
+    TEST_CHECK(st.double_frees == 1 && st.corrupts == 1 && st.bad_block == 1);
+
+    // 写坏块头(前一块向后越界或本块向前越界)
+    c[-1] = 0;
+    TEST_CHECK(ezos_mempool_free(pool, c) == EZOS_FAILURE);
+    ezos_mempool_stat_get(pool, &st);
+    TEST_CHECK(st.double_frees == 1 && st.corrupts == 2 && st.bad_block == 2);
+
+    // 出错的块不归还，其余块照常使用
+    TEST_CHECK(st.used == 2);
+    for (int i = 0; i < BLOCK_COUNT - 2; i++)
+    {
+        TEST_CHECK(ezos_mempool_alloc(pool) != NULL);
+    }
+    TEST_CHECK(ezos_mempool_alloc(pool) == NULL);
+}
+
+static void *worker(void *arg)
+{
+    uint32_t seed = (uint32_t)(uintptr_t)arg * 7919 + 1;
+    uint8_t *held[BLOCK_COUNT];
+    int n = 0;
+    uint8_t tag = (uint8_t)(uintptr_t)arg;
+
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        if (n < BLOCK_COUNT && (n == 0 || (test_rand(&seed) & 1)))
+        {
+            uint8_t *p = ezos_mempool_alloc(g_pool);
+
+            if (p == NULL)
+                continue;
+            memset(p, tag, BLOCK_SIZE);
+            held[n++] = p;
+        }
+        else
+        {
+            uint8_t *p = held[--n];
+
+            // 持有期间内容不被别的线程改写
+            for (int k = 0; k < BLOCK_SIZE; k++)
+            {
+                if (p[k] != tag)
+                {
+                    __atomic_fetch_add(&g_bad, 1, __ATOMIC_RELAXED);
+                    break;
+                }
+            }
+            if (ezos_mempool_free(g_pool, p) != EZOS_SUCCESS)
+                __atomic_fetch_add(&g_bad, 1, __ATOMIC_RELAXED);
+        }
+    }
+    while (n > 0)
+    {
+        if (ezos_mempool_free(g_pool, held[--n]) != EZOS_SUCCESS)
+            __atomic_fetch_add(&g_bad, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    pthread_t threads[THREADS];
+    ezos_mempool_stat_t st;
+
+    g_pool = ezos_mempool_create(BLOCK_SIZE, BLOCK_COUNT * 2);
+    TEST_CHECK(g_pool != NULL);
+    for (uintptr_t k = 0; k < THREADS; k++)
+    {
+        pthread_create(&threads[k], NULL, worker, (void *)(k + 1));
+    }
+    for (int k = 0; k < THREADS; k++)
+    {
+        pthread_join(threads[k], NULL);
+    }
+
+    ezos_mempool_stat_get(g_pool, &st);
+    printf("used_max %u, fails %u\n", (unsigned)st.used_max, (unsigned)st.fails);
+    TEST_CHECK(g_bad == 0);
+    TEST_CHECK(st.used == 0 && st.used_max <= BLOCK_COUNT * 2);
+    TEST_CHECK(st.double_frees == 0 && st.corrupts == 0);
+    ezos_mempool_destroy(g_pool);
+}
+
+int main(void)
+{
+    test_stats();
+    test_debug();
+    test_concurrent();
+    return TEST_RESULT();
+}
@@ -0,0 +1,209 @@
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+#include "ezos.h"
+#include "monitor.h"
+
+/*
+ * 顺序锁并发测试，主线程循环跑monitor_run_handler()：
+ *   writer_direct  直接写a/b/c三个轮询字段，外层write_begin/write_end，三者之间有固定关系
+ *   writer_setter  在写区间内用setter写d/e两个事件字段
+ *   churn          不停地增删同宽度的字段，让分组中的项被挪动，检查setter不会写到别的字段上
+ * 开始前检查按类型计算的分组容量，某一类满了返回失败，不影响其他类型。
+ * 每次handler中同一把锁的字段必须来自同一个快照，关系不成立就是读到了一半的写入。
+ * 写区间中间主动让出CPU，单核机器上也能让handler撞上正在进行的写入。
+ */
+
+#define RUN_MS 1000
+#define CHURN_MAGIC 0xA5A5A5A5u
+
+static uint32_t g_a, g_b;
+static uint64_t g_c;
+static int64_t g_d;
+static uint32_t g_e;
+static monitor_seqlock_t g_lock1 = MONITOR_SEQLOCK_INIT;
+static monitor_seqlock_t g_lock2 = MONITOR_SEQLOCK_INIT;
+static int g_id_d, g_id_e;
+static volatile int g_stop = 0;
+static uint32_t g_churn_bad = 0;
+static uint32_t g_churn_rounds = 0;
+
+// 每次handler中各字段最后一次回调的新值
+static struct
+{
+    uint8_t seen;
+    int64_t val;
+} g_cb[5];
+
+// 写区间外停一会儿再让出CPU，模拟真实的写者，不让handler每次都撞上写区间；
+// 单核机器上靠让出CPU让各线程交替运行
+static void pause_us(uint32_t us)
+{
+    uint64_t end = test_now_ns() + (uint64_t)us * 1000;
+
+    while (test_now_ns() < end)
+    {
+    }
+    sched_yield();
+}
+
+static void on_change(int64_t old_val, int64_t new_val, char *desc)
+{
+    int k = desc[0] - 'a';
+
+    (void)old_val;
+    if (k < 0 || k >= 5)
+        return;
+    g_cb[k].seen = 1;
+    g_cb[k].val = new_val;
+}
+
+static void *writer_direct(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 1; !g_stop; i++)
+    {
+        monitor_seqlock_write_begin(&g_lock1);
+        g_a = i;
+        sched_yield();
+        g_b = ~i;
+        g_c = ((uint64_t)i << 32) | i;
+        monitor_seqlock_write_end(&g_lock1);
+        pause_us(1);
+    }
+    return NULL;
+}
+
+static void *writer_setter(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 1; !g_stop; i++)
+    {
+        monitor_seqlock_write_begin(&g_lock2);
+        monitor_set_i64(g_id_d, -(int64_t)i);
+        sched_yield();
+        monitor_set_u32(g_id_e, i * 7);
+        monitor_seqlock_write_end(&g_lock2);
+        pause_us(5);
+    }
+    return NULL;
+}
+
+static void *churn(void *arg)
+{
+    static uint32_t dummy[4];
+
+    (void)arg;
+    while (!g_stop)
+    {
+        int ids[4];
+
+        for (int k = 0; k < 4; k++)
+        {
+            dummy[k] = CHURN_MAGIC;
+            ids[k] = monitor_val_add(&dummy[k], TYPE_U32, NULL, "x");
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            if (ids[k] >= 0)
+                monitor_val_remove(ids[k]);
+            if (dummy[k] != CHURN_MAGIC)
+                g_churn_bad++;
+        }
+        g_churn_rounds++;
+        pause_us(20);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t threads[3];
+    uint32_t rounds = 0, full1 = 0, full2 = 0;
+    uint64_t end;
+
+    TEST_CHECK(monitor_val_init(NULL) == 0);
+    TEST_CHECK(monitor_val_add(&g_a, TYPE_U32, on_change, "a") >= 0);
+    TEST_CHECK(monitor_val_add(&g_b, TYPE_U32, on_change, "b") >= 0);
+    TEST_CHECK(monitor_val_add(&g_c, TYPE_U64, on_change, "c") >= 0);
+    g_id_d = monitor_val_add_event(&g_d, TYPE_I64, on_change, "d");
+    g_id_e = monitor_val_add_event(&g_e, TYPE_U32, on_change, "e");
+    TEST_CHECK(g_id_d >= 0 && g_id_e >= 0);
+    for (int id = 0; id < 3; id++)
+    {
+        TEST_CHECK(monitor_val_set_seqlock(id, &g_lock1) == 0);
+    }
+    TEST_CHECK(monitor_val_set_seqlock(g_id_d, &g_lock2) == 0);
+    TEST_CHECK(monitor_val_set_seqlock(g_id_e, &g_lock2) == 0);
+
+    // 分组容量按类型单独计算，某一类满了其他类型仍可添加
+    {
+        static double dbl[MONITOR_MAX_NUM_DOUBLE + 1];
+        static uint8_t u8;
+        int ids[MONITOR_MAX_NUM_DOUBLE];
+        int id8;
+
+        for (int i = 0; i < MONITOR_MAX_NUM_DOUBLE; i++)
+        {
+            ids[i] = monitor_val_add_double(&dbl[i], 0.0, NULL, "dbl");
+            TEST_CHECK(ids[i] >= 0);
+        }
+        TEST_CHECK(monitor_val_add_double(&dbl[MONITOR_MAX_NUM_DOUBLE], 0.0, NULL, "dbl") < 0);
+        id8 = monitor_val_add(&u8, TYPE_U8, NULL, "u8");
+        TEST_CHECK(id8 >= 0);
+        TEST_CHECK(monitor_val_remove(id8) == 0);
+        for (int i = 0; i < MONITOR_MAX_NUM_DOUBLE; i++)
+        {
+            TEST_CHECK(monitor_val_remove(ids[i]) == 0);
+        }
+    }
+
+    pthread_create(&threads[0], NULL, writer_direct, NULL);
+    pthread_create(&threads[1], NULL, writer_setter, NULL);
+    pthread_create(&threads[2], NULL, churn, NULL);
+
+    end = test_now_ns() + (uint64_t)RUN_MS * 1000000;
+    while (test_now_ns() < end)
+    {
+        memset(g_cb, 0, sizeof(g_cb));
+        monitor_run_handler();
+        rounds++;
+        sched_yield();
+
+        if (g_cb[0].seen && g_cb[1].seen && g_cb[2].seen)
+        {
+            uint32_t a = (uint32_t)g_cb[0].val;
+
+            full1++;
+            TEST_CHECK((uint32_t)g_cb[1].val == ~a);
+            TEST_CHECK((uint64_t)g_cb[2].val == (((uint64_t)a << 32) | a));
+        }
+        // 只变了一部分说明快照跨了两次写入
+        TEST_CHECK((g_cb[0].seen + g_cb[1].seen + g_cb[2].seen) % 3 == 0);
+
+        if (g_cb[3].seen && g_cb[4].seen)
+        {
+            full2++;
+            TEST_CHECK((uint32_t)g_cb[4].val == (uint32_t)(-g_cb[3].val * 7));
+        }
+        TEST_CHECK(g_cb[3].seen == g_cb[4].seen);
+        if (g_test_fails > 20)
+            break;
+    }
+
+    g_stop = 1;
+    for (int k = 0; k < 3; k++)
+    {
+        pthread_join(threads[k], NULL);
+    }
+
+    printf("handler rounds %u, consistent snapshots: lock1 %u lock2 %u, churn rounds %u\n", (unsigned)rounds,
+           (unsigned)full1, (unsigned)full2, (unsigned)g_churn_rounds);
+    // 写者每轮都会改动，写者被抢占在写区间内时handler让出CPU等它写完，绝大多数轮次应能读到完整快照
+    TEST_CHECK(full1 * 4 >= rounds * 3 && full2 * 4 >= rounds * 3);
+    TEST_CHECK(g_churn_rounds > 0);
+    TEST_CHECK(g_churn_bad == 0);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,266 @@
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "test.h"
+#include "ezos.h"
+#include "ezos_sim.h"
+
+/*
+ * 仿真模式的可重复性：同一场景在两个子进程里各跑一遍，逐条比较事件记录(虚拟时间、来源、事件、值)。
+ *   场景：不同优先级的任务经队列、信号量、互斥锁、事件组交互，加上周期定时器和工作队列的延时作业，
+ *         带超时的等待既有等到的也有超时的
+ *   第二遍在每次记录时随机睡眠一小段真实时间，打乱主机线程调度，记录仍须完全相同
+ * 仿真只能在进程里开启一次，每遍用fork出的子进程，记录经管道交给父进程比较。
+ */
+
+#define TRACE_MAX 4096
+#define RUN_MS 1500
+#define PRIO EZ_DEFAULT_PRIORITY
+
+typedef struct
+{
+    uint32_t ms;
+    uint8_t who;
+    uint8_t what;
+    uint16_t val;
+} trace_rec_t;
+
+enum
+{
+    WHO_PRODUCER = 1,
+    WHO_CONSUMER,
+    WHO_WAITER,
+    WHO_TIMER,
+    WHO_WORK,
+};
+
+static trace_rec_t g_trace[TRACE_MAX];
+static uint32_t g_len = 0;
+static uint32_t g_jitter = 0; // 非0时为真实时间抖动的随机数种子
+
+static ezos_queue_id_t g_queue;
+static ezos_sem_id_t g_sem;
+static ezos_mutex_id_t g_mutex;
+static ezos_event_id_t g_event;
+static ezos_workqueue_id_t g_wq;
+static ezos_work_t g_work;
+static uint32_t g_shared = 0;
+
+// 仿真模式下同一时刻只有一个任务在运行，不用加锁
+static void trace(uint8_t who, uint8_t what, uint32_t val)
+{
+    if (g_jitter)
+        usleep(test_rand(&g_jitter) % 200);
+    if (g_len < TRACE_MAX)
+        g_trace[g_len] = (trace_rec_t){(uint32_t)ezos_sim_now_ms(), who, what, (uint16_t)val};
+    g_len++;
+}
+
+static void producer(void *arg)
+{
+    uint32_t seed = 7;
+
+    (void)arg;
+    for (uint32_t i = 0;; i++)
+    {
+        // 时快时慢：连续写时队列满，停顿时读端超时
+        if (i % 16 < 8)
+            ezos_delayms(test_rand(&seed) % 3);
+        else
+            ezos_delayms(test_rand(&seed) % 23 + 8);
+        trace(WHO_PRODUCER, 0, ezos_queue_write(g_queue, &i, sizeof(i), 5) == EZOS_SUCCESS);
+    }
+}
+
+static void consumer(void *arg)
+{
+    uint32_t seed = 11;
+    uint32_t msg;
+
+    (void)arg;
+    for (;;)
+    {
+        if (ezos_queue_read(g_queue, &msg, sizeof(msg), 20) != EZOS_SUCCESS)
+        {
+            trace(WHO_CONSUMER, 0, 0);
+            continue;
+        }
+        trace(WHO_CONSUMER, 1, msg);
+        ezos_mutex_lock(g_mutex);
+        g_shared++;
+        // 持锁时延时，工作作业要等锁
+        ezos_delayms(test_rand(&seed) % 8);
+        ezos_mutex_unlock(g_mutex);
+        if (msg % 5 == 0)
+            ezos_sem_give(g_sem);
+    }
+}
+
+static void waiter(void *arg)
+{
+    uint32_t bits;
+
+    (void)arg;
+    for (;;)
+    {
+        trace(WHO_WAITER, 0, ezos_sem_take(g_sem, 50) == EZOS_SUCCESS);
+        if (ezos_event_wait(g_event, 0x03, EZOS_EVENT_WAIT_ANY | EZOS_EVENT_CLEAR, &bits, 2) == EZOS_SUCCESS)
+            trace(WHO_WAITER, 1, bits);
+        else
+            trace(WHO_WAITER, 2, 0);
+    }
+}
+
+static void timer_cb(void *arg)
+{
+    (void)arg;
+    trace(WHO_TIMER, 0, 0);
+    ezos_event_set(g_event, 0x01);
+}
+
+static void work_func(void *arg)
+{
+    static uint32_t seed = 13;
+
+    (void)arg;
+    ezos_mutex_lock(g_mutex);
+    trace(WHO_WORK, 0, g_shared);
+    ezos_mutex_unlock(g_mutex);
+    ezos_event_set(g_event, 0x02);
+    ezos_work_submit_delayed(g_wq, &g_work, test_rand(&seed) % 31 + 1);
+}
+
+static void start_task(char *name, ezos_thread_func_cb func, uint16_t priority)
+{
+    ezos_thread_params_t param = {
+        .thread_name = name,
+        .priority = priority,
+        .stack_size = 2048,
+    };
+
+    if (ezos_thread_create(func, &param) == NULL)
+        abort();
+}
+
+// 子进程中运行场景，把记录写到fd
+static void run_child(int fd, uint32_t jitter)
+{
+    ezos_timer_id_t timer;
+    const uint8_t *p = (const uint8_t *)g_trace;
+    size_t left;
+
+    g_jitter = jitter;
+    ezos_sim_enable();
+    g_queue = ezos_queue_create(2, sizeof(uint32_t));
+    g_sem = ezos_sem_create(2, 0);
+    g_mutex = ezos_mutex_create();
+    g_event = ezos_event_create();
+    g_wq = ezos_workqueue_create("sim", 2, PRIO - 3, 2048);
+    timer = ezos_timer_create(timer_cb, NULL, 1);
+    if (g_queue == NULL || g_sem == NULL || g_mutex == NULL || g_event == NULL || g_wq == NULL || timer == NULL)
+        _exit(2);
+
+    start_task("producer", producer, PRIO - 1);
+    start_task("consumer", consumer, PRIO - 2);
+    start_task("waiter", waiter, PRIO - 1);
+    ezos_timer_start(timer, 7);
+    ezos_work_init(&g_work, work_func, NULL, EZOS_WORK_PRIO_NORMAL);
+    ezos_work_submit_delayed(g_wq, &g_work, 3);
+
+    // 主任务优先级最高，醒来时其他任务都停在阻塞点上，记录不再变化
+    ezos_delayms(RUN_MS);
+    if (g_len > TRACE_MAX)
+        _exit(3);
+    left = g_len * sizeof(trace_rec_t);
+    while (left > 0)
+    {
+        ssize_t n = write(fd, p, left);
+
+        if (n <= 0)
+            _exit(4);
+        p += n;
+        left -= n;
+    }
+    _exit(0);
+}
+
+// 跑一遍场景，返回记录条数，失败返回-1
+static int run(trace_rec_t *out, uint32_t jitter)
+{
+    int fds[2];
+    size_t got = 0;
+    int status;
+    pid_t pid;
+
+    if (pipe(fds) != 0)
+        return -1;
+    pid = fork();
+    if (pid < 0)
+        return -1;
+    if (pid == 0)
+    {
+        close(fds[0]);
+        run_child(fds[1], jitter);
+    }
+
+    close(fds[1]);
+    for (;;)
+    {
+        ssize_t n = read(fds[0], (uint8_t *)out + got, TRACE_MAX * sizeof(trace_rec_t) - got);
+
+        if (n <= 0)
+            break;
+        got += n;
+    }
+    close(fds[0]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return -1;
+    return (int)(got / sizeof(trace_rec_t));
+}
+
+static uint32_t count(const trace_rec_t *t, int n, uint8_t who, uint8_t what, int val)
+{
+    uint32_t c = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (t[i].who == who && t[i].what == what && (val < 0 || t[i].val == val))
+            c++;
+    }
+    return c;
+}
+
+int main(void)
+{
+    static trace_rec_t a[TRACE_MAX], b[TRACE_MAX];
+    int na, nb;
+    int first = -1;
+
+    na = run(a, 0);
+    nb = run(b, (uint32_t)getpid() | 1);
+    printf("trace %d / %d records\n", na, nb);
+    TEST_CHECK(na > 0 && na == nb);
+    if (na <= 0 || na != nb)
+        return TEST_RESULT();
+
+    for (int i = 0; i < na && first < 0; i++)
+    {
+        if (memcmp(&a[i], &b[i], sizeof(a[i])) != 0)
+            first = i;
+    }
+    if (first >= 0)
+        printf("first difference at %d: %u ms %u/%u/%u vs %u ms %u/%u/%u\n", first, (unsigned)a[first].ms,
+               a[first].who, a[first].what, a[first].val, (unsigned)b[first].ms, b[first].who, b[first].what,
+               b[first].val);
+    TEST_CHECK(first < 0);
+
+    // 场景确实覆盖了各种分支：写满超时、读空超时、信号量等到和超时、事件等到和超时
+    TEST_CHECK(count(a, na, WHO_PRODUCER, 0, 1) > 0 && count(a, na, WHO_PRODUCER, 0, 0) > 0);
+    TEST_CHECK(count(a, na, WHO_CONSUMER, 1, -1) > 0 && count(a, na, WHO_CONSUMER, 0, -1) > 0);
+    TEST_CHECK(count(a, na, WHO_WAITER, 0, 1) > 0 && count(a, na, WHO_WAITER, 0, 0) > 0);
+    TEST_CHECK(count(a, na, WHO_WAITER, 1, -1) > 0 && count(a, na, WHO_WAITER, 2, -1) > 0);
+    TEST_CHECK(count(a, na, WHO_TIMER, 0, -1) >= RUN_MS / 7 - 1 && count(a, na, WHO_WORK, 0, -1) > 0);
+    TEST_CHECK(a[na - 1].ms <= RUN_MS);
+    return TEST_RESULT();
+}
@@ -0,0 +1,271 @@
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+#include "spsc_ringbuf.h"
+
+/*
+ * 生产者和消费者各一个线程：
+ *   字节流  生产者交替用write和reserve/commit写入一个确定的字节序列，长度随机，
+ *           消费者交替用read和peek/release读出并逐字节比对
+ *   消息    消息长度和内容由序号决定，生产者交替用send和reserve/commit，
+ *           消费者交替用recv和peek/release，检查长度、内容和顺序，覆盖回绕时的填充
+ * 缓冲区取得很小，让满、空和回绕都频繁出现。
+ * 另外单线程检查最大消息长度：空缓冲区的任何写位置上都能预留，超过的一律拒绝。
+ */
+
+#define STREAM_BYTES (8u << 20)
+#define MSG_COUNT 200000u
+#define MSG_MAX 200u
+
+static uint8_t g_stream_buf[256];
+static spsc_ringbuf_t g_rb;
+static uint8_t g_msg_buf[1024] __attribute__((aligned(4)));
+static spsc_msgbuf_t g_mb;
+
+static uint8_t stream_byte(uint32_t pos)
+{
+    return (uint8_t)(pos * 31 + (pos >> 8));
+}
+
+static uint32_t msg_len(uint32_t seq)
+{
+    return (seq * 2654435761u >> 7) % (MSG_MAX + 1);
+}
+
+static uint8_t msg_byte(uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq + i * 7);
+}
+
+static void *stream_producer(void *arg)
+{
+    uint32_t seed = 5;
+    uint32_t pos = 0;
+
+    (void)arg;
+    while (pos < STREAM_BYTES)
+    {
+        uint32_t r = test_rand(&seed);
+        uint32_t want = r % 100 + 1;
+        uint32_t done = 0;
+
+        if (want > STREAM_BYTES - pos)
+            want = STREAM_BYTES - pos;
+
+        if (r & 0x10000)
+        {
+            uint8_t tmp[100];
+
+            for (uint32_t i = 0; i < want; i++)
+            {
+                tmp[i] = stream_byte(pos + i);
+            }
+            done = spsc_ringbuf_write(&g_rb, tmp, want);
+        }
+        else
+        {
+            uint32_t len = 0;
+            uint8_t *p = spsc_ringbuf_reserve(&g_rb, &len);
+
+            if (p != NULL)
+            {
+                done = len < want ? len : want;
+                for (uint32_t i = 0; i < done; i++)
+                {
+                    p[i] = stream_byte(pos + i);
+                }
+                spsc_ringbuf_commit(&g_rb, done);
+            }
+        }
+        pos += done;
+        if (done == 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void test_stream(void)
+{
+    pthread_t producer;
+    uint32_t seed = 9;
+    uint32_t pos = 0;
+    uint32_t bad = 0;
+
+    TEST_CHECK(spsc_ringbuf_init(&g_rb, g_stream_buf, 100) != 0);
+    TEST_CHECK(spsc_ringbuf_init(&g_rb, g_stream_buf, sizeof(g_stream_buf)) == 0);
+    pthread_create(&producer, NULL, stream_producer, NULL);
+
+    while (pos < STREAM_BYTES && bad == 0)
+    {
+        uint32_t r = test_rand(&seed);
+        uint32_t done = 0;
+
+        if (r & 1)
+        {
+            uint8_t tmp[128];
+
+            done = spsc_ringbuf_read(&g_rb, tmp, r % sizeof(tmp) + 1);
+            for (uint32_t i = 0; i < done; i++)
+            {
+                bad += tmp[i] != stream_byte(pos + i);
+            }
+        }
+        else
+        {
+            uint32_t len = 0;
+            const uint8_t *p = spsc_ringbuf_peek(&g_rb, &len);
+
+            if (p != NULL)
+            {
+                done = len < r % 64 + 1 ? len : r % 64 + 1;
+                for (uint32_t i = 0; i < done; i++)
+                {
+                    bad += p[i] != stream_byte(pos + i);
+                }
+                spsc_ringbuf_release(&g_rb, done);
+            }
+        }
+        TEST_CHECK(spsc_ringbuf_used(&g_rb) + spsc_ringbuf_free(&g_rb) == sizeof(g_stream_buf));
+        pos += done;
+        if (done == 0)
+            sched_yield();
+    }
+
+    pthread_join(producer, NULL);
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(pos == STREAM_BYTES);
+    TEST_CHECK(spsc_ringbuf_used(&g_rb) == 0);
+}
+
+static void *msg_producer(void *arg)
+{
+    uint8_t tmp[MSG_MAX];
+    uint32_t seq = 0;
+
+    (void)arg;
+    while (seq < MSG_COUNT)
+    {
+        uint32_t len = msg_len(seq);
+        int ok = 0;
+
+        if (seq & 1)
+        {
+            for (uint32_t i = 0; i < len; i++)
+            {
+                tmp[i] = msg_byte(seq, i);
+            }
+            ok = spsc_msgbuf_send(&g_mb, tmp, len) == 0;
+        }
+        else
+        {
+            // 预留最大长度，提交实际长度
+            uint8_t *p = spsc_msgbuf_reserve(&g_mb, MSG_MAX);
+
+            if (p != NULL)
+            {
+                for (uint32_t i = 0; i < len; i++)
+                {
+                    p[i] = msg_byte(seq, i);
+                }
+                spsc_msgbuf_commit(&g_mb, len);
+                ok = 1;
+            }
+        }
+        if (ok)
+            seq++;
+        else
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void test_msg(void)
+{
+    pthread_t producer;
+    uint32_t seq = 0;
+    uint32_t bad = 0;
+
+    TEST_CHECK(spsc_msgbuf_init(&g_mb, g_msg_buf, sizeof(g_msg_buf)) == 0);
+    TEST_CHECK(spsc_msgbuf_reserve(&g_mb, sizeof(g_msg_buf)) == NULL);
+    pthread_create(&producer, NULL, msg_producer, NULL);
+
+    while (seq < MSG_COUNT && bad == 0)
+    {
+        uint32_t len = 0;
+
+        if (seq & 2)
+        {
+            uint8_t tmp[MSG_MAX];
+            int n = spsc_msgbuf_recv(&g_mb, tmp, sizeof(tmp));
+
+            if (n < 0)
+            {
+                sched_yield();
+                continue;
+            }
+            bad += (uint32_t)n != msg_len(seq);
+            for (int i = 0; i < n; i++)
+            {
+                bad += tmp[i] != msg_byte(seq, (uint32_t)i);
+            }
+        }
+        else
+        {
+            const uint8_t *p = spsc_msgbuf_peek(&g_mb, &len);
+
+            if (p == NULL)
+            {
+                sched_yield();
+                continue;
+            }
+            TEST_CHECK(((uintptr_t)p & 3) == 0);
+            bad += len != msg_len(seq);
+            for (uint32_t i = 0; i < len; i++)
+            {
+                bad += p[i] != msg_byte(seq, i);
+            }
+            spsc_msgbuf_release(&g_mb);
+        }
+        seq++;
+    }
+
+    pthread_join(producer, NULL);
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(seq == MSG_COUNT);
+    TEST_CHECK(spsc_msgbuf_recv(&g_mb, NULL, 0) == -1);
+}
+
+static void test_msg_limit(void)
+{
+    static uint8_t buf[64] __attribute__((aligned(4)));
+    spsc_msgbuf_t mb;
+    uint8_t tmp[64];
+
+    TEST_CHECK(spsc_msgbuf_init(&mb, buf, sizeof(buf)) == 0);
+    // 写位置逐个4字节地挪过整个缓冲区
+    for (int k = 0; k < 32; k++)
+    {
+        uint8_t *p;
+
+        TEST_CHECK(spsc_msgbuf_reserve(&mb, SPSC_MSGBUF_MAX_LEN(sizeof(buf)) + 1) == NULL);
+        p = spsc_msgbuf_reserve(&mb, SPSC_MSGBUF_MAX_LEN(sizeof(buf)));
+        TEST_CHECK(p != NULL);
+        if (p == NULL)
+            return;
+        memset(p, k, SPSC_MSGBUF_MAX_LEN(sizeof(buf)));
+        spsc_msgbuf_commit(&mb, SPSC_MSGBUF_MAX_LEN(sizeof(buf)));
+        TEST_CHECK(spsc_msgbuf_recv(&mb, tmp, sizeof(tmp)) == SPSC_MSGBUF_MAX_LEN(sizeof(buf)) && tmp[0] == k);
+
+        TEST_CHECK(spsc_msgbuf_send(&mb, tmp, 0) == 0);
+        TEST_CHECK(spsc_msgbuf_recv(&mb, tmp, sizeof(tmp)) == 0);
+    }
+}
+
+int main(void)
+{
+    test_stream();
+    test_msg();
+    test_msg_limit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,230 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+
+/*
+ * 流缓冲区和消息缓冲区的阻塞式读写，写端是ezos任务，读端是主线程：
+ *   流    写端交替用send和reserve/commit写入确定的字节序列，读端交替用recv和peek/release逐字节比对
+ *   消息  长度和内容由序号决定，覆盖0长度和回绕，读端检查长度、内容和顺序
+ * 缓冲区取得很小，两端都会频繁阻塞在满和空上。
+ */
+
+#define STREAM_BYTES (2u << 20)
+#define MSG_COUNT 200000u
+#define MSG_MAX 120u
+
+static ezos_streambuf_id_t g_sb;
+static ezos_msgbuf_id_t g_mb;
+static ezos_sem_id_t g_done;
+
+static uint8_t stream_byte(uint32_t pos)
+{
+    return (uint8_t)(pos * 13 + (pos >> 9));
+}
+
+static uint32_t msg_len(uint32_t seq)
+{
+    return (seq * 2654435761u >> 9) % (MSG_MAX + 1);
+}
+
+static uint8_t msg_byte(uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq ^ (i * 5));
+}
+
+static void stream_producer(void *arg)
+{
+    uint32_t seed = 21;
+    uint32_t pos = 0;
+
+    (void)arg;
+    while (pos < STREAM_BYTES)
+    {
+        uint32_t r = test_rand(&seed);
+        uint32_t want = r % 200 + 1;
+
+        if (want > STREAM_BYTES - pos)
+            want = STREAM_BYTES - pos;
+
+        if (r & 0x10000)
+        {
+            uint8_t tmp[200];
+
+            for (uint32_t i = 0; i < want; i++)
+            {
+                tmp[i] = stream_byte(pos + i);
+            }
+            TEST_CHECK(ezos_streambuf_send(g_sb, tmp, want, EZOS_DELAY_FOREVER) == want);
+            pos += want;
+        }
+        else
+        {
+            uint32_t len = want;
+            uint8_t *p = ezos_streambuf_reserve(g_sb, &len, EZOS_DELAY_FOREVER);
+
+            TEST_CHECK(p != NULL && len > 0 && len <= want);
+            if (p == NULL)
+                break;
+            // 借出的部分只用一部分，剩下的归还
+            if (len > 1 && (r & 0x20000))
+                len--;
+            for (uint32_t i = 0; i < len; i++)
+            {
+                p[i] = stream_byte(pos + i);
+            }
+            TEST_CHECK(ezos_streambuf_commit(g_sb, len) == EZOS_SUCCESS);
+            pos += len;
+        }
+    }
+    ezos_sem_give(g_done);
+}
+
+static void test_stream(void)
+{
+    ezos_thread_params_t param = {.thread_name = "sb_producer", .priority = EZ_DEFAULT_PRIORITY, .stack_size = 4096};
+    uint32_t seed = 23;
+    uint32_t pos = 0;
+    uint32_t bad = 0;
+
+    g_sb = ezos_streambuf_create(300, 16);
+    TEST_CHECK(g_sb != NULL);
+    if (g_sb == NULL)
+        return;
+    TEST_CHECK(ezos_thread_create(stream_producer, &param) != NULL);
+
+    while (pos < STREAM_BYTES && bad == 0)
+    {
+        uint32_t r = test_rand(&seed);
+        uint32_t done = 0;
+
+        if (r & 1)
+        {
+            uint8_t tmp[256];
+
+            done = ezos_streambuf_recv(g_sb, tmp, r % sizeof(tmp) + 1, 1000);
+            for (uint32_t i = 0; i < done; i++)
+            {
+                bad += tmp[i] != stream_byte(pos + i);
+            }
+        }
+        else
+        {
+            uint32_t len = 0;
+            const uint8_t *p = ezos_streambuf_peek(g_sb, &len, 1000);
+
+            if (p != NULL)
+            {
+                done = len < r % 100 + 1 ? len : r % 100 + 1;
+                for (uint32_t i = 0; i < done; i++)
+                {
+                    bad += p[i] != stream_byte(pos + i);
+                }
+                TEST_CHECK(ezos_streambuf_release(g_sb, done) == EZOS_SUCCESS);
+            }
+        }
+        // 写端会一直写到最后，读不到数据只能是卡住了
+        TEST_CHECK(done > 0);
+        if (done == 0)
+            break;
+        pos += done;
+    }
+
+    TEST_CHECK(ezos_sem_take(g_done, 5000) == EZOS_SUCCESS);
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(pos == STREAM_BYTES);
+    TEST_CHECK(ezos_streambuf_bytes_get(g_sb) == 0);
+    ezos_streambuf_destroy(g_sb);
+}
+
+static void msg_producer(void *arg)
+{
+    uint8_t tmp[MSG_MAX];
+
+    (void)arg;
+    for (uint32_t seq = 0; seq < MSG_COUNT; seq++)
+    {
+        uint32_t len = msg_len(seq);
+
+        if (seq & 1)
+        {
+            for (uint32_t i = 0; i < len; i++)
+            {
+                tmp[i] = msg_byte(seq, i);
+            }
+            TEST_CHECK(ezos_msgbuf_send(g_mb, tmp, len, EZOS_DELAY_FOREVER) == EZOS_SUCCESS);
+        }
+        else
+        {
+            uint8_t *p = ezos_msgbuf_reserve(g_mb, MSG_MAX, EZOS_DELAY_FOREVER);
+
+            TEST_CHECK(p != NULL);
+            if (p == NULL)
+                break;
+            for (uint32_t i = 0; i < len; i++)
+            {
+                p[i] = msg_byte(seq, i);
+            }
+            TEST_CHECK(ezos_msgbuf_commit(g_mb, len) == EZOS_SUCCESS);
+        }
+    }
+    ezos_sem_give(g_done);
+}
+
+static void test_msg(void)
+{
+    ezos_thread_params_t param = {.thread_name = "mb_producer", .priority = EZ_DEFAULT_PRIORITY, .stack_size = 4096};
+    uint32_t bad = 0;
+    uint32_t seq;
+
+    g_mb = ezos_msgbuf_create(EZOS_MSGBUF_BUF_SIZE(MSG_MAX, 4));
+    TEST_CHECK(g_mb != NULL);
+    if (g_mb == NULL)
+        return;
+    TEST_CHECK(ezos_msgbuf_reserve(g_mb, EZOS_MSGBUF_BUF_SIZE(MSG_MAX, 4), 0) == NULL);
+    TEST_CHECK(ezos_thread_create(msg_producer, &param) != NULL);
+
+    for (seq = 0; seq < MSG_COUNT && bad == 0; seq++)
+    {
+        if (seq & 2)
+        {
+            uint8_t tmp[MSG_MAX];
+            uint32_t n = ezos_msgbuf_recv(g_mb, tmp, sizeof(tmp), 1000);
+
+            bad += n != msg_len(seq);
+            for (uint32_t i = 0; i < n; i++)
+            {
+                bad += tmp[i] != msg_byte(seq, i);
+            }
+        }
+        else
+        {
+            uint32_t len = 0;
+            const uint8_t *p = ezos_msgbuf_peek(g_mb, &len, 1000);
+
+            TEST_CHECK(p != NULL);
+            if (p == NULL)
+                break;
+            TEST_CHECK(((uintptr_t)p & (EZOS_MSGBUF_ALIGN - 1)) == 0);
+            bad += len != msg_len(seq);
+            for (uint32_t i = 0; i < len; i++)
+            {
+                bad += p[i] != msg_byte(seq, i);
+            }
+            TEST_CHECK(ezos_msgbuf_release(g_mb) == EZOS_SUCCESS);
+        }
+    }
+
+    TEST_CHECK(ezos_sem_take(g_done, 5000) == EZOS_SUCCESS);
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(seq == MSG_COUNT);
+    TEST_CHECK(ezos_msgbuf_count_get(g_mb) == 0);
+    ezos_msgbuf_destroy(g_mb);
+}
+
+int main(void)
+{
+    g_done = ezos_sem_create(1, 0);
+    test_stream();
+    test_msg();
+    return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+#include "ezos_sim.h"
+
+/*
+ * 仿真模式下随机启动、重启、停止一批定时器，虚拟时钟推进，检查：
+ *   每次到期的时刻落在预期tick内：启动时刻加定时时间后向上取整到tick，不会早于启动时刻加定时时间
+ *   周期定时器按周期连续到期，回调中停止自己后不再到期
+ *   停止后的定时器不再回调，最后所有单次定时器都到期
+ * 定时时间覆盖时间轮的前3级，级联路径都会走到。
+ */
+
+#define TIMERS 200
+#define OPS 20000
+#define TICK EZOS_TWHEEL_TICK_MS
+
+typedef struct
+{
+    ezos_wtimer_t timer;
+    uint8_t active;
+    uint8_t stop_in_cb; // 周期定时器在下次回调中停止自己
+    uint64_t expect;    // 预期到期的tick起点，单位ms
+    uint64_t earliest;  // 最早允许到期的时刻，单位ms
+    uint32_t period;    // 取整后的周期，单位ms，0为单次
+    uint32_t fired;
+} tm_t;
+
+static tm_t g_tm[TIMERS];
+static uint32_t g_fires = 0;
+static uint32_t g_bad = 0;
+
+static uint32_t round_up(uint32_t ms)
+{
+    return (ms + TICK - 1) / TICK * TICK;
+}
+
+static uint64_t round_up64(uint64_t ms)
+{
+    return (ms + TICK - 1) / TICK * TICK;
+}
+
+static void tm_cb(void *arg)
+{
+    tm_t *t = (tm_t *)arg;
+    uint64_t now = ezos_sim_now_ms();
+
+    g_fires++;
+    t->fired++;
+    if (!t->active || now < t->earliest || now < t->expect || now >= t->expect + TICK)
+    {
+        if (g_bad++ < 10)
+            printf("timer %d: active %u now %llu expect %llu\n", (int)(t - g_tm), t->active, (unsigned long long)now,
+                   (unsigned long long)t->expect);
+        return;
+    }
+
+    if (t->period == 0)
+    {
+        t->active = 0;
+    }
+    else if (t->stop_in_cb)
+    {
+        ezos_wtimer_stop(&t->timer);
+        t->active = 0;
+    }
+    else
+    {
+        t->expect += t->period;
+        t->earliest += t->period;
+    }
+}
+
+static void tm_start(tm_t *t, uint32_t ms, uint32_t period_ms, uint8_t stop_in_cb)
+{
+    uint64_t now = ezos_sim_now_ms();
+
+    t->active = 1;
+    t->stop_in_cb = stop_in_cb;
+    t->expect = round_up64(now + ms);
+    t->earliest = now + ms;
+    t->period = round_up(period_ms);
+    TEST_CHECK(ezos_wtimer_start(&t->timer, ms, period_ms) == EZOS_SUCCESS);
+}
+
+// 大多数是短超时，少数跨过第1、2级
+static uint32_t rand_delay(uint32_t *seed)
+{
+    uint32_t r = test_rand(seed);
+
+    switch (r & 7)
+    {
+    case 0:
+        return r % (20 * 60 * 1000) + 1;
+    case 1:
+    case 2:
+        return r % 60000 + 1;
+    default:
+        return r % 600 + 1;
+    }
+}
+
+int main(void)
+{
+    uint32_t seed = 1234;
+    uint32_t active = 0;
+
+    ezos_sim_enable();
+    TEST_CHECK(ezos_twheel_init() == EZOS_SUCCESS);
+    for (int i = 0; i < TIMERS; i++)
+    {
+        ezos_wtimer_init(&g_tm[i].timer, tm_cb, &g_tm[i]);
+    }
+
+    for (int op = 0; op < OPS; op++)
+    {
+        uint32_t r = test_rand(&seed);
+        tm_t *t = &g_tm[r % TIMERS];
+
+        switch ((r >> 16) % 8)
+        {
+        case 0:
+            ezos_wtimer_stop(&t->timer);
+            t->active = 0;
+            break;
+        case 1:
+            // 周期定时器，一部分在回调中停止自己
+            tm_start(t, rand_delay(&seed), test_rand(&seed) % 300 + 1, (r >> 24) & 1);
+            break;
+        default:
+            tm_start(t, rand_delay(&seed), 0, 0);
+            break;
+        }
+        TEST_CHECK(ezos_wtimer_is_active(&t->timer) == t->active);
+        ezos_delayms(test_rand(&seed) % 50);
+    }
+
+    // 停掉还在跑的周期定时器，单次定时器等它们全部到期
+    for (int i = 0; i < TIMERS; i++)
+    {
+        if (g_tm[i].active && g_tm[i].period != 0)
+        {
+            ezos_wtimer_stop(&g_tm[i].timer);
+            g_tm[i].active = 0;
+        }
+    }
+    ezos_delayms(20 * 60 * 1000 + 2 * TICK);
+    for (int i = 0; i < TIMERS; i++)
+    {
+        active += g_tm[i].active;
+        TEST_CHECK(!ezos_wtimer_is_active(&g_tm[i].timer));
+    }
+
+    printf("fires %u, virtual time %llu s\n", (unsigned)g_fires, (unsigned long long)(ezos_sim_now_ms() / 1000));
+    TEST_CHECK(g_bad == 0);
+    TEST_CHECK(active == 0);
+    TEST_CHECK(g_fires > OPS / 2);
+    return TEST_RESULT();
+}
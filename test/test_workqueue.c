@@ -0,0 +1,240 @@
+#include <string.h>
+#include "test.h"
+#include "ezos.h"
+#include "ezos_sim.h"
+
+/*
+ * 仿真模式下的工作队列行为：
+ *   优先级分道和道内先进先出、重复提交合并、执行中再提交会在执行完后再执行一次、
+ *   取消排队中和延时中的作业、延时提交和重新设置延时
+ * 最后4个工作任务随机压测，作业中会阻塞，检查同一作业不会并发执行、提交过的作业最终都执行。
+ * 工作任务优先级低于主任务，主任务延时时它们才运行，先后顺序可以确定。
+ */
+
+#define WQ_PRIORITY (EZ_DEFAULT_PRIORITY - 2)
+#define TICK EZOS_TWHEEL_TICK_MS
+
+typedef struct
+{
+    ezos_work_t work;
+    int id;
+    uint32_t runs;
+    uint8_t running;
+    uint8_t need;       // 提交后还没开始执行
+    uint32_t block_ms;  // 作业中阻塞的时间
+    uint8_t resubmit;   // 执行时再提交自己的次数
+    uint64_t last_run;  // 最近一次开始执行的虚拟时间
+} job_t;
+
+static ezos_workqueue_id_t g_wq;
+static int g_order[16];
+static int g_order_len = 0;
+static uint32_t g_overlap = 0;
+
+static void job_func(void *arg)
+{
+    job_t *job = arg;
+
+    if (job->running)
+        g_overlap++;
+    job->running = 1;
+    job->need = 0;
+    job->runs++;
+    job->last_run = ezos_sim_now_ms();
+    if (g_order_len < 16)
+        g_order[g_order_len++] = job->id;
+    if (job->resubmit > 0)
+    {
+        job->resubmit--;
+        ezos_work_submit(job->work.wq, &job->work);
+    }
+    if (job->block_ms)
+        ezos_delayms(job->block_ms);
+    job->running = 0;
+}
+
+static void job_init(job_t *job, int id, ezos_work_prio_t prio)
+{
+    memset(job, 0, sizeof(*job));
+    job->id = id;
+    ezos_work_init(&job->work, job_func, job, prio);
+}
+
+static void test_order(void)
+{
+    static const ezos_work_prio_t prios[] = {EZOS_WORK_PRIO_LOW,  EZOS_WORK_PRIO_NORMAL, EZOS_WORK_PRIO_HIGH,
+                                             EZOS_WORK_PRIO_NORMAL, EZOS_WORK_PRIO_HIGH, EZOS_WORK_PRIO_LOW};
+    static const int expect[] = {2, 4, 1, 3, 0, 5};
+    job_t jobs[6];
+
+    g_order_len = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        job_init(&jobs[i], i, prios[i]);
+        TEST_CHECK(ezos_work_submit(g_wq, &jobs[i].work) == EZOS_SUCCESS);
+    }
+    // 重复提交不增加执行次数
+    TEST_CHECK(ezos_work_submit(g_wq, &jobs[0].work) == EZOS_SUCCESS);
+    TEST_CHECK(ezos_work_submit(g_wq, &jobs[2].work) == EZOS_SUCCESS);
+    TEST_CHECK(ezos_work_is_pending(&jobs[0].work));
+
+    ezos_delayms(1);
+    TEST_CHECK(g_order_len == 6);
+    TEST_CHECK(memcmp(g_order, expect, sizeof(expect)) == 0);
+    for (int i = 0; i < 6; i++)
+    {
+        TEST_CHECK(jobs[i].runs == 1);
+        TEST_CHECK(!ezos_work_is_pending(&jobs[i].work));
+    }
+}
+
+static void test_resubmit_running(void)
+{
+    job_t job;
+
+    // 执行中提交自己两次，合并为执行完后再执行一次
+    job_init(&job, 0, EZOS_WORK_PRIO_NORMAL);
+    job.resubmit = 1;
+    job.block_ms = 5;
+    ezos_work_submit(g_wq, &job.work);
+    ezos_delayms(1);
+    TEST_CHECK(job.running && job.runs == 1);
+    ezos_work_submit(g_wq, &job.work);
+    ezos_work_submit(g_wq, &job.work);
+    ezos_delayms(20);
+    TEST_CHECK(job.runs == 2);
+    TEST_CHECK(g_overlap == 0);
+    TEST_CHECK(!ezos_work_is_pending(&job.work));
+}
+
+static void test_cancel(void)
+{
+    job_t queued, delayed, running;
+
+    job_init(&queued, 0, EZOS_WORK_PRIO_NORMAL);
+    job_init(&delayed, 1, EZOS_WORK_PRIO_NORMAL);
+    job_init(&running, 2, EZOS_WORK_PRIO_NORMAL);
+    running.block_ms = 5;
+
+    ezos_work_submit(g_wq, &queued.work);
+    ezos_work_submit_delayed(g_wq, &delayed.work, 50);
+    TEST_CHECK(ezos_work_is_pending(&delayed.work));
+    TEST_CHECK(ezos_work_cancel(&queued.work) == EZOS_SUCCESS);
+    TEST_CHECK(ezos_work_cancel(&delayed.work) == EZOS_SUCCESS);
+    TEST_CHECK(!ezos_work_is_pending(&queued.work) && !ezos_work_is_pending(&delayed.work));
+
+    // 正在执行的取消不了本次执行，但执行中的再次提交被取消
+    ezos_work_submit(g_wq, &running.work);
+    ezos_delayms(1);
+    ezos_work_submit(g_wq, &running.work);
+    TEST_CHECK(ezos_work_cancel(&running.work) == EZOS_EBUZY);
+
+    ezos_delayms(100);
+    TEST_CHECK(queued.runs == 0 && delayed.runs == 0);
+    TEST_CHECK(running.runs == 1);
+}
+
+static void test_delayed(void)
+{
+    job_t a, b;
+    uint64_t t0;
+
+    job_init(&a, 0, EZOS_WORK_PRIO_NORMAL);
+    job_init(&b, 1, EZOS_WORK_PRIO_NORMAL);
+
+    t0 = ezos_sim_now_ms();
+    ezos_work_submit_delayed(g_wq, &a.work, 100);
+    // 已在延时中，再次延时提交什么也不做
+    ezos_work_submit_delayed(g_wq, &a.work, 30);
+    ezos_work_submit_delayed(g_wq, &b.work, 100);
+    // 重新设置为更早
+    ezos_work_reschedule(g_wq, &b.work, 40);
+
+    ezos_delayms(60);
+    TEST_CHECK(a.runs == 0);
+    TEST_CHECK(b.runs == 1);
+    TEST_CHECK(b.last_run >= t0 + 40 && b.last_run <= t0 + 40 + TICK);
+    ezos_delayms(60);
+    TEST_CHECK(a.runs == 1);
+    TEST_CHECK(a.last_run >= t0 + 100 && a.last_run <= t0 + 100 + TICK);
+
+    // 延时为0等同立即提交，EZOS_DELAY_FOREVER只取消延时
+    ezos_work_reschedule(g_wq, &a.work, 0);
+    ezos_work_submit_delayed(g_wq, &b.work, 30);
+    ezos_work_reschedule(g_wq, &b.work, EZOS_DELAY_FOREVER);
+    ezos_delayms(50);
+    TEST_CHECK(a.runs == 2);
+    TEST_CHECK(b.runs == 1);
+}
+
+static void test_stress(void)
+{
+    job_t jobs[16];
+    uint32_t seed = 99;
+    uint32_t runs = 0;
+    ezos_workqueue_id_t wq = ezos_workqueue_create("stress", 4, WQ_PRIORITY, 2048);
+
+    TEST_CHECK(wq != NULL);
+    if (wq == NULL)
+        return;
+
+    for (int i = 0; i < 16; i++)
+    {
+        job_init(&jobs[i], i, (ezos_work_prio_t)(i % EZOS_WORK_PRIO_NUM));
+    }
+
+    for (int op = 0; op < 20000; op++)
+    {
+        uint32_t r = test_rand(&seed);
+        job_t *job = &jobs[r % 16];
+
+        job->block_ms = (r >> 8) % 4;
+        switch ((r >> 12) % 6)
+        {
+        case 0:
+            ezos_work_cancel(&job->work);
+            job->need = 0;
+            break;
+        case 1:
+            ezos_work_submit_delayed(wq, &job->work, (r >> 16) % 50 + 1);
+            job->need = 1;
+            break;
+        case 2:
+            ezos_work_reschedule(wq, &job->work, (r >> 16) % 50);
+            job->need = 1;
+            break;
+        default:
+            ezos_work_submit(wq, &job->work);
+            job->need = 1;
+            break;
+        }
+        if ((r >> 24) % 4 == 0)
+            ezos_delayms((r >> 26) % 8);
+    }
+
+    ezos_delayms(200);
+    for (int i = 0; i < 16; i++)
+    {
+        TEST_CHECK(jobs[i].need == 0);
+        TEST_CHECK(!jobs[i].running && !ezos_work_is_pending(&jobs[i].work));
+        runs += jobs[i].runs;
+    }
+    printf("stress runs %u\n", (unsigned)runs);
+    TEST_CHECK(g_overlap == 0);
+}
+
+int main(void)
+{
+    ezos_sim_enable();
+    g_wq = ezos_workqueue_create("test", 2, WQ_PRIORITY, 2048);
+    TEST_CHECK(g_wq != NULL);
+    if (g_wq == NULL)
+        return TEST_RESULT();
+
+    test_order();
+    test_resubmit_running();
+    test_cancel();
+    test_delayed();
+    test_stress();
+    return TEST_RESULT();
+}